@@ -36,6 +36,20 @@ function ofs.ScriptCount() end
 -- @treturn String Name
 function ofs.ScriptName(scriptIdx) end
 
+--- Get the script version
+--
+-- Increases with every change of the actions, the same version is passed to scriptChange.
+-- @tparam number scriptIdx
+-- @treturn number Version
+function ofs.ScriptVersion(scriptIdx) end
+
+--- Request frames to be rendered
+--
+-- OFS only renders when something changed. Extensions which animate their gui
+-- or wait for something outside of OFS call this to keep update and gui going.
+-- @tparam[opt=1] number frames
+function ofs.Redraw(frames) end
+
 --- Funscript.
 -- @section funscript
 
@@ -49,6 +63,24 @@ function ofs.ActiveIdx() end
 --   local script = ofs.Script(ofs.ActiveIdx())
 function ofs.Script(scriptIdx) end
 
+--- Get a view of the actions between two timestamps of a loaded script
+--
+-- Unlike `ofs.Script()` nothing is copied until the range is accessed and
+-- the actions are read and written as whole arrays, which is a lot faster on long scripts.
+-- @tparam number scriptIdx
+-- @tparam number fromTime Time in seconds
+-- @tparam number toTime Time in seconds
+-- @treturn ScriptRange|nil range
+-- @example
+--   local range = ofs.ScriptRange(ofs.ActiveIdx(), 10.0, 20.0)
+--   local positions = range:positions()
+--   for i=1, #positions do
+--     positions[i] = 100 - positions[i]
+--   end
+--   range:setPositions(positions)
+--   range:commit()
+function ofs.ScriptRange(scriptIdx, fromTime, toTime) end
+
 --- Get a read-only version of the clipboard
 -- @treturn Funscript clipboard
 function ofs.Clipboard() end
@@ -60,6 +92,149 @@ function ofs.Clipboard() end
 function ofs.Undo() end
 
 
+--- Ops.
+-- Native bulk transforms.
+--
+-- Every op works on the selected actions of a script, or on all actions between
+-- `fromTime` and `toTime` when both are given. Each call is a single undo step.
+-- @example
+--   -- smooth all actions between 10 and 20 seconds
+--   ofs.ops.Smooth(ofs.ActiveIdx(), 2, 10.0, 20.0)
+-- @section ops
+
+--- Insert points along a catmull-rom spline between consecutive actions
+-- @tparam number scriptIdx
+-- @tparam number interval Seconds between the inserted points
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.SplineResample(scriptIdx, interval, fromTime, toTime) end
+
+--- Insert points on the straight line between consecutive actions
+-- @tparam number scriptIdx
+-- @tparam number interval Seconds between the inserted points
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.LinearResample(scriptIdx, interval, fromTime, toTime) end
+
+--- Moving average of the positions
+-- @tparam number scriptIdx
+-- @tparam number radius Neighbours on each side
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.Smooth(scriptIdx, radius, fromTime, toTime) end
+
+--- Scale positions around 50
+-- @tparam number scriptIdx
+-- @tparam number factor
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.ScalePositions(scriptIdx, factor, fromTime, toTime) end
+
+--- Add an offset to the positions
+-- @tparam number scriptIdx
+-- @tparam number offset
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.OffsetPositions(scriptIdx, offset, fromTime, toTime) end
+
+--- Scale the timestamps relative to the start of the selection or range
+-- @tparam number scriptIdx
+-- @tparam number factor
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.ScaleTimes(scriptIdx, factor, fromTime, toTime) end
+
+--- Move the timestamps
+-- @tparam number scriptIdx
+-- @tparam number offset Time in seconds
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.OffsetTimes(scriptIdx, offset, fromTime, toTime) end
+
+--- Randomly move actions, timestamps stay in between the neighbouring actions
+-- @tparam number scriptIdx
+-- @tparam number timeJitter Maximum time offset in seconds
+-- @tparam number positionJitter Maximum position offset
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.Jitter(scriptIdx, timeJitter, positionJitter, fromTime, toTime) end
+
+--- Clamp positions
+-- @tparam number scriptIdx
+-- @tparam number min
+-- @tparam number max
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.Clamp(scriptIdx, min, max, fromTime, toTime) end
+
+--- Invert positions
+-- @tparam number scriptIdx
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.Invert(scriptIdx, fromTime, toTime) end
+
+--- Remove actions which are closer than tolerance to the line between their neighbours
+-- @tparam number scriptIdx
+-- @tparam number tolerance Position units
+-- @tparam number|nil fromTime
+-- @tparam number|nil toTime
+-- @treturn number Action count of the modified interval
+function ofs.ops.Decimate(scriptIdx, tolerance, fromTime, toTime) end
+
+--- Select all actions
+-- @tparam number scriptIdx
+-- @treturn nil
+function ofs.ops.SelectAll(scriptIdx) end
+
+--- Deselect all actions
+-- @tparam number scriptIdx
+-- @treturn nil
+function ofs.ops.SelectNone(scriptIdx) end
+
+
+--- Tasks.
+-- Long running work on a background thread.
+--
+-- The task function runs in a separate Lua state, so it can't access upvalues,
+-- globals of the extension or the `ofs` API. Data is passed in through `params`.
+-- It receives a read-only `Snapshot` of the actions, a `TaskContext` and the params.
+-- If it returns arrays of times and positions (and optionally selection flags),
+-- those replace the snapshotted actions as a single undo step once the task finished.
+-- If the snapshotted actions were edited while the task was running the result is
+-- discarded and `Task:error()` says so, edits outside of the range are kept.
+-- @example
+--   local task = ofs.Task("Invert", function(snapshot, ctx, params)
+--     local times = snapshot:times()
+--     local positions = snapshot:positions()
+--     for i=1, #positions do
+--       positions[i] = 100 - positions[i]
+--       if i % 1000 == 0 then ctx:progress(i / #positions) end
+--     end
+--     return times, positions
+--   end, ofs.ActiveIdx())
+-- @section task
+
+--- Start a task
+-- @tparam string name Shown next to the progress bar
+-- @tparam function fn `fn(snapshot, ctx, params)`
+-- @tparam number scriptIdx
+-- @tparam table|nil params Copied, only plain data
+-- @tparam number|nil fromTime Only snapshot actions from here, the whole script without a range
+-- @tparam number|nil toTime Only snapshot actions up to here
+-- @treturn Task|nil task
+function ofs.Task(name, fn, scriptIdx, params, fromTime, toTime) end
+
+
 --- GUI.
 -- @note Important
 --   All of these functions must be called from within the `gui()` function.
@@ -304,6 +479,16 @@ function Funscript:closestActionAfter(time) end
 -- @treturn number index
 function Funscript:closestActionBefore(time) end
 
+--- Get the indices of the closest actions for many timestamps at once
+-- @tparam number[] times Time in seconds
+-- @treturn number[] indices 0 where the script has no actions
+function Funscript:closestIndices(times) end
+
+--- Get the interpolated positions for many timestamps at once
+-- @tparam number[] times Time in seconds
+-- @treturn number[] positions
+function Funscript:positionsAt(times) end
+
 --- Get an array of selected indices into the actions array
 -- @treturn number[] indices
 function Funscript:selectedIndices() end
@@ -325,6 +510,127 @@ function Funscript:markForRemoval(actionIdx) end
 function Funscript:removeMarked() end
 
 
+--- Range returned by `ofs.ScriptRange()`
+-- @see funscript
+-- @display ScriptRange
+-- @class ScriptRange
+
+--- Start of the range in seconds
+-- @meta read-only
+-- @type number
+from = 0
+
+--- End of the range in seconds
+-- @meta read-only
+-- @type number
+to = 0
+
+--- Get the amount of actions in the range
+-- @treturn number count
+function ScriptRange:count() end
+
+--- Get the timestamps of all actions in the range
+-- @treturn number[] times Time in seconds
+function ScriptRange:times() end
+
+--- Get the positions of all actions in the range
+-- @treturn number[] positions
+function ScriptRange:positions() end
+
+--- Get the selection state of all actions in the range
+-- @treturn bool[] selected
+function ScriptRange:selected() end
+
+--- Set the timestamps of all actions in the range
+-- @tparam number[] times Must have the length of `count()`
+-- @treturn nil
+function ScriptRange:setTimes(times) end
+
+--- Set the positions of all actions in the range
+-- @tparam number[] positions Must have the length of `count()`
+-- @treturn nil
+function ScriptRange:setPositions(positions) end
+
+--- Set the selection state of all actions in the range
+-- @tparam bool[] selected Must have the length of `count()`
+-- @treturn nil
+function ScriptRange:setSelected(selected) end
+
+--- Replace all actions in the range
+-- @tparam number[] times
+-- @tparam number[] positions
+-- @tparam bool[]|nil selected
+-- @treturn nil
+function ScriptRange:replace(times, positions, selected) end
+
+--- Commit the changes as one undo step
+--
+-- Only the actions within the range are replaced.
+-- Actions moved outside of the range extend it.
+-- @treturn nil
+function ScriptRange:commit() end
+
+
+--- Handle returned by `ofs.Task()`
+-- @see task
+-- @display Task
+-- @class Task
+
+--- Progress reported by the task
+-- @treturn number progress 0.0 - 1.0
+function Task:progress() end
+
+--- Has the task finished
+-- @treturn bool done
+function Task:done() end
+
+--- Cancel the task, nothing gets committed
+-- @treturn nil
+function Task:cancel() end
+
+--- Error of a finished task
+-- @treturn string|nil error
+function Task:error() end
+
+
+--- Read-only actions passed to a task function
+-- @see task
+-- @display Snapshot
+-- @class Snapshot
+
+--- Get the amount of actions
+-- @treturn number count
+function Snapshot:count() end
+
+--- Get all timestamps
+-- @treturn number[] times
+function Snapshot:times() end
+
+--- Get all positions
+-- @treturn number[] positions
+function Snapshot:positions() end
+
+--- Get all selection flags
+-- @treturn bool[] selected
+function Snapshot:selected() end
+
+
+--- Passed to a task function
+-- @see task
+-- @display TaskContext
+-- @class TaskContext
+
+--- Report progress
+-- @tparam number progress 0.0 - 1.0
+-- @treturn nil
+function TaskContext:progress(progress) end
+
+--- Check if the task was cancelled
+--
+-- Cancelled tasks are also stopped automatically.
+-- @treturn bool cancelled
+function TaskContext:cancelled() end
+
 --- Action creation
 -- @module action
 
@@ -364,6 +670,25 @@ selected = false
 -- @treturn Process|nil Returns a process on success or nil
 function Process.new(program, ...) end
 
+--- Create a new process with redirected stdin, stdout and stderr
+--
+-- The output is read on background threads and can be fetched with `readLine`/`read` without blocking.
+-- Each stream buffers up to 1 MB, after that the process blocks until the output gets read.
+-- @display Process.pipe
+-- @treturn Process|nil Returns a process on success or nil
+-- @example
+--  local p = Process.pipe("python", "analyze.py")
+--  p:write("0.5 100\n1.0 0\n")
+--  p:closeInput()
+--  p:onExit(function(code)
+--    local line = p:readLine()
+--    while line do
+--      print(line)
+--      line = p:readLine()
+--    end
+--  end)
+function Process.pipe(program, ...) end
+
 --- Process handle returned by `Process.new()`
 --
 -- If the handle goes out of scope the process may get killed. (This is not guaranteed)
@@ -396,3 +721,42 @@ function Process:detach() end
 --- Kill the process
 -- @treturn nil
 function Process:kill() end
+
+--- Read the next line from stdout
+--
+-- Returns the remaining output without a trailing newline once the process closed stdout.
+-- Only for processes created with `Process.pipe()`.
+-- @treturn string|nil Line without the newline or nil if no complete line is available
+function Process:readLine() end
+
+--- Read everything available from stdout
+-- @treturn string|nil Output or nil if nothing is available
+function Process:read() end
+
+--- Read the next line from stderr
+-- @treturn string|nil Line without the newline or nil if no complete line is available
+function Process:readErrorLine() end
+
+--- Read everything available from stderr
+-- @treturn string|nil Output or nil if nothing is available
+function Process:readError() end
+
+--- Write to stdin
+--
+-- The data is written on a background thread and never blocks.
+-- Up to 1 MB can be waiting to be written, after that `write` fails until the process reads.
+-- @tparam string data
+-- @treturn bool false if the buffer is full, the input was closed or the process stopped reading
+function Process:write(data) end
+
+--- Close stdin, signalling the end of the input
+-- @treturn nil
+function Process:closeInput() end
+
+--- Call a function on the main thread once the process exited
+--
+-- The function gets called after all of the output has been read from the pipes,
+-- so it can still be fetched with `readLine`/`read`. Calling it again replaces the function.
+-- @tparam function callback Called with the return code
+-- @treturn nil
+function Process:onExit(callback) end
@@ -25,6 +25,18 @@ std::array<const char*, 9> Funscript::AxisNames =
 	"raw"
 };
 
+std::string Funscript::AxisIdToName(const std::string& id) noexcept
+{
+	if (id == "L0") return "stroke";
+	if (id == "L1") return "surge";
+	if (id == "L2") return "sway";
+	if (id == "R0") return "twist";
+	if (id == "R1") return "roll";
+	if (id == "R2") return "pitch";
+	if (id == "A1") return "suck";
+	return id; // fallback
+}
+
 Funscript::Funscript() noexcept
 {
 	notifyActionsChanged(false);
@@ -49,8 +61,16 @@ void Funscript::saveMetadata(nlohmann::json& outMetadataObj, const Funscript::Me
 }
 
 void Funscript::notifyActionsChanged(bool isEdit) noexcept
+{
+	notifyActionsChanged(isEdit, -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity());
+}
+
+void Funscript::notifyActionsChanged(bool isEdit, float fromTime, float toTime) noexcept
 {
 	funscriptChanged = true;
+	version += 1;
+	dirtyFrom = std::min(dirtyFrom, fromTime);
+	dirtyTo = std::max(dirtyTo, toTime);
 	if (isEdit && !unsavedEdits) {
 		unsavedEdits = true;
 		editTime = std::chrono::system_clock::now();
@@ -62,11 +82,13 @@ void Funscript::Update() noexcept
 	OFS_PROFILE(__FUNCTION__);
 	if (funscriptChanged) {
 		funscriptChanged = false;
-		EV::Enqueue<FunscriptActionsChangedEvent>(scriptId, title, data.Actions.size());
+		EV::Enqueue<FunscriptActionsChangedEvent>(scriptId, data.Actions.size(), version, dirtyFrom, dirtyTo);
+		dirtyFrom = std::numeric_limits<float>::infinity();
+		dirtyTo = -std::numeric_limits<float>::infinity();
 	}
 	if (selectionChanged) {
 		selectionChanged = false;
-		EV::Enqueue<FunscriptSelectionChangedEvent>(scriptId, title, data.Selection.size());
+		EV::Enqueue<FunscriptSelectionChangedEvent>(scriptId, data.Selection.size());
 	}
 }
 
@@ -112,7 +134,9 @@ void Funscript::AddMultipleActions(const FunscriptArray& actions) noexcept
 		data.Actions.emplace(action);
 	}
 	sortActions(data.Actions);
-	notifyActionsChanged(true);
+	if (!actions.empty()) {
+		notifyActionsChanged(true, actions.front().atS, actions.back().atS);
+	}
 }
 
 
@@ -125,7 +149,7 @@ bool Funscript::EditAction(FunscriptAction oldAction, FunscriptAction newAction)
 		act->atS = newAction.atS;
 		act->pos = newAction.pos;
 		checkForInvalidatedActions();
-		notifyActionsChanged(true);
+		notifyActionsChanged(true, std::min(oldAction.atS, newAction.atS), std::max(oldAction.atS, newAction.atS));
 		sortActions(data.Actions);
 		return true;
 	}
@@ -137,8 +161,8 @@ void Funscript::AddEditAction(FunscriptAction action, float frameTime) noexcept
 	OFS_PROFILE(__FUNCTION__);
 	auto close = getActionAtTime(data.Actions, action.atS, frameTime);
 	if (close != nullptr) {
+		notifyActionsChanged(true, std::min(close->atS, action.atS), std::max(close->atS, action.atS));
 		*close = action;
-		notifyActionsChanged(true);
 		checkForInvalidatedActions();
 	}
 	else {
@@ -167,7 +191,7 @@ void Funscript::RemoveAction(FunscriptAction action, bool checkInvalidSelection)
 	auto it = data.Actions.find(action);
 	if (it != data.Actions.end()) {
 		data.Actions.erase(it);
-		notifyActionsChanged(true);
+		notifyActionsChanged(true, action.atS, action.atS);
 
 		if (checkInvalidSelection) { checkForInvalidatedActions(); }
 	}
@@ -185,7 +209,9 @@ void Funscript::RemoveActions(const FunscriptArray& removeActions) noexcept
 		});
 	data.Actions.erase(it, data.Actions.end());
 
-	notifyActionsChanged(true);
+	if (!removeActions.empty()) {
+		notifyActionsChanged(true, removeActions.front().atS, removeActions.back().atS);
+	}
 	checkForInvalidatedActions();
 }
 
@@ -259,7 +285,24 @@ void Funscript::RemoveActionsInInterval(float fromTime, float toTime) noexcept
 			}), data.Actions.end()
 	);
 	checkForInvalidatedActions();
-	notifyActionsChanged(true);
+	notifyActionsChanged(true, fromTime, toTime);
+}
+
+void Funscript::ReplaceActionsInInterval(float fromTime, float toTime, const FunscriptArray& actions, const FunscriptArray& selection) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	auto replaceInterval = [fromTime, toTime](FunscriptArray& target, const FunscriptArray& replacement) noexcept {
+		auto first = std::lower_bound(target.begin(), target.end(), fromTime,
+			[](auto action, float time) noexcept { return action.atS < time; });
+		auto last = std::upper_bound(first, target.end(), toTime,
+			[](float time, auto action) noexcept { return time < action.atS; });
+		auto it = target.erase(first, last);
+		target.insert(it, replacement.begin(), replacement.end());
+	};
+	replaceInterval(data.Actions, actions);
+	replaceInterval(data.Selection, selection);
+	notifyActionsChanged(true, fromTime, toTime);
+	notifySelectionChanged();
 }
 
 void Funscript::RangeExtendSelection(int32_t rangeExtend) noexcept
@@ -459,7 +502,7 @@ void Funscript::SelectTime(float fromTime, float toTime, bool clear) noexcept
 	notifySelectionChanged();
 }
 
-FunscriptArray Funscript::GetSelection(float fromTime, float toTime) noexcept
+FunscriptArray Funscript::GetSelection(float fromTime, float toTime) const noexcept
 {
 	FunscriptArray selection;
 	if (!data.Actions.empty()) {
@@ -588,7 +631,11 @@ void Funscript::MoveSelectionTime(float timeOffset, float frameTime) noexcept
 	}
 	ClearSelection();
 	data.Selection = std::move(newSelection);
-	notifyActionsChanged(true);
+	if (!data.Selection.empty()) {
+		float fromTime = data.Selection.front().atS;
+		float toTime = data.Selection.back().atS;
+		notifyActionsChanged(true, std::min(fromTime, fromTime - timeOffset), std::max(toTime, toTime - timeOffset));
+	}
 }
 
 void Funscript::MoveSelectionPosition(int32_t pos_offset) noexcept
@@ -619,7 +666,9 @@ void Funscript::MoveSelectionPosition(int32_t pos_offset) noexcept
 		data.Selection.emplace_back_unsorted(*move);
 	}
 	sortSelection();
-	notifyActionsChanged(true);
+	if (!data.Selection.empty()) {
+		notifyActionsChanged(true, data.Selection.front().atS, data.Selection.back().atS);
+	}
 }
 
 void Funscript::SetSelection(const FunscriptArray& actionsToSelect) noexcept
@@ -692,7 +741,7 @@ void Funscript::UpdateRelativePath(const std::string& path) noexcept
 	}
 }
 
-bool Funscript::Deserialize(const nlohmann::json& json, Funscript::Metadata* outMetadata, bool loadChapters) noexcept
+bool Funscript::Deserialize(const nlohmann::json& json, Funscript::Metadata* outMetadata, ChapterState* outChapters) noexcept
 {
 	OFS_PROFILE(__FUNCTION__);
 
@@ -725,9 +774,9 @@ bool Funscript::Deserialize(const nlohmann::json& json, Funscript::Metadata* out
 		}
 	}
 
-	if(loadChapters && json.contains("metadata"))
+	if(outChapters && json.contains("metadata"))
 	{
-		auto& chapterState = ChapterState::StaticStateSlow();
+		auto& chapterState = *outChapters;
 		auto& jsonMetadata = json["metadata"];
 
 		if(jsonMetadata.contains("bookmarks"))
@@ -812,7 +861,7 @@ bool Funscript::Deserialize(const nlohmann::json& json, Funscript::Metadata* out
 	return true;
 }
 
-void Funscript::Serialize(nlohmann::json& json, const FunscriptData& funscriptData, const Funscript::Metadata& metadata, bool includeChapters) noexcept
+void Funscript::Serialize(nlohmann::json& json, const FunscriptData& funscriptData, const Funscript::Metadata& metadata, const ChapterState* chapterState) noexcept
 {
 	OFS_PROFILE(__FUNCTION__);
 	json = nlohmann::json::object();
@@ -833,9 +882,9 @@ void Funscript::Serialize(nlohmann::json& json, const FunscriptData& funscriptDa
 		Util::FormatTime(durationBuf, sizeof(durationBuf), (float)metadata.duration, true);
 		jsonMetadata["durationTime"] = std::string(durationBuf);
 	}
-	if(includeChapters)
+	if(chapterState)
 	{
-		auto& chapters = ChapterState::StaticStateSlow();
+		auto& chapters = *chapterState;
 		{
 			auto jsonBookmarks = nlohmann::json::array();
 			for(auto& bookmark : chapters.bookmarks)
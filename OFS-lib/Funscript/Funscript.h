@@ -9,6 +9,8 @@
 #include <string>
 #include <memory>
 #include <chrono>
+#include <limits>
+#include <algorithm>
 
 #include "OFS_Util.h"
 #include "FunscriptSpline.h"
@@ -19,17 +21,31 @@
 
 class FunscriptUndoSystem;
 class Funscript;
+struct ChapterState;
 
 class FunscriptActionsChangedEvent : public OFS_Event<FunscriptActionsChangedEvent>
 {
 	public:
 	// Use ID-based lookup instead of raw pointer to avoid use-after-free
 	uint32_t scriptId = 0;
-	std::string scriptName;
 	int actionCount = 0;
+	// changes since the last event, the range is infinite if unknown
+	uint32_t version = 0;
+	float dirtyFrom = 0.f;
+	float dirtyTo = 0.f;
 
-	FunscriptActionsChangedEvent(uint32_t id, const std::string& name, int count) noexcept
-		: scriptId(id), scriptName(name), actionCount(count) {}
+	FunscriptActionsChangedEvent(uint32_t id, int count, uint32_t version, float dirtyFrom, float dirtyTo) noexcept
+		: scriptId(id), actionCount(count), version(version), dirtyFrom(dirtyFrom), dirtyTo(dirtyTo) {}
+
+	static constexpr bool Coalescing = true;
+	inline uint64_t CoalescingKey() const noexcept { return scriptId; }
+	inline void Merge(const FunscriptActionsChangedEvent& newer) noexcept
+	{
+		actionCount = newer.actionCount;
+		version = newer.version;
+		dirtyFrom = std::min(dirtyFrom, newer.dirtyFrom);
+		dirtyTo = std::max(dirtyTo, newer.dirtyTo);
+	}
 };
 
 class FunscriptSelectionChangedEvent : public OFS_Event<FunscriptSelectionChangedEvent>
@@ -37,11 +53,13 @@ class FunscriptSelectionChangedEvent : public OFS_Event<FunscriptSelectionChange
 	public:
 	// Use ID-based lookup instead of raw pointer to avoid use-after-free
 	uint32_t scriptId = 0;
-	std::string scriptName;
 	int selectedCount = 0;
 
-	FunscriptSelectionChangedEvent(uint32_t id, const std::string& name, int count) noexcept
-		: scriptId(id), scriptName(name), selectedCount(count) {}
+	FunscriptSelectionChangedEvent(uint32_t id, int count) noexcept
+		: scriptId(id), selectedCount(count) {}
+
+	static constexpr bool Coalescing = true;
+	inline uint64_t CoalescingKey() const noexcept { return scriptId; }
 };
 
 class FunscriptNameChangedEvent : public OFS_Event<FunscriptNameChangedEvent>
@@ -114,6 +132,10 @@ private:
 	bool funscriptChanged = false; // used to fire only one event every frame a change occurs
 	bool unsavedEdits = false; // used to track if the script has unsaved changes
 	bool selectionChanged = false;
+	// incremented on every change of the actions
+	uint32_t version = 0;
+	float dirtyFrom = std::numeric_limits<float>::infinity();
+	float dirtyTo = -std::numeric_limits<float>::infinity();
 	FunscriptData data;
 
 	void checkForInvalidatedActions() noexcept;
@@ -188,13 +210,15 @@ private:
 	void moveActionsPosition(std::vector<FunscriptAction*> moving, int32_t posOffset);
 	inline void sortSelection() noexcept { sortActions(data.Selection); }
 	inline void sortActions(FunscriptArray& actions) noexcept { std::sort(actions.begin(), actions.end()); }
-	inline void addAction(FunscriptArray& actions, FunscriptAction newAction) noexcept { actions.emplace(newAction); notifyActionsChanged(true); }
+	inline void addAction(FunscriptArray& actions, FunscriptAction newAction) noexcept { actions.emplace(newAction); notifyActionsChanged(true, newAction.atS, newAction.atS); }
 	inline void notifySelectionChanged() noexcept { selectionChanged = true; }
 
 	static void loadMetadata(const nlohmann::json& metadataObj, Funscript::Metadata& outMetadata) noexcept;
 	static void saveMetadata(nlohmann::json& outMetadataObj, const Funscript::Metadata& inMetadata) noexcept;
 
-	void notifyActionsChanged(bool isEdit) noexcept; 
+	// without a range everything is considered changed
+	void notifyActionsChanged(bool isEdit) noexcept;
+	void notifyActionsChanged(bool isEdit, float fromTime, float toTime) noexcept;
 	std::string currentPathRelative;
 	std::string title;
 public:
@@ -203,6 +227,35 @@ public:
 
 	static std::array<const char*, 9> AxisNames;
 
+	// Maps 1.1 axis ids (L0, R1, ...) to the channel names used for the per axis files.
+	static std::string AxisIdToName(const std::string& id) noexcept;
+	// Funscript 2.0 `channels` and 1.1 `axes` carry additional scripts next to the root actions.
+	// Calls fn(channelName, channelJson) for every channel with an actions array,
+	// returns false if the json has neither. Channels can be modified through a non-const json.
+	template<typename Json, typename Fn>
+	static bool ForEachChannel(Json& json, Fn&& fn) noexcept
+	{
+		bool hasChannels = json.contains("channels") && json["channels"].is_object();
+		bool hasAxes = json.contains("axes") && json["axes"].is_array();
+		if (hasChannels) {
+			for (auto it = json["channels"].begin(); it != json["channels"].end(); ++it) {
+				auto& channelObj = it.value();
+				if (!channelObj.is_object()) continue;
+				if (!channelObj.contains("actions") || !channelObj["actions"].is_array()) continue;
+				fn(it.key(), channelObj);
+			}
+		}
+		if (hasAxes) {
+			for (auto& axisObj : json["axes"]) {
+				if (!axisObj.is_object()) continue;
+				if (!axisObj.contains("actions") || !axisObj["actions"].is_array()) continue;
+				std::string axisId = axisObj.contains("id") && axisObj["id"].is_string() ? axisObj["id"].template get<std::string>() : std::string{};
+				fn(!axisId.empty() ? AxisIdToName(axisId) : std::string{"axis"}, axisObj);
+			}
+		}
+		return hasChannels || hasAxes;
+	}
+
 	bool Enabled = true;
 	std::unique_ptr<FunscriptUndoSystem> undoSystem;
 
@@ -211,20 +264,22 @@ public:
 	inline const std::string& RelativePath() const noexcept { return currentPathRelative; }
 	inline const std::string& Title() const noexcept { return title; }
 	inline uint32_t ScriptId() const noexcept { return scriptId; }
+	inline uint32_t Version() const noexcept { return version; }
 	inline void SetScriptId(uint32_t id) noexcept { scriptId = id; }
 
 	inline void Rollback(FunscriptData&& data) noexcept { this->data = std::move(data); notifyActionsChanged(true); }
 	inline void Rollback(const FunscriptData& data) noexcept { this->data = data; notifyActionsChanged(true); }
 	void Update() noexcept;
 
-	bool Deserialize(const nlohmann::json& json, Funscript::Metadata* outMetadata, bool loadChapters) noexcept;
-	inline nlohmann::json Serialize(const Funscript::Metadata& metadata, bool includeChapters) const noexcept 
+	// Chapters and bookmarks are only read into or written from the given state, nullptr skips them.
+	bool Deserialize(const nlohmann::json& json, Funscript::Metadata* outMetadata, ChapterState* outChapters) noexcept;
+	inline nlohmann::json Serialize(const Funscript::Metadata& metadata, const ChapterState* chapters) const noexcept 
 	{ 
 		nlohmann::json json;
-		Serialize(json, data, metadata, includeChapters); 
+		Serialize(json, data, metadata, chapters); 
 		return json;
 	}
-	static void Serialize(nlohmann::json& json, const FunscriptData& funscriptData, const Funscript::Metadata& metadata, bool includeChapters) noexcept;
+	static void Serialize(nlohmann::json& json, const FunscriptData& funscriptData, const Funscript::Metadata& metadata, const ChapterState* chapters) noexcept;
 	
 	inline const FunscriptData& Data() const noexcept { return data; }
 	inline const auto& Selection() const noexcept { return data.Selection; }
@@ -254,6 +309,9 @@ public:
 	inline const std::chrono::system_clock::time_point& EditTime() const { return editTime; }
 
 	void RemoveActionsInInterval(float fromTime, float toTime) noexcept;
+	// Batched edit, swaps the actions and the selection inside [fromTime, toTime] for the given ones.
+	// Both arrays have to be sorted and inside of the interval.
+	void ReplaceActionsInInterval(float fromTime, float toTime, const FunscriptArray& actions, const FunscriptArray& selection) noexcept;
 
 	// selection api
 	void RangeExtendSelection(int32_t rangeExtend) noexcept;
@@ -264,7 +322,7 @@ public:
 	void SelectBottomActions() noexcept;
 	void SelectMidActions() noexcept;
 	void SelectTime(float fromTime, float toTime, bool clear=true) noexcept;
-	FunscriptArray GetSelection(float fromTime, float toTime) noexcept;
+	FunscriptArray GetSelection(float fromTime, float toTime) const noexcept;
 
 	void SelectAction(FunscriptAction select) noexcept;
 	void DeselectAction(FunscriptAction deselect) noexcept;
@@ -1,6 +1,7 @@
 #include "FunscriptHeatmap.h"
 #include "OFS_Util.h"
 #include "OFS_Profiling.h"
+#include "OFS_FrameArena.h"
 
 #include "OFS_ImGui.h"
 #include "OFS_Shader.h"
@@ -9,6 +10,8 @@
 #include <chrono>
 #include <memory>
 #include <array>
+#include <cmath>
+#include <algorithm>
 
 ImGradient FunscriptHeatmap::Colors;
 ImGradient FunscriptHeatmap::LineColors;
@@ -149,15 +152,14 @@ FunscriptHeatmap::FunscriptHeatmap() noexcept
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void FunscriptHeatmap::Update(float totalDuration, const FunscriptArray& actions) noexcept
+void FunscriptHeatmap::ComputeSpeeds(float totalDuration, const FunscriptArray& actions, float* outSpeeds, uint32_t resolution) noexcept
 {
     OFS_PROFILE(__FUNCTION__);
-    std::vector<float> speedBuffer; 
-    speedBuffer.resize(SpeedTextureResolution, 0.f);
-    std::vector<uint16_t> sampleCountBuffer;
-    sampleCountBuffer.resize(SpeedTextureResolution, 0);
+    auto speedBuffer = outSpeeds;
+    std::fill_n(speedBuffer, resolution, 0.f);
+    OFS_FrameVector<uint16_t> sampleCountBuffer(resolution, 0);
 
-    float timeStep = totalDuration / SpeedTextureResolution;
+    float timeStep = totalDuration / resolution;
 
     for(uint32_t i = 0, j = 1, size = actions.size(); j < size; i = j++)
     {
@@ -171,7 +173,7 @@ void FunscriptHeatmap::Update(float totalDuration, const FunscriptArray& actions
         uint32_t nextSampleIdx = next.atS / timeStep;
         if(prevSampleIdx == nextSampleIdx)
         {
-            if(prevSampleIdx < SpeedTextureResolution)
+            if(prevSampleIdx < resolution)
             {
                 sampleCountBuffer[prevSampleIdx] += 1;
                 speedBuffer[prevSampleIdx] += speed;
@@ -179,7 +181,7 @@ void FunscriptHeatmap::Update(float totalDuration, const FunscriptArray& actions
         }
         else
         {
-            if(prevSampleIdx < SpeedTextureResolution && nextSampleIdx < SpeedTextureResolution)
+            if(prevSampleIdx < resolution && nextSampleIdx < resolution)
             {
                 for(int x = prevSampleIdx; x < nextSampleIdx; x += 1)
                 {
@@ -190,12 +192,63 @@ void FunscriptHeatmap::Update(float totalDuration, const FunscriptArray& actions
         }
     }
 
-    for(uint32_t i=0; i < SpeedTextureResolution; i += 1)
+    for(uint32_t i=0; i < resolution; i += 1)
     {
         speedBuffer[i] /= sampleCountBuffer[i] > 0 ? (float)sampleCountBuffer[i] : 1.f;
         speedBuffer[i] /= MaxSpeedPerSecond;
         speedBuffer[i] = Util::Clamp(speedBuffer[i], 0.f, 1.f);
     }
+}
+
+std::vector<uint8_t> FunscriptHeatmap::RenderSpeedsToBitmap(const std::vector<float>& speeds, int16_t width, int16_t height) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    // has to match the RAMP in HeatmapShader
+    static constexpr float RampColors[6][3] = {
+        { 0.f, 0.f, 0.f },
+        { 30.f / 255.f, 144.f / 255.f, 1.f },
+        { 0.f, 1.f, 1.f },
+        { 0.f, 1.f, 0.f },
+        { 1.f, 1.f, 0.f },
+        { 1.f, 0.f, 0.f },
+    };
+    width = Util::Clamp<int16_t>(width, 1, FunscriptHeatmap::MaxResolution);
+    height = Util::Clamp<int16_t>(height, 1, FunscriptHeatmap::MaxResolution);
+    std::vector<uint8_t> bitmap((size_t)width * height * 3, 0);
+    if(speeds.empty()) return bitmap;
+
+    for(int32_t x = 0; x < width; x += 1)
+    {
+        // linear filtering like the speed texture
+        float texel = ((x + 0.5f) / width) * speeds.size() - 0.5f;
+        int32_t i0 = Util::Clamp<int32_t>((int32_t)std::floor(texel), 0, speeds.size() - 1);
+        int32_t i1 = Util::Min<int32_t>(i0 + 1, speeds.size() - 1);
+        float speed = Util::Lerp(speeds[i0], speeds[i1], Util::Clamp(texel - i0, 0.f, 1.f));
+
+        float ramp = Util::Clamp(speed, 0.f, 1.f) * 5.f;
+        int32_t idx = Util::Min<int32_t>((int32_t)ramp, 4);
+        float t = Util::Clamp(ramp - idx, 0.f, 1.f);
+        t = t * t * (3.f - 2.f * t);
+        float color[3];
+        for(int c = 0; c < 3; c += 1)
+            color[c] = RampColors[idx][c] + (RampColors[idx + 1][c] - RampColors[idx][c]) * t;
+
+        for(int32_t y = 0; y < height; y += 1)
+        {
+            float fade = (y + 0.5f) / height;
+            auto pixel = &bitmap[((size_t)y * width + x) * 3];
+            for(int c = 0; c < 3; c += 1)
+                pixel[c] = (uint8_t)std::lround(color[c] * fade * 255.f);
+        }
+    }
+    return bitmap;
+}
+
+void FunscriptHeatmap::Update(float totalDuration, const FunscriptArray& actions) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    OFS_FrameVector<float> speedBuffer;
+    ComputeSpeeds(totalDuration, actions, speedBuffer, SpeedTextureResolution);
 
     glBindTexture(GL_TEXTURE_2D, speedTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, SpeedTextureResolution, 1, 0, GL_RED, GL_FLOAT, speedBuffer.data());
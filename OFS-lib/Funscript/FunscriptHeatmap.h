@@ -19,6 +19,17 @@ public:
 
 	void DrawHeatmap(ImDrawList* drawList, const ImVec2& min, const ImVec2& max) noexcept;
 	void Update(float totalDuration , const FunscriptArray& actions) noexcept;
+	// The CPU side of Update, speeds normalized to [0, 1]. Doesn't need a GL context.
+	template<typename Allocator>
+	static void ComputeSpeeds(float totalDuration, const FunscriptArray& actions, std::vector<float, Allocator>& outSpeeds, uint32_t resolution = 2048) noexcept
+	{
+		outSpeeds.resize(resolution);
+		ComputeSpeeds(totalDuration, actions, outSpeeds.data(), resolution);
+	}
+	// outSpeeds has to hold resolution values
+	static void ComputeSpeeds(float totalDuration, const FunscriptArray& actions, float* outSpeeds, uint32_t resolution) noexcept;
+	// Same colors as the heatmap shader, RGB rows from top to bottom.
+	static std::vector<uint8_t> RenderSpeedsToBitmap(const std::vector<float>& speeds, int16_t width, int16_t height) noexcept;
 
 	std::vector<uint8_t> RenderToBitmap(int16_t width, int16_t height) noexcept;
 };
@@ -0,0 +1,277 @@
+#include "FunscriptOps.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+void FunscriptColumns::Reserve(size_t size) noexcept
+{
+	times.reserve(size);
+	positions.reserve(size);
+	mask.reserve(size);
+	selected.reserve(size);
+}
+
+void FunscriptColumns::Append(FunscriptAction action, bool isMasked, bool isSelected) noexcept
+{
+	times.emplace_back(action.atS);
+	positions.emplace_back((float)action.pos);
+	mask.emplace_back(isMasked);
+	selected.emplace_back(isSelected);
+}
+
+void FunscriptColumns::Load(const FunscriptAction* first, const FunscriptAction* last,
+	const FunscriptArray& selection, bool maskSelection) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	Clear();
+	Reserve(last - first);
+	if (first == last) return;
+
+	// both are sorted, so the selection is walked alongside instead of searched per action
+	auto selIt = std::lower_bound(selection.begin(), selection.end(), first->atS,
+		[](auto action, float time) noexcept { return action.atS < time; });
+	for (auto it = first; it != last; ++it) {
+		while (selIt != selection.end() && selIt->atS < it->atS) ++selIt;
+		bool isSelected = selIt != selection.end() && *selIt == *it;
+		Append(*it, maskSelection ? isSelected : true, isSelected);
+	}
+}
+
+void FunscriptColumns::Store(FunscriptArray& outActions, FunscriptArray& outSelection) const noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	outActions.clear();
+	outSelection.clear();
+	outActions.reserve(Size());
+	for (size_t i = 0, size = Size(); i < size; i += 1) {
+		if (!outActions.empty() && outActions.back().atS == times[i]) continue;
+		FunscriptAction action(Util::Max(times[i], 0.f), Util::Clamp((int32_t)std::lround(positions[i]), 0, 100));
+		outActions.emplace_back_unsorted(action);
+		if (selected[i]) outSelection.emplace_back_unsorted(action);
+	}
+}
+
+// Restores the time order after masked actions were moved past unmasked ones.
+static void sortByTime(FunscriptColumns& cols) noexcept
+{
+	if (std::is_sorted(cols.times.begin(), cols.times.end())) return;
+	OFS_PROFILE(__FUNCTION__);
+	std::vector<uint32_t> order(cols.Size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+		[&cols](uint32_t a, uint32_t b) noexcept { return cols.times[a] < cols.times[b]; });
+
+	FunscriptColumns sorted;
+	sorted.Reserve(cols.Size());
+	for (auto i : order) {
+		sorted.times.emplace_back(cols.times[i]);
+		sorted.positions.emplace_back(cols.positions[i]);
+		sorted.mask.emplace_back(cols.mask[i]);
+		sorted.selected.emplace_back(cols.selected[i]);
+	}
+	cols = std::move(sorted);
+}
+
+void FunscriptOps::ScalePositions(FunscriptColumns& cols, float factor, float center) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	float* pos = cols.positions.data();
+	const uint8_t* mask = cols.mask.data();
+	for (size_t i = 0, size = cols.Size(); i < size; i += 1) {
+		float scaled = (pos[i] - center) * factor + center;
+		pos[i] = mask[i] ? scaled : pos[i];
+	}
+}
+
+void FunscriptOps::OffsetPositions(FunscriptColumns& cols, float offset) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	float* pos = cols.positions.data();
+	const uint8_t* mask = cols.mask.data();
+	for (size_t i = 0, size = cols.Size(); i < size; i += 1) {
+		pos[i] += mask[i] ? offset : 0.f;
+	}
+}
+
+void FunscriptOps::ClampPositions(FunscriptColumns& cols, float min, float max) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	float* pos = cols.positions.data();
+	const uint8_t* mask = cols.mask.data();
+	for (size_t i = 0, size = cols.Size(); i < size; i += 1) {
+		float clamped = std::min(std::max(pos[i], min), max);
+		pos[i] = mask[i] ? clamped : pos[i];
+	}
+}
+
+void FunscriptOps::InvertPositions(FunscriptColumns& cols) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	float* pos = cols.positions.data();
+	const uint8_t* mask = cols.mask.data();
+	for (size_t i = 0, size = cols.Size(); i < size; i += 1) {
+		pos[i] = mask[i] ? 100.f - pos[i] : pos[i];
+	}
+}
+
+void FunscriptOps::OffsetTimes(FunscriptColumns& cols, float offset) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	float* times = cols.times.data();
+	const uint8_t* mask = cols.mask.data();
+	for (size_t i = 0, size = cols.Size(); i < size; i += 1) {
+		times[i] += mask[i] ? offset : 0.f;
+	}
+	sortByTime(cols);
+}
+
+void FunscriptOps::ScaleTimes(FunscriptColumns& cols, float factor, float origin) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	float* times = cols.times.data();
+	const uint8_t* mask = cols.mask.data();
+	for (size_t i = 0, size = cols.Size(); i < size; i += 1) {
+		float scaled = (times[i] - origin) * factor + origin;
+		times[i] = mask[i] ? scaled : times[i];
+	}
+	sortByTime(cols);
+}
+
+void FunscriptOps::Smooth(FunscriptColumns& cols, int32_t radius) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	const int64_t size = cols.Size();
+	if (radius <= 0 || size < 2) return;
+
+	std::vector<double> prefix(size + 1);
+	prefix[0] = 0.0;
+	for (int64_t i = 0; i < size; i += 1) prefix[i + 1] = prefix[i] + cols.positions[i];
+
+	float* pos = cols.positions.data();
+	const uint8_t* mask = cols.mask.data();
+	for (int64_t i = 0; i < size; i += 1) {
+		int64_t lo = std::max<int64_t>(i - radius, 0);
+		int64_t hi = std::min<int64_t>(i + radius + 1, size);
+		float mean = (float)((prefix[hi] - prefix[lo]) / (double)(hi - lo));
+		pos[i] = mask[i] ? mean : pos[i];
+	}
+}
+
+void FunscriptOps::Jitter(FunscriptColumns& cols, float timeJitter, float positionJitter) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	static thread_local std::mt19937 rng(std::random_device{}());
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+	// funscripts store milliseconds, closer actions would collapse into one when saved
+	constexpr float MinGap = 0.001f;
+	const size_t size = cols.Size();
+	// every action stays below the midpoint to its next neighbour and at least MinGap
+	// above the already jittered previous one, so the order can't change
+	std::vector<float> original = cols.times;
+	for (size_t i = 0; i < size; i += 1) {
+		if (!cols.mask[i]) continue;
+		float t = original[i];
+		float lo = i > 0 ? Util::Max((original[i - 1] + t) * 0.5f, cols.times[i - 1] + MinGap) : t - timeJitter;
+		float hi = i + 1 < size ? (t + original[i + 1]) * 0.5f : t + timeJitter;
+		// too close to its neighbours to move, staying put keeps it in between them
+		if (lo <= hi) {
+			cols.times[i] = Util::Clamp(t + unit(rng) * timeJitter, lo, hi);
+		}
+		cols.positions[i] += std::round(unit(rng) * positionJitter);
+	}
+}
+
+inline static float catmullRom(float v0, float v1, float v2, float v3, float s) noexcept
+{
+	float s2 = s * s;
+	float s3 = s2 * s;
+	float f0 = -s3 + 2.f * s2 - s;
+	float f1 = 3.f * s3 - 5.f * s2 + 2.f;
+	float f2 = -3.f * s3 + 4.f * s2 + s;
+	float f3 = s3 - s2;
+	return (f0 * v0 + f1 * v1 + f2 * v2 + f3 * v3) * 0.5f;
+}
+
+void FunscriptOps::Resample(FunscriptColumns& cols, float interval, bool spline) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	const int64_t size = cols.Size();
+	if (interval <= 0.f || size < 2) return;
+
+	size_t insertCount = 0;
+	for (int64_t i = 0; i + 1 < size; i += 1) {
+		if (cols.mask[i] && cols.mask[i + 1]) {
+			insertCount += (size_t)((cols.times[i + 1] - cols.times[i]) / interval);
+		}
+	}
+
+	FunscriptColumns resampled;
+	resampled.Reserve(size + insertCount);
+	for (int64_t i = 0; i < size; i += 1) {
+		resampled.times.emplace_back(cols.times[i]);
+		resampled.positions.emplace_back(cols.positions[i]);
+		resampled.mask.emplace_back(cols.mask[i]);
+		resampled.selected.emplace_back(cols.selected[i]);
+		if (i + 1 >= size || !cols.mask[i] || !cols.mask[i + 1]) continue;
+
+		const float t1 = cols.times[i];
+		const float duration = cols.times[i + 1] - t1;
+		// the last point would land on or right before the next action
+		const int32_t pointCount = (int32_t)std::ceil(duration / interval - 0.001f) - 1;
+		const float p0 = cols.positions[std::max<int64_t>(i - 1, 0)];
+		const float p1 = cols.positions[i];
+		const float p2 = cols.positions[i + 1];
+		const float p3 = cols.positions[std::min<int64_t>(i + 2, size - 1)];
+		const bool isSelected = cols.selected[i] && cols.selected[i + 1];
+		for (int32_t k = 1; k <= pointCount; k += 1) {
+			float s = (k * interval) / duration;
+			resampled.times.emplace_back(t1 + k * interval);
+			resampled.positions.emplace_back(spline ? catmullRom(p0, p1, p2, p3, s) : p1 + (p2 - p1) * s);
+			resampled.mask.emplace_back(1);
+			resampled.selected.emplace_back(isSelected);
+		}
+	}
+	cols = std::move(resampled);
+}
+
+void FunscriptOps::Decimate(FunscriptColumns& cols, float tolerance) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	const size_t size = cols.Size();
+	if (size < 3) return;
+
+	// compacts in place, lastKept always refers to the already compacted output
+	size_t out = 1;
+	for (size_t i = 1; i + 1 < size; i += 1) {
+		const size_t lastKept = out - 1;
+		bool keep = !cols.mask[i];
+		if (!keep) {
+			float t0 = cols.times[lastKept], p0 = cols.positions[lastKept];
+			float t2 = cols.times[i + 1], p2 = cols.positions[i + 1];
+			float s = t2 > t0 ? (cols.times[i] - t0) / (t2 - t0) : 0.f;
+			keep = std::abs(cols.positions[i] - (p0 + (p2 - p0) * s)) > tolerance;
+		}
+		if (keep) {
+			cols.times[out] = cols.times[i];
+			cols.positions[out] = cols.positions[i];
+			cols.mask[out] = cols.mask[i];
+			cols.selected[out] = cols.selected[i];
+			out += 1;
+		}
+	}
+	cols.times[out] = cols.times[size - 1];
+	cols.positions[out] = cols.positions[size - 1];
+	cols.mask[out] = cols.mask[size - 1];
+	cols.selected[out] = cols.selected[size - 1];
+	out += 1;
+
+	cols.times.resize(out);
+	cols.positions.resize(out);
+	cols.mask.resize(out);
+	cols.selected.resize(out);
+}
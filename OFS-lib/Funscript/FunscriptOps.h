@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FunscriptAction.h"
+
+#include <cstdint>
+#include <vector>
+
+// Actions split into columns so the bulk operations below are plain loops over
+// float arrays, which the compiler can vectorize. Only masked actions get modified,
+// the others are kept as anchors for neighbourhood based operations.
+struct FunscriptColumns
+{
+	std::vector<float> times;
+	std::vector<float> positions;
+	std::vector<uint8_t> mask;
+	std::vector<uint8_t> selected;
+
+	inline size_t Size() const noexcept { return times.size(); }
+	inline void Clear() noexcept { times.clear(); positions.clear(); mask.clear(); selected.clear(); }
+	void Reserve(size_t size) noexcept;
+	void Append(FunscriptAction action, bool isMasked, bool isSelected) noexcept;
+
+	// Columns for [first, last), only selected actions are masked if maskSelection is set.
+	void Load(const FunscriptAction* first, const FunscriptAction* last,
+		const FunscriptArray& selection, bool maskSelection) noexcept;
+	// Rounds and clamps back into actions. Columns have to be sorted by time,
+	// of multiple actions with the same timestamp only the first one is kept.
+	void Store(FunscriptArray& outActions, FunscriptArray& outSelection) const noexcept;
+};
+
+struct FunscriptOps
+{
+	// all positions are in the 0 - 100 range and all times in seconds
+	static void ScalePositions(FunscriptColumns& cols, float factor, float center) noexcept;
+	static void OffsetPositions(FunscriptColumns& cols, float offset) noexcept;
+	static void ClampPositions(FunscriptColumns& cols, float min, float max) noexcept;
+	static void InvertPositions(FunscriptColumns& cols) noexcept;
+
+	// Time operations keep the columns sorted, masked actions which end up
+	// on top of each other are resolved when storing.
+	static void OffsetTimes(FunscriptColumns& cols, float offset) noexcept;
+	static void ScaleTimes(FunscriptColumns& cols, float factor, float origin) noexcept;
+
+	// Moving average over radius neighbours on each side.
+	static void Smooth(FunscriptColumns& cols, int32_t radius) noexcept;
+	// Random offsets, times stay in between the neighbouring actions.
+	static void Jitter(FunscriptColumns& cols, float timeJitter, float positionJitter) noexcept;
+	// Inserts a point every interval seconds between two consecutive masked actions,
+	// either on a catmull-rom spline through the actions or on the straight line.
+	static void Resample(FunscriptColumns& cols, float interval, bool spline) noexcept;
+	// Removes masked actions which deviate less than tolerance from the line between their neighbours.
+	static void Decimate(FunscriptColumns& cols, float tolerance) noexcept;
+};
@@ -10,202 +10,463 @@
 #include "SDL_timer.h"
 
 #include "stb_sprintf.h"
+#include <algorithm>
+#include <cctype>
+#include <string>
 #include <vector>
 
 #include <atomic>
 
 static OFS::AppLog OFS_MainLog;
+// the log window is cleared once it holds this much text
+static constexpr int MaxLogWindowBytes = 4 * 1024 * 1024;
 
 SDL_RWops* OFS_FileLogger::LogFileHandle = nullptr;
+SDL_atomic_t OFS_FileLogger::MinSeverity = { OFS_LOG_MIN_SEVERITY };
 
-struct OFS_LogThread {
-    SDL_SpinLock lock;
-    SDL_cond* WaitFlush = nullptr;
-    std::vector<char> LogMsgBuffer;
+// Rings are never freed, a thread which exits hands its ring to the next one.
+static constexpr int MaxLogRings = 64;
+static OFS_LogRing* LogRings[MaxLogRings] = {};
+static SDL_atomic_t LogRingCount = {0};
+static SDL_SpinLock LogRingLock = 0;
 
-    std::atomic<bool> ShouldExit = false;
-    std::atomic<bool> Exited = false;
+static SDL_atomic_t LogSequence = {0};
+// messages which didn't fit into their ring
+static SDL_atomic_t DroppedMessages = {0};
 
-    void Init() noexcept
-    {
-        WaitFlush = SDL_CreateCond();
-        LogMsgBuffer.reserve(4096);
-    }
+struct OFS_ThreadLogRing {
+    OFS_LogRing* ring = nullptr;
+    bool acquired = false;
 
-    void Shutdown() noexcept
+    ~OFS_ThreadLogRing() noexcept
     {
-        ShouldExit = true;
-        SDL_CondSignal(WaitFlush);
-        while (!Exited) {
-            SDL_Delay(1);
-        }
-        SDL_DestroyCond(WaitFlush);
+        if (ring) SDL_AtomicSet(&ring->inUse, 0);
     }
 };
+static thread_local OFS_ThreadLogRing ThreadRing;
+
+struct OFS_LogThread {
+    SDL_Thread* thread = nullptr;
+    SDL_mutex* waitMut = nullptr;
+    SDL_cond* WaitFlush = nullptr;
+
+    std::atomic<bool> ShouldExit = false;
+
+    // formatted lines for the log window, which may only be touched on the main thread
+    SDL_SpinLock windowLock = 0;
+    std::string windowText;
+};
 
 static OFS_LogThread Thread;
 
-static int LogThreadFunction(void* threadData) noexcept
+static OFS_LogRing* acquireRing() noexcept
 {
-    auto& thread = *(OFS_LogThread*)threadData;
-    auto& msg = thread.LogMsgBuffer;
-    auto waitMut = SDL_CreateMutex();
-    SDL_LockMutex(waitMut);
-    while (!thread.ShouldExit && OFS_FileLogger::LogFileHandle) {
-        if (SDL_CondWait(thread.WaitFlush, waitMut) == 0) {
-            SDL_AtomicLock(&thread.lock);
-            SDL_RWwrite(OFS_FileLogger::LogFileHandle, msg.data(), 1, msg.size());
-            msg.clear();
-            SDL_AtomicUnlock(&thread.lock);
+    SDL_AtomicLock(&LogRingLock);
+    OFS_LogRing* ring = nullptr;
+    int count = SDL_AtomicGet(&LogRingCount);
+    for (int i = 0; i < count; i += 1) {
+        if (SDL_AtomicGet(&LogRings[i]->inUse) == 0) {
+            ring = LogRings[i];
+            break;
         }
     }
-
-    SDL_DestroyMutex(waitMut);
-    thread.Exited = true;
-
-    return 0;
+    if (!ring && count < MaxLogRings) {
+        ring = new OFS_LogRing();
+        LogRings[count] = ring;
+        SDL_AtomicSet(&LogRingCount, count + 1);
+    }
+    if (ring) SDL_AtomicSet(&ring->inUse, 1);
+    SDL_AtomicUnlock(&LogRingLock);
+    return ring;
 }
 
-void OFS_FileLogger::Init() noexcept
+bool OFS_FileLogger::allow(OFS_LogSite& site, uint32_t& outSuppressed) noexcept
 {
-    if (LogFileHandle) return;
-#ifndef NDEBUG
-    SDL_LogSetAllPriority(SDL_LOG_PRIORITY_VERBOSE);
-#endif
-    auto LogFilePath = Util::Prefpath("OFS.log");
-    LogFileHandle = SDL_RWFromFile(LogFilePath.c_str(), "w");
-
-    Thread.Init();
-    auto t = SDL_CreateThread(LogThreadFunction, "MessageLogging", &Thread);
-    SDL_DetachThread(t);
+    int second = (int)(SDL_GetTicks() / 1000);
+    int siteSecond = SDL_AtomicGet(&site.second);
+    if (siteSecond != second && SDL_AtomicCAS(&site.second, siteSecond, second)) {
+        SDL_AtomicSet(&site.count, 0);
+    }
+    if (SDL_AtomicAdd(&site.count, 1) < MaxMessagesPerSecond) {
+        outSuppressed = (uint32_t)SDL_AtomicSet(&site.suppressed, 0);
+        return true;
+    }
+    SDL_AtomicIncRef(&site.suppressed);
+    return false;
 }
 
-void OFS_FileLogger::Shutdown() noexcept
+OFS_LogRecord* OFS_FileLogger::beginRecord(uint32_t size) noexcept
 {
-    if (!LogFileHandle) return;
-    Thread.Shutdown();
-    SDL_RWclose(LogFileHandle);
+    if (!ThreadRing.acquired) {
+        ThreadRing.acquired = true;
+        ThreadRing.ring = acquireRing();
+    }
+    auto ring = ThreadRing.ring;
+    size = (size + 7) & ~7u;
+    if (!ring || size > OFS_LogRing::Capacity / 4) {
+        SDL_AtomicIncRef(&DroppedMessages);
+        return nullptr;
+    }
+
+    uint32_t head = (uint32_t)SDL_AtomicGet(&ring->head);
+    uint32_t tail = (uint32_t)SDL_AtomicGet(&ring->tail);
+    uint32_t offset = head & (OFS_LogRing::Capacity - 1);
+    // records are never split, the rest of the ring gets skipped instead
+    uint32_t padding = offset + size > OFS_LogRing::Capacity ? OFS_LogRing::Capacity - offset : 0;
+    if (head + padding + size - tail > OFS_LogRing::Capacity) {
+        SDL_AtomicIncRef(&DroppedMessages);
+        return nullptr;
+    }
+
+    if (padding > 0) {
+        auto pad = (OFS_LogRecord*)(ring->data + offset);
+        pad->size = OFS_LogRecord::Padding;
+        offset = 0;
+        // the consumer only sees the padding together with the record
+        SDL_AtomicSet(&ring->head, (int)(head + padding));
+    }
+    auto record = (OFS_LogRecord*)(ring->data + offset);
+    record->size = size;
+    return record;
 }
 
-void OFS_FileLogger::DrawLogWindow(bool* open) noexcept
+void OFS_FileLogger::commitRecord(OFS_LogRecord* record, OFS_LogLevel level) noexcept
 {
-    if (!*open) return;
-    OFS_MainLog.Draw(TR_ID("OFS_LOG_OUTPUT", Tr::OFS_LOG_OUTPUT), open);
+    auto ring = ThreadRing.ring;
+    record->timeMs = SDL_GetTicks();
+    record->sequence = (uint32_t)SDL_AtomicAdd(&LogSequence, 1);
+    uint32_t head = (uint32_t)SDL_AtomicGet(&ring->head);
+    SDL_AtomicSet(&ring->head, (int)(head + record->size));
+    if (level == OFS_LogLevel::OFS_LOG_ERROR && Thread.WaitFlush) {
+        SDL_CondSignal(Thread.WaitFlush);
+    }
 }
 
-inline static void LogToConsole(OFS_LogLevel level, const char* msg) noexcept
+inline static const char* LevelName(OFS_LogLevel level) noexcept
 {
-    OFS_PROFILE(__FUNCTION__);
     switch (level) {
-        case OFS_LogLevel::OFS_LOG_INFO:
-            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, msg);
-            OFS_MainLog.AddLog("[INFO]: %s\n", msg);
-            break;
-        case OFS_LogLevel::OFS_LOG_WARN:
-            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, msg);
-            OFS_MainLog.AddLog("[WARN]: %s\n", msg);
-            break;
-        case OFS_LogLevel::OFS_LOG_DEBUG:
-            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, msg);
-            OFS_MainLog.AddLog("[DEBUG]: %s\n", msg);
-            break;
-        case OFS_LogLevel::OFS_LOG_ERROR:
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, msg);
-            OFS_MainLog.AddLog("[ERROR]: %s\n", msg);
-            break;
+        case OFS_LogLevel::OFS_LOG_INFO: return "INFO ";
+        case OFS_LogLevel::OFS_LOG_WARN: return "WARN ";
+        case OFS_LogLevel::OFS_LOG_DEBUG: return "DEBUG";
+        case OFS_LogLevel::OFS_LOG_ERROR: return "ERROR";
     }
+    return "-----";
 }
 
-inline static void AppendToBuf(std::vector<char>& buffer, const char* msg, uint32_t size) noexcept
+// Formats one conversion at a time, the length modifier is replaced to match how the argument was stored.
+static void FormatRecord(std::string& out, const char* fmt, const char* args, const char* argsEnd) noexcept
 {
-    OFS_PROFILE(__FUNCTION__);
-    auto initialSize = buffer.size();
-    buffer.resize(initialSize + size);
-    memcpy(buffer.data() + initialSize, msg, size);
-};
+    char spec[32];
+    char buffer[512];
+    const char* p = fmt;
+    while (*p) {
+        if (*p != '%') {
+            const char* start = p;
+            while (*p && *p != '%') p += 1;
+            out.append(start, p - start);
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            p += 2;
+            continue;
+        }
 
-inline static void AddNewLine() noexcept
-{
-    OFS_PROFILE(__FUNCTION__);
-    // insert a newline if needed
-    auto& buffer = Thread.LogMsgBuffer;
-    if (!buffer.empty() && buffer.back() != '\n') {
-        buffer.resize(buffer.size() + 1);
-        buffer.back() = '\n';
+        const char* specStart = p++;
+        while (*p && strchr("-+ #0", *p)) p += 1;
+        while (std::isdigit((unsigned char)*p)) p += 1;
+        if (*p == '.') {
+            p += 1;
+            while (std::isdigit((unsigned char)*p)) p += 1;
+        }
+        const char* lengthStart = p;
+        while (*p && strchr("hljztL", *p)) p += 1;
+        char conversion = *p;
+        if (!conversion) break;
+        p += 1;
+
+        size_t specLength = lengthStart - specStart;
+        if (args >= argsEnd || specLength + 4 > sizeof(spec)) {
+            out += "<?>";
+            continue;
+        }
+        memcpy(spec, specStart, specLength);
+        auto appendSpec = [&](const char* modifier, char conversion) noexcept {
+            size_t length = strlen(modifier);
+            memcpy(spec + specLength, modifier, length);
+            spec[specLength + length] = conversion;
+            spec[specLength + length + 1] = '\0';
+        };
+        bool isInteger = strchr("diouxXc", conversion) != nullptr;
+        bool isFloat = strchr("fFeEgGaA", conversion) != nullptr;
+
+        int length = -1;
+        auto tag = (OFS_LogArgs::Tag)*args++;
+        switch (tag) {
+            case OFS_LogArgs::Int:
+            case OFS_LogArgs::Uint:
+            case OFS_LogArgs::Double:
+            case OFS_LogArgs::Pointer:
+            {
+                uint64_t bits;
+                memcpy(&bits, args, sizeof(bits));
+                args += sizeof(bits);
+                int64_t i;
+                double d;
+                memcpy(&i, &bits, sizeof(i));
+                memcpy(&d, &bits, sizeof(d));
+                if (tag == OFS_LogArgs::Double) {
+                    if (isFloat) { appendSpec("", conversion); length = stbsp_snprintf(buffer, sizeof(buffer), spec, d); }
+                    else if (isInteger) { appendSpec("ll", 'd'); length = stbsp_snprintf(buffer, sizeof(buffer), spec, (long long)d); }
+                }
+                else if (tag == OFS_LogArgs::Pointer) {
+                    if (conversion == 'p') { appendSpec("", 'p'); length = stbsp_snprintf(buffer, sizeof(buffer), spec, (void*)(uintptr_t)bits); }
+                }
+                else if (conversion == 'c') {
+                    appendSpec("", 'c');
+                    length = stbsp_snprintf(buffer, sizeof(buffer), spec, (int)i);
+                }
+                else if (isInteger) {
+                    appendSpec("ll", conversion);
+                    length = tag == OFS_LogArgs::Int
+                        ? stbsp_snprintf(buffer, sizeof(buffer), spec, (long long)i)
+                        : stbsp_snprintf(buffer, sizeof(buffer), spec, (unsigned long long)bits);
+                }
+                else if (isFloat) {
+                    appendSpec("", conversion);
+                    length = stbsp_snprintf(buffer, sizeof(buffer), spec, tag == OFS_LogArgs::Int ? (double)i : (double)bits);
+                }
+                break;
+            }
+            case OFS_LogArgs::String:
+            {
+                uint32_t strLength;
+                memcpy(&strLength, args, sizeof(strLength));
+                const char* str = args + sizeof(strLength);
+                args = str + strLength + 1;
+                if (conversion != 's') break;
+                if (specLength == 1) {
+                    out.append(str, strLength);
+                    continue;
+                }
+                appendSpec("", 's');
+                length = stbsp_snprintf(buffer, sizeof(buffer), spec, str);
+                break;
+            }
+            default:
+                // can't know the size of an unknown tag
+                out += "<?>";
+                return;
+        }
+        if (length < 0) out += "<?>";
+        else out.append(buffer, Util::Min<size_t>(length, sizeof(buffer) - 1));
     }
 }
 
-void OFS_FileLogger::LogToFileR(const char* prefix, const char* msg, bool newLine) noexcept
+struct PendingRecord {
+    uint64_t sequence;
+    const OFS_LogRecord* record;
+};
+
+// Logger thread. Formats everything which was logged so far, oldest message first.
+static void DrainRings(std::string& fileText) noexcept
 {
     OFS_PROFILE(__FUNCTION__);
-    SDL_Log("%s %s", prefix, msg);
-    SDL_AtomicLock(&Thread.lock);
-
-    auto& buffer = Thread.LogMsgBuffer;
-    AppendToBuf(buffer, prefix, strlen(prefix));
-    AppendToBuf(buffer, msg, strlen(msg));
+    static std::vector<PendingRecord> pending;
+    static std::string line;
+    uint32_t heads[MaxLogRings];
+    int ringCount = SDL_AtomicGet(&LogRingCount);
 
-    if (newLine) {
-        AddNewLine();
+    pending.clear();
+    for (int i = 0; i < ringCount; i += 1) {
+        auto ring = LogRings[i];
+        uint32_t head = (uint32_t)SDL_AtomicGet(&ring->head);
+        uint32_t tail = (uint32_t)SDL_AtomicGet(&ring->tail);
+        heads[i] = head;
+        while (tail != head) {
+            auto record = (const OFS_LogRecord*)(ring->data + (tail & (OFS_LogRing::Capacity - 1)));
+            if (record->size == OFS_LogRecord::Padding) {
+                tail += OFS_LogRing::Capacity - (tail & (OFS_LogRing::Capacity - 1));
+                continue;
+            }
+            pending.emplace_back(PendingRecord{ record->sequence, record });
+            tail += record->size;
+        }
     }
+    std::sort(pending.begin(), pending.end(),
+        [](auto& a, auto& b) { return a.sequence < b.sequence; });
 
-    SDL_AtomicUnlock(&Thread.lock);
-}
+    std::string windowText;
+    for (auto& entry : pending) {
+        auto record = entry.record;
+        line.clear();
+        auto args = (const char*)(record + 1);
+        auto argsEnd = (const char*)record + record->size;
+        if (record->fmt) {
+            FormatRecord(line, record->fmt, args, argsEnd);
+        }
+        else {
+            // raw messages are a prefix and the message
+            FormatRecord(line, "%s%s", args, argsEnd);
+        }
+        if (record->suppressed > 0) {
+            char suppressed[64];
+            int length = stbsp_snprintf(suppressed, sizeof(suppressed), " (%u similar messages suppressed)", record->suppressed);
+            if (!line.empty() && line.back() == '\n') line.pop_back();
+            line.append(suppressed, length);
+        }
+        if (line.empty() || line.back() != '\n') line += '\n';
 
-void OFS_FileLogger::LogToFileR(OFS_LogLevel level, const char* msg, uint32_t size, bool newLine) noexcept
-{
-    OFS_PROFILE(__FUNCTION__);
-    LogToConsole(level, msg);
-    SDL_AtomicLock(&Thread.lock);
+        if (!record->fmt) {
+            SDL_Log("%s", line.c_str());
+            fileText += line;
+            continue;
+        }
 
-    auto& buffer = Thread.LogMsgBuffer;
-    {
-        constexpr const char* fmt = "[%6.3f][%s]: ";
-        char fileFmt[32];
-        int msgTypeLen;
-        const float time = SDL_GetTicks() / 1000.f;
-        switch (level) {
+        char header[32];
+        int headerLength = stbsp_snprintf(header, sizeof(header), "[%6.3f][%s]: ", record->timeMs / 1000.f, LevelName(record->level));
+        fileText.append(header, headerLength);
+        fileText += line;
+
+        switch (record->level) {
             case OFS_LogLevel::OFS_LOG_INFO:
-                msgTypeLen = stbsp_snprintf(fileFmt, sizeof(fileFmt), fmt, time, "INFO ");
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%s", line.c_str());
+                windowText += "[INFO]: ";
                 break;
             case OFS_LogLevel::OFS_LOG_WARN:
-                msgTypeLen = stbsp_snprintf(fileFmt, sizeof(fileFmt), fmt, time, "WARN ");
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", line.c_str());
+                windowText += "[WARN]: ";
                 break;
             case OFS_LogLevel::OFS_LOG_DEBUG:
-                msgTypeLen = stbsp_snprintf(fileFmt, sizeof(fileFmt), fmt, time, "DEBUG");
+                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "%s", line.c_str());
+                windowText += "[DEBUG]: ";
                 break;
             case OFS_LogLevel::OFS_LOG_ERROR:
-                msgTypeLen = stbsp_snprintf(fileFmt, sizeof(fileFmt), fmt, time, "ERROR");
-                break;
-            default:
-                msgTypeLen = stbsp_snprintf(fileFmt, sizeof(fileFmt), fmt, time, "-----");
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", line.c_str());
+                windowText += "[ERROR]: ";
                 break;
         }
-        AppendToBuf(buffer, fileFmt, msgTypeLen);
+        windowText += line;
     }
 
-    size = size == 0 ? strlen(msg) : size;
-    AppendToBuf(buffer, msg, size);
+    // only now the producers may reuse the space
+    for (int i = 0; i < ringCount; i += 1) {
+        SDL_AtomicSet(&LogRings[i]->tail, (int)heads[i]);
+    }
+
+    uint32_t dropped = (uint32_t)SDL_AtomicSet(&DroppedMessages, 0);
+    if (dropped > 0) {
+        char droppedMsg[64];
+        int length = stbsp_snprintf(droppedMsg, sizeof(droppedMsg), "%u log messages were dropped\n", dropped);
+        fileText.append(droppedMsg, length);
+        windowText.append("[WARN]: ").append(droppedMsg, length);
+    }
+
+    if (!windowText.empty()) {
+        SDL_AtomicLock(&Thread.windowLock);
+        if (Thread.windowText.size() + windowText.size() <= MaxLogWindowBytes) {
+            Thread.windowText += windowText;
+        }
+        SDL_AtomicUnlock(&Thread.windowLock);
+    }
+}
+
+static int LogThreadFunction(void* threadData) noexcept
+{
+    auto& thread = *(OFS_LogThread*)threadData;
+    std::string fileText;
+    SDL_LockMutex(thread.waitMut);
+    for (;;) {
+        // background threads get written even when nobody calls Flush
+        SDL_CondWaitTimeout(thread.WaitFlush, thread.waitMut, 100);
+        bool exit = thread.ShouldExit;
+        fileText.clear();
+        DrainRings(fileText);
+        if (!fileText.empty() && OFS_FileLogger::LogFileHandle) {
+            SDL_RWwrite(OFS_FileLogger::LogFileHandle, fileText.data(), 1, fileText.size());
+        }
+        if (exit) break;
+    }
+    SDL_UnlockMutex(thread.waitMut);
+    return 0;
+}
+
+void OFS_FileLogger::Init(const char* logFileName) noexcept
+{
+    if (LogFileHandle) return;
+#ifndef NDEBUG
+    SDL_LogSetAllPriority(SDL_LOG_PRIORITY_VERBOSE);
+#endif
+    auto LogFilePath = Util::Prefpath(logFileName);
+    LogFileHandle = SDL_RWFromFile(LogFilePath.c_str(), "w");
 
-    if (newLine) {
-        AddNewLine();
+    Thread.waitMut = SDL_CreateMutex();
+    Thread.WaitFlush = SDL_CreateCond();
+    Thread.thread = SDL_CreateThread(LogThreadFunction, "MessageLogging", &Thread);
+}
+
+void OFS_FileLogger::Shutdown() noexcept
+{
+    if (!Thread.thread) return;
+    // the thread drains everything once more before exiting
+    Thread.ShouldExit = true;
+    SDL_CondSignal(Thread.WaitFlush);
+    SDL_WaitThread(Thread.thread, nullptr);
+    Thread.thread = nullptr;
+    SDL_DestroyCond(Thread.WaitFlush);
+    Thread.WaitFlush = nullptr;
+    SDL_DestroyMutex(Thread.waitMut);
+    Thread.waitMut = nullptr;
+    if (LogFileHandle) {
+        SDL_RWclose(LogFileHandle);
+        LogFileHandle = nullptr;
+    }
+}
+
+void OFS_FileLogger::DrawLogWindow(bool* open) noexcept
+{
+    SDL_AtomicLock(&Thread.windowLock);
+    if (!Thread.windowText.empty()) {
+        if (OFS_MainLog.LogSizeBytes() > MaxLogWindowBytes) {
+            OFS_MainLog.Clear();
+        }
+        OFS_MainLog.AddLog("%s", Thread.windowText.c_str());
+        Thread.windowText.clear();
     }
+    SDL_AtomicUnlock(&Thread.windowLock);
+
+    if (!*open) return;
+    OFS_MainLog.Draw(TR_ID("OFS_LOG_OUTPUT", Tr::OFS_LOG_OUTPUT), open);
+}
 
-    SDL_AtomicUnlock(&Thread.lock);
+void OFS_FileLogger::LogToFileR(const char* prefix, const char* msg, bool newLine) noexcept
+{
+    Log(nullptr, OFS_LogLevel::OFS_LOG_INFO, nullptr, prefix, msg);
+}
+
+void OFS_FileLogger::LogToFileR(OFS_LogLevel level, const char* msg, uint32_t size, bool newLine) noexcept
+{
+    if (!Enabled(level)) return;
+    if (size == 0 || msg[size] == '\0') {
+        Log(nullptr, level, "%s", msg);
+        return;
+    }
+    std::string copy(msg, size);
+    Log(nullptr, level, "%s", copy.c_str());
 }
 
 void OFS_FileLogger::Flush() noexcept
 {
-    if (!Thread.LogMsgBuffer.empty()) SDL_CondSignal(Thread.WaitFlush);
+    if (Thread.WaitFlush) SDL_CondSignal(Thread.WaitFlush);
 }
 
 void OFS_FileLogger::LogToFileF(OFS_LogLevel level, const char* fmt, ...) noexcept
 {
-    OFS_PROFILE(__FUNCTION__);
+    if (!Enabled(level)) return;
     char FormatBuffer[1024];
     va_list args;
     va_start(args, fmt);
-    auto len = stbsp_vsnprintf(FormatBuffer, sizeof(FormatBuffer), fmt, args);
+    stbsp_vsnprintf(FormatBuffer, sizeof(FormatBuffer), fmt, args);
     va_end(args);
-    LogToFileR(level, FormatBuffer, len > sizeof(FormatBuffer) ? sizeof(FormatBuffer) : len);
-}
\ No newline at end of file
+    Log(nullptr, level, "%s", FormatBuffer);
+}
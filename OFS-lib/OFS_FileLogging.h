@@ -1,6 +1,10 @@
 #pragma once
 #include <cstdint>
 #include <cstdarg>
+#include <cstring>
+#include <type_traits>
+
+#include "SDL_atomic.h"
 
 enum class OFS_LogLevel : int32_t {
     OFS_LOG_INFO,
@@ -9,40 +13,189 @@ enum class OFS_LogLevel : int32_t {
     OFS_LOG_ERROR,
 };
 
+// the enum isn't ordered by importance
+constexpr int32_t OFS_LogSeverity(OFS_LogLevel level) noexcept
+{
+    switch (level) {
+        case OFS_LogLevel::OFS_LOG_DEBUG: return 0;
+        case OFS_LogLevel::OFS_LOG_INFO: return 1;
+        case OFS_LogLevel::OFS_LOG_WARN: return 2;
+        case OFS_LogLevel::OFS_LOG_ERROR: return 3;
+    }
+    return 3;
+}
+
+// Messages below this severity aren't compiled in.
+#ifndef OFS_LOG_MIN_SEVERITY
+#ifndef NDEBUG
+#define OFS_LOG_MIN_SEVERITY 0
+#else
+#define OFS_LOG_MIN_SEVERITY 1
+#endif
+#endif
+
+// One per logging call site, limits how many messages it can emit per second.
+struct OFS_LogSite {
+    SDL_atomic_t second;
+    SDL_atomic_t count;
+    SDL_atomic_t suppressed;
+};
+
+// Single producer ring owned by one thread, drained by the logger thread.
+struct OFS_LogRing {
+    static constexpr uint32_t Capacity = 64 * 1024;
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+    // both only grow, the position in data is the value modulo Capacity
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+    SDL_atomic_t inUse;
+    alignas(8) char data[Capacity];
+};
+
+// Record layout in the ring, followed by the encoded arguments.
+struct OFS_LogRecord {
+    static constexpr uint32_t Padding = 0xFFFF'FFFF;
+    // in bytes including this header, Padding marks unused space at the end of the ring
+    uint32_t size;
+    OFS_LogLevel level;
+    uint32_t timeMs;
+    uint32_t suppressed;
+    uint64_t sequence;
+    // string literal or nullptr for raw messages which don't get a level prefix
+    const char* fmt;
+};
+
+// Arguments are stored as a tag and their value, strings get copied.
+namespace OFS_LogArgs {
+    enum Tag : uint8_t {
+        Int,
+        Uint,
+        Double,
+        String,
+        Pointer,
+    };
+    constexpr uint32_t MaxStringLength = 8 * 1024;
+
+    template<typename T>
+    inline uint32_t Size(const T& value) noexcept
+    {
+        using V = std::decay_t<T>;
+        if constexpr (std::is_same_v<V, char*> || std::is_same_v<V, const char*>) {
+            uint32_t length = value ? (uint32_t)strnlen(value, MaxStringLength) : 6;
+            return 1 + sizeof(uint32_t) + length + 1;
+        }
+        else {
+            return 1 + sizeof(uint64_t);
+        }
+    }
+
+    template<typename T>
+    inline char* Write(char* out, const T& value) noexcept
+    {
+        using V = std::decay_t<T>;
+        auto writeValue = [](char* out, Tag tag, const auto& value) noexcept {
+            *out = tag;
+            memcpy(out + 1, &value, sizeof(value));
+            return out + 1 + sizeof(value);
+        };
+        if constexpr (std::is_same_v<V, char*> || std::is_same_v<V, const char*>) {
+            const char* str = value ? value : "(null)";
+            uint32_t length = (uint32_t)strnlen(str, MaxStringLength);
+            *out = String;
+            memcpy(out + 1, &length, sizeof(length));
+            memcpy(out + 1 + sizeof(length), str, length);
+            out[1 + sizeof(length) + length] = '\0';
+            return out + 1 + sizeof(length) + length + 1;
+        }
+        else if constexpr (std::is_floating_point_v<V>) {
+            return writeValue(out, Double, (double)value);
+        }
+        else if constexpr (std::is_enum_v<V> || std::is_same_v<V, bool> || (std::is_integral_v<V> && std::is_signed_v<V>)) {
+            return writeValue(out, Int, (int64_t)value);
+        }
+        else if constexpr (std::is_integral_v<V>) {
+            return writeValue(out, Uint, (uint64_t)value);
+        }
+        else if constexpr (std::is_pointer_v<V> || std::is_null_pointer_v<V>) {
+            return writeValue(out, Pointer, (uint64_t)(uintptr_t)value);
+        }
+        else {
+            static_assert(std::is_pointer_v<V>, "unsupported log argument");
+            return out;
+        }
+    }
+}
+
+// Logging only copies the arguments into a per thread ring,
+// formatting and writing to the console, file and log window happens on the logger thread.
 class OFS_FileLogger {
 public:
-    static constexpr int MaxLogThreads = 1;
+    // per call site
+    static constexpr int32_t MaxMessagesPerSecond = 20;
     static struct SDL_RWops* LogFileHandle;
+    // runtime filter, compared against OFS_LogSeverity
+    static SDL_atomic_t MinSeverity;
 
-    static void Init() noexcept;
+    // logFileName is relative to the preference path
+    static void Init(const char* logFileName = "OFS.log") noexcept;
     static void Shutdown() noexcept;
 
     static void Flush() noexcept;
     static void DrawLogWindow(bool* open) noexcept;
 
+    inline static bool Enabled(OFS_LogLevel level) noexcept
+    {
+        return OFS_LogSeverity(level) >= SDL_AtomicGet(&MinSeverity);
+    }
+
+    template<typename... Args>
+    static void Log(OFS_LogSite* site, OFS_LogLevel level, const char* fmt, const Args&... args) noexcept
+    {
+        uint32_t suppressed = 0;
+        if (site && !allow(*site, suppressed)) return;
+
+        uint32_t size = sizeof(OFS_LogRecord);
+        ((size += OFS_LogArgs::Size(args)), ...);
+        auto record = beginRecord(size);
+        if (!record) return;
+        record->level = level;
+        record->suppressed = suppressed;
+        record->fmt = fmt;
+        char* out = (char*)(record + 1);
+        ((out = OFS_LogArgs::Write(out, args)), ...);
+        (void)out;
+        commitRecord(record, level);
+    }
+
     static void LogToFileR(const char* prefix, const char* msg, bool newLine = true) noexcept;
     static void LogToFileR(OFS_LogLevel level, const char* msg, uint32_t size = 0, bool newLine = true) noexcept;
     static void LogToFileF(OFS_LogLevel level, const char* fmt, ...) noexcept;
+
+private:
+    static bool allow(OFS_LogSite& site, uint32_t& outSuppressed) noexcept;
+    // returns nullptr when the message has to be dropped
+    static OFS_LogRecord* beginRecord(uint32_t size) noexcept;
+    static void commitRecord(OFS_LogRecord* record, OFS_LogLevel level) noexcept;
 };
 
-#ifndef NDEBUG
-#define LOG_INFO(msg) OFS_FileLogger::LogToFileR(OFS_LogLevel::OFS_LOG_INFO, msg)
-#define LOG_WARN(msg) OFS_FileLogger::LogToFileR(OFS_LogLevel::OFS_LOG_WARN, msg)
-#define LOG_DEBUG(msg) OFS_FileLogger::LogToFileR(OFS_LogLevel::OFS_LOG_DEBUG, msg)
-#define LOG_ERROR(msg) OFS_FileLogger::LogToFileR(OFS_LogLevel::OFS_LOG_ERROR, msg)
-
-#define LOGF_INFO(fmt, ...) OFS_FileLogger::LogToFileF(OFS_LogLevel::OFS_LOG_INFO, fmt, __VA_ARGS__)
-#define LOGF_WARN(fmt, ...) OFS_FileLogger::LogToFileF(OFS_LogLevel::OFS_LOG_WARN, fmt, __VA_ARGS__)
-#define LOGF_DEBUG(fmt, ...) OFS_FileLogger::LogToFileF(OFS_LogLevel::OFS_LOG_DEBUG, fmt, __VA_ARGS__)
-#define LOGF_ERROR(fmt, ...) OFS_FileLogger::LogToFileF(OFS_LogLevel::OFS_LOG_ERROR, fmt, __VA_ARGS__)
-#else
-#define LOG_INFO(msg) OFS_FileLogger::LogToFileR(OFS_LogLevel::OFS_LOG_INFO, msg)
-#define LOG_WARN(msg) OFS_FileLogger::LogToFileR(OFS_LogLevel::OFS_LOG_WARN, msg)
-#define LOG_DEBUG(msg)
-#define LOG_ERROR(msg) OFS_FileLogger::LogToFileR(OFS_LogLevel::OFS_LOG_ERROR, msg)
-
-#define LOGF_INFO(fmt, ...) OFS_FileLogger::LogToFileF(OFS_LogLevel::OFS_LOG_INFO, fmt, __VA_ARGS__)
-#define LOGF_WARN(fmt, ...) OFS_FileLogger::LogToFileF(OFS_LogLevel::OFS_LOG_WARN, fmt, __VA_ARGS__)
-#define LOGF_DEBUG(fmt, ...)
-#define LOGF_ERROR(fmt, ...) OFS_FileLogger::LogToFileF(OFS_LogLevel::OFS_LOG_ERROR, fmt, __VA_ARGS__)
-#endif
\ No newline at end of file
+// fmt has to be a string literal, it's only read once the logger thread formats the message
+#define OFS_LOG_AT(level, fmt, ...) \
+    do { \
+        if constexpr (OFS_LogSeverity(level) >= OFS_LOG_MIN_SEVERITY) { \
+            if (OFS_FileLogger::Enabled(level)) { \
+                static OFS_LogSite ofsLogSite = {}; \
+                OFS_FileLogger::Log(&ofsLogSite, level, "" fmt, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOG_INFO(msg) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_INFO, "%s", (const char*)(msg))
+#define LOG_WARN(msg) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_WARN, "%s", (const char*)(msg))
+#define LOG_DEBUG(msg) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_DEBUG, "%s", (const char*)(msg))
+#define LOG_ERROR(msg) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_ERROR, "%s", (const char*)(msg))
+
+#define LOGF_INFO(fmt, ...) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_INFO, fmt, __VA_ARGS__)
+#define LOGF_WARN(fmt, ...) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_WARN, fmt, __VA_ARGS__)
+#define LOGF_DEBUG(fmt, ...) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_DEBUG, fmt, __VA_ARGS__)
+#define LOGF_ERROR(fmt, ...) OFS_LOG_AT(OFS_LogLevel::OFS_LOG_ERROR, fmt, __VA_ARGS__)
@@ -0,0 +1,131 @@
+#include "OFS_FrameArena.h"
+#include "OFS_Util.h"
+
+#include "stb_sprintf.h"
+
+#include <climits>
+
+// the arena doesn't grow beyond this, bigger frames keep overflowing to the heap
+static constexpr size_t MaxCapacity = 64 * 1024 * 1024;
+
+SDL_atomic_t OFS_FrameArena::HeapAllocations = {0};
+
+thread_local bool OFS_FrameArena::owner = false;
+uint8_t* OFS_FrameArena::buffer = nullptr;
+size_t OFS_FrameArena::capacity = 0;
+size_t OFS_FrameArena::offset = 0;
+std::vector<void*> OFS_FrameArena::overflow;
+size_t OFS_FrameArena::overflowBytes = 0;
+
+OFS_FrameArena::FrameStats OFS_FrameArena::current;
+OFS_FrameArena::FrameStats OFS_FrameArena::last;
+uint32_t OFS_FrameArena::heapAllocationsAtFrameStart = 0;
+
+void OFS_FrameArena::Init(size_t initialCapacity) noexcept
+{
+    FUN_ASSERT(!buffer, "frame arena was already initialized");
+    capacity = initialCapacity;
+    buffer = static_cast<uint8_t*>(::operator new(capacity));
+    offset = 0;
+    overflow.reserve(64);
+    heapAllocationsAtFrameStart = SDL_AtomicGet(&HeapAllocations);
+    owner = true;
+}
+
+void OFS_FrameArena::Shutdown() noexcept
+{
+    if (!owner) return;
+    for (auto ptr : overflow) ::operator delete(ptr);
+    overflow.clear();
+    ::operator delete(buffer);
+    buffer = nullptr;
+    capacity = 0;
+    offset = 0;
+    owner = false;
+}
+
+void OFS_FrameArena::EndFrame() noexcept
+{
+    if (!owner) return;
+    uint32_t heapAllocations = SDL_AtomicGet(&HeapAllocations);
+    current.heapAllocations = heapAllocations - heapAllocationsAtFrameStart;
+    heapAllocationsAtFrameStart = heapAllocations;
+    last = current;
+    current = FrameStats();
+
+    if (!overflow.empty()) {
+        for (auto ptr : overflow) ::operator delete(ptr);
+        overflow.clear();
+
+        // sized for the whole frame, the next one most likely looks the same
+        size_t needed = offset + overflowBytes;
+        size_t newCapacity = capacity;
+        while (newCapacity < needed && newCapacity < MaxCapacity) newCapacity *= 2;
+        if (newCapacity != capacity) {
+            ::operator delete(buffer);
+            buffer = static_cast<uint8_t*>(::operator new(newCapacity));
+            capacity = newCapacity;
+            LOGF_DEBUG("Frame arena grew to %zu KB", capacity / 1024);
+        }
+        overflowBytes = 0;
+    }
+    offset = 0;
+}
+
+void* OFS_FrameArena::Allocate(size_t size, size_t align) noexcept
+{
+    if (!owner) return ::operator new(size);
+    FUN_ASSERT(align <= alignof(std::max_align_t), "over-aligned allocations aren't supported");
+
+    current.allocations += 1;
+    current.bytes += (uint32_t)size;
+    size_t start = (offset + (align - 1)) & ~(align - 1);
+    if (start + size <= capacity) {
+        offset = start + size;
+        return buffer + start;
+    }
+
+    current.overflows += 1;
+    overflowBytes += size;
+    void* ptr = ::operator new(size);
+    overflow.emplace_back(ptr);
+    return ptr;
+}
+
+void OFS_FrameArena::Free(void* ptr, size_t size) noexcept
+{
+    if (!owner) {
+        ::operator delete(ptr);
+        return;
+    }
+    // anything else, including overflow blocks, is released by EndFrame
+    auto bytes = static_cast<uint8_t*>(ptr);
+    if (bytes >= buffer && bytes + size == buffer + offset) {
+        offset = bytes - buffer;
+    }
+}
+
+const char* OFS_FrameArena::FormatV(const char* fmt, va_list args) noexcept
+{
+    FUN_ASSERT(owner, "only the main thread formats into the frame arena");
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+
+    // formatted straight into the free space, a second pass is only needed if it didn't fit
+    size_t available = Util::Min<size_t>(capacity - offset, INT_MAX);
+    char* str = reinterpret_cast<char*>(buffer + offset);
+    int length = available > 0
+        ? stbsp_vsnprintf(str, (int)available, fmt, args)
+        : stbsp_vsnprintf(nullptr, 0, fmt, args);
+    if ((size_t)length < available) {
+        offset += length + 1;
+        current.allocations += 1;
+        current.bytes += length + 1;
+    }
+    else {
+        str = static_cast<char*>(Allocate(length + 1, 1));
+        stbsp_vsnprintf(str, length + 1, fmt, argsCopy);
+    }
+    va_end(argsCopy);
+    return str;
+}
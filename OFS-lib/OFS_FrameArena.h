@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdarg>
+#include <vector>
+#include <new>
+
+#include "SDL_atomic.h"
+
+// Bump allocator for data which doesn't outlive the current frame.
+// Only the main thread allocates from it and EndFrame releases everything at once.
+// Other threads, and tools which never call Init, get plain heap allocations instead.
+class OFS_FrameArena
+{
+public:
+    struct FrameStats
+    {
+        uint32_t allocations = 0;
+        uint32_t bytes = 0;
+        // allocations which didn't fit and went to the heap, the arena grows for the next frame
+        uint32_t overflows = 0;
+        // all heap allocations of the process during the frame, see HeapAllocations (debug builds)
+        uint32_t heapAllocations = 0;
+    };
+
+    // Incremented by the global operator new of the application in debug builds, stays at zero otherwise.
+    static SDL_atomic_t HeapAllocations;
+
+private:
+    static constexpr size_t DefaultCapacity = 1024 * 1024;
+
+    static thread_local bool owner;
+    static uint8_t* buffer;
+    static size_t capacity;
+    static size_t offset;
+    static std::vector<void*> overflow;
+    static size_t overflowBytes;
+
+    static FrameStats current;
+    static FrameStats last;
+    static uint32_t heapAllocationsAtFrameStart;
+
+public:
+    // The calling thread becomes the owner.
+    static void Init(size_t initialCapacity = DefaultCapacity) noexcept;
+    static void Shutdown() noexcept;
+    // Everything allocated so far becomes invalid.
+    static void EndFrame() noexcept;
+
+    inline static bool IsOwner() noexcept { return owner; }
+    inline static const FrameStats& LastFrameStats() noexcept { return last; }
+
+    static void* Allocate(size_t size, size_t align) noexcept;
+    // Only the most recent allocation is given back, which lets a growing vector reuse its space.
+    static void Free(void* ptr, size_t size) noexcept;
+
+    // Formatted string which is valid until the end of the frame.
+    static const char* FormatV(const char* fmt, va_list args) noexcept;
+};
+
+// STL allocator on top of the frame arena.
+// Containers using it have to be local to a frame and must not be passed to other threads.
+template<typename T>
+struct OFS_FrameAllocator
+{
+    using value_type = T;
+
+    OFS_FrameAllocator() noexcept = default;
+    template<typename U>
+    OFS_FrameAllocator(const OFS_FrameAllocator<U>&) noexcept {}
+
+    inline T* allocate(size_t n) noexcept
+    {
+        return static_cast<T*>(OFS_FrameArena::Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    inline void deallocate(T* ptr, size_t n) noexcept
+    {
+        OFS_FrameArena::Free(ptr, n * sizeof(T));
+    }
+
+    template<typename U>
+    inline bool operator==(const OFS_FrameAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    inline bool operator!=(const OFS_FrameAllocator<U>&) const noexcept { return false; }
+};
+
+template<typename T>
+using OFS_FrameVector = std::vector<T, OFS_FrameAllocator<T>>;
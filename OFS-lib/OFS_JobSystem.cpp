@@ -0,0 +1,409 @@
+#include "OFS_JobSystem.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+#include "OFS_Localization.h"
+#include "OFS_EventSystem.h"
+#include "OFS_Event.h"
+#include "OFS_Redraw.h"
+#include "OFS_FrameArena.h"
+
+#include "imgui.h"
+
+#include "SDL_timer.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "subprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+// finished jobs are kept around for the job list until there are more than this
+static constexpr size_t MaxFinishedJobs = 64;
+
+SDL_SpinLock OFS_JobSystem::jobsLock = 0;
+std::vector<OFS_JobHandle> OFS_JobSystem::jobs;
+
+// Started with the first process lane job
+struct OFS_ProcessLane
+{
+    SDL_SpinLock startLock = 0;
+    SDL_mutex* mutex = nullptr;
+    SDL_cond* wake = nullptr;
+    std::deque<OFS_JobHandle> queues[(int)OFS_ThreadPool::Priority::Count];
+    std::vector<SDL_Thread*> threads;
+    bool shutdown = false;
+};
+static OFS_ProcessLane ProcessLane;
+
+void OFS_Job::Cancel() noexcept
+{
+    if (!cancellable || IsFinished()) return;
+    SDL_AtomicSet(&cancel, 1);
+    OFS_Redraw::Request(1);
+}
+
+void OFS_Job::SetProgress(int newProgress, int newMaxProgress) noexcept
+{
+    SDL_AtomicSet(&maxProgress, newMaxProgress);
+    if (SDL_AtomicSet(&progress, newProgress) != newProgress) {
+        OFS_Redraw::Request(1);
+    }
+}
+
+float OFS_Job::Progress() noexcept
+{
+    int max = SDL_AtomicGet(&maxProgress);
+    if (max <= 0) return -1.f;
+    return Util::Clamp(SDL_AtomicGet(&progress) / (float)max, 0.f, 1.f);
+}
+
+bool OFS_Job::JoinProcess(struct subprocess_s* proc, int* returnCode) noexcept
+{
+    while (subprocess_alive(proc) > 0) {
+        if (IsCancelled()) {
+            subprocess_terminate(proc);
+            break;
+        }
+        SDL_Delay(20);
+    }
+
+    int code = -1;
+    subprocess_join(proc, &code);
+    subprocess_destroy(proc);
+    if (returnCode) *returnCode = code;
+    return !IsCancelled() && code == 0;
+}
+
+OFS_JobHandle OFS_JobSystem::Submit(OFS_JobDesc&& desc) noexcept
+{
+    FUN_ASSERT(OFS_ThreadPool::Get(), "thread pool has to be initialized first");
+    FUN_ASSERT(desc.Work, "job without work");
+
+    auto job = std::make_shared<OFS_Job>();
+    job->name = std::move(desc.Name);
+    job->work = std::move(desc.Work);
+    job->then = std::move(desc.Then);
+    job->priority = desc.Priority;
+    job->lane = desc.Lane;
+    job->cancellable = desc.Cancellable;
+    job->orderOnly = desc.OrderOnly;
+
+    for (auto& dependency : desc.DependsOn) {
+        if (!dependency) continue;
+        // the state only changes to finished while holding the lock, see finish
+        SDL_AtomicLock(&dependency->dependentsLock);
+        if (!dependency->IsFinished()) {
+            SDL_AtomicAdd(&job->blockers, 1);
+            dependency->dependents.emplace_back(job);
+        }
+        else if (!dependency->Succeeded() && !job->orderOnly) {
+            SDL_AtomicSet(&job->dependencyFailed, 1);
+        }
+        SDL_AtomicUnlock(&dependency->dependentsLock);
+    }
+
+    SDL_AtomicLock(&jobsLock);
+    {
+        size_t finishedCount = std::count_if(jobs.begin(), jobs.end(),
+            [](auto& j) noexcept { return j->IsFinished(); });
+        for (auto it = jobs.begin(); it != jobs.end() && finishedCount > MaxFinishedJobs;) {
+            if ((*it)->IsFinished()) {
+                it = jobs.erase(it);
+                finishedCount -= 1;
+            }
+            else {
+                ++it;
+            }
+        }
+        jobs.emplace_back(job);
+    }
+    SDL_AtomicUnlock(&jobsLock);
+
+    release(job);
+    OFS_Redraw::Request(1);
+    return job;
+}
+
+void OFS_JobSystem::release(const OFS_JobHandle& job) noexcept
+{
+    if (SDL_AtomicAdd(&job->blockers, -1) != 1) return;
+
+    SDL_AtomicSet(&job->state, (int)OFS_Job::State::Queued);
+    if (job->lane == OFS_JobLane::Process) {
+        submitToProcessLane(job);
+    }
+    else {
+        OFS_ThreadPool::Get()->Submit([job]() noexcept { run(job); }, job->priority);
+    }
+}
+
+void OFS_JobSystem::submitToProcessLane(const OFS_JobHandle& job) noexcept
+{
+    auto& lane = ProcessLane;
+    SDL_AtomicLock(&lane.startLock);
+    if (!lane.mutex) {
+        lane.mutex = SDL_CreateMutex();
+        lane.wake = SDL_CreateCond();
+        lane.shutdown = false;
+        for (int i = 0; i < ProcessLaneThreads; i += 1) {
+            lane.threads.emplace_back(SDL_CreateThread(processLaneThread, "OFS_ProcessLane", nullptr));
+        }
+    }
+    SDL_AtomicUnlock(&lane.startLock);
+
+    SDL_LockMutex(lane.mutex);
+    lane.queues[(int)job->priority].emplace_back(job);
+    SDL_UnlockMutex(lane.mutex);
+    SDL_CondSignal(lane.wake);
+}
+
+int OFS_JobSystem::processLaneThread(void* data) noexcept
+{
+    auto& lane = ProcessLane;
+    SDL_LockMutex(lane.mutex);
+    for (;;) {
+        OFS_JobHandle job;
+        for (auto& queue : lane.queues) {
+            if (!queue.empty()) {
+                job = std::move(queue.front());
+                queue.pop_front();
+                break;
+            }
+        }
+        if (job) {
+            SDL_UnlockMutex(lane.mutex);
+            run(job);
+            job.reset();
+            SDL_LockMutex(lane.mutex);
+            continue;
+        }
+        if (lane.shutdown) break;
+        SDL_CondWait(lane.wake, lane.mutex);
+    }
+    SDL_UnlockMutex(lane.mutex);
+    return 0;
+}
+
+void OFS_JobSystem::shutdownProcessLane() noexcept
+{
+    auto& lane = ProcessLane;
+    SDL_AtomicLock(&lane.startLock);
+    if (lane.mutex) {
+        SDL_LockMutex(lane.mutex);
+        lane.shutdown = true;
+        SDL_UnlockMutex(lane.mutex);
+        SDL_CondBroadcast(lane.wake);
+        for (auto thread : lane.threads) SDL_WaitThread(thread, nullptr);
+        lane.threads.clear();
+        SDL_DestroyCond(lane.wake);
+        lane.wake = nullptr;
+        SDL_DestroyMutex(lane.mutex);
+        lane.mutex = nullptr;
+    }
+    SDL_AtomicUnlock(&lane.startLock);
+}
+
+void OFS_JobSystem::run(const OFS_JobHandle& job) noexcept
+{
+    if (job->IsCancelled() || SDL_AtomicGet(&job->dependencyFailed)) {
+        finish(job, OFS_Job::State::Cancelled);
+        return;
+    }
+
+    OFS_PROFILE_DYNAMIC(job->name.c_str(), job->name.size());
+    SDL_AtomicSet(&job->startTicks, (int)SDL_GetTicks());
+    SDL_AtomicSet(&job->state, (int)OFS_Job::State::Running);
+    OFS_Redraw::Request(1);
+
+    bool success = job->work(*job);
+    finish(job, job->IsCancelled()
+        ? OFS_Job::State::Cancelled
+        : success ? OFS_Job::State::Done : OFS_Job::State::Failed);
+}
+
+void OFS_JobSystem::finish(const OFS_JobHandle& job, OFS_Job::State result) noexcept
+{
+    // drops whatever the work function captured
+    job->work = nullptr;
+    SDL_AtomicSet(&job->endTicks, (int)SDL_GetTicks());
+
+    std::vector<OFS_JobHandle> dependents;
+    std::vector<std::function<void()>> waiters;
+    SDL_AtomicLock(&job->dependentsLock);
+    SDL_AtomicSet(&job->state, (int)result);
+    dependents.swap(job->dependents);
+    waiters.swap(job->waiters);
+    SDL_AtomicUnlock(&job->dependentsLock);
+
+    if (result == OFS_Job::State::Failed) {
+        LOGF_WARN("Job \"%s\" failed.", job->name.c_str());
+    }
+
+    for (auto& dependent : dependents) {
+        if (result != OFS_Job::State::Done && !dependent->orderOnly) {
+            SDL_AtomicSet(&dependent->dependencyFailed, 1);
+        }
+        release(dependent);
+    }
+
+    if (job->then) {
+        EV::Enqueue<OFS_DeferEvent>([job]() noexcept {
+            job->then(*job);
+            job->then = nullptr;
+        });
+    }
+    for (auto& waiter : waiters) {
+        EV::Enqueue<OFS_DeferEvent>(std::move(waiter));
+    }
+    OFS_Redraw::Request(1);
+}
+
+void OFS_JobSystem::After(const OFS_JobHandle& job, std::function<void()>&& fn) noexcept
+{
+    if (job) {
+        // the state only changes to finished while holding the lock, see finish
+        SDL_AtomicLock(&job->dependentsLock);
+        if (!job->IsFinished()) {
+            job->waiters.emplace_back(std::move(fn));
+            SDL_AtomicUnlock(&job->dependentsLock);
+            return;
+        }
+        SDL_AtomicUnlock(&job->dependentsLock);
+    }
+    fn();
+}
+
+void OFS_JobSystem::CancelAll() noexcept
+{
+    SDL_AtomicLock(&jobsLock);
+    for (auto& job : jobs) job->Cancel();
+    SDL_AtomicUnlock(&jobsLock);
+}
+
+void OFS_JobSystem::Shutdown() noexcept
+{
+    CancelAll();
+    int active = ActiveJobs();
+    if (active > 0) {
+        LOGF_INFO("Waiting for %d background jobs", active);
+    }
+    while (ActiveJobs() > 0) {
+        // helps out instead of just waiting, the workers may be busy with something long
+        if (!OFS_ThreadPool::Get()->TryRunOne()) {
+            SDL_Delay(1);
+        }
+    }
+
+    shutdownProcessLane();
+
+    SDL_AtomicLock(&jobsLock);
+    jobs.clear();
+    SDL_AtomicUnlock(&jobsLock);
+}
+
+int OFS_JobSystem::ActiveJobs() noexcept
+{
+    SDL_AtomicLock(&jobsLock);
+    int active = (int)std::count_if(jobs.begin(), jobs.end(),
+        [](auto& job) noexcept { return !job->IsFinished(); });
+    SDL_AtomicUnlock(&jobsLock);
+    return active;
+}
+
+void OFS_JobSystem::ClearFinished() noexcept
+{
+    SDL_AtomicLock(&jobsLock);
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+        [](auto& job) noexcept { return job->IsFinished(); }), jobs.end());
+    SDL_AtomicUnlock(&jobsLock);
+}
+
+static const char* StateString(OFS_Job::State state) noexcept
+{
+    switch (state) {
+        case OFS_Job::State::Waiting: return TR(JOB_WAITING);
+        case OFS_Job::State::Queued: return TR(JOB_QUEUED);
+        case OFS_Job::State::Running: return TR(JOB_RUNNING);
+        case OFS_Job::State::Done: return TR(JOB_DONE);
+        case OFS_Job::State::Failed: return TR(JOB_FAILED);
+        case OFS_Job::State::Cancelled: return TR(JOB_CANCELLED);
+    }
+    return "";
+}
+
+void OFS_JobSystem::ShowWindow(bool* open) noexcept
+{
+    if (!*open) return;
+    OFS_PROFILE(__FUNCTION__);
+
+    // copy so that workers aren't blocked while drawing
+    OFS_FrameVector<OFS_JobHandle> jobList;
+    SDL_AtomicLock(&jobsLock);
+    jobList.assign(jobs.begin(), jobs.end());
+    SDL_AtomicUnlock(&jobsLock);
+
+    ImGui::Begin(TR_ID("JOBS", Tr::JOBS), open, ImGuiWindowFlags_None);
+    bool anyRunning = false;
+    if (ImGui::Button(TR(CLEAR_FINISHED))) {
+        ClearFinished();
+    }
+
+    if (jobList.empty()) {
+        ImGui::TextDisabled("%s", TR(NO_JOBS));
+    }
+    else if (ImGui::BeginTable("##Jobs", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+        const uint32_t now = SDL_GetTicks();
+        // newest first
+        for (auto it = jobList.rbegin(); it != jobList.rend(); ++it) {
+            auto& job = *it;
+            auto state = job->GetState();
+            ImGui::PushID(job.get());
+            ImGui::TableNextRow();
+
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(job->Name().c_str());
+
+            ImGui::TableNextColumn();
+            if (job->IsCancelled() && !job->IsFinished()) {
+                ImGui::TextDisabled("%s", TR(JOB_CANCELLED));
+            }
+            else {
+                ImGui::TextUnformatted(StateString(state));
+            }
+
+            ImGui::TableNextColumn();
+            if (state == OFS_Job::State::Running) {
+                anyRunning = true;
+                float seconds = (now - (uint32_t)SDL_AtomicGet(&job->startTicks)) / 1000.f;
+                float progress = job->Progress();
+                if (progress >= 0.f) {
+                    ImGui::ProgressBar(progress, ImVec2(-1.f, 0.f), FMT("%.0f%% %.0fs", progress * 100.f, seconds));
+                }
+                else {
+                    // indeterminate
+                    ImGui::ProgressBar(std::fmod(seconds, 1.f), ImVec2(-1.f, 0.f), FMT("%.0fs", seconds));
+                }
+            }
+            else if (job->IsFinished() && SDL_AtomicGet(&job->startTicks) != 0) {
+                float seconds = (uint32_t)(SDL_AtomicGet(&job->endTicks) - SDL_AtomicGet(&job->startTicks)) / 1000.f;
+                ImGui::Text("%.2fs", seconds);
+            }
+
+            ImGui::TableNextColumn();
+            if (!job->IsFinished() && job->IsCancellable()) {
+                if (ImGui::SmallButton(TR(CANCEL))) {
+                    job->Cancel();
+                }
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+
+    if (anyRunning) {
+        // keeps the running timers going
+        OFS_Redraw::Request(1);
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "OFS_ThreadPool.h"
+
+#include "SDL_atomic.h"
+
+struct subprocess_s;
+
+class OFS_Job;
+using OFS_JobHandle = std::shared_ptr<OFS_Job>;
+
+enum class OFS_JobLane : int32_t
+{
+    // pool workers, for work which keeps a core busy
+    Cpu,
+    // dedicated threads for long running jobs, mostly ones waiting on a child process,
+    // minutes of ffmpeg or a Lua task don't hold back short cpu jobs like saving
+    Process
+};
+
+// A unit of background work tracked by the OFS_JobSystem.
+// The work function runs on a pool worker or a process lane thread and polls IsCancelled(),
+// progress is reported through SetProgress.
+class OFS_Job
+{
+public:
+    enum class State : int32_t
+    {
+        Waiting, // on dependencies
+        Queued,
+        Running,
+        Done,
+        Failed,
+        Cancelled
+    };
+
+    // returns false on failure
+    using WorkFn = std::function<bool(OFS_Job& job)>;
+    using ContinuationFn = std::function<void(OFS_Job& job)>;
+
+private:
+    friend class OFS_JobSystem;
+
+    std::string name;
+    WorkFn work;
+    ContinuationFn then;
+    OFS_ThreadPool::Priority priority = OFS_ThreadPool::Priority::Normal;
+    OFS_JobLane lane = OFS_JobLane::Cpu;
+    bool cancellable = true;
+    bool orderOnly = false;
+
+    SDL_atomic_t state = { (int)State::Waiting };
+    SDL_atomic_t cancel = {0};
+    SDL_atomic_t progress = {0};
+    SDL_atomic_t maxProgress = {0};
+    // unfinished dependencies plus one which is released by Submit
+    SDL_atomic_t blockers = {1};
+    SDL_atomic_t dependencyFailed = {0};
+
+    SDL_SpinLock dependentsLock = 0;
+    std::vector<OFS_JobHandle> dependents;
+    // OFS_JobSystem::After, also guarded by dependentsLock
+    std::vector<std::function<void()>> waiters;
+
+    // SDL_GetTicks, for the job list
+    SDL_atomic_t startTicks = {0};
+    SDL_atomic_t endTicks = {0};
+
+public:
+    inline const std::string& Name() const noexcept { return name; }
+    inline State GetState() noexcept { return (State)SDL_AtomicGet(&state); }
+    inline bool IsFinished() noexcept { return GetState() >= State::Done; }
+    inline bool Succeeded() noexcept { return GetState() == State::Done; }
+    inline bool IsCancellable() const noexcept { return cancellable; }
+
+    inline bool IsCancelled() noexcept { return SDL_AtomicGet(&cancel) != 0; }
+    void Cancel() noexcept;
+
+    // maxProgress <= 0 means the progress is unknown
+    void SetProgress(int progress, int maxProgress) noexcept;
+    // [0, 1] or -1 when unknown
+    float Progress() noexcept;
+
+    // subprocess_join which terminates the process when the job gets cancelled and destroys it.
+    // Returns true if the process exited with 0 and the job wasn't cancelled.
+    bool JoinProcess(struct subprocess_s* proc, int* returnCode = nullptr) noexcept;
+};
+
+struct OFS_JobDesc
+{
+    std::string Name;
+    OFS_Job::WorkFn Work;
+    // Main thread, called once the job is done, failed or got cancelled.
+    OFS_Job::ContinuationFn Then;
+    // The job gets queued when all of these are done and is cancelled if any of them didn't succeed.
+    std::vector<OFS_JobHandle> DependsOn;
+    // Runs even if a dependency failed, the dependencies only order the jobs.
+    bool OrderOnly = false;
+    OFS_ThreadPool::Priority Priority = OFS_ThreadPool::Priority::Normal;
+    OFS_JobLane Lane = OFS_JobLane::Cpu;
+    // Saves have to finish, they are waited for on shutdown.
+    bool Cancellable = true;
+};
+
+// Background jobs on top of the OFS_ThreadPool.
+// Jobs can depend on other jobs, be cancelled, report progress and continue on the main thread.
+// Blocking work like ffmpeg runs on the process lane, a few threads of its own next to the pool.
+class OFS_JobSystem
+{
+public:
+    // Process lane jobs beyond this wait for a free thread, in priority order.
+    static constexpr int ProcessLaneThreads = 4;
+
+private:
+    static SDL_SpinLock jobsLock;
+    static std::vector<OFS_JobHandle> jobs;
+
+    static void release(const OFS_JobHandle& job) noexcept;
+    static void run(const OFS_JobHandle& job) noexcept;
+    static void finish(const OFS_JobHandle& job, OFS_Job::State result) noexcept;
+
+    static void submitToProcessLane(const OFS_JobHandle& job) noexcept;
+    static int processLaneThread(void* data) noexcept;
+    static void shutdownProcessLane() noexcept;
+
+public:
+    static OFS_JobHandle Submit(OFS_JobDesc&& desc) noexcept;
+    // Main thread, fn runs once the job finished. Right away if there is no job or it already finished.
+    static void After(const OFS_JobHandle& job, std::function<void()>&& fn) noexcept;
+
+    static void CancelAll() noexcept;
+    // Cancels what can be cancelled and waits for everything else, call before OFS_ThreadPool::Shutdown.
+    // Stops the process lane threads.
+    static void Shutdown() noexcept;
+
+    static int ActiveJobs() noexcept;
+    static void ClearFinished() noexcept;
+
+    static void ShowWindow(bool* open) noexcept;
+};
@@ -0,0 +1,64 @@
+#include "OFS_Redraw.h"
+#include "OFS_Profiling.h"
+
+#include <thread>
+
+#include "SDL_timer.h"
+
+SDL_atomic_t OFS_Redraw::requestedFrames = {0};
+uint32_t OFS_Redraw::wakeEventType = (uint32_t)-1;
+
+bool OFS_Redraw::Init() noexcept
+{
+    wakeEventType = SDL_RegisterEvents(1);
+    // the first frames always get rendered
+    Request();
+    return wakeEventType != (uint32_t)-1;
+}
+
+void OFS_Redraw::Request(int32_t frames) noexcept
+{
+    int32_t current = SDL_AtomicGet(&requestedFrames);
+    while(current < frames) {
+        if(SDL_AtomicCAS(&requestedFrames, current, frames)) {
+            // only the request which ends the wait has to wake the loop
+            if(current == 0 && wakeEventType != (uint32_t)-1) {
+                SDL_Event ev = {0};
+                ev.type = wakeEventType;
+                SDL_PushEvent(&ev);
+            }
+            return;
+        }
+        current = SDL_AtomicGet(&requestedFrames);
+    }
+}
+
+void OFS_Redraw::BeginFrame() noexcept
+{
+    int32_t current = SDL_AtomicGet(&requestedFrames);
+    while(current > 0 && !SDL_AtomicCAS(&requestedFrames, current, current - 1)) {
+        current = SDL_AtomicGet(&requestedFrames);
+    }
+}
+
+void OFS_Redraw::Wait(uint32_t timeoutMs) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    if(Pending()) return;
+    // the event stays in the queue and gets handled by the next frame
+    SDL_WaitEventTimeout(nullptr, timeoutMs);
+}
+
+void OFS_Redraw::SleepUntil(uint64_t deadline) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    const double ticksPerUs = SDL_GetPerformanceFrequency() / 1000000.0;
+    for(;;) {
+        uint64_t now = SDL_GetPerformanceCounter();
+        if(now >= deadline) break;
+        uint64_t remainingUs = (uint64_t)((deadline - now) / ticksPerUs);
+        // SDL_Delay may oversleep a bit, the rest is waited out by yielding
+        if(remainingUs > 1500) SDL_Delay((uint32_t)((remainingUs - 500) / 1000));
+        else std::this_thread::yield();
+    }
+}
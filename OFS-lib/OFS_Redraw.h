@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SDL_atomic.h"
+#include "SDL_events.h"
+
+// Frames are only rendered when something asked for one.
+// Requests can come from any thread, the main loop sleeps in Wait otherwise.
+class OFS_Redraw
+{
+private:
+    static SDL_atomic_t requestedFrames;
+    static uint32_t wakeEventType;
+
+public:
+    // imgui needs a couple of frames to settle after input (hover, popups, layout)
+    static constexpr int32_t SettleFrames = 3;
+
+    static bool Init() noexcept;
+
+    // Any thread. Renders at least the given amount of frames, wakes the main loop if it waits.
+    static void Request(int32_t frames = SettleFrames) noexcept;
+    inline static bool Pending() noexcept { return SDL_AtomicGet(&requestedFrames) > 0; }
+    // Main thread, before a frame gets rendered. Requests made during the frame are for the next ones.
+    static void BeginFrame() noexcept;
+    // Main thread, blocks until a frame was requested, an SDL event arrived or the timeout passed.
+    static void Wait(uint32_t timeoutMs) noexcept;
+    // Sleeps until the performance counter reaches the deadline,
+    // coarse sleeps first and only yields for the last millisecond.
+    static void SleepUntil(uint64_t deadline) noexcept;
+
+    inline static bool IsWakeEvent(const SDL_Event& ev) noexcept { return ev.type == wakeEventType; }
+};
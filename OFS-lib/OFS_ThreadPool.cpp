@@ -0,0 +1,187 @@
+#include "OFS_ThreadPool.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+
+#include "SDL_cpuinfo.h"
+
+OFS_ThreadPool* OFS_ThreadPool::instance = nullptr;
+
+static thread_local int currentWorkerIdx = -1;
+
+bool OFS_ThreadPool::Init(int threadCount) noexcept
+{
+    if (!instance) {
+        if (threadCount <= 0) {
+            threadCount = Util::Max(SDL_GetCPUCount() - 1, 1);
+        }
+        instance = new OFS_ThreadPool(threadCount);
+        LOGF_INFO("Thread pool started with %d workers", threadCount);
+    }
+    return instance != nullptr;
+}
+
+void OFS_ThreadPool::Shutdown() noexcept
+{
+    if (instance) {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+int OFS_ThreadPool::CurrentWorker() noexcept
+{
+    return currentWorkerIdx;
+}
+
+OFS_ThreadPool::OFS_ThreadPool(int threadCount) noexcept
+{
+    taskAvailable = SDL_CreateSemaphore(0);
+    queues.reserve(threadCount);
+    for (int i = 0; i < threadCount; i += 1) {
+        queues.emplace_back(std::make_unique<WorkerQueue>());
+    }
+    workers.resize(threadCount);
+    for (int i = 0; i < threadCount; i += 1) {
+        auto& worker = workers[i];
+        worker.pool = this;
+        worker.index = i;
+        worker.thread = SDL_CreateThread(workerThread, "OFS_ThreadPool", &worker);
+    }
+}
+
+OFS_ThreadPool::~OFS_ThreadPool() noexcept
+{
+    SDL_AtomicSet(&shutdown, 1);
+    for (size_t i = 0; i < workers.size(); i += 1) {
+        SDL_SemPost(taskAvailable);
+    }
+    for (auto& worker : workers) {
+        SDL_WaitThread(worker.thread, nullptr);
+    }
+    SDL_DestroySemaphore(taskAvailable);
+}
+
+int OFS_ThreadPool::workerThread(void* data) noexcept
+{
+    auto& worker = *(Worker*)data;
+    auto pool = worker.pool;
+    currentWorkerIdx = worker.index;
+
+    Task task;
+    for (;;) {
+        SDL_SemWait(pool->taskAvailable);
+        if (SDL_AtomicGet(&pool->shutdown)) break;
+        // a helping thread may have taken the task already, that's fine
+        while (pool->popTask(worker.index, task)) {
+            task();
+            task = nullptr;
+            SDL_AtomicAdd(&pool->pendingTasks, -1);
+        }
+    }
+    return 0;
+}
+
+bool OFS_ThreadPool::popTask(int workerIdx, Task& outTask) noexcept
+{
+    const int queueCount = (int)queues.size();
+    const int start = workerIdx >= 0 ? workerIdx + 1 : 0;
+    for (int priority = 0; priority < (int)Priority::Count; priority += 1) {
+        // own queue from the back
+        if (workerIdx >= 0) {
+            auto& own = *queues[workerIdx];
+            auto& tasks = own.tasks[priority];
+            SDL_AtomicLock(&own.lock);
+            if (!tasks.empty()) {
+                outTask = std::move(tasks.back());
+                tasks.pop_back();
+                SDL_AtomicUnlock(&own.lock);
+                return true;
+            }
+            SDL_AtomicUnlock(&own.lock);
+        }
+
+        // steal from the front of the others
+        for (int i = 0; i < queueCount; i += 1) {
+            auto& other = *queues[(start + i) % queueCount];
+            auto& tasks = other.tasks[priority];
+            SDL_AtomicLock(&other.lock);
+            if (!tasks.empty()) {
+                outTask = std::move(tasks.front());
+                tasks.pop_front();
+                SDL_AtomicUnlock(&other.lock);
+                return true;
+            }
+            SDL_AtomicUnlock(&other.lock);
+        }
+    }
+    return false;
+}
+
+void OFS_ThreadPool::Submit(Task&& task, Priority priority) noexcept
+{
+    int target = currentWorkerIdx >= 0
+        ? currentWorkerIdx
+        : (int)((uint32_t)SDL_AtomicAdd(&submitCursor, 1) % (uint32_t)queues.size());
+
+    auto& queue = *queues[target];
+    SDL_AtomicAdd(&pendingTasks, 1);
+    SDL_AtomicLock(&queue.lock);
+    queue.tasks[(int)priority].emplace_back(std::move(task));
+    SDL_AtomicUnlock(&queue.lock);
+    SDL_SemPost(taskAvailable);
+}
+
+bool OFS_ThreadPool::TryRunOne() noexcept
+{
+    Task task;
+    if (popTask(currentWorkerIdx, task)) {
+        task();
+        SDL_AtomicAdd(&pendingTasks, -1);
+        return true;
+    }
+    return false;
+}
+
+void OFS_ThreadPool::ParallelFor(int count, const std::function<void(int)>& fn) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    if (count <= 0) return;
+    if (count == 1) {
+        fn(0);
+        return;
+    }
+
+    // Shared with the runner tasks, which may start after ParallelFor returned
+    struct ParallelState
+    {
+        const std::function<void(int)>* fn = nullptr;
+        SDL_atomic_t next = {0};
+        SDL_atomic_t completed = {0};
+        SDL_sem* done = nullptr;
+        int count = 0;
+        ~ParallelState() noexcept { SDL_DestroySemaphore(done); }
+
+        void Run() noexcept
+        {
+            int idx;
+            while ((idx = SDL_AtomicAdd(&next, 1)) < count) {
+                (*fn)(idx);
+                if (SDL_AtomicAdd(&completed, 1) + 1 == count) {
+                    SDL_SemPost(done);
+                }
+            }
+        }
+    };
+
+    auto state = std::make_shared<ParallelState>();
+    state->fn = &fn;
+    state->count = count;
+    state->done = SDL_CreateSemaphore(0);
+
+    int runners = Util::Min(count - 1, ThreadCount());
+    for (int i = 0; i < runners; i += 1) {
+        Submit([state]() noexcept { state->Run(); });
+    }
+    state->Run();
+    SDL_SemWait(state->done);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "SDL_thread.h"
+#include "SDL_mutex.h"
+#include "SDL_atomic.h"
+
+// Work-stealing thread pool shared by everything that wants to run CPU work off the main thread.
+// Every worker owns a deque, tasks submitted from a worker go to its own deque (LIFO for cache locality),
+// tasks submitted from other threads are distributed round-robin. Idle workers steal from the front of other deques.
+// Higher priorities are drained first, across all deques, before a worker looks at the next lower one.
+class OFS_ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    enum class Priority : int32_t
+    {
+        High,
+        Normal,
+        Low,
+        Count
+    };
+
+private:
+    struct WorkerQueue
+    {
+        SDL_SpinLock lock = 0;
+        std::deque<Task> tasks[(int)Priority::Count];
+    };
+
+    struct Worker
+    {
+        OFS_ThreadPool* pool = nullptr;
+        SDL_Thread* thread = nullptr;
+        int index = 0;
+    };
+
+    static OFS_ThreadPool* instance;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<Worker> workers;
+    SDL_sem* taskAvailable = nullptr;
+    SDL_atomic_t submitCursor = {0};
+    SDL_atomic_t shutdown = {0};
+    SDL_atomic_t pendingTasks = {0};
+
+    bool popTask(int workerIdx, Task& outTask) noexcept;
+    static int workerThread(void* data) noexcept;
+
+    OFS_ThreadPool(int threadCount) noexcept;
+    ~OFS_ThreadPool() noexcept;
+
+public:
+    OFS_ThreadPool(const OFS_ThreadPool&) = delete;
+    OFS_ThreadPool(OFS_ThreadPool&&) = delete;
+
+    // threadCount <= 0 picks the cpu count minus the main thread
+    static bool Init(int threadCount = 0) noexcept;
+    static void Shutdown() noexcept;
+    inline static OFS_ThreadPool* Get() noexcept { return instance; }
+
+    // Index of the calling pool worker or -1 for any other thread
+    static int CurrentWorker() noexcept;
+
+    void Submit(Task&& task, Priority priority = Priority::Normal) noexcept;
+    // Runs one pending task on the calling thread. Returns false if there was nothing to do.
+    bool TryRunOne() noexcept;
+    // Calls fn(i) for i in [0, count) across the pool, the calling thread participates. Blocks until done.
+    void ParallelFor(int count, const std::function<void(int)>& fn) noexcept;
+
+    inline int ThreadCount() const noexcept { return (int)workers.size(); }
+    inline int PendingTasks() noexcept { return SDL_AtomicGet(&pendingTasks); }
+};
@@ -1,6 +1,7 @@
 #include "OFS_Util.h"
 #include "OFS_GL.h"
 #include "OFS_EventSystem.h"
+#include "OFS_FrameArena.h"
 
 #include <filesystem>
 #include "SDL_rwops.h"
@@ -36,7 +37,15 @@
 #define RND_IMPLEMENTATION
 #include "rnd.h"
 
-char Util::FormatBuffer[4096];
+const char* Util::FormatV(const char* fmt, va_list argp) noexcept
+{
+    if (OFS_FrameArena::IsOwner()) {
+        return OFS_FrameArena::FormatV(fmt, argp);
+    }
+    static thread_local char buffer[4096];
+    stbsp_vsnprintf(buffer, sizeof(buffer), fmt, argp);
+    return buffer;
+}
 
 static void SanitizeString(std::string& str) noexcept
 {
@@ -364,6 +373,42 @@ std::filesystem::path Util::FfmpegPath() noexcept
 #endif
 }
 
+std::filesystem::path Util::FfprobePath() noexcept
+{
+    // ffprobe ships with ffmpeg, look for it in the same place
+    auto ffprobePath = FfmpegPath();
+    auto extension = ffprobePath.extension();
+    ffprobePath.replace_filename("ffprobe");
+    ffprobePath.replace_extension(extension);
+    return ffprobePath;
+}
+
+std::string Util::MediaFingerprint(const std::string& mediaPath) noexcept
+{
+    std::error_code ec;
+    auto path = Util::PathFromString(mediaPath);
+    uint64_t fileSize = std::filesystem::file_size(path, ec);
+    if (ec) fileSize = 0;
+    int64_t modified = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    if (ec) modified = 0;
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    auto fnv = [&hash](const void* bytes, size_t size) noexcept {
+        for (size_t i = 0; i < size; i += 1) {
+            hash ^= ((const uint8_t*)bytes)[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    fnv(mediaPath.data(), mediaPath.size());
+    fnv(&fileSize, sizeof(fileSize));
+    fnv(&modified, sizeof(modified));
+
+    char hex[17];
+    stbsp_snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+    return hex;
+}
+
 static rnd_pcg_t pcg;
 void Util::InitRandom() noexcept
 {
@@ -478,14 +478,20 @@ public:
     static bool SavePNG(const std::string& path, void* buffer, int32_t width, int32_t height, int32_t channels = 3, bool flipVertical = true) noexcept;
 
     static std::filesystem::path FfmpegPath() noexcept;
+    static std::filesystem::path FfprobePath() noexcept;
+    // Hex hash of path, size and modification time. Used to key on-disk caches of media files.
+    static std::string MediaFingerprint(const std::string& mediaPath) noexcept;
 
-    static char FormatBuffer[4096];
+    // On the main thread the result lives in the frame arena until the end of the frame,
+    // other threads share one buffer per thread which the next call overwrites.
+    static const char* FormatV(const char* fmt, va_list argp) noexcept;
     inline static const char* Format(const char* fmt, ...) noexcept
     {
         va_list argp;
         va_start(argp, fmt);
-        stbsp_vsnprintf(FormatBuffer, sizeof(FormatBuffer), fmt, argp);
-        return FormatBuffer;
+        const char* str = FormatV(fmt, argp);
+        va_end(argp);
+        return str;
     }
 
     inline static const char* FormatBytes(size_t bytes) noexcept
@@ -1,17 +1,10 @@
 #include "OFS_BlockingTask.h"
 #include "OFS_ImGui.h"
 #include "OFS_Localization.h"
+#include "OFS_Redraw.h"
+#include "OFS_JobSystem.h"
 #include "imgui.h"
 
-static int BlockingTaskThread(void* data) noexcept
-{
-	auto bdata = (OFS_BlockingTask*)data;
-	bdata->currentTask->TaskThreadFunc(bdata->currentTask.get());
-	bdata->currentTask.reset();
-	bdata->Running = false;
-	return 0;
-}
-
 void OFS_BlockingTask::ShowBlockingTask() noexcept
 {
 	if (currentTask) {
@@ -22,10 +15,22 @@ void OFS_BlockingTask::ShowBlockingTask() noexcept
 	if (!Running) {
 		RunningTimer = 0.f;
 		Running = true;
-		auto thread = SDL_CreateThread(BlockingTaskThread, "BlockingTaskThread", this);
-		SDL_DetachThread(thread);
+		OFS_JobDesc desc;
+		desc.Name = currentTask->TaskDescription;
+		desc.Priority = OFS_ThreadPool::Priority::High;
+		// the modal can't be closed, so there is nothing that could cancel it
+		desc.Cancellable = false;
+		desc.Work = [this](OFS_Job&) noexcept {
+			currentTask->TaskThreadFunc(currentTask.get());
+			currentTask.reset();
+			Running = false;
+			return true;
+		};
+		OFS_JobSystem::Submit(std::move(desc));
 	}
 	RunningTimer += ImGui::GetIO().DeltaTime;
+	// keeps the spinner going and notices when the task is done
+	OFS_Redraw::Request(1);
 
 	auto& style = ImGui::GetStyle();
 	float a = RunningTimer / 1.f;
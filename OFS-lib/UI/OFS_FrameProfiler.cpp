@@ -0,0 +1,288 @@
+#include "OFS_FrameProfiler.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+#include "OFS_FrameArena.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cinttypes>
+#include <cstring>
+#include <map>
+#include <vector>
+
+bool OFS_FrameProfiler::Enabled = true;
+thread_local bool OFS_FrameProfiler::recording = false;
+thread_local uint32_t OFS_FrameProfiler::depth = 0;
+
+OFS_FrameProfiler::Sample OFS_FrameProfiler::samples[OFS_FrameProfiler::MaxSamples] = {};
+uint32_t OFS_FrameProfiler::sampleHead = 0;
+OFS_FrameProfiler::Frame OFS_FrameProfiler::frames[OFS_FrameProfiler::MaxFrames] = {};
+uint32_t OFS_FrameProfiler::frameHead = 0;
+uint64_t OFS_FrameProfiler::frameStart = 0;
+uint32_t OFS_FrameProfiler::frameFirstSample = 0;
+
+void OFS_FrameProfiler::BeginFrame() noexcept
+{
+    recording = Enabled;
+    depth = 0;
+    frameFirstSample = sampleHead;
+    frameStart = SDL_GetPerformanceCounter();
+}
+
+void OFS_FrameProfiler::EndFrame() noexcept
+{
+    if(!recording) return;
+    recording = false;
+    auto& frame = frames[frameHead++ & (MaxFrames - 1)];
+    frame.start = frameStart;
+    frame.duration = SDL_GetPerformanceCounter() - frameStart;
+    frame.sampleCount = std::min(sampleHead - frameFirstSample, MaxSamples);
+    frame.firstSample = sampleHead - frame.sampleCount;
+}
+
+uint32_t OFS_FrameProfiler::firstFrameWithin(float seconds) noexcept
+{
+    uint32_t oldest = frameHead > MaxFrames ? frameHead - MaxFrames : 0;
+    if(frameHead == 0) return 0;
+    auto& newest = frames[(frameHead - 1) & (MaxFrames - 1)];
+    uint64_t end = newest.start + newest.duration;
+    uint64_t window = (uint64_t)(seconds * (double)SDL_GetPerformanceFrequency());
+    uint32_t first = frameHead - 1;
+    while(first > oldest && end - frames[(first - 1) & (MaxFrames - 1)].start <= window) {
+        first -= 1;
+    }
+    return first;
+}
+
+bool OFS_FrameProfiler::ExportCsv(const std::string& path, float seconds) noexcept
+{
+    const double ticksToMs = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    std::string csv = "frame,frame_start_ms,frame_ms,scope,depth,scope_start_ms,scope_ms\n";
+    char line[512];
+    uint32_t first = firstFrameWithin(seconds);
+    if(first == frameHead) return false;
+    uint64_t origin = frames[first & (MaxFrames - 1)].start;
+
+    for(uint32_t i = first; i < frameHead; i += 1) {
+        auto& frame = frames[i & (MaxFrames - 1)];
+        int prefix = stbsp_snprintf(line, sizeof(line), "%u,%.4f,%.4f,",
+            i, (frame.start - origin) * ticksToMs, frame.duration * ticksToMs);
+        if(!samplesValid(frame) || frame.sampleCount == 0) {
+            csv.append(line, prefix);
+            csv += ",,,\n";
+            continue;
+        }
+        for(uint32_t s = 0; s < frame.sampleCount; s += 1) {
+            auto& sample = samples[(frame.firstSample + s) & (MaxSamples - 1)];
+            csv.append(line, prefix);
+            char values[256];
+            // names can contain commas, e.g. "overlay->DrawScriptPositionContent(drawingCtx)"
+            stbsp_snprintf(values, sizeof(values), "\"%s\",%u,%.4f,%.4f\n",
+                sample.name, sample.depth, (sample.start - frame.start) * ticksToMs, sample.duration * ticksToMs);
+            csv += values;
+        }
+    }
+    return Util::WriteFile(path.c_str(), csv.data(), csv.size()) == csv.size();
+}
+
+static void appendJsonString(std::string& out, const char* str) noexcept
+{
+    out += '"';
+    for(; *str; str += 1) {
+        if(*str == '"' || *str == '\\') out += '\\';
+        out += *str;
+    }
+    out += '"';
+}
+
+bool OFS_FrameProfiler::ExportChromeTrace(const std::string& path, float seconds) noexcept
+{
+    // chrome://tracing and Perfetto expect microseconds
+    const double ticksToUs = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char values[128];
+    uint32_t first = firstFrameWithin(seconds);
+    if(first == frameHead) return false;
+    uint64_t origin = frames[first & (MaxFrames - 1)].start;
+
+    bool firstEvent = true;
+    auto appendEvent = [&](const char* name, uint64_t start, uint64_t duration) noexcept {
+        if(!firstEvent) json += ',';
+        firstEvent = false;
+        json += "{\"name\":";
+        appendJsonString(json, name);
+        stbsp_snprintf(values, sizeof(values), ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+            (start - origin) * ticksToUs, duration * ticksToUs);
+        json += values;
+    };
+
+    for(uint32_t i = first; i < frameHead; i += 1) {
+        auto& frame = frames[i & (MaxFrames - 1)];
+        appendEvent("Frame", frame.start, frame.duration);
+        if(!samplesValid(frame)) continue;
+        for(uint32_t s = 0; s < frame.sampleCount; s += 1) {
+            auto& sample = samples[(frame.firstSample + s) & (MaxSamples - 1)];
+            appendEvent(sample.name, sample.start, sample.duration);
+        }
+    }
+    json += "]}";
+    return Util::WriteFile(path.c_str(), json.data(), json.size()) == json.size();
+}
+
+namespace {
+    struct ScopeStats
+    {
+        uint32_t calls = 0;
+        uint32_t depth = 0;
+        uint64_t totalTicks = 0;
+        uint64_t maxTicks = 0;
+    };
+
+    struct NameLess
+    {
+        bool operator()(const char* a, const char* b) const noexcept { return strcmp(a, b) < 0; }
+    };
+}
+
+void OFS_FrameProfiler::ShowWindow(bool* open) noexcept
+{
+    if(!*open) return;
+    OFS_PROFILE(__FUNCTION__);
+    constexpr int WorstFrameCount = 10;
+    constexpr int PlotFrameCount = 240;
+    static float statsSeconds = 5.f;
+    static float exportSeconds = 10.f;
+    static uint64_t selectedFrameStart = 0;
+    const double ticksToMs = 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    ImGui::Begin("Frame profiler", open, ImGuiWindowFlags_None);
+    ImGui::Checkbox("Record", &Enabled);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8.f);
+    ImGui::SliderFloat("Window", &statsSeconds, 1.f, 30.f, "%.0f s", ImGuiSliderFlags_AlwaysClamp);
+
+    uint32_t first = firstFrameWithin(statsSeconds);
+    uint32_t frameCount = frameHead - first;
+    if(frameCount == 0) {
+        ImGui::TextDisabled("No frames recorded.");
+        ImGui::End();
+        return;
+    }
+
+    OFS_FrameVector<uint32_t> byDuration;
+    byDuration.reserve(frameCount);
+    for(uint32_t i = first; i < frameHead; i += 1) byDuration.push_back(i);
+    std::sort(byDuration.begin(), byDuration.end(), [](uint32_t a, uint32_t b) noexcept {
+        return frames[a & (MaxFrames - 1)].duration < frames[b & (MaxFrames - 1)].duration;
+    });
+    auto percentile = [&](float p) noexcept {
+        uint32_t idx = std::min((uint32_t)(p * frameCount), frameCount - 1);
+        return frames[byDuration[idx] & (MaxFrames - 1)].duration * ticksToMs;
+    };
+    ImGui::Text("%u frames  p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms",
+        frameCount, percentile(.5f), percentile(.9f), percentile(.99f),
+        frames[byDuration.back() & (MaxFrames - 1)].duration * ticksToMs);
+
+    {
+        float plot[PlotFrameCount];
+        int plotCount = (int)std::min<uint32_t>(frameHead - (frameHead > MaxFrames ? frameHead - MaxFrames : 0), PlotFrameCount);
+        for(int i = 0; i < plotCount; i += 1) {
+            plot[i] = (float)(frames[(frameHead - plotCount + i) & (MaxFrames - 1)].duration * ticksToMs);
+        }
+        ImGui::PlotLines("##FrameTimes", plot, plotCount, 0, "Frame time (ms)", 0.f, FLT_MAX, ImVec2(-1.f, ImGui::GetFontSize() * 5.f));
+    }
+
+    ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8.f);
+    ImGui::SliderFloat("##ExportSeconds", &exportSeconds, 1.f, 60.f, "Last %.0f s", ImGuiSliderFlags_AlwaysClamp);
+    ImGui::SameLine();
+    if(ImGui::Button("Export CSV")) {
+        Util::SaveFileDialog("Export frame profile", Util::Prefpath("frames.csv"),
+            [](auto& result) noexcept {
+                if(!result.files.empty() && !ExportCsv(result.files[0], exportSeconds)) {
+                    LOGF_ERROR("Failed to export frame profile to \"%s\"", result.files[0].c_str());
+                }
+            }, { "CSV", "*.csv" });
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Export trace")) {
+        Util::SaveFileDialog("Export frame trace", Util::Prefpath("frames.json"),
+            [](auto& result) noexcept {
+                if(!result.files.empty() && !ExportChromeTrace(result.files[0], exportSeconds)) {
+                    LOGF_ERROR("Failed to export frame trace to \"%s\"", result.files[0].c_str());
+                }
+            }, { "Chrome trace", "*.json" });
+    }
+
+    if(ImGui::CollapsingHeader("Scopes", ImGuiTreeNodeFlags_DefaultOpen)) {
+        std::map<const char*, ScopeStats, NameLess, OFS_FrameAllocator<std::pair<const char* const, ScopeStats>>> scopes;
+        uint32_t sampledFrames = 0;
+        for(uint32_t i = first; i < frameHead; i += 1) {
+            auto& frame = frames[i & (MaxFrames - 1)];
+            if(!samplesValid(frame)) continue;
+            sampledFrames += 1;
+            for(uint32_t s = 0; s < frame.sampleCount; s += 1) {
+                auto& sample = samples[(frame.firstSample + s) & (MaxSamples - 1)];
+                auto& stats = scopes[sample.name];
+                stats.depth = stats.calls == 0 ? sample.depth : std::min(stats.depth, sample.depth);
+                stats.calls += 1;
+                stats.totalTicks += sample.duration;
+                stats.maxTicks = std::max(stats.maxTicks, sample.duration);
+            }
+        }
+
+        OFS_FrameVector<std::pair<const char*, ScopeStats>> sorted(scopes.begin(), scopes.end());
+        std::sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) noexcept { return a.second.totalTicks > b.second.totalTicks; });
+        if(sampledFrames > 0 && ImGui::BeginTable("##Scopes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollY, ImVec2(0.f, ImGui::GetFontSize() * 15.f))) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Scope");
+            ImGui::TableSetupColumn("Depth");
+            ImGui::TableSetupColumn("Calls/frame");
+            ImGui::TableSetupColumn("Avg ms/frame");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+            for(auto& [name, stats] : sorted) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", stats.depth);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", stats.calls / (float)sampledFrames);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.totalTicks * ticksToMs / sampledFrames);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.maxTicks * ticksToMs);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    if(ImGui::CollapsingHeader("Worst frames", ImGuiTreeNodeFlags_DefaultOpen)) {
+        const Frame* selected = nullptr;
+        for(int i = 0; i < WorstFrameCount && i < (int)frameCount; i += 1) {
+            auto& frame = frames[byDuration[frameCount - 1 - i] & (MaxFrames - 1)];
+            char label[64];
+            stbsp_snprintf(label, sizeof(label), "%.2f ms##%" PRIu64, frame.duration * ticksToMs, frame.start);
+            if(ImGui::Selectable(label, frame.start == selectedFrameStart)) {
+                selectedFrameStart = frame.start;
+            }
+            if(frame.start == selectedFrameStart) selected = &frame;
+        }
+
+        if(selected) {
+            ImGui::Separator();
+            if(!samplesValid(*selected)) {
+                ImGui::TextDisabled("The scopes of this frame were already overwritten.");
+            }
+            else {
+                for(uint32_t s = 0; s < selected->sampleCount; s += 1) {
+                    auto& sample = samples[(selected->firstSample + s) & (MaxSamples - 1)];
+                    ImGui::Text("%*s%s  %.3f ms", (int)sample.depth * 2, "", sample.name, sample.duration * ticksToMs);
+                }
+            }
+        }
+    }
+    ImGui::End();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "SDL_timer.h"
+
+// Always available frame profiler fed by the OFS_PROFILE scopes.
+// Only the main thread records, between BeginFrame and EndFrame, into fixed size rings.
+class OFS_FrameProfiler
+{
+public:
+    static constexpr uint32_t MaxFrames = 4096;
+    static constexpr uint32_t MaxSamples = 1 << 17;
+    static_assert((MaxFrames & (MaxFrames - 1)) == 0 && (MaxSamples & (MaxSamples - 1)) == 0, "ring sizes have to be powers of two");
+
+    struct Sample
+    {
+        const char* name;
+        uint32_t depth;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    struct Frame
+    {
+        uint64_t start;
+        uint64_t duration;
+        // index into the sample ring, only valid as long as it wasn't overwritten
+        uint32_t firstSample;
+        uint32_t sampleCount;
+    };
+
+    class Scope
+    {
+    private:
+        Sample* sample = nullptr;
+    public:
+        inline explicit Scope(const char* name) noexcept
+        {
+            if (!recording) return;
+            sample = &samples[sampleHead++ & (MaxSamples - 1)];
+            sample->name = name;
+            sample->depth = depth++;
+            sample->start = SDL_GetPerformanceCounter();
+        }
+        inline ~Scope() noexcept
+        {
+            if (!sample) return;
+            sample->duration = SDL_GetPerformanceCounter() - sample->start;
+            depth -= 1;
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static bool Enabled;
+
+    // Main thread, around everything that makes up one frame.
+    static void BeginFrame() noexcept;
+    static void EndFrame() noexcept;
+
+    static void ShowWindow(bool* open) noexcept;
+    // frames of the last seconds
+    static bool ExportCsv(const std::string& path, float seconds) noexcept;
+    static bool ExportChromeTrace(const std::string& path, float seconds) noexcept;
+
+private:
+    static thread_local bool recording;
+    static thread_local uint32_t depth;
+
+    static Sample samples[MaxSamples];
+    static uint32_t sampleHead;
+    static Frame frames[MaxFrames];
+    static uint32_t frameHead;
+    static uint64_t frameStart;
+    static uint32_t frameFirstSample;
+
+    static uint32_t firstFrameWithin(float seconds) noexcept;
+    inline static bool samplesValid(const Frame& frame) noexcept { return sampleHead - frame.firstSample <= MaxSamples; }
+};
@@ -1,18 +1,27 @@
 #pragma once
+#include "OFS_FrameProfiler.h"
+
 #if OFS_PROFILE_ENABLED == 1
 #include "tracy/Tracy.hpp"
 #endif
 
+#define OFS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define OFS_PROFILE_CONCAT(a, b) OFS_PROFILE_CONCAT_IMPL(a, b)
+// the built-in frame profiler is always compiled in, it only records on the main thread
+#define OFS_FRAME_SCOPE(name) OFS_FrameProfiler::Scope OFS_PROFILE_CONCAT(ofsFrameScope, __LINE__)(name)
+
 #if OFS_PROFILE_ENABLED == 1
 class OFS_Profiler
 {
 public:
 	inline static void BeginProfiling() noexcept
 	{
+		OFS_FrameProfiler::BeginFrame();
 		//FrameMark;
 	}
 	inline static void EndProfiling() noexcept
 	{
+		OFS_FrameProfiler::EndFrame();
 		FrameMark;
 		//FrameMarkEnd(nullptr);
 	}
@@ -20,12 +29,14 @@ public:
 #endif
 
 #if OFS_PROFILE_ENABLED == 1
-#define OFS_PROFILE(name) ZoneScopedN(name)
+#define OFS_PROFILE(name) ZoneScopedN(name); OFS_FRAME_SCOPE(name)
+// for names which aren't string literals
+#define OFS_PROFILE_DYNAMIC(name, size) ZoneScoped; ZoneName(name, size); OFS_FRAME_SCOPE(name)
 #define OFS_BEGINPROFILING() OFS_Profiler::BeginProfiling()
 #define OFS_ENDPROFILING() OFS_Profiler::EndProfiling();
 #else
-#define OFS_PROFILE(name)
-#define OFS_BEGINPROFILING()
-#define OFS_ENDPROFILING()
+#define OFS_PROFILE(name) OFS_FRAME_SCOPE(name)
+#define OFS_PROFILE_DYNAMIC(name, size) OFS_FRAME_SCOPE(name)
+#define OFS_BEGINPROFILING() OFS_FrameProfiler::BeginFrame()
+#define OFS_ENDPROFILING() OFS_FrameProfiler::EndFrame()
 #endif
-
@@ -11,6 +11,7 @@
 #include "OFS_Shader.h"
 #include "OFS_GL.h"
 #include "OFS_EventSystem.h"
+#include "OFS_JobSystem.h"
 
 #include "state/states/BaseOverlayState.h"
 #include "state/states/WaveformState.h"
@@ -51,7 +52,7 @@ void ScriptTimeline::FfmpegAudioProcessingFinished(const WaveformProcessingFinis
 {
 	ShowAudioWaveform = true;
 	// Update cache
-	auto& waveCache = WaveformState::StaticStateSlow();
+	auto& waveCache = WaveformState::State(waveformStateHandle);
 	waveCache.Filename = videoPath;
 	waveCache.SetSamples(Wave.data.Samples());
 	LOG_INFO("Audio processing complete.");
@@ -60,6 +61,7 @@ void ScriptTimeline::FfmpegAudioProcessingFinished(const WaveformProcessingFinis
 void ScriptTimeline::Init()
 {
 	overlayStateHandle = BaseOverlayState::RegisterStatic();
+	waveformStateHandle = OFS_ProjectState<WaveformState>::Register(WaveformState::StateName);
 
 	EV::Queue().appendListener(SDL_MOUSEWHEEL,
 		OFS_SDL_Event::HandleEvent(EVENT_SYSTEM_BIND(this, &ScriptTimeline::mouseScroll)));
@@ -99,7 +101,7 @@ void ScriptTimeline::videoLoaded(const VideoLoadedEvent* ev) noexcept
 {
 	if(ev->playerType != VideoplayerType::Main) return;
 	videoPath = ev->videoPath;
-	auto& waveCache = WaveformState::StaticStateSlow();
+	auto& waveCache = WaveformState::State(waveformStateHandle);
 	auto samples = waveCache.GetSamples();
 	if(waveCache.Filename == videoPath && !samples.empty())
 	{
@@ -465,20 +467,6 @@ void ScriptTimeline::ShowScriptPositions(
 				ImGui::EndMenu();
 			}
 
-			auto updateAudioWaveformThread = [](void* userData) -> int {
-				auto& ctx = *((ScriptTimeline*)userData);
-				std::error_code ec;
-				auto ffmpegPath = Util::FfmpegPath();
-				auto outputPath = Util::Prefpath("tmp");
-				if (!Util::CreateDirectories(outputPath)) {
-					return 0;
-				}
-				
-				outputPath = (Util::PathFromString(outputPath) / "audio.flac").u8string();
-				bool succ = ctx.Wave.data.GenerateAndLoadFlac(ffmpegPath.u8string(), ctx.videoPath, outputPath);
-				EV::Enqueue<WaveformProcessingFinishedEvent>();
-				return 0;
-			};
 			if (ImGui::BeginMenu(TR_ID("WAVEFORM", Tr::WAVEFORM))) {
 				if(ImGui::BeginMenu(TR_ID("SETTINGS", Tr::SETTINGS))) {
 					ImGui::SetNextItemWidth(ImGui::GetFontSize()*5.f);
@@ -497,7 +485,7 @@ void ScriptTimeline::ShowScriptPositions(
 					if (!Wave.data.BusyGenerating()) {
 						ShowAudioWaveform = false; // gets switched true after processing
 
-						auto& waveCache = WaveformState::StaticStateSlow();
+						auto& waveCache = WaveformState::State(waveformStateHandle);
 						auto samples = waveCache.GetSamples();
 						if(waveCache.Filename == videoPath && !samples.empty())
 						{
@@ -506,8 +494,23 @@ void ScriptTimeline::ShowScriptPositions(
 						}
 						else 
 						{
-							auto handle = SDL_CreateThread(updateAudioWaveformThread, "OFS_GenWaveform", this);
-							SDL_DetachThread(handle);
+							OFS_JobDesc desc;
+							desc.Name = TR(UPDATE_WAVEFORM);
+							desc.Lane = OFS_JobLane::Process;
+							desc.Work = [this, mediaPath = videoPath](OFS_Job& job) noexcept {
+								auto outputPath = Util::Prefpath("tmp");
+								if (!Util::CreateDirectories(outputPath)) {
+									return false;
+								}
+								outputPath = (Util::PathFromString(outputPath) / "audio.flac").u8string();
+								return Wave.data.GenerateAndLoadFlac(Util::FfmpegPath().u8string(), mediaPath, outputPath, &job);
+							};
+							desc.Then = [](OFS_Job& job) noexcept {
+								if (job.Succeeded()) {
+									EV::Enqueue<WaveformProcessingFinishedEvent>();
+								}
+							};
+							OFS_JobSystem::Submit(std::move(desc));
 						}
 					}
 				}
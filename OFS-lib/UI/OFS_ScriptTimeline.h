@@ -17,6 +17,7 @@ class ScriptTimeline
 {
 public:
 	uint32_t overlayStateHandle = 0xFFFF'FFFF;
+	uint32_t waveformStateHandle = 0xFFFF'FFFF;
 	float absSel1 = 0.f; // absolute selection start
 	float relSel2 = 0.f; // relative selection end
 
@@ -20,20 +20,100 @@ void OFS_VideoplayerControls::VideoLoaded(const VideoLoadedEvent* ev) noexcept
 {
     OFS_PROFILE(__FUNCTION__);
     if(ev->playerType != VideoplayerType::Main) return;
-    videoPreview->PreviewVideo(ev->videoPath, 0.f);
+    // the atlas gets built once duration and resolution are known
+    thumbnails.Clear();
+    durationKnown = false;
+    previewRequestTime = -1.f;
+    if(videoPreview) {
+        videoPreview->PreviewVideo(ev->videoPath, 0.f);
+    }
+}
+
+void OFS_VideoplayerControls::DurationChange(const DurationChangeEvent* ev) noexcept
+{
+    if(ev->playerType != VideoplayerType::Main) return;
+    durationKnown = true;
 }
 
 void OFS_VideoplayerControls::Init(OFS_Videoplayer* player, bool hwAccel) noexcept
 {
     if(this->player) return;
     this->player = player;
+    this->hwAccel = hwAccel;
     chapterStateHandle = OFS_ProjectState<ChapterState>::Register(ChapterState::StateName);
     Heatmap = std::make_unique<FunscriptHeatmap>();
-    videoPreview = std::make_unique<VideoPreview>(hwAccel);
-    videoPreview->Init();
 
     EV::Queue().appendListener(VideoLoadedEvent::EventType,
         VideoLoadedEvent::HandleEvent(EVENT_SYSTEM_BIND(this, &OFS_VideoplayerControls::VideoLoaded)));
+    EV::Queue().appendListener(DurationChangeEvent::EventType,
+        DurationChangeEvent::HandleEvent(EVENT_SYSTEM_BIND(this, &OFS_VideoplayerControls::DurationChange)));
+}
+
+void OFS_VideoplayerControls::Update(float delta) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    if(videoPreview) {
+        videoPreview->Update(delta);
+    }
+    thumbnails.Update();
+    if(durationKnown && player->VideoLoaded() && thumbnails.GetStatus() == OFS_ThumbnailAtlas::Status::Empty) {
+        thumbnails.Build(player->VideoPath(), player->Duration(), player->VideoWidth(), player->VideoHeight());
+    }
+}
+
+void OFS_VideoplayerControls::CloseVideo() noexcept
+{
+    thumbnails.Clear();
+    durationKnown = false;
+    previewRequestTime = -1.f;
+    if(videoPreview) {
+        videoPreview->CloseVideo();
+    }
+}
+
+void OFS_VideoplayerControls::requestFinePreview(float relPosition) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    if(!videoPreview) {
+        videoPreview = std::make_unique<VideoPreview>(hwAccel);
+        videoPreview->Init();
+        videoPreview->PreviewVideo(player->VideoPath(), relPosition);
+    }
+    videoPreview->Play();
+    videoPreview->SetPosition(relPosition);
+    previewRequestTime = player->Duration() * relPosition;
+    lastPreviewUpdate = SDL_GetTicks();
+}
+
+void OFS_VideoplayerControls::drawPreviewTooltip(float relPosition) noexcept
+{
+    const float imageHeight = ImGui::GetFontSize() * 7.f;
+    float timeSeconds = player->Duration() * relPosition;
+
+    // mpv only wins if it is showing the hovered position, the atlas is instant but coarse
+    bool showFinePreview = videoPreview && previewRequestTime >= 0.f
+        && (!thumbnails.IsReady()
+            || (std::abs(previewRequestTime - timeSeconds) < 0.001f
+                && std::abs(videoPreview->PlayerTime() - previewRequestTime) < thumbnails.Interval()));
+
+    OFS_ThumbnailAtlas::Sprite sprite;
+    if (showFinePreview) {
+        ImGui::Image((void*)(intptr_t)videoPreview->FrameTex(), ImVec2(imageHeight * (16.f / 9.f), imageHeight));
+    }
+    else if (thumbnails.Lookup(timeSeconds, &sprite)) {
+        ImGui::Image((void*)(intptr_t)sprite.texture, ImVec2(imageHeight * thumbnails.AspectRatio(), imageHeight),
+            ImVec2(sprite.uv0[0], sprite.uv0[1]), ImVec2(sprite.uv1[0], sprite.uv1[1]));
+    }
+
+    float timeDelta = timeSeconds - player->CurrentTime();
+    char timeBuf1[16];
+    char timeBuf2[16];
+    Util::FormatTime(timeBuf1, sizeof(timeBuf1), timeSeconds, false);
+    Util::FormatTime(timeBuf2, sizeof(timeBuf2), (timeDelta > 0) ? timeDelta : -timeDelta, false);
+    if (timeDelta > 0)
+        ImGui::Text("%s (+%s)", timeBuf1, timeBuf2);
+    else
+        ImGui::Text("%s (-%s)", timeBuf1, timeBuf2);
 }
 
 inline static ImRect GetWidgetBB(float heightMulti) noexcept
@@ -114,31 +194,21 @@ bool OFS_VideoplayerControls::DrawTimelineWidget(const char* label, float* posit
 
         if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
         {
-            if (SDL_GetTicks() - lastPreviewUpdate >= PreviewUpdateMs) {
-                videoPreview->Play();
-                videoPreview->SetPosition(relTimelinePos);
-                lastPreviewUpdate = SDL_GetTicks();
+            if (mouse.x != lastHoverX) {
+                lastHoverX = mouse.x;
+                hoverStartTicks = SDL_GetTicks();
             }
-            ImGui::BeginTooltipEx(ImGuiWindowFlags_None, ImGuiTooltipFlags_None);
-            {
-                const ImVec2 ImageDim = ImVec2(ImGui::GetFontSize()*7.f * (16.f / 9.f), ImGui::GetFontSize() * 7.f);
-                ImGui::Image((void*)(intptr_t)videoPreview->FrameTex(), ImageDim);
-                float timeSeconds = player->Duration() * relTimelinePos;
-                float timeDelta = timeSeconds - player->CurrentTime();
-
-                char timeBuf1[16];
-                char timeBuf2[16];
-                Util::FormatTime(timeBuf1, sizeof(timeBuf1), timeSeconds, false);
-                Util::FormatTime(timeBuf2, sizeof(timeBuf2), (timeDelta > 0) ? timeDelta : -timeDelta, false);
-                if (timeDelta > 0)
-                    ImGui::Text("%s (+%s)", timeBuf1, timeBuf2);
-                else
-                    ImGui::Text("%s (-%s)", timeBuf1, timeBuf2);
+            // the atlas covers quick scrubbing, mpv is started when the cursor rests or there is no atlas
+            bool wantsFinePreview = !thumbnails.IsReady() || SDL_GetTicks() - hoverStartTicks >= FinePreviewDelayMs;
+            if (wantsFinePreview && SDL_GetTicks() - lastPreviewUpdate >= PreviewUpdateMs) {
+                requestFinePreview(relTimelinePos);
             }
+            ImGui::BeginTooltipEx(ImGuiWindowFlags_None, ImGuiTooltipFlags_None);
+            drawPreviewTooltip(relTimelinePos);
             ImGui::EndTooltip();
         }
     }
-    else 
+    else if(videoPreview)
     {
         videoPreview->Pause();
     }
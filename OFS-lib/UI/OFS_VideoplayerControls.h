@@ -3,6 +3,7 @@
 #include "GradientBar.h"
 #include "OFS_Videopreview.h"
 #include "FunscriptHeatmap.h"
+#include "OFS_ThumbnailAtlas.h"
 
 class OFS_VideoplayerControls
 {
@@ -19,22 +20,36 @@ private:
 	
 	static constexpr int32_t PreviewUpdateMs = 1000;
 	uint32_t lastPreviewUpdate = 0;
+	// mpv preview is only used after the cursor rested this long
+	static constexpr int32_t FinePreviewDelayMs = 500;
+	uint32_t hoverStartTicks = 0;
+	float lastHoverX = 0.f;
+	float previewRequestTime = -1.f;
+	bool hwAccel = false;
+	bool durationKnown = false;
 	class OFS_Videoplayer* player = nullptr;
+	OFS_ThumbnailAtlas thumbnails;
 
 	bool DrawChapter(ImDrawList* drawList, const ImRect& frameBB, class Chapter& chapter, ImDrawFlags drawFlags, float currentTime) noexcept;
 	bool DrawBookmark(ImDrawList* drawList, const ImRect& frameBB, class Bookmark& bookmark) noexcept;
 	void DrawChapterWidget(ImDrawList* drawList, float currentTime) noexcept;
 
 	void VideoLoaded(const class VideoLoadedEvent* ev) noexcept;
+	void DurationChange(const class DurationChangeEvent* ev) noexcept;
+	void requestFinePreview(float relPosition) noexcept;
+	void drawPreviewTooltip(float relPosition) noexcept;
 	bool DrawTimelineWidget(const char* label, float* position) noexcept;
 public:
 	static constexpr const char* ControlId = "###CONTROLS";
 	static constexpr const char* TimeId = "###TIME";
 
+	// Created on demand for previews finer than the thumbnail atlas
 	std::unique_ptr<VideoPreview> videoPreview;
 	std::unique_ptr<FunscriptHeatmap> Heatmap;
 
 	void Init(class OFS_Videoplayer* player, bool hwAccel) noexcept;
+	void Update(float delta) noexcept;
+	void CloseVideo() noexcept;
 
 	inline void UpdateHeatmap(float totalDuration, const FunscriptArray& actions) noexcept
 	{
@@ -22,4 +22,5 @@ public:
 	void CloseVideo() noexcept;
 
 	inline uint32_t FrameTex() const noexcept { return player->FrameTexture(); }
+	inline double PlayerTime() const noexcept { return player->CurrentPlayerTime(); }
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "OFS_Profiling.h"
 #include "OFS_GL.h"
 #include "OFS_ScriptTimeline.h"
+#include "OFS_JobSystem.h"
 
 #define DR_FLAC_IMPLEMENTATION
 #include "dr_flac.h"
@@ -58,7 +59,7 @@ bool OFS_Waveform::LoadFlac(const std::string& output) noexcept
 	return true;
 }
 
-bool OFS_Waveform::GenerateAndLoadFlac(const std::string& ffmpegPath, const std::string& videoPath, const std::string& output) noexcept
+bool OFS_Waveform::GenerateAndLoadFlac(const std::string& ffmpegPath, const std::string& videoPath, const std::string& output, OFS_Job* job) noexcept
 {
 	generating = true;
 
@@ -93,10 +94,15 @@ bool OFS_Waveform::GenerateAndLoadFlac(const std::string& ffmpegPath, const std:
 	}
 
 	int return_code;
-	subprocess_join(&proc, &return_code);
-	subprocess_destroy(&proc);
+	if (job) {
+		job->JoinProcess(&proc, &return_code);
+	}
+	else {
+		subprocess_join(&proc, &return_code);
+		subprocess_destroy(&proc);
+	}
 
-	if (!LoadFlac(output)) {
+	if ((job && job->IsCancelled()) || !LoadFlac(output)) {
 		generating = false;
 		return false;
 	}
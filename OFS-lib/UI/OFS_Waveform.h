@@ -8,7 +8,7 @@
 #include "OFS_Shader.h"
 #include "imgui.h"
 
-
+class OFS_Job;
 
 // LOD level for efficient waveform rendering at different zoom levels
 struct WaveformLODLevel
@@ -26,7 +26,8 @@ class OFS_Waveform
 public:
 
 	inline bool BusyGenerating() noexcept { return generating; }
-	bool GenerateAndLoadFlac(const std::string& ffmpegPath, const std::string& videoPath, const std::string& output) noexcept;
+	// the job, if any, can cancel the ffmpeg run
+	bool GenerateAndLoadFlac(const std::string& ffmpegPath, const std::string& videoPath, const std::string& output, OFS_Job* job = nullptr) noexcept;
 	bool LoadFlac(const std::string& path) noexcept;
 
 	inline void Clear() noexcept {
@@ -8,8 +8,6 @@
 
 #include <cmath>
 
-std::vector<BaseOverlay::ColoredLine> BaseOverlay::ColoredLines;
-
 constexpr float MaxPointSize = 8.f;
 float BaseOverlay::PointSize = MaxPointSize;
 
@@ -87,9 +85,9 @@ ImVec2 BaseOverlay::GetPointForAction(const OverlayDrawingCtx& ctx, FunscriptAct
     return ImVec2(x, y);
 };
 
-void BaseOverlay::drawActionLinesSpline(const OverlayDrawingCtx& ctx, const BaseOverlayState& state) noexcept
+void BaseOverlay::drawActionLinesSpline(const OverlayDrawingCtx& ctx, const BaseOverlayState& state, ColoredLines& coloredLines) noexcept
 {
-    auto drawSpline = [](const OverlayDrawingCtx& ctx, FunscriptAction startAction, FunscriptAction endAction, uint32_t color, float width, bool background = true) noexcept
+    auto drawSpline = [&coloredLines](const OverlayDrawingCtx& ctx, FunscriptAction startAction, FunscriptAction endAction, uint32_t color, float width, bool background = true) noexcept
     {
         constexpr float SamplesPerTwothousandPixels = 150.f;
         const float MaximumSamples = SamplesPerTwothousandPixels * (ctx.canvasSize.x / 2000.f);
@@ -150,7 +148,7 @@ void BaseOverlay::drawActionLinesSpline(const OverlayDrawingCtx& ctx, const Base
                 ctx.drawList->PathLineTo(p2);
                 ctx.drawList->PathStroke(IM_COL32_BLACK, false, 7.f);
             }
-            ColoredLines.emplace_back(std::move(BaseOverlay::ColoredLine{ p1, p2, color }));
+            coloredLines.emplace_back(BaseOverlay::ColoredLine{ p1, p2, color });
         }
         else {
             putPoint(ctx, currentTime);
@@ -204,12 +202,12 @@ void BaseOverlay::drawActionLinesSpline(const OverlayDrawingCtx& ctx, const Base
     }
 }
 
-void BaseOverlay::drawActionLinesLinear(const OverlayDrawingCtx& ctx, const BaseOverlayState& state) noexcept
+void BaseOverlay::drawActionLinesLinear(const OverlayDrawingCtx& ctx, const BaseOverlayState& state, ColoredLines& coloredLines) noexcept
 {
-    auto drawLine = [](const OverlayDrawingCtx& ctx, ImVec2 p1, ImVec2 p2, uint32_t color) noexcept
+    auto drawLine = [&coloredLines](const OverlayDrawingCtx& ctx, ImVec2 p1, ImVec2 p2, uint32_t color) noexcept
     {
         ctx.drawList->AddLine(p1, p2, IM_COL32(0, 0, 0, 255), 7.0f); // border
-        ColoredLines.emplace_back(std::move(BaseOverlay::ColoredLine{ p1, p2, color }));
+        coloredLines.emplace_back(BaseOverlay::ColoredLine{ p1, p2, color });
     };
 
     auto& drawingScript = ctx.DrawingScript();
@@ -246,14 +244,12 @@ void BaseOverlay::drawActionLinesLinear(const OverlayDrawingCtx& ctx, const Base
 
             if (prevAction != nullptr) {
                 // draw highlight line
-                ColoredLines.emplace_back(
-                    std::move(
-                        BaseOverlay::ColoredLine{ 
-                            BaseOverlay::GetPointForAction(ctx, *prevAction),
-                            point,
-                            SelectedLineColor
-                        })
-                );
+                coloredLines.emplace_back(
+                    BaseOverlay::ColoredLine{ 
+                        BaseOverlay::GetPointForAction(ctx, *prevAction),
+                        point,
+                        SelectedLineColor
+                    });
             }
 
             prevAction = &action;
@@ -265,24 +261,23 @@ void BaseOverlay::DrawActionLines(const OverlayDrawingCtx& ctx) noexcept
 {
     if (!BaseOverlay::ShowLines) return;
     OFS_PROFILE(__FUNCTION__);
-    auto& drawingScript = ctx.DrawingScript();
     auto& state = BaseOverlayState::State(StateHandle);
 
-    auto startIt = drawingScript->Actions().begin() + ctx.actionFromIdx;
-    auto endIt = drawingScript->Actions().begin() + ctx.actionToIdx;
-    ColoredLines.clear();
+    // at most one line per visible action plus the selection, lives until the end of the frame
+    ColoredLines coloredLines;
+    coloredLines.reserve((ctx.actionToIdx - ctx.actionFromIdx) + (ctx.selectionToIdx - ctx.selectionFromIdx));
     
     if(state.SplineMode)
     {
-        drawActionLinesSpline(ctx, state);
+        drawActionLinesSpline(ctx, state, coloredLines);
     }
     else 
     {
-        drawActionLinesLinear(ctx, state);
+        drawActionLinesLinear(ctx, state, coloredLines);
     }
 
     // this is so that the black background line gets rendered first
-    for (auto&& line : ColoredLines) {
+    for (auto&& line : coloredLines) {
         ctx.drawList->AddLine(line.p1, line.p2, line.color, 3.f);
     }
 }
@@ -8,6 +8,7 @@
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "GradientBar.h"
+#include "OFS_FrameArena.h"
 
 #include "state/states/BaseOverlayState.h"
 
@@ -45,8 +46,15 @@ protected:
 	class ScriptTimeline* timeline;
 	static uint32_t StateHandle;
 
-	static void drawActionLinesSpline(const OverlayDrawingCtx& ctx, const BaseOverlayState& state) noexcept;
-	static void drawActionLinesLinear(const OverlayDrawingCtx& ctx, const BaseOverlayState& state) noexcept;
+	struct ColoredLine {
+		ImVec2 p1;
+		ImVec2 p2;
+		uint32_t color;
+	};
+	using ColoredLines = OFS_FrameVector<ColoredLine>;
+
+	static void drawActionLinesSpline(const OverlayDrawingCtx& ctx, const BaseOverlayState& state, ColoredLines& coloredLines) noexcept;
+	static void drawActionLinesLinear(const OverlayDrawingCtx& ctx, const BaseOverlayState& state, ColoredLines& coloredLines) noexcept;
 
 public:
 	inline static BaseOverlayState& State() noexcept
@@ -54,12 +62,6 @@ public:
 		return BaseOverlayState::State(StateHandle);
 	}
 
-	struct ColoredLine {
-		ImVec2 p1;
-		ImVec2 p2;
-		uint32_t color;
-	};
-	static std::vector<ColoredLine> ColoredLines;
 	static float PointSize;
 	
 	static bool ShowLines;
@@ -77,6 +79,7 @@ public:
 	virtual float steppingIntervalForward(float realFrameTime, float fromTime) noexcept = 0;
 	virtual float steppingIntervalBackward(float realFrameTime, float fromTime) noexcept = 0;
 	virtual float logicalFrameTime(float realFrameTime) noexcept;
+	virtual float snapTime(float time) noexcept { return time; }
 
 	static void DrawActionLines(const OverlayDrawingCtx& ctx) noexcept;
 	static void DrawActionPoints(const OverlayDrawingCtx& ctx) noexcept;
@@ -1,7 +1,19 @@
 #include "OFS_Event.h"
 #include "OFS_EventSystem.h"
 
+#include <cctype>
+#include <cstring>
+
 OFS_EventType BaseEvent::RegisterNewEvent() noexcept
 {
     return EV::RegisterEvent();
 }
+
+const char* BaseEvent::CleanTypeName(const char* mangledName) noexcept
+{
+    // msvc prefixes the name with "class ", gcc and clang with its length
+    if(strncmp(mangledName, "class ", 6) == 0) return mangledName + 6;
+    if(strncmp(mangledName, "struct ", 7) == 0) return mangledName + 7;
+    while(std::isdigit((unsigned char)*mangledName)) mangledName += 1;
+    return mangledName;
+}
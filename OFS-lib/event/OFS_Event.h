@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <typeinfo>
 
 using OFS_EventType = uint32_t;
 
@@ -15,7 +16,10 @@ class BaseEvent
     static constexpr OFS_EventType InvalidType = 0;
     virtual ~BaseEvent() noexcept {}
     virtual OFS_EventType Type() const noexcept = 0;
+    virtual const char* Name() const noexcept = 0;
     static OFS_EventType RegisterNewEvent() noexcept;
+    // strips what the compiler adds to typeid names
+    static const char* CleanTypeName(const char* mangledName) noexcept;
 };
 
 using EventPointer = std::shared_ptr<BaseEvent>;
@@ -26,6 +30,19 @@ class OFS_Event : public BaseEvent
     public:
     static OFS_EventType EventType;
     OFS_EventType Type() const noexcept override { return EventType; }
+    const char* Name() const noexcept override { return TypeName(); }
+
+    inline static const char* TypeName() noexcept
+    {
+        static const char* name = CleanTypeName(typeid(Event).name());
+        return name;
+    }
+
+    // Events which only carry the latest state can redeclare Coalescing as true.
+    // A pending event with the same CoalescingKey then gets merged instead of queueing another one.
+    static constexpr bool Coalescing = false;
+    inline uint64_t CoalescingKey() const noexcept { return 0; }
+    inline void Merge(const Event& newer) noexcept { static_cast<Event&>(*this) = newer; }
 
     template<typename Handler>
     static auto HandleEvent(Handler&& handler) noexcept
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "SDL_atomic.h"
+
+// Totals over all event pools.
+struct OFS_EventPoolStats
+{
+    static SDL_atomic_t Allocations;
+    // allocations which couldn't be served from a freelist
+    static SDL_atomic_t HeapAllocations;
+};
+
+// Freelist of equally sized blocks, shared by all events with the same size and alignment.
+// Blocks are reused forever, the list is intentionally never destroyed so events
+// released during static destruction are still safe.
+template<size_t Size, size_t Align>
+class OFS_EventFreeList
+{
+    private:
+    struct Node { Node* next; };
+    static constexpr size_t BlockSize = Size < sizeof(Node) ? sizeof(Node) : Size;
+    static_assert(Align <= alignof(std::max_align_t), "over-aligned events aren't supported");
+    // blocks beyond this go back to the heap
+    static constexpr uint32_t MaxFreeBlocks = 1024;
+
+    SDL_SpinLock lock;
+    Node* head;
+    uint32_t freeBlocks;
+
+    public:
+    inline static OFS_EventFreeList& Get() noexcept
+    {
+        static OFS_EventFreeList list{};
+        return list;
+    }
+
+    inline void* Pop() noexcept
+    {
+        SDL_AtomicIncRef(&OFS_EventPoolStats::Allocations);
+        SDL_AtomicLock(&lock);
+        Node* node = head;
+        if(node) {
+            head = node->next;
+            freeBlocks -= 1;
+        }
+        SDL_AtomicUnlock(&lock);
+        if(node) return node;
+
+        SDL_AtomicIncRef(&OFS_EventPoolStats::HeapAllocations);
+        return ::operator new(BlockSize);
+    }
+
+    inline void Push(void* block) noexcept
+    {
+        SDL_AtomicLock(&lock);
+        bool keep = freeBlocks < MaxFreeBlocks;
+        if(keep) {
+            auto node = static_cast<Node*>(block);
+            node->next = head;
+            head = node;
+            freeBlocks += 1;
+        }
+        SDL_AtomicUnlock(&lock);
+        if(!keep) ::operator delete(block);
+    }
+};
+
+// Used with std::allocate_shared, the event and its reference count live in one pooled block.
+template<typename T>
+struct OFS_EventAllocator
+{
+    using value_type = T;
+
+    OFS_EventAllocator() noexcept = default;
+    template<typename U>
+    OFS_EventAllocator(const OFS_EventAllocator<U>&) noexcept {}
+
+    inline T* allocate(size_t n) noexcept
+    {
+        if(n != 1) {
+            SDL_AtomicIncRef(&OFS_EventPoolStats::HeapAllocations);
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(OFS_EventFreeList<sizeof(T), alignof(T)>::Get().Pop());
+    }
+
+    inline void deallocate(T* ptr, size_t n) noexcept
+    {
+        if(n != 1) {
+            ::operator delete(ptr);
+            return;
+        }
+        OFS_EventFreeList<sizeof(T), alignof(T)>::Get().Push(ptr);
+    }
+
+    template<typename U>
+    inline bool operator==(const OFS_EventAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    inline bool operator!=(const OFS_EventAllocator<U>&) const noexcept { return false; }
+};
@@ -1,9 +1,26 @@
 #include "OFS_EventSystem.h"
 
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+
 #include "SDL_events.h"
+#include "imgui.h"
+
+#include <cfloat>
+#include <cinttypes>
+#include <cmath>
 
 EV* EV::instance = nullptr;
 
+SDL_atomic_t OFS_EventPoolStats::Allocations = {0};
+SDL_atomic_t OFS_EventPoolStats::HeapAllocations = {0};
+
+OFS_EventTraceSample OFS_EventTrace::samples[OFS_EventTrace::Capacity] = {};
+SDL_atomic_t OFS_EventTrace::writeIndex = {0};
+SDL_atomic_t OFS_EventTrace::nextListener = {0};
+uint32_t OFS_EventTrace::readIndex = 0;
+SDL_atomic_t OFS_EventTrace::Enabled = {0};
+
 // In order to not collide with SDL_Event types the counter starts at SDL_USEREVENT
 uint32_t EV::eventCounter = SDL_USEREVENT;
 
@@ -23,3 +40,256 @@ bool EV::Init() noexcept
     return true;
 }
 
+bool EV::process() noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    // events enqueued from now on start a new pending event instead of merging into one being dispatched
+    SDL_AtomicLock(&eventLock);
+    dispatching.swap(pending);
+    uint32_t queueDepth = 0;
+    for(auto& stats : typeStats) {
+        stats.lastDepth = stats.queued;
+        stats.maxDepth = Util::Max(stats.maxDepth, stats.queued);
+        stats.dispatched += stats.queued;
+        queueDepth += stats.queued;
+        stats.queued = 0;
+    }
+    SDL_AtomicUnlock(&eventLock);
+
+    uint32_t allocations = SDL_AtomicGet(&OFS_EventPoolStats::Allocations);
+    uint32_t heapAllocations = SDL_AtomicGet(&OFS_EventPoolStats::HeapAllocations);
+    lastFrame.allocations = allocations - allocationsTotal;
+    lastFrame.heapAllocations = heapAllocations - heapAllocationsTotal;
+    lastFrame.queueDepth = queueDepth;
+    allocationsTotal = allocations;
+    heapAllocationsTotal = heapAllocations;
+    for(auto& ev : dispatching) {
+        queue.enqueue(std::move(ev.event));
+    }
+    dispatching.clear();
+    bool processed = queue.process();
+    collectTrace();
+    return processed;
+}
+
+void EV::collectTrace() noexcept
+{
+    static const double ticksToUs = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    droppedSamples += OFS_EventTrace::Drain([this](OFS_EventType type, uint32_t listener, uint64_t ticks) noexcept {
+        if(listener >= listenerStats.size()) {
+            listenerStats.resize(listener + 1);
+        }
+        auto& stats = listenerStats[listener];
+        stats.type = type;
+        stats.calls += 1;
+        stats.totalTicks += ticks;
+        stats.maxTicks = Util::Max(stats.maxTicks, ticks);
+
+        double us = ticks * ticksToUs;
+        uint32_t bucket = us < 1.0 ? 0 : (uint32_t)std::log2(us) + 1;
+        stats.histogram[Util::Min(bucket, HistogramBuckets - 1)] += 1;
+    });
+}
+
+void EV::resetStats() noexcept
+{
+    SDL_AtomicLock(&eventLock);
+    for(auto& stats : typeStats) {
+        stats.enqueued = 0;
+        stats.coalesced = 0;
+        stats.dispatched = 0;
+        stats.maxDepth = 0;
+    }
+    SDL_AtomicUnlock(&eventLock);
+    listenerStats.clear();
+    droppedSamples = 0;
+}
+
+BaseEvent* EV::findPending(OFS_EventType type, uint64_t key) noexcept
+{
+    for(auto& ev : pending) {
+        if(ev.type == type && ev.key == key) return ev.event.get();
+    }
+    return nullptr;
+}
+
+EV::TypeStats& EV::statsFor(OFS_EventType type, const char* typeName) noexcept
+{
+    // registered event types are consecutive, starting after SDL_USEREVENT
+    uint32_t idx = type > SDL_USEREVENT ? type - SDL_USEREVENT - 1 : 0;
+    if(idx >= typeStats.size()) {
+        typeStats.resize(idx + 1);
+    }
+    auto& stats = typeStats[idx];
+    if(!stats.name) {
+        stats.name = typeName;
+    }
+    return stats;
+}
+
+static const char* eventName(const char* name, OFS_EventType type, char (&buffer)[32]) noexcept
+{
+    if(name) return name;
+    stbsp_snprintf(buffer, sizeof(buffer), "Event %u", type);
+    return buffer;
+}
+
+void EV::ShowDebugWindow(bool* open) noexcept
+{
+    if(!*open) return;
+    OFS_PROFILE(__FUNCTION__);
+    auto self = Get();
+    ImGui::Begin("Events", open, ImGuiWindowFlags_None);
+    ImGui::Text("Last frame: %u queued, %u allocated, %u from the heap",
+        self->lastFrame.queueDepth, self->lastFrame.allocations, self->lastFrame.heapAllocations);
+
+    bool tracing = OFS_EventTrace::IsEnabled();
+    if(ImGui::Checkbox("Time listeners", &tracing)) {
+        SDL_AtomicSet(&OFS_EventTrace::Enabled, tracing);
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Reset")) {
+        self->resetStats();
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Export CSV")) {
+        Util::SaveFileDialog("Export event stats", Util::Prefpath("events.csv"),
+            [](auto& result) noexcept {
+                if(!result.files.empty() && !ExportStatsCsv(result.files[0])) {
+                    LOGF_ERROR("Failed to export event stats to \"%s\"", result.files[0].c_str());
+                }
+            }, { "CSV", "*.csv" });
+    }
+    if(self->droppedSamples > 0) {
+        ImGui::TextDisabled("%" PRIu64 " samples were dropped", self->droppedSamples);
+    }
+
+    char buffer[32];
+    if(ImGui::BeginTable("##EventStats", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Event");
+        ImGui::TableSetupColumn("Enqueued");
+        ImGui::TableSetupColumn("Coalesced");
+        ImGui::TableSetupColumn("Dispatched");
+        ImGui::TableSetupColumn("Depth");
+        ImGui::TableSetupColumn("Max depth");
+        ImGui::TableHeadersRow();
+
+        SDL_AtomicLock(&self->eventLock);
+        for(uint32_t i = 0, size = self->typeStats.size(); i < size; i += 1) {
+            auto& stats = self->typeStats[i];
+            if(stats.enqueued == 0) continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(eventName(stats.name, SDL_USEREVENT + 1 + i, buffer));
+            ImGui::TableNextColumn();
+            ImGui::Text("%" PRIu64, stats.enqueued);
+            ImGui::TableNextColumn();
+            ImGui::Text("%" PRIu64, stats.coalesced);
+            ImGui::TableNextColumn();
+            ImGui::Text("%" PRIu64, stats.dispatched);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.lastDepth);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.maxDepth);
+        }
+        SDL_AtomicUnlock(&self->eventLock);
+        ImGui::EndTable();
+    }
+
+    if(!self->listenerStats.empty() && ImGui::BeginTable("##ListenerStats", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        static const double ticksToMs = 1000.0 / (double)SDL_GetPerformanceFrequency();
+        ImGui::TableSetupColumn("Listener");
+        ImGui::TableSetupColumn("Event");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableSetupColumn("Histogram (1us - 16ms)");
+        ImGui::TableHeadersRow();
+
+        for(uint32_t i = 0, size = self->listenerStats.size(); i < size; i += 1) {
+            auto& stats = self->listenerStats[i];
+            if(stats.calls == 0) continue;
+            const char* name = nullptr;
+            uint32_t typeIdx = stats.type - SDL_USEREVENT - 1;
+            SDL_AtomicLock(&self->eventLock);
+            if(typeIdx < self->typeStats.size()) name = self->typeStats[typeIdx].name;
+            SDL_AtomicUnlock(&self->eventLock);
+
+            float histogram[HistogramBuckets];
+            for(uint32_t bucket = 0; bucket < HistogramBuckets; bucket += 1) {
+                histogram[bucket] = (float)stats.histogram[bucket];
+            }
+
+            ImGui::PushID(i);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("#%u", i);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(eventName(name, stats.type, buffer));
+            ImGui::TableNextColumn();
+            ImGui::Text("%" PRIu64, stats.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.totalTicks * ticksToMs / stats.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.maxTicks * ticksToMs);
+            ImGui::TableNextColumn();
+            ImGui::PlotHistogram("##Histogram", histogram, HistogramBuckets, 0, nullptr, 0.f, FLT_MAX, ImVec2(160.f, ImGui::GetTextLineHeight()));
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+bool EV::ExportStatsCsv(const std::string& path) noexcept
+{
+    auto self = Get();
+    const double ticksToMs = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    char line[512];
+    char nameBuffer[32];
+    std::string csv = "event,enqueued,coalesced,dispatched,max_depth,listener,calls,avg_ms,max_ms";
+    for(uint32_t bucket = 0; bucket < HistogramBuckets - 1; bucket += 1) {
+        stbsp_snprintf(line, sizeof(line), ",lt_%uus", 1u << bucket);
+        csv += line;
+    }
+    stbsp_snprintf(line, sizeof(line), ",ge_%uus", 1u << (HistogramBuckets - 2));
+    csv += line;
+    csv += '\n';
+
+    SDL_AtomicLock(&self->eventLock);
+    auto typeStats = self->typeStats;
+    SDL_AtomicUnlock(&self->eventLock);
+
+    for(uint32_t i = 0, size = typeStats.size(); i < size; i += 1) {
+        auto& stats = typeStats[i];
+        if(stats.enqueued == 0) continue;
+        OFS_EventType type = SDL_USEREVENT + 1 + i;
+        int prefix = stbsp_snprintf(line, sizeof(line), "%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%u,",
+            eventName(stats.name, type, nameBuffer), stats.enqueued, stats.coalesced, stats.dispatched, stats.maxDepth);
+
+        bool hasListener = false;
+        for(uint32_t listener = 0, count = self->listenerStats.size(); listener < count; listener += 1) {
+            auto& lstats = self->listenerStats[listener];
+            if(lstats.type != type || lstats.calls == 0) continue;
+            hasListener = true;
+            csv.append(line, prefix);
+            char values[256];
+            stbsp_snprintf(values, sizeof(values), "%u,%" PRIu64 ",%.4f,%.4f",
+                listener, lstats.calls, lstats.totalTicks * ticksToMs / lstats.calls, lstats.maxTicks * ticksToMs);
+            csv += values;
+            for(auto count : lstats.histogram) {
+                stbsp_snprintf(values, sizeof(values), ",%u", count);
+                csv += values;
+            }
+            csv += '\n';
+        }
+        // events nobody listened to while tracing still get a row
+        if(!hasListener) {
+            csv.append(line, prefix);
+            csv += ",,,";
+            csv.append(HistogramBuckets, ',');
+            csv += '\n';
+        }
+    }
+    return Util::WriteFile(path.c_str(), csv.data(), csv.size()) == csv.size();
+}
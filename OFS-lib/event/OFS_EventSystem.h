@@ -1,11 +1,18 @@
 #pragma once
 
 #include "OFS_Event.h"
+#include "OFS_EventPool.h"
+#include "OFS_EventTrace.h"
+#include "OFS_Redraw.h"
 #include "eventpp/eventqueue.h"
+#include <array>
+#include <string>
 #include <vector>
 
 struct OFS_EventPolicy
 {
+    using Callback = OFS_EventCallback;
+
     static OFS_EventType getEvent(const EventPointer& event) 
     {
         return event->Type();
@@ -14,15 +21,95 @@ struct OFS_EventPolicy
 
 class EV
 {
+    public:
+    // event allocations between the last two Process calls
+    struct FrameStats
+    {
+        uint32_t allocations = 0;
+        uint32_t heapAllocations = 0;
+        uint32_t queueDepth = 0;
+    };
+
+    struct TypeStats
+    {
+        const char* name = nullptr;
+        uint64_t enqueued = 0;
+        uint64_t coalesced = 0;
+        uint64_t dispatched = 0;
+        // in the queue right now
+        uint32_t queued = 0;
+        uint32_t lastDepth = 0;
+        uint32_t maxDepth = 0;
+    };
+
+    // bucket 0 is below 1us, bucket n covers [2^(n-1), 2^n) microseconds, the last one everything above
+    static constexpr uint32_t HistogramBuckets = 16;
+    struct ListenerStats
+    {
+        OFS_EventType type = 0;
+        uint64_t calls = 0;
+        uint64_t totalTicks = 0;
+        uint64_t maxTicks = 0;
+        std::array<uint32_t, HistogramBuckets> histogram = {};
+    };
+
     private:
+    struct PendingEvent
+    {
+        OFS_EventType type;
+        uint64_t key;
+        EventPointer event;
+    };
+
     static EV* instance;
     static uint32_t eventCounter;
     eventpp::EventQueue<OFS_EventType, void(const EventPointer&), OFS_EventPolicy> queue;
-    inline bool process() noexcept { return queue.process(); }
+    FrameStats lastFrame;
+    uint32_t allocationsTotal = 0;
+    uint32_t heapAllocationsTotal = 0;
+
+    // guards pending and typeStats, events get enqueued from other threads too
+    SDL_SpinLock eventLock = {0};
+    // coalescing events which haven't been dispatched yet, they only enter the queue in process
+    // so nothing can be merged into an event which is already being dispatched
+    std::vector<PendingEvent> pending;
+    // main thread, pending events taken by process, kept to reuse the allocation
+    std::vector<PendingEvent> dispatching;
+    std::vector<TypeStats> typeStats;
+    // indexed by listener id, only touched on the main thread
+    std::vector<ListenerStats> listenerStats;
+    uint64_t droppedSamples = 0;
+
+    bool process() noexcept;
+    void collectTrace() noexcept;
+    void resetStats() noexcept;
+    BaseEvent* findPending(OFS_EventType type, uint64_t key) noexcept;
+    TypeStats& statsFor(OFS_EventType type, const char* typeName) noexcept;
+
+    template<typename Event>
+    inline void enqueueCoalescing(Event&& ev) noexcept
+    {
+        const uint64_t key = ev.CoalescingKey();
+        SDL_AtomicLock(&eventLock);
+        auto& stats = statsFor(Event::EventType, Event::TypeName());
+        stats.enqueued += 1;
+        if(auto pendingEvent = findPending(Event::EventType, key)) {
+            static_cast<Event*>(pendingEvent)->Merge(ev);
+            stats.coalesced += 1;
+            SDL_AtomicUnlock(&eventLock);
+            return;
+        }
+        stats.queued += 1;
+        pending.emplace_back(PendingEvent{ Event::EventType, key, MakeTyped<Event>(std::move(ev)) });
+        SDL_AtomicUnlock(&eventLock);
+    }
     public:
 
     static bool Init() noexcept;
     inline static void Process() noexcept { Get()->process(); }
+    inline static const FrameStats& LastFrameStats() noexcept { return Get()->lastFrame; }
+    static void ShowDebugWindow(bool* open) noexcept;
+    static bool ExportStatsCsv(const std::string& path) noexcept;
     inline static OFS_EventType RegisterEvent() noexcept { return ++eventCounter; }
 
     inline static EV* Get() noexcept { return instance; }
@@ -41,25 +128,43 @@ class EV
     template<typename Event, typename... Args>
     inline static EventPointer Make(Args&&... args) noexcept
     {
-        return std::static_pointer_cast<BaseEvent>(
-            std::make_shared<Event>(std::forward<Args>(args)...)
-        );
+        return MakeTyped<Event>(std::forward<Args>(args)...);
     }
 
     template<typename Event, typename... Args>
-    inline static auto MakeTyped(Args&&... args) noexcept
+    inline static std::shared_ptr<Event> MakeTyped(Args&&... args) noexcept
     {
-        return std::make_shared<Event>(std::forward<Args>(args)...);
+        return std::allocate_shared<Event>(OFS_EventAllocator<Event>(), std::forward<Args>(args)...);
     }
 
     template<typename Event, typename... Args>
     inline static void Enqueue(Args&&... args) noexcept
     {
-        Queue().enqueue(Make<Event>(std::forward<Args>(args)...));
+        auto self = Get();
+        // the event gets dispatched by the next frame
+        OFS_Redraw::Request(1);
+        if constexpr (Event::Coalescing) {
+            self->enqueueCoalescing(Event(std::forward<Args>(args)...));
+        }
+        else {
+            SDL_AtomicLock(&self->eventLock);
+            auto& stats = self->statsFor(Event::EventType, Event::TypeName());
+            stats.enqueued += 1;
+            stats.queued += 1;
+            SDL_AtomicUnlock(&self->eventLock);
+            self->queue.enqueue(Make<Event>(std::forward<Args>(args)...));
+        }
     }
     inline static void Enqueue(EventPointer ev) noexcept
     {
-        Queue().enqueue(ev);
+        auto self = Get();
+        OFS_Redraw::Request(1);
+        SDL_AtomicLock(&self->eventLock);
+        auto& stats = self->statsFor(ev->Type(), ev->Name());
+        stats.enqueued += 1;
+        stats.queued += 1;
+        SDL_AtomicUnlock(&self->eventLock);
+        self->queue.enqueue(std::move(ev));
     }
 };
 
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "OFS_Event.h"
+#include "OFS_Profiling.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#include "SDL_atomic.h"
+#include "SDL_timer.h"
+
+// One listener call.
+struct OFS_EventTraceSample
+{
+    // 0 while being written, the write index + 1 once the sample is complete
+    SDL_atomic_t sequence;
+    OFS_EventType type;
+    uint32_t listener;
+    uint64_t durationTicks;
+};
+
+// Listener timings, written by whichever thread dispatches and drained on the main thread.
+// Writers claim a slot with an atomic increment, there are no locks on the dispatch path.
+// A writer which laps the ring can overwrite a slot while it's read, so every slot is a seqlock.
+class OFS_EventTrace
+{
+    public:
+    static constexpr uint32_t Capacity = 4096;
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+    private:
+    static OFS_EventTraceSample samples[Capacity];
+    static SDL_atomic_t writeIndex;
+    static SDL_atomic_t nextListener;
+    static uint32_t readIndex;
+
+    public:
+    static SDL_atomic_t Enabled;
+
+    inline static bool IsEnabled() noexcept { return SDL_AtomicGet(&Enabled) != 0; }
+    inline static uint32_t NextListenerId() noexcept { return (uint32_t)SDL_AtomicAdd(&nextListener, 1); }
+
+    inline static void Record(OFS_EventType type, uint32_t listener, uint64_t durationTicks) noexcept
+    {
+        uint32_t index = (uint32_t)SDL_AtomicAdd(&writeIndex, 1);
+        auto& sample = samples[index & (Capacity - 1)];
+        SDL_AtomicSet(&sample.sequence, 0);
+        SDL_MemoryBarrierRelease();
+        sample.type = type;
+        sample.listener = listener;
+        sample.durationTicks = durationTicks;
+        SDL_AtomicSet(&sample.sequence, (int)(index + 1));
+    }
+
+    // Main thread. Calls fn for every complete sample since the last drain,
+    // returns how many were overwritten before they could be read.
+    template<typename Fn>
+    static uint32_t Drain(Fn&& fn) noexcept
+    {
+        uint32_t end = (uint32_t)SDL_AtomicGet(&writeIndex);
+        uint32_t dropped = 0;
+        if(end - readIndex > Capacity) {
+            dropped = end - readIndex - Capacity;
+            readIndex = end - Capacity;
+        }
+        for(; readIndex != end; readIndex += 1) {
+            auto& sample = samples[readIndex & (Capacity - 1)];
+            uint32_t sequence = (uint32_t)SDL_AtomicGet(&sample.sequence);
+            if(sequence != readIndex + 1) {
+                // already overwritten by a writer which lapped the ring
+                if(sequence != 0 && (int32_t)(sequence - (readIndex + 1)) > 0) {
+                    dropped += 1;
+                    continue;
+                }
+                // still being written, picked up by the next drain
+                break;
+            }
+            auto type = sample.type;
+            auto listener = sample.listener;
+            auto durationTicks = sample.durationTicks;
+            SDL_MemoryBarrierAcquire();
+            // overwritten while copying, the copy may be torn
+            if((uint32_t)SDL_AtomicGet(&sample.sequence) != readIndex + 1) {
+                dropped += 1;
+                continue;
+            }
+            fn(type, listener, durationTicks);
+        }
+        return dropped;
+    }
+};
+
+// Used by eventpp for every listener, times the call while tracing is enabled.
+class OFS_EventCallback
+{
+    private:
+    std::function<void(const EventPointer&)> function;
+    uint32_t listener = 0;
+
+    public:
+    OFS_EventCallback() noexcept = default;
+
+    template<typename Fn, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Fn>, OFS_EventCallback>>>
+    OFS_EventCallback(Fn&& fn) noexcept
+        : function(std::forward<Fn>(fn)), listener(OFS_EventTrace::NextListenerId()) {}
+
+    inline explicit operator bool() const noexcept { return (bool)function; }
+    inline uint32_t Listener() const noexcept { return listener; }
+
+    inline void operator()(const EventPointer& ev) const noexcept
+    {
+        OFS_PROFILE_DYNAMIC(ev->Name(), strlen(ev->Name()));
+        if(!OFS_EventTrace::IsEnabled()) {
+            function(ev);
+            return;
+        }
+        uint64_t start = SDL_GetPerformanceCounter();
+        function(ev);
+        OFS_EventTrace::Record(ev->Type(), listener, SDL_GetPerformanceCounter() - start);
+    }
+};
@@ -0,0 +1,468 @@
+#pragma once
+#include "OFS_Serialization.h"
+#include "OFS_BinarySerialization.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <array>
+#include <vector>
+#include <type_traits>
+
+/*
+    Binary format of the application and project state files.
+
+    file:   u32 magic "OFSS", u16 format version, u32 state count, states
+    state:  string name, string type name, u32 size, object
+    object: u16 field count, fields
+    field:  u32 name hash, u8 wire type, u32 size, value
+    array:  u8 item wire type, u8 item size (0 if it varies), u32 count, items
+    string: u32 length, bytes (also used for byte vectors)
+
+    Numbers are stored with their own width and converted on load.
+    Unknown fields, fields whose type changed and unknown states are skipped,
+    missing fields keep their default value. Fields can be added, removed and reordered
+    without touching FormatVersion.
+*/
+class OFS_StateBinary
+{
+public:
+    static constexpr uint32_t Magic = 0x5353464F; // "OFSS"
+    static constexpr uint16_t FormatVersion = 1;
+
+    enum class WireType : uint8_t
+    {
+        Int = 1,
+        UInt,
+        Float,
+        String,
+        Bytes,
+        Array,
+        Object
+    };
+
+    inline static bool HasHeader(const ByteBuffer& buffer) noexcept
+    {
+        return buffer.size() >= sizeof(uint32_t)
+            && buffer[0] == 'O' && buffer[1] == 'F' && buffer[2] == 'S' && buffer[3] == 'S';
+    }
+
+    // FNV-1a
+    inline static uint32_t FieldHash(std::string_view name) noexcept
+    {
+        uint32_t hash = 2166136261u;
+        for (char c : name) {
+            hash ^= (uint8_t)c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // bitsery copies buffers of integers only, floats are copied as their bits
+    template<typename T>
+    using raw_type_t = std::conditional_t<sizeof(T) == 1, uint8_t,
+        std::conditional_t<sizeof(T) == 2, uint16_t,
+        std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+    template<typename T>
+    struct is_byte_vector : std::false_type {};
+    template<typename Allocator>
+    struct is_byte_vector<std::vector<uint8_t, Allocator>> : std::true_type {};
+
+    template<typename T>
+    static constexpr WireType WireTypeOf() noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>) return WireType::UInt;
+        else if constexpr (std::is_floating_point_v<T>) return WireType::Float;
+        else if constexpr (std::is_integral_v<T>) return std::is_signed_v<T> ? WireType::Int : WireType::UInt;
+        else if constexpr (std::is_same_v<T, std::string>) return WireType::String;
+        else if constexpr (is_byte_vector<T>::value) return WireType::Bytes;
+        else if constexpr (refl::trait::is_container_v<T>) return WireType::Array;
+        else return WireType::Object;
+    }
+};
+
+// Writes straight into the output buffer, sizes get patched in once a field is complete.
+class OFS_StateWriter
+{
+private:
+    bitsery::Serializer<OutputAdapter> ser;
+
+    template<typename T>
+    inline void writeScalar(const T& value) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            uint8_t byte = value ? 1 : 0;
+            ser.value1b(byte);
+        }
+        else {
+            ser.template value<sizeof(T)>(value);
+        }
+    }
+
+    template<typename T>
+    void writeArray(const T& container) noexcept
+    {
+        using ItemType = std::remove_const_t<std::remove_reference_t<decltype(*std::begin(container))>>;
+        constexpr auto itemWireType = OFS_StateBinary::WireTypeOf<ItemType>();
+        constexpr bool isScalar = itemWireType <= OFS_StateBinary::WireType::Float;
+
+        ser.value1b((uint8_t)itemWireType);
+        ser.value1b((uint8_t)(isScalar ? (std::is_same_v<ItemType, bool> ? 1 : sizeof(ItemType)) : 0));
+        ser.value4b((uint32_t)std::size(container));
+        if constexpr (isScalar && !std::is_same_v<ItemType, bool>) {
+            using RawType = OFS_StateBinary::raw_type_t<ItemType>;
+            ser.adapter().template writeBuffer<sizeof(ItemType)>(reinterpret_cast<const RawType*>(std::data(container)), std::size(container));
+        }
+        else {
+            for (auto& item : container) Value(item);
+        }
+    }
+
+    template<typename T>
+    void writeObject(const T& obj) noexcept
+    {
+        uint16_t fieldCount = 0;
+        for_each(refl::reflect(obj).members, [&](auto member) noexcept {
+            if constexpr (refl::descriptor::is_field(member) && !refl::descriptor::is_static(member)) {
+                fieldCount += 1;
+            }
+        });
+        ser.value2b(fieldCount);
+
+        for_each(refl::reflect(obj).members, [&](auto member) noexcept {
+            if constexpr (refl::descriptor::is_field(member) && !refl::descriptor::is_static(member)) {
+                auto& memberRef = member(obj);
+                using MemberType = std::remove_const_t<std::remove_reference_t<decltype(memberRef)>>;
+                if constexpr (refl::descriptor::has_attribute<serializeEnum>(member)) {
+                    using EnumType = typename std::underlying_type<MemberType>::type;
+                    Field(get_display_name(member), static_cast<EnumType>(memberRef));
+                }
+                else {
+                    Field(get_display_name(member), memberRef);
+                }
+            }
+        });
+    }
+
+public:
+    explicit OFS_StateWriter(ByteBuffer& buffer) noexcept
+        : ser(buffer) {}
+
+    inline size_t Position() noexcept { return ser.adapter().currentWritePos(); }
+
+    // Reserves a u32 which EndSize fills with the amount of bytes written in between.
+    inline size_t BeginSize() noexcept
+    {
+        size_t sizePos = Position();
+        ser.value4b(uint32_t(0));
+        return sizePos;
+    }
+
+    inline void EndSize(size_t sizePos) noexcept
+    {
+        auto& adapter = ser.adapter();
+        size_t end = adapter.currentWritePos();
+        adapter.currentWritePos(sizePos);
+        ser.value4b((uint32_t)(end - sizePos - sizeof(uint32_t)));
+        adapter.currentWritePos(end);
+    }
+
+    inline void Header(uint32_t stateCount) noexcept
+    {
+        ser.value4b(OFS_StateBinary::Magic);
+        ser.value2b(OFS_StateBinary::FormatVersion);
+        ser.value4b(stateCount);
+    }
+
+    inline void String(std::string_view str) noexcept
+    {
+        ser.value4b((uint32_t)str.size());
+        ser.adapter().template writeBuffer<1>(str.data(), str.size());
+    }
+
+    // Returns the amount of bytes written, the buffer may be bigger than that.
+    inline size_t Finish() noexcept
+    {
+        ser.adapter().flush();
+        return ser.adapter().writtenBytesCount();
+    }
+
+    template<typename T>
+    void Value(const T& value) noexcept
+    {
+        constexpr auto wireType = OFS_StateBinary::WireTypeOf<T>();
+        if constexpr (wireType <= OFS_StateBinary::WireType::Float) {
+            writeScalar(value);
+        }
+        else if constexpr (wireType == OFS_StateBinary::WireType::String) {
+            String(value);
+        }
+        else if constexpr (wireType == OFS_StateBinary::WireType::Bytes) {
+            ser.value4b((uint32_t)value.size());
+            ser.adapter().template writeBuffer<1>(value.data(), value.size());
+        }
+        else if constexpr (wireType == OFS_StateBinary::WireType::Array) {
+            writeArray(value);
+        }
+        else {
+            writeObject(value);
+        }
+    }
+
+    template<typename T>
+    void Field(const char* name, const T& value) noexcept
+    {
+        ser.value4b(OFS_StateBinary::FieldHash(name));
+        ser.value1b((uint8_t)OFS_StateBinary::WireTypeOf<T>());
+        size_t sizePos = BeginSize();
+        Value(value);
+        EndSize(sizePos);
+    }
+};
+
+// Reads from the file buffer, every read is checked against the end of the enclosing field.
+// Corrupt data fails the whole read, values of the wrong type are only skipped.
+class OFS_StateReader
+{
+private:
+    bitsery::Deserializer<InputAdapter> des;
+    size_t bufferSize;
+    bool corrupt = false;
+
+    inline bool fits(size_t bytes, size_t end) noexcept
+    {
+        if (corrupt || Position() + bytes > end) {
+            corrupt = true;
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    bool readScalar(T& value, OFS_StateBinary::WireType wireType, uint32_t width, size_t end) noexcept
+    {
+        if (!fits(width, end)) return false;
+        if (wireType == OFS_StateBinary::WireType::Float) {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (width == sizeof(float)) { float v; des.value4b(v); value = (T)v; return true; }
+                if (width == sizeof(double)) { double v; des.value8b(v); value = (T)v; return true; }
+            }
+            return false;
+        }
+
+        if constexpr (std::is_integral_v<T>) {
+            if (wireType == OFS_StateBinary::WireType::Int) {
+                int64_t v;
+                switch (width) {
+                    case 1: { int8_t x; des.value1b(x); v = x; break; }
+                    case 2: { int16_t x; des.value2b(x); v = x; break; }
+                    case 4: { int32_t x; des.value4b(x); v = x; break; }
+                    case 8: { int64_t x; des.value8b(x); v = x; break; }
+                    default: return false;
+                }
+                if constexpr (std::is_same_v<T, bool>) value = v != 0; else value = (T)v;
+                return true;
+            }
+            else if (wireType == OFS_StateBinary::WireType::UInt) {
+                uint64_t v;
+                switch (width) {
+                    case 1: { uint8_t x; des.value1b(x); v = x; break; }
+                    case 2: { uint16_t x; des.value2b(x); v = x; break; }
+                    case 4: { uint32_t x; des.value4b(x); v = x; break; }
+                    case 8: { uint64_t x; des.value8b(x); v = x; break; }
+                    default: return false;
+                }
+                if constexpr (std::is_same_v<T, bool>) value = v != 0; else value = (T)v;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename ItemType>
+    bool readItems(ItemType* items, uint32_t count, OFS_StateBinary::WireType itemWireType, uint8_t itemSize, size_t end) noexcept
+    {
+        constexpr auto expected = OFS_StateBinary::WireTypeOf<ItemType>();
+        if constexpr (expected <= OFS_StateBinary::WireType::Float && !std::is_same_v<ItemType, bool>) {
+            // stored exactly like in memory, one copy into the container
+            if (itemWireType == expected && itemSize == sizeof(ItemType)) {
+                if (!fits((size_t)count * itemSize, end)) return false;
+                using RawType = OFS_StateBinary::raw_type_t<ItemType>;
+                des.adapter().template readBuffer<sizeof(ItemType)>(reinterpret_cast<RawType*>(items), count);
+                return true;
+            }
+        }
+        for (uint32_t i = 0; i < count; i += 1) {
+            if (!Value(items[i], itemWireType, itemSize, end)) return false;
+        }
+        return true;
+    }
+
+    template<typename ItemType, typename Allocator>
+    bool readArray(std::vector<ItemType, Allocator>& container, OFS_StateBinary::WireType itemWireType, uint8_t itemSize, uint32_t count, size_t end) noexcept
+    {
+        std::vector<ItemType, Allocator> items;
+        items.resize(count);
+        if (!readItems(items.data(), count, itemWireType, itemSize, end)) return false;
+        static_cast<std::vector<ItemType, Allocator>&>(container) = std::move(items);
+        return true;
+    }
+
+    template<typename ItemType, size_t Size>
+    bool readArray(std::array<ItemType, Size>& container, OFS_StateBinary::WireType itemWireType, uint8_t itemSize, uint32_t count, size_t end) noexcept
+    {
+        if (count != Size) return false;
+        auto items = container;
+        if (!readItems(items.data(), count, itemWireType, itemSize, end)) return false;
+        container = items;
+        return true;
+    }
+
+    template<typename T>
+    bool readObject(T& obj, size_t end) noexcept
+    {
+        uint16_t fieldCount = 0;
+        if (!fits(sizeof(fieldCount), end)) return false;
+        des.value2b(fieldCount);
+
+        for (uint16_t i = 0; i < fieldCount; i += 1) {
+            uint32_t hash = 0;
+            uint8_t wireType = 0;
+            uint32_t size = 0;
+            if (!fits(9, end)) return false;
+            des.value4b(hash);
+            des.value1b(wireType);
+            des.value4b(size);
+            size_t fieldEnd = Position() + size;
+            if (!fits(size, end)) return false;
+
+            bool found = false;
+            for_each(refl::reflect(obj).members, [&](auto member) noexcept {
+                if constexpr (refl::descriptor::is_field(member) && !refl::descriptor::is_static(member)) {
+                    if (found || OFS_StateBinary::FieldHash(get_display_name(member)) != hash) return;
+                    found = true;
+
+                    auto& memberRef = member(obj);
+                    using MemberType = std::remove_reference_t<decltype(memberRef)>;
+                    bool succ;
+                    if constexpr (refl::descriptor::has_attribute<serializeEnum>(member)) {
+                        using EnumType = typename std::underlying_type<MemberType>::type;
+                        auto enumValue = static_cast<EnumType>(memberRef);
+                        succ = Value(enumValue, (OFS_StateBinary::WireType)wireType, size, fieldEnd);
+                        if (succ) memberRef = static_cast<MemberType>(enumValue);
+                    }
+                    else {
+                        succ = Value(memberRef, (OFS_StateBinary::WireType)wireType, size, fieldEnd);
+                    }
+                    if (!succ && !corrupt) {
+                        LOGF_WARN("The field \"%s\" changed its type and was skipped.", get_display_name(member));
+                    }
+                }
+            });
+            if (corrupt) return false;
+            Seek(fieldEnd);
+        }
+        return true;
+    }
+
+public:
+    explicit OFS_StateReader(const ByteBuffer& buffer) noexcept
+        : des(buffer.begin(), buffer.size()), bufferSize(buffer.size()) {}
+
+    inline size_t Position() noexcept { return des.adapter().currentReadPos(); }
+    inline size_t Size() const noexcept { return bufferSize; }
+    inline bool Ok() noexcept { return !corrupt && des.adapter().error() == bitsery::ReaderError::NoError; }
+
+    inline void Seek(size_t pos) noexcept
+    {
+        if (pos > bufferSize) {
+            corrupt = true;
+            return;
+        }
+        des.adapter().currentReadPos(pos);
+    }
+
+    inline bool Header(uint32_t* stateCount) noexcept
+    {
+        uint32_t magic = 0;
+        uint16_t version = 0;
+        if (!fits(10, bufferSize)) return false;
+        des.value4b(magic);
+        des.value2b(version);
+        des.value4b(*stateCount);
+        if (magic != OFS_StateBinary::Magic) return false;
+        if (version > OFS_StateBinary::FormatVersion) {
+            LOGF_ERROR("The state was saved with a newer format version %u.", version);
+            return false;
+        }
+        return true;
+    }
+
+    inline bool Size(uint32_t* size, size_t end) noexcept
+    {
+        if (!fits(sizeof(uint32_t), end)) return false;
+        des.value4b(*size);
+        return fits(*size, end);
+    }
+
+    inline bool String(std::string& str, size_t end) noexcept
+    {
+        uint32_t length = 0;
+        if (!Size(&length, end)) return false;
+        str.resize(length);
+        des.adapter().template readBuffer<1>(str.data(), length);
+        return true;
+    }
+
+    // Leaves the value as it was and returns false if the stored type doesn't match.
+    template<typename T>
+    bool Value(T& value, OFS_StateBinary::WireType wireType, uint32_t size, size_t end) noexcept
+    {
+        constexpr auto expected = OFS_StateBinary::WireTypeOf<T>();
+        if constexpr (expected <= OFS_StateBinary::WireType::Float) {
+            return readScalar(value, wireType, size, end);
+        }
+        else if constexpr (expected == OFS_StateBinary::WireType::String) {
+            if (wireType != expected) return false;
+            std::string str;
+            if (!String(str, end)) return false;
+            value = std::move(str);
+            return true;
+        }
+        else if constexpr (expected == OFS_StateBinary::WireType::Bytes) {
+            if (wireType != expected) return false;
+            uint32_t length = 0;
+            if (!Size(&length, end)) return false;
+            value.resize(length);
+            des.adapter().template readBuffer<1>(value.data(), length);
+            return true;
+        }
+        else if constexpr (expected == OFS_StateBinary::WireType::Array) {
+            if (wireType != expected) return false;
+            uint8_t itemWireType = 0;
+            uint8_t itemSize = 0;
+            uint32_t count = 0;
+            if (!fits(6, end)) return false;
+            des.value1b(itemWireType);
+            des.value1b(itemSize);
+            des.value4b(count);
+            // every item takes at least a byte, keeps corrupt counts from allocating
+            if (count > end - Position()) {
+                corrupt = true;
+                return false;
+            }
+            using ItemType = std::remove_reference_t<decltype(*std::begin(value))>;
+            if (itemWireType != (uint8_t)OFS_StateBinary::WireTypeOf<ItemType>()
+                && !(itemWireType <= (uint8_t)OFS_StateBinary::WireType::Float
+                    && OFS_StateBinary::WireTypeOf<ItemType>() <= OFS_StateBinary::WireType::Float)) {
+                return false;
+            }
+            return readArray(value, (OFS_StateBinary::WireType)itemWireType, itemSize, count, end);
+        }
+        else {
+            if (wireType != expected) return false;
+            return readObject(value, end);
+        }
+    }
+};
@@ -15,8 +15,8 @@ class OFS_AppState
     inline OFS_AppState(uint32_t id = OFS_AppState::InvalidId) noexcept
         : Id(id) {}
 
-    T& Get() noexcept {
-        OFS_PROFILE(__FUNCTION__);
+    // an index into the state collection, no lookup
+    inline T& Get() noexcept {
         auto mgr = OFS_StateManager::Get();
         return mgr->template GetApp<T>(Id);
     }
@@ -40,8 +40,8 @@ class OFS_ProjectState
     inline OFS_ProjectState(uint32_t id = OFS_ProjectState::InvalidId) noexcept
         : Id(id) {}
 
-    T& Get() noexcept {
-        OFS_PROFILE(__FUNCTION__);
+    // an index into the state collection, no lookup
+    inline T& Get() noexcept {
         auto mgr = OFS_StateManager::Get();
         return mgr->template GetProject<T>(Id);
     }
@@ -30,11 +30,11 @@ inline static nlohmann::json SerializeStateCollection(const std::vector<OFS_Stat
 
         if(md) {
             auto& subObj = obj[state.Name];
-            subObj["TypeName"] = state.TypeName;
+            subObj["TypeName"] = md->Name();
 
             bool succ = md->Serialize(state.State, subObj["State"], enableBinary);
             if(!succ) {
-                LOGF_ERROR("Failed to serialize \"%s\" state. Type: %s", state.Name.c_str(), state.TypeName.c_str());
+                LOGF_ERROR("Failed to serialize \"%s\" state. Type: %s", state.Name.c_str(), md->Name().data());
             }
         }
     }
@@ -44,6 +44,35 @@ inline static nlohmann::json SerializeStateCollection(const std::vector<OFS_Stat
     return obj;
 }
 
+static void InsertState(OFS_State&& state, std::vector<OFS_State>& stateCollection, OFS_StateManager::StateHandleMap& handleMap) noexcept
+{
+    // handles are dense, a new one comes after all the registered ones
+    auto handleIt = handleMap.find(state.Name);
+    uint32_t handle = handleIt != handleMap.end() ? handleIt->second.Id : (uint32_t)handleMap.size();
+    if(handleIt == handleMap.end()) {
+        handleMap.emplace(state.Name, OFS_StateManager::StateSlot{ state.Metadata, handle });
+    }
+    if(stateCollection.size() < handle + 1) {
+        stateCollection.resize(handle + 1);
+    }
+    stateCollection[handle] = std::move(state);
+}
+
+static void InitializeMissingStates(std::vector<OFS_State>& stateCollection, OFS_StateManager::StateHandleMap& handleMap) noexcept
+{
+    // Ideally this does nothing because every item has a value.
+    for(auto& [name, slot] : handleMap)
+    {
+        if(stateCollection.size() < slot.Id + 1) {
+            stateCollection.resize(slot.Id + 1);
+        }
+        if(!stateCollection[slot.Id].State) {
+            // Default initialize
+            stateCollection[slot.Id] = OFS_State(name, slot.Metadata);
+        }
+    }
+}
+
 inline static bool DeserializeStateCollection(const nlohmann::json& state, std::vector<OFS_State>& stateCollection, OFS_StateManager::StateHandleMap& handleMap, bool enableBinary) noexcept
 {
     for(auto& stateItem : state.items()) {
@@ -56,54 +85,93 @@ inline static bool DeserializeStateCollection(const nlohmann::json& state, std::
             LOG_ERROR("Failed to deserialize expected \"State\"");
         }
 
-        OFS_State state;
-        state.Name = stateItem.key();
-        state.TypeName = stateValue["TypeName"];
-
-        auto md = OFS_StateRegistry::Get().Find(state.TypeName);
+        auto& typeName = stateValue["TypeName"].get_ref<const std::string&>();
+        auto md = OFS_StateRegistry::Get().Find(typeName);
         if(!md) {
-            LOGF_ERROR("Didn't find state metadata for \"%s\"", state.TypeName.c_str());
+            LOGF_ERROR("Didn't find state metadata for \"%s\"", typeName.c_str());
+            continue;
+        }
+
+        auto handleIt = handleMap.find(stateItem.key());
+        if(handleIt != handleMap.end() && handleIt->second.Metadata != md) {
+            LOGF_ERROR("State \"%s\" was saved as %s but is registered as %s", stateItem.key().c_str(), typeName.c_str(), handleIt->second.Metadata->Name().data());
             continue;
         }
-        state.Metadata = md;
-        state.State = md->Create();
+
+        OFS_State state(stateItem.key(), md);
         if(md->Deserialize(state.State, stateValue["State"], enableBinary)) {
-            auto handleIt = handleMap.find(state.Name);
-            if(handleIt != handleMap.end()) {
-                uint32_t handle = handleIt->second.second;
-                if(stateCollection.size() < handle + 1) {
-                    stateCollection.resize(handle + 1);
-                }
-                stateCollection[handle] = std::move(state);
-            }
-            else {
-                uint32_t handle = stateCollection.size();
-                handleMap.insert(std::make_pair(state.Name, std::make_pair(md->Name(), handle)));
-                stateCollection.emplace_back(std::move(state));
-            }
+            InsertState(std::move(state), stateCollection, handleMap);
         }
     }
 
-    // Ideally this does nothing because every item has a value.
-    for(auto& state : handleMap)
-    {
-        uint32_t handle = state.second.second;
-        if(stateCollection.size() < handle + 1) {
-            stateCollection.resize(handle + 1);
+    InitializeMissingStates(stateCollection, handleMap);
+    return true;
+}
+
+static void WriteStateCollection(const std::vector<OFS_State>& stateCollection, ByteBuffer& buffer) noexcept
+{
+    auto startTime = SDL_GetPerformanceCounter();
+    buffer.clear();
+    OFS_StateWriter writer(buffer);
+    writer.Header((uint32_t)stateCollection.size());
+    for(auto& state : stateCollection) {
+        auto md = state.Metadata;
+        FUN_ASSERT(md, "metadata was null");
+        writer.String(state.Name);
+        writer.String(md->Name());
+        size_t sizePos = writer.BeginSize();
+        md->WriteBinary(state.State, writer);
+        writer.EndSize(sizePos);
+    }
+    buffer.resize(writer.Finish());
+
+    auto duration = (float)(SDL_GetPerformanceCounter() - startTime) / (float)SDL_GetPerformanceFrequency();
+    LOGF_INFO("OFS_StateManager::WriteStateCollection took %f seconds", duration);
+}
+
+static bool ReadStateCollection(const ByteBuffer& buffer, std::vector<OFS_State>& stateCollection, OFS_StateManager::StateHandleMap& handleMap) noexcept
+{
+    OFS_StateReader reader(buffer);
+    uint32_t stateCount = 0;
+    if(!reader.Header(&stateCount)) {
+        LOG_ERROR("Failed to read the state header");
+        return false;
+    }
+
+    std::string name;
+    std::string typeName;
+    for(uint32_t i = 0; i < stateCount; i += 1) {
+        uint32_t size = 0;
+        if(!reader.String(name, reader.Size()) || !reader.String(typeName, reader.Size()) || !reader.Size(&size, reader.Size())) {
+            break;
         }
-        if(!stateCollection[handle].State.has_value()) {
-            // Default initialize
-            auto md = OFS_StateRegistry::Get().Find(state.second.first);
-            FUN_ASSERT(md, "Metadata not found this must not happen in this context.");
-            auto& stateItem = stateCollection[handle];
-            stateItem.Name = state.first;
-            stateItem.State = md->Create();
-            stateItem.Metadata = md;
-            stateItem.TypeName = md->Name();
+        size_t end = reader.Position() + size;
+
+        auto md = OFS_StateRegistry::Get().Find(typeName);
+        auto handleIt = handleMap.find(name);
+        if(!md) {
+            LOGF_ERROR("Didn't find state metadata for \"%s\"", typeName.c_str());
+        }
+        else if(handleIt != handleMap.end() && handleIt->second.Metadata != md) {
+            LOGF_ERROR("State \"%s\" was saved as %s but is registered as %s", name.c_str(), typeName.c_str(), handleIt->second.Metadata->Name().data());
         }
+        else {
+            OFS_State state(name, md);
+            if(md->ReadBinary(state.State, reader, end)) {
+                InsertState(std::move(state), stateCollection, handleMap);
+            }
+            else {
+                LOGF_ERROR("Failed to read \"%s\" state. Type: %s", name.c_str(), typeName.c_str());
+            }
+        }
+        reader.Seek(end);
     }
 
-    return true;
+    bool succ = reader.Ok();
+    if(!succ) {
+        LOG_ERROR("The state file is corrupt, some of it was reset to defaults.");
+    }
+    return succ;
 }
 
 nlohmann::json OFS_StateManager::SerializeAppAll(bool enableBinary) noexcept
@@ -133,4 +201,44 @@ void OFS_StateManager::ClearProjectAll() noexcept
     ProjectState.clear();
     // Initialize with defaults
     DeserializeStateCollection(nlohmann::json::object(), ProjectState, ProjectHandleMap, false);
-}
\ No newline at end of file
+}
+
+void OFS_StateManager::SerializeAppAll(ByteBuffer& buffer) noexcept
+{
+    WriteStateCollection(ApplicationState, buffer);
+}
+
+void OFS_StateManager::SerializeProjectAll(ByteBuffer& buffer) noexcept
+{
+    WriteStateCollection(ProjectState, buffer);
+}
+
+inline static bool DeserializeStateFile(const ByteBuffer& buffer, std::vector<OFS_State>& stateCollection, OFS_StateManager::StateHandleMap& handleMap) noexcept
+{
+    stateCollection.clear();
+    bool succ = false;
+    if(OFS_StateBinary::HasHeader(buffer)) {
+        succ = ReadStateCollection(buffer, stateCollection, handleMap);
+    }
+    else {
+        // CBOR written by versions before the binary format
+        auto json = Util::ParseCBOR(buffer, &succ);
+        if(succ) {
+            LOG_INFO("Importing state saved by an older version.");
+            succ = DeserializeStateCollection(json, stateCollection, handleMap, true);
+        }
+    }
+    // every registered handle has to stay valid, whatever happened above
+    InitializeMissingStates(stateCollection, handleMap);
+    return succ;
+}
+
+bool OFS_StateManager::DeserializeAppAll(const ByteBuffer& buffer) noexcept
+{
+    return DeserializeStateFile(buffer, ApplicationState, ApplicationHandleMap);
+}
+
+bool OFS_StateManager::DeserializeProjectAll(const ByteBuffer& buffer) noexcept
+{
+    return DeserializeStateFile(buffer, ProjectState, ProjectHandleMap);
+}
@@ -1,86 +1,117 @@
 #pragma once
 #include "OFS_Util.h"
 #include "OFS_Serialization.h"
+#include "OFS_StateBinary.h"
 
 #include <string>
 #include <vector>
-#include <any>
-#include <map>
+#include <string_view>
+#include <unordered_map>
 
+// Type erased operations for one state type.
+// There is exactly one instance per type, so comparing the pointer is enough to check the type.
 class OFS_StateMetadata
 {
     public:
     template<typename T>
-    static OFS_StateMetadata CreateMetadata() noexcept
+    static const OFS_StateMetadata& For() noexcept
     {
-        constexpr auto type = refl::reflect<T>();
-        OFS_StateMetadata md;
-        md.name = type.name.c_str();
-        md.creator = &OFS_StateMetadata::createUntyped<T>;
-        md.serializer = &OFS_StateMetadata::serializeUntyped<T>;
-        md.deserializer = &OFS_StateMetadata::deserializeUntyped<T>;
+        static const OFS_StateMetadata md = createMetadata<T>();
         return md;
     }
-    
-    std::any Create() const noexcept { return creator(); }
+
+    void* Create() const noexcept { return creator(); }
+    void Destroy(void* value) const noexcept { destroyer(value); }
     std::string_view Name() const noexcept { return name; }
-    
-    bool Serialize(const std::any& value, nlohmann::json& obj, bool enableBinary) const noexcept {
+
+    bool Serialize(const void* value, nlohmann::json& obj, bool enableBinary) const noexcept {
         return serializer(value, obj, enableBinary);
     }
 
-    bool Deserialize(std::any& value, const nlohmann::json& obj, bool enableBinary) const noexcept {
+    bool Deserialize(void* value, const nlohmann::json& obj, bool enableBinary) const noexcept {
         return deserializer(value, obj, enableBinary);
     }
 
+    void WriteBinary(const void* value, OFS_StateWriter& writer) const noexcept {
+        binaryWriter(value, writer);
+    }
+
+    bool ReadBinary(void* value, OFS_StateReader& reader, size_t end) const noexcept {
+        return binaryReader(value, reader, end);
+    }
+
     private:
-    using OFS_StateCreator = std::any(*)() noexcept;
-    using OFS_StateSerializer = bool (*)(const std::any&, nlohmann::json&, bool) noexcept;
-    using OFS_StateDeserializer = bool (*)(std::any&, const nlohmann::json&, bool) noexcept;
+    using OFS_StateCreator = void*(*)() noexcept;
+    using OFS_StateDestroyer = void(*)(void*) noexcept;
+    using OFS_StateSerializer = bool (*)(const void*, nlohmann::json&, bool) noexcept;
+    using OFS_StateDeserializer = bool (*)(void*, const nlohmann::json&, bool) noexcept;
+    using OFS_StateBinaryWriter = void (*)(const void*, OFS_StateWriter&) noexcept;
+    using OFS_StateBinaryReader = bool (*)(void*, OFS_StateReader&, size_t) noexcept;
 
     std::string name;
     OFS_StateCreator creator;
+    OFS_StateDestroyer destroyer;
     OFS_StateSerializer serializer;
     OFS_StateDeserializer deserializer;
+    OFS_StateBinaryWriter binaryWriter;
+    OFS_StateBinaryReader binaryReader;
+
+    template<typename T>
+    static OFS_StateMetadata createMetadata() noexcept
+    {
+        constexpr auto type = refl::reflect<T>();
+        OFS_StateMetadata md;
+        md.name = type.name.c_str();
+        md.creator = &OFS_StateMetadata::createUntyped<T>;
+        md.destroyer = &OFS_StateMetadata::destroyUntyped<T>;
+        md.serializer = &OFS_StateMetadata::serializeUntyped<T>;
+        md.deserializer = &OFS_StateMetadata::deserializeUntyped<T>;
+        md.binaryWriter = &OFS_StateMetadata::writeBinaryUntyped<T>;
+        md.binaryReader = &OFS_StateMetadata::readBinaryUntyped<T>;
+        return md;
+    }
 
     template <typename T>
-    static std::any createUntyped() noexcept
-    {
-        T instance{};
-        //for_each(refl::reflect<T>().members, [&](auto member) {
-        //    if constexpr (refl::descriptor::has_attribute<UiProperty>(member)) {
-        //        auto&& prop = refl::descriptor::get_attribute<UiProperty>(member);
-        //        if (auto propIter = props.find(member.name.str()); propIter != props.end()) {
-        //            member(instance) = prop.parser(propIter->second);
-        //        }
-        //    }
-        //});
-        return instance;
+    static void* createUntyped() noexcept
+    {
+        return new T{};
+    }
+
+    template <typename T>
+    static void destroyUntyped(void* value) noexcept
+    {
+        delete static_cast<T*>(value);
     }
 
     template<typename T>
-    static bool serializeUntyped(const std::any& value, nlohmann::json& obj, bool enableBinary) noexcept
+    static bool serializeUntyped(const void* value, nlohmann::json& obj, bool enableBinary) noexcept
     {
-        auto* realValue = std::any_cast<const T>(&value);
-        if (!realValue) {
-            LOG_ERROR("Failed to cast state value during serialization - type mismatch");
-            return false;
-        }
-        return enableBinary ? OFS::Serializer<true>::Serialize(*realValue, obj) : OFS::Serializer<false>::Serialize(*realValue, obj);
+        auto& realValue = *static_cast<const T*>(value);
+        return enableBinary ? OFS::Serializer<true>::Serialize(realValue, obj) : OFS::Serializer<false>::Serialize(realValue, obj);
     }
 
     template<typename T>
-    static bool deserializeUntyped(std::any& value, const nlohmann::json& obj, bool enableBinary) noexcept
+    static bool deserializeUntyped(void* value, const nlohmann::json& obj, bool enableBinary) noexcept
     {
-        auto* realValue = std::any_cast<T>(&value);
-        if (!realValue) {
-            LOG_ERROR("Failed to cast state value during deserialization - type mismatch");
-            return false;
-        }
-        return enableBinary ? OFS::Serializer<true>::Deserialize(*realValue, obj) : OFS::Serializer<false>::Deserialize(*realValue, obj);
+        auto& realValue = *static_cast<T*>(value);
+        return enableBinary ? OFS::Serializer<true>::Deserialize(realValue, obj) : OFS::Serializer<false>::Deserialize(realValue, obj);
+    }
+
+    template<typename T>
+    static void writeBinaryUntyped(const void* value, OFS_StateWriter& writer) noexcept
+    {
+        writer.Value(*static_cast<const T*>(value));
+    }
+
+    template<typename T>
+    static bool readBinaryUntyped(void* value, OFS_StateReader& reader, size_t end) noexcept
+    {
+        return reader.Value(*static_cast<T*>(value), OFS_StateBinary::WireType::Object, 0, end);
     }
 };
 
+// Maps the type names stored in state files to their metadata.
+// Only used when loading, handles already know their type.
 class OFS_StateRegistry
 {
     public:
@@ -92,40 +123,80 @@ class OFS_StateRegistry
 
     const OFS_StateMetadata* Find(std::string_view typeName) const noexcept
     {
-        auto iter = std::find_if(metadata.begin(), metadata.end(), [&](auto&& x) {
-            return x.Name() == typeName;
-        });
-        if (iter != metadata.end()) {
-            return &(*iter);
-        }
-        return nullptr;
+        auto iter = metadata.find(typeName);
+        return iter != metadata.end() ? iter->second : nullptr;
+    }
+
+    template<typename T>
+    bool IsRegistered() const noexcept
+    {
+        auto& md = OFS_StateMetadata::For<T>();
+        return Find(md.Name()) == &md;
     }
 
     template<typename T>
     void RegisterState()
     {
-        metadata.push_back(OFS_StateMetadata::CreateMetadata<T>());
+        auto& md = OFS_StateMetadata::For<T>();
+        metadata.emplace(md.Name(), &md);
     }
 
     private:
-    std::vector<OFS_StateMetadata> metadata;
+    // the keys point into the metadata which lives until exit
+    std::unordered_map<std::string_view, const OFS_StateMetadata*> metadata;
     OFS_StateRegistry() noexcept {}
 };
 
 #define OFS_REGISTER_STATE(StateTypeName) OFS_StateRegistry::Get().RegisterState<StateTypeName>()
 
+// Owns one state value, the metadata knows its type.
 struct OFS_State
 {
     std::string Name;
-    std::string TypeName;
     const OFS_StateMetadata* Metadata = nullptr;
-    std::any State;
+    void* State = nullptr;
+
+    OFS_State() noexcept = default;
+    OFS_State(std::string name, const OFS_StateMetadata* md) noexcept
+        : Name(std::move(name)), Metadata(md), State(md->Create()) {}
+    OFS_State(const OFS_State&) = delete;
+    OFS_State& operator=(const OFS_State&) = delete;
+    OFS_State(OFS_State&& other) noexcept
+        : Name(std::move(other.Name)), Metadata(other.Metadata), State(other.State)
+    {
+        other.State = nullptr;
+    }
+    OFS_State& operator=(OFS_State&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            Name = std::move(other.Name);
+            Metadata = other.Metadata;
+            State = other.State;
+            other.State = nullptr;
+        }
+        return *this;
+    }
+    ~OFS_State() noexcept { reset(); }
+
+    private:
+    void reset() noexcept
+    {
+        if (State) Metadata->Destroy(State);
+        State = nullptr;
+    }
 };
 
 class OFS_StateManager
 {
-    public:                        // StateName -> Pair(TypeName, Handle)
-    using StateHandleMap = std::map<std::string, std::pair<std::string, uint32_t>>;
+    public:
+    struct StateSlot
+    {
+        const OFS_StateMetadata* Metadata;
+        uint32_t Id;
+    };
+    // StateName -> Slot, only used while registering and loading
+    using StateHandleMap = std::unordered_map<std::string, StateSlot>;
     private:
     std::vector<OFS_State> ApplicationState;
     std::vector<OFS_State> ProjectState;
@@ -138,28 +209,23 @@ class OFS_StateManager
     template<typename T>
     inline static uint32_t registerState(const char* name, std::vector<OFS_State>& stateCollection, StateHandleMap& handleMap) noexcept
     {
-        constexpr auto type = refl::reflect<T>();
+        auto metadata = &OFS_StateMetadata::For<T>();
+        FUN_ASSERT(OFS_StateRegistry::Get().IsRegistered<T>(), "State wasn't registered using OFS_REGISTER_STATE macro");
+
         auto it = handleMap.find(name);
         if(it == handleMap.end()) {
-            LOGF_DEBUG("Registering new state \"%s\". Type: %s", name, type.name.c_str());
-
-            auto metadata = OFS_StateRegistry::Get().Find(type.name.c_str());
-            FUN_ASSERT(metadata, "State wasn't registered using OFS_REGISTER_STATE macro");
+            LOGF_DEBUG("Registering new state \"%s\". Type: %s", name, metadata->Name().data());
 
             uint32_t Id = stateCollection.size();
-            stateCollection.emplace_back(
-                std::move(OFS_State{name, type.name.c_str(), metadata, std::move(std::make_any<T>())})
-            );
-
-            auto sanityCheck = handleMap.insert(std::make_pair(std::string(name), std::make_pair(type.name, Id)));
-            FUN_ASSERT(sanityCheck.second, "Why did this fail?");
-
-            return Id;   
+            stateCollection.emplace_back(name, metadata);
+            handleMap.emplace(name, StateSlot{ metadata, Id });
+            return Id;
         }
         else {
-            FUN_ASSERT(stateCollection[it->second.second].Name == name, "Something went wrong");
+            FUN_ASSERT(it->second.Metadata == metadata, "State was registered with a different type");
+            FUN_ASSERT(stateCollection[it->second.Id].Name == name, "Something went wrong");
             LOGF_DEBUG("Loading existing state \"%s\"", name);
-            return it->second.second;
+            return it->second.Id;
         }
     }
 
@@ -168,9 +234,8 @@ class OFS_StateManager
     {
         FUN_ASSERT(id < stateCollection.size(), "out of bounds");
         auto& item = stateCollection[id];
-        auto* value = std::any_cast<T>(&item.State);
-        FUN_ASSERT(value != nullptr, "State type mismatch - this indicates a serious programming error");
-        return *value;
+        FUN_ASSERT(item.Metadata == &OFS_StateMetadata::For<T>(), "State type mismatch - this indicates a serious programming error");
+        return *static_cast<T*>(item.State);
     }
 
     public:
@@ -207,5 +272,12 @@ class OFS_StateManager
 
     nlohmann::json SerializeProjectAll(bool enableBinary) noexcept;
     bool DeserializeProjectAll(const nlohmann::json& project, bool enableBinary) noexcept;
+
+    // OFS_StateBinary files, the buffer is overwritten
+    void SerializeAppAll(ByteBuffer& buffer) noexcept;
+    void SerializeProjectAll(ByteBuffer& buffer) noexcept;
+    // Also reads the CBOR files written by older versions.
+    bool DeserializeAppAll(const ByteBuffer& buffer) noexcept;
+    bool DeserializeProjectAll(const ByteBuffer& buffer) noexcept;
     void ClearProjectAll() noexcept;
 };
@@ -36,12 +36,6 @@ struct ChapterState
         return OFS_ProjectState<ChapterState>(stateHandle).Get();
     }
 
-    inline static ChapterState& StaticStateSlow() noexcept
-    {
-        auto handle = OFS_ProjectState<ChapterState>::Register(StateName);
-        return State(handle);
-    }
-
     bool SetChapterSize(Chapter& chapter, float toTime) noexcept;
     Chapter* AddChapter(float time, float duration) noexcept;
     Bookmark* AddBookmark(float time) noexcept;
@@ -77,4 +71,10 @@ class ExportClipForChapter : public OFS_Event<ExportClipForChapter>
     Chapter chapter;
     ExportClipForChapter(const Chapter& chapter) noexcept
         : chapter(chapter) {}
+};
+
+class ExportClipsForAllChapters : public OFS_Event<ExportClipsForAllChapters>
+{
+    public:
+    ExportClipsForAllChapters() noexcept {}
 };
\ No newline at end of file
@@ -71,12 +71,6 @@ struct OFS_KeybindingState
     void ConvertToOFS() noexcept;
     void ConvertToImGui() noexcept;
 
-    inline static OFS_KeybindingState& StateSlow() noexcept
-    {
-        auto stateHandle = OFS_AppState<OFS_KeybindingState>::Register(StateName);
-        return State(stateHandle);
-    }
-
     inline static OFS_KeybindingState& State(uint32_t stateHandle) noexcept
     {
         return OFS_AppState<OFS_KeybindingState>(stateHandle).Get();
@@ -31,6 +31,16 @@ struct ProcessingVideoWindowState
     bool useRightEye = false;  // false = left eye, true = right eye
     float vrPitch = -21.0f;    // Adjustable pitch for processing pipeline
     float vrZoom = 0.2f;       // VR zoom factor (lower = more zoom)
+    float vrYaw = 0.0f;        // Horizontal rotation in degrees (CPU remap)
+    bool vrUnwarp = false;     // Unwarp the projection, otherwise only crop (CPU remap)
+    bool cpuRemap = false;     // Crop/unwarp on the CPU instead of VRCropShader
+
+    // Motion tracker
+    ImVec2 trackerRoiPos = ImVec2(0.25f, 0.25f);  // Normalized region of interest
+    ImVec2 trackerRoiSize = ImVec2(0.5f, 0.5f);
+    float trackerDetrendSeconds = 2.0f;
+    float trackerMinStrokeHeight = 10.0f;
+    bool trackerInvert = false;
 
 	inline static ProcessingVideoWindowState& State(uint32_t stateHandle) noexcept {
 		return OFS_ProjectState<ProcessingVideoWindowState>(stateHandle).Get();
@@ -48,4 +58,12 @@ REFL_TYPE(ProcessingVideoWindowState)
     REFL_FIELD(useRightEye)
     REFL_FIELD(vrPitch)
     REFL_FIELD(vrZoom)
+    REFL_FIELD(vrYaw)
+    REFL_FIELD(vrUnwarp)
+    REFL_FIELD(cpuRemap)
+    REFL_FIELD(trackerRoiPos)
+    REFL_FIELD(trackerRoiSize)
+    REFL_FIELD(trackerDetrendSeconds)
+    REFL_FIELD(trackerMinStrokeHeight)
+    REFL_FIELD(trackerInvert)
 REFL_END
@@ -59,11 +59,9 @@ struct WaveformState
         BinSamples = std::move(compressedBin);
     }
 
-    inline static WaveformState& StaticStateSlow() noexcept
+    inline static WaveformState& State(uint32_t stateHandle) noexcept
     {
-        // This shouldn't be done in hot paths but shouldn't be a problem otherwise.
-        uint32_t handle = OFS_ProjectState<WaveformState>::Register(StateName);
-        return OFS_ProjectState<WaveformState>(handle).Get();
+        return OFS_ProjectState<WaveformState>(stateHandle).Get();
     }
 };
 
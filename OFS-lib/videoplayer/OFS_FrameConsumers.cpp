@@ -0,0 +1,343 @@
+#include "OFS_FrameConsumers.h"
+#include "OFS_ThreadPool.h"
+#include "OFS_EventSystem.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+
+#include "imgui.h"
+
+#include "SDL_timer.h"
+
+#include <cstring>
+#include <algorithm>
+
+OFS_FrameConsumers* OFS_FrameConsumers::instance = nullptr;
+
+bool OFS_FrameConsumers::Init() noexcept
+{
+	if (!instance) {
+		FUN_ASSERT(OFS_ThreadPool::Get(), "thread pool has to be initialized first");
+		instance = new OFS_FrameConsumers();
+		EV::Queue().appendListener(ProcessingFrameReadyEvent::EventType,
+			ProcessingFrameReadyEvent::HandleEvent(EVENT_SYSTEM_BIND(instance, &OFS_FrameConsumers::frameReady)));
+	}
+	return instance != nullptr;
+}
+
+void OFS_FrameConsumers::Shutdown() noexcept
+{
+	// The thread pool has to be shut down before this, tasks reference the instance.
+	if (instance) {
+		delete instance;
+		instance = nullptr;
+	}
+}
+
+OFS_FrameConsumers::OFS_FrameConsumers() noexcept
+{
+	resultMutex = SDL_CreateMutex();
+}
+
+OFS_FrameConsumers::~OFS_FrameConsumers() noexcept
+{
+	results.clear();
+	consumers.clear();
+	SDL_DestroyMutex(resultMutex);
+}
+
+OFS_FrameConsumers::ConsumerSlot::~ConsumerSlot() noexcept
+{
+	for (auto frame : queue) releaseFrame(frame);
+	queue.clear();
+	SDL_DestroyCond(idle);
+	SDL_DestroyMutex(mutex);
+}
+
+OFS_FrameConsumers::PooledFrame* OFS_FrameConsumers::acquireFrame() noexcept
+{
+	for (int i = 0; i < PoolSize; i += 1) {
+		auto& frame = pool[(poolCursor + i) % PoolSize];
+		// only the main thread hands out frames, so a frame at 0 refs can't be grabbed concurrently
+		if (SDL_AtomicGet(&frame.refs) == 0) {
+			poolCursor = (poolCursor + i + 1) % PoolSize;
+			SDL_AtomicSet(&frame.refs, 1);
+			return &frame;
+		}
+	}
+	return nullptr;
+}
+
+void OFS_FrameConsumers::releaseFrame(PooledFrame* frame) noexcept
+{
+	SDL_AtomicDecRef(&frame->refs);
+}
+
+uint32_t OFS_FrameConsumers::Register(std::shared_ptr<OFS_FrameConsumer> consumer) noexcept
+{
+	FUN_ASSERT(Util::InMainThread(), "not in main thread");
+	auto slot = std::make_shared<ConsumerSlot>();
+	slot->id = nextConsumerId++;
+	slot->desc = consumer->Describe();
+	slot->desc.downscale = Util::Max(slot->desc.downscale, 1);
+	slot->desc.maxQueueDepth = Util::Max(slot->desc.maxQueueDepth, 1);
+	slot->consumer = std::move(consumer);
+	slot->mutex = SDL_CreateMutex();
+	slot->idle = SDL_CreateCond();
+	slot->throughputWindowStart = SDL_GetPerformanceCounter();
+	LOGF_INFO("Registered frame consumer \"%s\"", slot->desc.name.c_str());
+	consumers.emplace_back(std::move(slot));
+	return consumers.back()->id;
+}
+
+void OFS_FrameConsumers::Unregister(uint32_t id) noexcept
+{
+	FUN_ASSERT(Util::InMainThread(), "not in main thread");
+	auto it = std::find_if(consumers.begin(), consumers.end(),
+		[id](auto& slot) noexcept { return slot->id == id; });
+	if (it == consumers.end()) return;
+
+	auto& slot = *it;
+	SDL_LockMutex(slot->mutex);
+	slot->removed = true;
+	for (auto frame : slot->queue) releaseFrame(frame);
+	slot->queue.clear();
+	// Process must not run concurrently with a new registration of the same consumer.
+	// Only the frame in flight is waited for, queued tasks see removed and return.
+	while (slot->processing) {
+		SDL_CondWait(slot->idle, slot->mutex);
+	}
+	SDL_UnlockMutex(slot->mutex);
+	consumers.erase(it);
+}
+
+void OFS_FrameConsumers::frameReady(const ProcessingFrameReadyEvent* ev) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	if (ev->playerType != VideoplayerType::Main || consumers.empty()) return;
+
+	auto frame = acquireFrame();
+	if (!frame) {
+		// every frame is still referenced by some consumer
+		poolExhausted += 1;
+		return;
+	}
+
+	size_t size = (size_t)ev->width * ev->height * 4;
+	frame->rgba.resize(size);
+	memcpy(frame->rgba.data(), ev->frameData, size);
+	frame->width = ev->width;
+	frame->height = ev->height;
+	frame->timeSeconds = ev->timeSeconds;
+	frame->frameIndex = frameCounter++;
+	frame->arrivalTicks = SDL_GetPerformanceCounter();
+
+	for (auto& slot : consumers) {
+		SDL_LockMutex(slot->mutex);
+		bool push = true;
+		if ((int)slot->queue.size() >= slot->desc.maxQueueDepth) {
+			slot->stats.droppedQueueFull += 1;
+			if (slot->desc.dropPolicy == OFS_FrameDropPolicy::DropOldest) {
+				releaseFrame(slot->queue.front());
+				slot->queue.pop_front();
+			}
+			else {
+				push = false;
+			}
+		}
+		if (push) {
+			SDL_AtomicIncRef(&frame->refs);
+			slot->queue.push_back(frame);
+		}
+		bool needsSchedule = !slot->scheduled && !slot->queue.empty();
+		slot->scheduled = slot->scheduled || needsSchedule;
+		slot->stats.queueDepth = (uint32_t)slot->queue.size();
+		SDL_UnlockMutex(slot->mutex);
+
+		if (needsSchedule) schedule(slot);
+	}
+	// drop the reference held while distributing
+	releaseFrame(frame);
+}
+
+void OFS_FrameConsumers::schedule(const std::shared_ptr<ConsumerSlot>& slot) noexcept
+{
+	OFS_ThreadPool::Get()->Submit([this, slot]() noexcept { runConsumer(slot); });
+}
+
+void OFS_FrameConsumers::convertFrame(const PooledFrame& frame, ConsumerSlot& slot, OFS_ConsumerFrame& out) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	const int ds = slot.desc.downscale;
+	out.format = slot.desc.format;
+	out.timeSeconds = frame.timeSeconds;
+	out.frameIndex = frame.frameIndex;
+
+	if (ds == 1 && slot.desc.format == OFS_FrameFormat::RGBA) {
+		out.data = frame.rgba.data();
+		out.width = frame.width;
+		out.height = frame.height;
+		out.pitch = frame.width * 4;
+		return;
+	}
+
+	out.width = frame.width / ds;
+	out.height = frame.height / ds;
+	const int channels = slot.desc.format == OFS_FrameFormat::RGBA ? 4 : 1;
+	out.pitch = out.width * channels;
+	slot.scratch.resize((size_t)out.pitch * out.height);
+
+	const int srcPitch = frame.width * 4;
+	const uint32_t area = ds * ds;
+	for (int y = 0; y < out.height; y += 1) {
+		uint8_t* dst = slot.scratch.data() + (size_t)y * out.pitch;
+		for (int x = 0; x < out.width; x += 1) {
+			// box filter over ds*ds source pixels
+			uint32_t sum[4] = {};
+			for (int sy = 0; sy < ds; sy += 1) {
+				const uint8_t* src = frame.rgba.data() + (size_t)(y * ds + sy) * srcPitch + (size_t)x * ds * 4;
+				for (int sx = 0; sx < ds; sx += 1, src += 4) {
+					sum[0] += src[0]; sum[1] += src[1]; sum[2] += src[2]; sum[3] += src[3];
+				}
+			}
+			if (channels == 4) {
+				for (int c = 0; c < 4; c += 1) dst[x * 4 + c] = (uint8_t)(sum[c] / area);
+			}
+			else {
+				// BT.601 luma
+				dst[x] = (uint8_t)(((77 * sum[0] + 150 * sum[1] + 29 * sum[2]) >> 8) / area);
+			}
+		}
+	}
+	out.data = slot.scratch.data();
+}
+
+void OFS_FrameConsumers::runConsumer(const std::shared_ptr<ConsumerSlot>& slot) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	PooledFrame* frame = nullptr;
+	SDL_LockMutex(slot->mutex);
+	if (slot->removed || slot->queue.empty()) {
+		slot->scheduled = false;
+		SDL_UnlockMutex(slot->mutex);
+		return;
+	}
+	frame = slot->queue.front();
+	slot->queue.pop_front();
+	slot->stats.queueDepth = (uint32_t)slot->queue.size();
+	slot->processing = true;
+	SDL_UnlockMutex(slot->mutex);
+
+	const uint64_t freq = SDL_GetPerformanceFrequency();
+	uint64_t startTicks = SDL_GetPerformanceCounter();
+	float ageMs = (float)((startTicks - frame->arrivalTicks) * 1000.0 / (double)freq);
+
+	OFS_FrameResultPtr result;
+	bool stale = slot->desc.latencyToleranceMs > 0.f && ageMs > slot->desc.latencyToleranceMs;
+	float processMs = 0.f;
+	if (!stale) {
+		OFS_ConsumerFrame consumerFrame;
+		convertFrame(*frame, *slot, consumerFrame);
+		result = slot->consumer->Process(consumerFrame);
+		processMs = (float)((SDL_GetPerformanceCounter() - startTicks) * 1000.0 / (double)freq);
+		if (result) {
+			result->timeSeconds = frame->timeSeconds;
+			result->frameIndex = frame->frameIndex;
+		}
+	}
+	releaseFrame(frame);
+
+	if (result) {
+		SDL_LockMutex(resultMutex);
+		results.emplace_back(PendingResult{ slot, std::move(result) });
+		SDL_UnlockMutex(resultMutex);
+	}
+
+	SDL_LockMutex(slot->mutex);
+	slot->processing = false;
+	SDL_CondBroadcast(slot->idle);
+	auto& stats = slot->stats;
+	if (stale) {
+		stats.droppedStale += 1;
+	}
+	else {
+		stats.processed += 1;
+		stats.averageProcessMs = stats.processed == 1
+			? processMs
+			: stats.averageProcessMs + (processMs - stats.averageProcessMs) * 0.05f;
+		slot->throughputWindowCount += 1;
+		uint64_t now = SDL_GetPerformanceCounter();
+		double windowSeconds = (now - slot->throughputWindowStart) / (double)freq;
+		if (windowSeconds >= 1.0) {
+			stats.throughput = (float)(slot->throughputWindowCount / windowSeconds);
+			slot->throughputWindowCount = 0;
+			slot->throughputWindowStart = now;
+		}
+	}
+	// one frame per task so consumers share the pool fairly
+	bool more = !slot->removed && !slot->queue.empty();
+	slot->scheduled = more;
+	SDL_UnlockMutex(slot->mutex);
+
+	if (more) schedule(slot);
+}
+
+void OFS_FrameConsumers::Update() noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	SDL_LockMutex(resultMutex);
+	std::swap(results, resultsSwap);
+	SDL_UnlockMutex(resultMutex);
+
+	for (auto& pending : resultsSwap) {
+		if (!pending.slot->removed) {
+			pending.slot->consumer->OnResult(*pending.result);
+		}
+	}
+	resultsSwap.clear();
+}
+
+void OFS_FrameConsumers::ShowStats() noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	if (consumers.empty()) {
+		ImGui::TextDisabled("No frame consumers registered.");
+		return;
+	}
+
+	ImGui::Text("Frame pool: %d frames, %llu exhausted", PoolSize, (unsigned long long)poolExhausted);
+	if (ImGui::BeginTable("##FrameConsumers", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+		ImGui::TableSetupColumn("Consumer");
+		ImGui::TableSetupColumn("Input");
+		ImGui::TableSetupColumn("Queue");
+		ImGui::TableSetupColumn("Processed");
+		ImGui::TableSetupColumn("Dropped (full/stale)");
+		ImGui::TableSetupColumn("Avg ms");
+		ImGui::TableSetupColumn("FPS");
+		ImGui::TableHeadersRow();
+
+		for (auto& slot : consumers) {
+			SDL_LockMutex(slot->mutex);
+			auto stats = slot->stats;
+			SDL_UnlockMutex(slot->mutex);
+			auto& desc = slot->desc;
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(desc.name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%s 1/%d", desc.format == OFS_FrameFormat::RGBA ? "RGBA" : "Gray", desc.downscale);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u/%d %s", stats.queueDepth, desc.maxQueueDepth,
+				desc.dropPolicy == OFS_FrameDropPolicy::DropOldest ? "drop oldest" : "drop newest");
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)stats.processed);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu/%llu", (unsigned long long)stats.droppedQueueFull, (unsigned long long)stats.droppedStale);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.2f", stats.averageProcessMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", stats.throughput);
+		}
+		ImGui::EndTable();
+	}
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "OFS_VideoplayerEvents.h"
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "SDL_mutex.h"
+#include "SDL_atomic.h"
+
+enum class OFS_FrameFormat : int32_t
+{
+    RGBA,
+    Gray
+};
+
+enum class OFS_FrameDropPolicy : int32_t
+{
+    DropOldest, // keep the newest frames, good for realtime trackers
+    DropNewest  // keep what is queued, good for consumers which need continuity
+};
+
+struct OFS_FrameConsumerDesc
+{
+    std::string name;
+    OFS_FrameFormat format = OFS_FrameFormat::RGBA;
+    int downscale = 1;              // 1 = full processing resolution, 2 = half, ...
+    float latencyToleranceMs = 0.f; // frames older than this are dropped before processing, 0 = no limit
+    int maxQueueDepth = 2;
+    OFS_FrameDropPolicy dropPolicy = OFS_FrameDropPolicy::DropOldest;
+};
+
+// Frame handed to OFS_FrameConsumer::Process already converted to the requested format
+struct OFS_ConsumerFrame
+{
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int pitch = 0; // bytes per row
+    OFS_FrameFormat format = OFS_FrameFormat::RGBA;
+    double timeSeconds = 0.0;
+    uint64_t frameIndex = 0;
+};
+
+// Output of a consumer, passed back to the main thread
+struct OFS_FrameResult
+{
+    double timeSeconds = 0.0;
+    uint64_t frameIndex = 0;
+    virtual ~OFS_FrameResult() noexcept {}
+};
+using OFS_FrameResultPtr = std::unique_ptr<OFS_FrameResult>;
+
+class OFS_FrameConsumer
+{
+public:
+    virtual ~OFS_FrameConsumer() noexcept {}
+    virtual OFS_FrameConsumerDesc Describe() const noexcept = 0;
+    // Called on a pool thread. Frames of one consumer are processed in order, never concurrently.
+    // Returning nullptr produces no result.
+    virtual OFS_FrameResultPtr Process(const OFS_ConsumerFrame& frame) noexcept = 0;
+    // Called on the main thread with results in frame order.
+    virtual void OnResult(OFS_FrameResult& result) noexcept {}
+};
+
+struct OFS_FrameConsumerStats
+{
+    uint32_t queueDepth = 0;
+    uint64_t processed = 0;
+    uint64_t droppedQueueFull = 0;
+    uint64_t droppedStale = 0;
+    float averageProcessMs = 0.f;
+    float throughput = 0.f; // frames per second
+};
+
+// Owns the pooled frame ring and the consumer registry.
+// ProcessingFrameReadyEvent frames are copied once into the ring and shared by all consumers via refcount.
+class OFS_FrameConsumers
+{
+public:
+    static constexpr int PoolSize = 8;
+
+    struct PooledFrame
+    {
+        std::vector<uint8_t> rgba;
+        int width = 0;
+        int height = 0;
+        double timeSeconds = 0.0;
+        uint64_t frameIndex = 0;
+        uint64_t arrivalTicks = 0;
+        SDL_atomic_t refs = {0};
+    };
+
+private:
+    struct ConsumerSlot
+    {
+        uint32_t id = 0;
+        std::shared_ptr<OFS_FrameConsumer> consumer;
+        OFS_FrameConsumerDesc desc;
+
+        SDL_mutex* mutex = nullptr;
+        // signalled when a task finishes processing a frame
+        SDL_cond* idle = nullptr;
+        std::deque<PooledFrame*> queue;
+        bool scheduled = false;
+        bool processing = false;
+        bool removed = false;
+
+        // only touched by the task currently processing this consumer
+        std::vector<uint8_t> scratch;
+
+        OFS_FrameConsumerStats stats;
+        uint64_t throughputWindowStart = 0;
+        uint32_t throughputWindowCount = 0;
+
+        ~ConsumerSlot() noexcept;
+    };
+
+    struct PendingResult
+    {
+        std::shared_ptr<ConsumerSlot> slot;
+        OFS_FrameResultPtr result;
+    };
+
+    static OFS_FrameConsumers* instance;
+
+    PooledFrame pool[PoolSize];
+    uint32_t poolCursor = 0;
+    uint64_t frameCounter = 0;
+    uint64_t poolExhausted = 0;
+
+    std::vector<std::shared_ptr<ConsumerSlot>> consumers;
+    uint32_t nextConsumerId = 1;
+
+    SDL_mutex* resultMutex = nullptr;
+    std::vector<PendingResult> results;
+    std::vector<PendingResult> resultsSwap;
+
+    OFS_FrameConsumers() noexcept;
+    ~OFS_FrameConsumers() noexcept;
+
+    PooledFrame* acquireFrame() noexcept;
+    static void releaseFrame(PooledFrame* frame) noexcept;
+    void schedule(const std::shared_ptr<ConsumerSlot>& slot) noexcept;
+    void runConsumer(const std::shared_ptr<ConsumerSlot>& slot) noexcept;
+    static void convertFrame(const PooledFrame& frame, ConsumerSlot& slot, OFS_ConsumerFrame& outFrame) noexcept;
+
+    void frameReady(const ProcessingFrameReadyEvent* ev) noexcept;
+
+public:
+    static bool Init() noexcept;
+    static void Shutdown() noexcept;
+    inline static OFS_FrameConsumers* Get() noexcept { return instance; }
+
+    uint32_t Register(std::shared_ptr<OFS_FrameConsumer> consumer) noexcept;
+    // Waits for a Process call already running, the consumer can be registered again right after.
+    void Unregister(uint32_t id) noexcept;
+    bool HasConsumers() const noexcept { return !consumers.empty(); }
+
+    // Dispatches finished results on the main thread.
+    void Update() noexcept;
+    void ShowStats() noexcept;
+};
@@ -0,0 +1,318 @@
+#include "OFS_FrameIndex.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+#include "OFS_BinarySerialization.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "SDL_timer.h"
+
+#include "subprocess.h"
+#include "sdefl.h"
+#include "sinfl.h"
+
+static constexpr uint32_t CacheMagic = 0x4946534F; // "OSFI"
+
+// On disk representation, times are stored as microsecond deltas which compress very well.
+struct FrameIndexCacheFile
+{
+    uint32_t version = 0;
+    std::string mediaPath;
+    int64_t firstFrameUs = 0;
+    std::vector<int32_t> frameDeltasUs;
+    std::vector<uint32_t> keyframes;
+
+    template<typename S>
+    void serialize(S& s)
+    {
+        s.value4b(version);
+        s.text1b(mediaPath, std::numeric_limits<uint32_t>::max());
+        s.value8b(firstFrameUs);
+        s.container4b(frameDeltasUs, std::numeric_limits<uint32_t>::max());
+        s.container4b(keyframes, std::numeric_limits<uint32_t>::max());
+    }
+};
+
+OFS_FrameIndex::~OFS_FrameIndex() noexcept
+{
+    Clear();
+}
+
+std::string OFS_FrameIndex::CachePath(const std::string& mediaPath) noexcept
+{
+    auto name = Util::MediaFingerprint(mediaPath) + ".bin";
+    return Util::Prefpath((Util::PathFromString("cache") / "frameindex" / name).u8string());
+}
+
+void OFS_FrameIndex::Build(const std::string& newMediaPath) noexcept
+{
+    Clear();
+    mediaPath = newMediaPath;
+    status = Status::Building;
+
+    job = std::make_shared<BuildJob>();
+    job->mediaPath = newMediaPath;
+    OFS_JobDesc desc;
+    desc.Name = "Frame index: " + Util::Filename(newMediaPath);
+    desc.Priority = OFS_ThreadPool::Priority::Low;
+    desc.Lane = OFS_JobLane::Process;
+    // the task keeps the job alive, even if the index moves on to another file
+    desc.Work = [buildJob = job](OFS_Job& task) noexcept { return build(*buildJob, task); };
+    task = OFS_JobSystem::Submit(std::move(desc));
+}
+
+void OFS_FrameIndex::Clear() noexcept
+{
+    if (task) {
+        task->Cancel();
+        task.reset();
+    }
+    job.reset();
+    data.reset();
+    mediaPath.clear();
+    status = Status::Empty;
+}
+
+void OFS_FrameIndex::Update() noexcept
+{
+    if (!task || !task->IsFinished()) return;
+
+    if (job->success) {
+        auto newData = std::make_shared<Data>(std::move(job->data));
+        LOGF_INFO("Frame index ready: %zu frames, %zu keyframes%s", newData->frameTimes.size(),
+            newData->keyframes.size(), job->fromCache ? " (cached)" : "");
+        data = std::move(newData);
+        status = Status::Ready;
+    }
+    else {
+        status = Status::Failed;
+    }
+    job.reset();
+    task.reset();
+}
+
+bool OFS_FrameIndex::build(BuildJob& job, OFS_Job& task) noexcept
+{
+    auto cachePath = CachePath(job.mediaPath);
+    if (loadCache(cachePath, job)) {
+        job.success = true;
+        job.fromCache = true;
+    }
+    else {
+        auto startTicks = SDL_GetTicks64();
+        job.success = runProbe(job, task);
+        if (job.success) {
+            LOGF_INFO("Frame index built in %.2f seconds", (SDL_GetTicks64() - startTicks) / 1000.f);
+            saveCache(cachePath, job);
+        }
+    }
+
+    return job.success;
+}
+
+bool OFS_FrameIndex::runProbe(BuildJob& job, OFS_Job& task) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    auto ffprobePath = Util::FfprobePath().u8string();
+
+    // packet level is enough for pts and key flags, -show_frames would decode the whole stream
+    std::array<const char*, 12> args =
+    {
+        ffprobePath.c_str(),
+        "-v", "error",
+        "-select_streams", "v:0",
+        "-show_entries", "packet=pts_time,flags:format=start_time",
+        "-of", "csv",
+        job.mediaPath.c_str(),
+        nullptr
+    };
+
+    struct subprocess_s proc;
+    if (subprocess_create(args.data(), subprocess_option_no_window | subprocess_option_inherit_environment
+        | subprocess_option_combined_stdout_stderr, &proc) != 0) {
+        LOGF_ERROR("Failed to start \"%s\"", ffprobePath.c_str());
+        return false;
+    }
+
+    struct Packet
+    {
+        double pts;
+        bool key;
+    };
+    std::vector<Packet> packets;
+    double startTime = NAN;
+
+    char line[256];
+    FILE* out = subprocess_stdout(&proc);
+    while (out && fgets(line, sizeof(line), out)) {
+        if (task.IsCancelled()) {
+            subprocess_terminate(&proc);
+            break;
+        }
+        char* endPtr = nullptr;
+        if (strncmp(line, "packet,", 7) == 0) {
+            // packet,<pts_time>,<flags>
+            double pts = strtod(line + 7, &endPtr);
+            if (endPtr == line + 7 || *endPtr != ',') continue; // N/A
+            packets.emplace_back(Packet{ pts, endPtr[1] == 'K' });
+        }
+        else if (strncmp(line, "format,", 7) == 0) {
+            double time = strtod(line + 7, &endPtr);
+            if (endPtr != line + 7) startTime = time;
+        }
+    }
+
+    int returnCode = -1;
+    subprocess_join(&proc, &returnCode);
+    subprocess_destroy(&proc);
+
+    if (task.IsCancelled() || packets.empty()) {
+        if (returnCode != 0) LOGF_WARN("ffprobe failed with code %d", returnCode);
+        return false;
+    }
+
+    // packets come in decode order
+    std::sort(packets.begin(), packets.end(), [](auto& a, auto& b) noexcept { return a.pts < b.pts; });
+    if (std::isnan(startTime)) startTime = packets.front().pts;
+
+    auto& frameTimes = job.data.frameTimes;
+    auto& keyframes = job.data.keyframes;
+    frameTimes.reserve(packets.size());
+    for (auto& packet : packets) {
+        if (!frameTimes.empty() && packet.pts - startTime <= frameTimes.back()) continue; // duplicate pts
+        if (packet.key) keyframes.emplace_back((uint32_t)frameTimes.size());
+        frameTimes.emplace_back(packet.pts - startTime);
+    }
+    return true;
+}
+
+bool OFS_FrameIndex::loadCache(const std::string& cachePath, BuildJob& job) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    std::vector<uint8_t> fileData;
+    if (Util::ReadFile(cachePath.c_str(), fileData) < sizeof(uint32_t) * 2) {
+        return false;
+    }
+
+    uint32_t header[2];
+    memcpy(header, fileData.data(), sizeof(header));
+    if (header[0] != CacheMagic) return false;
+
+    ByteBuffer buffer;
+    buffer.resize(header[1]);
+    int compressedSize = (int)(fileData.size() - sizeof(header));
+    // sinflate reads whole words, keep it inside the allocation
+    fileData.resize(fileData.size() + sizeof(uint64_t));
+    auto size = sinflate(buffer.data(), (int)buffer.size(), fileData.data() + sizeof(header), compressedSize);
+    if (size != (int)header[1]) return false;
+
+    FrameIndexCacheFile cache;
+    auto error = OFS_Binary::Deserialize(buffer, cache);
+    if (error != bitsery::ReaderError::NoError || cache.version != CacheVersion || cache.mediaPath != job.mediaPath) {
+        return false;
+    }
+
+    auto& frameTimes = job.data.frameTimes;
+    frameTimes.reserve(cache.frameDeltasUs.size());
+    int64_t us = cache.firstFrameUs;
+    for (auto delta : cache.frameDeltasUs) {
+        us += delta;
+        frameTimes.emplace_back(us / 1000000.0);
+    }
+    job.data.keyframes = std::move(cache.keyframes);
+    return !frameTimes.empty();
+}
+
+bool OFS_FrameIndex::saveCache(const std::string& cachePath, const BuildJob& job) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    if (!Util::CreateDirectories(Util::PathFromString(cachePath).parent_path())) {
+        return false;
+    }
+
+    FrameIndexCacheFile cache;
+    cache.version = CacheVersion;
+    cache.mediaPath = job.mediaPath;
+    cache.keyframes = job.data.keyframes;
+    auto& frameTimes = job.data.frameTimes;
+    cache.firstFrameUs = std::llround(frameTimes.front() * 1000000.0);
+    cache.frameDeltasUs.reserve(frameTimes.size());
+    int64_t previousUs = cache.firstFrameUs;
+    for (auto time : frameTimes) {
+        int64_t us = std::llround(time * 1000000.0);
+        cache.frameDeltasUs.emplace_back((int32_t)(us - previousUs));
+        previousUs = us;
+    }
+
+    ByteBuffer buffer;
+    auto size = OFS_Binary::Serialize(buffer, cache);
+
+    std::vector<uint8_t> fileData;
+    fileData.resize(sizeof(uint32_t) * 2 + sdefl_bound((int)size));
+    uint32_t header[2] = { CacheMagic, (uint32_t)size };
+    memcpy(fileData.data(), header, sizeof(header));
+
+    sdefl ctx = {0};
+    auto compressedSize = sdeflate(&ctx, fileData.data() + sizeof(header), buffer.data(), (int)size, 8);
+    fileData.resize(sizeof(header) + compressedSize);
+    return Util::WriteFile(cachePath.c_str(), fileData.data(), fileData.size()) == fileData.size();
+}
+
+int64_t OFS_FrameIndex::FrameAt(double time) const noexcept
+{
+    if (!data || data->frameTimes.empty()) return -1;
+    auto& frameTimes = data->frameTimes;
+    auto it = std::upper_bound(frameTimes.begin(), frameTimes.end(), time + LookupEpsilon);
+    return (int64_t)(it - frameTimes.begin()) - 1;
+}
+
+double OFS_FrameIndex::FrameTime(int64_t frameIdx) const noexcept
+{
+    if (!data || data->frameTimes.empty()) return 0.0;
+    auto& frameTimes = data->frameTimes;
+    frameIdx = Util::Clamp<int64_t>(frameIdx, 0, (int64_t)frameTimes.size() - 1);
+    return frameTimes[frameIdx];
+}
+
+double OFS_FrameIndex::StepFrames(double time, int32_t offset) const noexcept
+{
+    auto frameIdx = FrameAt(time);
+    if (frameIdx < 0 && offset > 0) {
+        // before the first frame, the first step lands on it
+        offset -= 1;
+        frameIdx = 0;
+    }
+    return FrameTime(frameIdx + offset);
+}
+
+double OFS_FrameIndex::NextFrameTime(double time) const noexcept
+{
+    return StepFrames(time, 1);
+}
+
+double OFS_FrameIndex::PreviousFrameTime(double time) const noexcept
+{
+    // last frame start before time, so times between two frames snap back to the frame start
+    if (!data || data->frameTimes.empty()) return 0.0;
+    auto& frameTimes = data->frameTimes;
+    auto it = std::lower_bound(frameTimes.begin(), frameTimes.end(), time - LookupEpsilon);
+    return FrameTime((int64_t)(it - frameTimes.begin()) - 1);
+}
+
+double OFS_FrameIndex::SnapToFrame(double time) const noexcept
+{
+    return FrameTime(Util::Max<int64_t>(FrameAt(time), 0));
+}
+
+double OFS_FrameIndex::KeyframeBefore(double time) const noexcept
+{
+    if (!data || data->keyframes.empty()) return 0.0;
+    auto frameIdx = FrameAt(time);
+    auto& keyframes = data->keyframes;
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), (uint32_t)Util::Max<int64_t>(frameIdx, 0));
+    if (it == keyframes.begin()) return FrameTime(0);
+    return FrameTime(*(it - 1));
+}
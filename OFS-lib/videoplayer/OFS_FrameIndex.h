@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "OFS_JobSystem.h"
+
+// Per media index of every video frame's presentation time and the keyframe positions.
+// Built once in the background via ffprobe (packet level, no decoding) and cached on disk
+// keyed by a fingerprint of the media file. Times are rebased so that 0 is the start of the media,
+// same as mpv's time-pos.
+class OFS_FrameIndex
+{
+public:
+    static constexpr uint32_t CacheVersion = 1;
+    // Tolerance used when looking up the frame at a time, logical positions are only float precise.
+    static constexpr double LookupEpsilon = 0.002;
+
+    enum class Status : int32_t
+    {
+        Empty,
+        Building,
+        Ready,
+        Failed
+    };
+
+    struct Data
+    {
+        std::vector<double> frameTimes; // sorted
+        std::vector<uint32_t> keyframes; // indices into frameTimes, sorted
+    };
+
+private:
+    struct BuildJob
+    {
+        std::string mediaPath;
+        Data data;
+        bool success = false;
+        bool fromCache = false;
+    };
+
+    std::shared_ptr<const Data> data;
+    std::shared_ptr<BuildJob> job;
+    OFS_JobHandle task;
+    std::string mediaPath;
+    Status status = Status::Empty;
+
+    static bool build(BuildJob& job, OFS_Job& task) noexcept;
+    static bool runProbe(BuildJob& job, OFS_Job& task) noexcept;
+    static bool loadCache(const std::string& cachePath, BuildJob& job) noexcept;
+    static bool saveCache(const std::string& cachePath, const BuildJob& job) noexcept;
+
+public:
+    OFS_FrameIndex() noexcept {}
+    ~OFS_FrameIndex() noexcept;
+
+    static std::string CachePath(const std::string& mediaPath) noexcept;
+
+    // Starts building the index for mediaPath in the background, cancels a running build.
+    void Build(const std::string& mediaPath) noexcept;
+    void Clear() noexcept;
+    // Main thread, adopts a finished build.
+    void Update() noexcept;
+
+    inline Status GetStatus() const noexcept { return status; }
+    inline bool IsReady() const noexcept { return status == Status::Ready; }
+    inline const std::string& MediaPath() const noexcept { return mediaPath; }
+
+    inline size_t FrameCount() const noexcept { return data ? data->frameTimes.size() : 0; }
+    inline size_t KeyframeCount() const noexcept { return data ? data->keyframes.size() : 0; }
+
+    // Index of the frame which is displayed at time, -1 if before the first frame or not ready.
+    int64_t FrameAt(double time) const noexcept;
+    // Presentation time of a frame, the index is clamped.
+    double FrameTime(int64_t frameIdx) const noexcept;
+
+    // First frame start after time.
+    double NextFrameTime(double time) const noexcept;
+    // Last frame start before time.
+    double PreviousFrameTime(double time) const noexcept;
+    // Moves by offset frames from the frame displayed at time.
+    double StepFrames(double time, int32_t offset) const noexcept;
+    // Start time of the frame displayed at time.
+    double SnapToFrame(double time) const noexcept;
+    // Closest keyframe at or before time.
+    double KeyframeBefore(double time) const noexcept;
+};
@@ -0,0 +1,317 @@
+#include "OFS_MotionTracker.h"
+#include "OFS_ThreadPool.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OFS_TRACKER_SSE2 1
+#include "emmintrin.h"
+#else
+#define OFS_TRACKER_SSE2 0
+#endif
+
+// Frames further apart than this are treated as a seek
+static constexpr double MaxFrameGapSeconds = 0.5;
+
+OFS_FrameConsumerDesc OFS_MotionTracker::Describe() const noexcept
+{
+	OFS_FrameConsumerDesc desc;
+	desc.name = "Motion tracker";
+	desc.format = OFS_FrameFormat::Gray;
+	desc.downscale = 1;
+	// every frame matters for the accumulated displacement
+	desc.latencyToleranceMs = 0.f;
+	desc.maxQueueDepth = 8;
+	desc.dropPolicy = OFS_FrameDropPolicy::DropNewest;
+	return desc;
+}
+
+void OFS_MotionTracker::SetROI(const OFS_TrackerROI& newRoi) noexcept
+{
+	SDL_AtomicLock(&roiLock);
+	roi = newRoi;
+	SDL_AtomicUnlock(&roiLock);
+}
+
+void OFS_MotionTracker::Reset() noexcept
+{
+	samples.clear();
+	accumulated = 0.f;
+	SDL_AtomicSet(&resetRequested, 1);
+}
+
+void OFS_MotionTracker::buildPyramid(const OFS_ConsumerFrame& frame, Pyramid& pyramid) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	auto& base = pyramid[0];
+	base.width = frame.width;
+	base.height = frame.height;
+	base.pixels.resize((size_t)frame.width * frame.height);
+	for (int y = 0; y < frame.height; y += 1) {
+		memcpy(base.pixels.data() + (size_t)y * frame.width, frame.data + (size_t)y * frame.pitch, frame.width);
+	}
+
+	for (int level = 1; level < PyramidLevels; level += 1) {
+		auto& src = pyramid[level - 1];
+		auto& dst = pyramid[level];
+		dst.width = src.width / 2;
+		dst.height = src.height / 2;
+		dst.pixels.resize((size_t)dst.width * dst.height);
+		for (int y = 0; y < dst.height; y += 1) {
+			const uint8_t* s0 = src.pixels.data() + (size_t)(y * 2) * src.width;
+			const uint8_t* s1 = s0 + src.width;
+			uint8_t* d = dst.pixels.data() + (size_t)y * dst.width;
+			for (int x = 0; x < dst.width; x += 1) {
+				d[x] = (uint8_t)((s0[x * 2] + s0[x * 2 + 1] + s1[x * 2] + s1[x * 2 + 1] + 2) >> 2);
+			}
+		}
+	}
+}
+
+inline static uint32_t sad(const uint8_t* a, const uint8_t* b, int pitch, int w, int h) noexcept
+{
+	uint32_t sum = 0;
+#if OFS_TRACKER_SSE2
+	__m128i acc = _mm_setzero_si128();
+#endif
+	for (int y = 0; y < h; y += 1) {
+		int x = 0;
+#if OFS_TRACKER_SSE2
+		for (; x + 16 <= w; x += 16) {
+			__m128i va = _mm_loadu_si128((const __m128i*)(a + x));
+			__m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+		}
+#endif
+		for (; x < w; x += 1) {
+			sum += (uint32_t)std::abs((int)a[x] - (int)b[x]);
+		}
+		a += pitch;
+		b += pitch;
+	}
+#if OFS_TRACKER_SSE2
+	sum += (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#endif
+	return sum;
+}
+
+void OFS_MotionTracker::matchRegion(const GrayImage& prev, const GrayImage& cur,
+	int x, int y, int w, int h, int searchRange, int guessX, int guessY, int* outX, int* outY) noexcept
+{
+	constexpr uint32_t Invalid = UINT32_MAX;
+	uint32_t best = Invalid;
+	int bestX = guessX, bestY = guessY;
+	const uint8_t* prevBlock = prev.pixels.data() + (size_t)y * prev.width + x;
+
+	for (int dy = -searchRange; dy <= searchRange; dy += 1) {
+		int cy = y + guessY + dy;
+		if (cy < 0 || cy + h > cur.height) continue;
+		for (int dx = -searchRange; dx <= searchRange; dx += 1) {
+			int cx = x + guessX + dx;
+			if (cx < 0 || cx + w > cur.width) continue;
+			uint32_t cost = sad(prevBlock, cur.pixels.data() + (size_t)cy * cur.width + cx, cur.width, w, h);
+			// prefer the smaller motion on ties
+			if (cost < best || (cost == best && std::abs(guessX + dx) + std::abs(guessY + dy) < std::abs(bestX) + std::abs(bestY))) {
+				best = cost;
+				bestX = guessX + dx;
+				bestY = guessY + dy;
+			}
+		}
+	}
+	*outX = bestX;
+	*outY = bestY;
+}
+
+// Vertex of the parabola through the costs left of, at and right of the best integer offset
+inline static float parabolaVertex(uint32_t before, uint32_t at, uint32_t after) noexcept
+{
+	float denom = (float)before - 2.f * (float)at + (float)after;
+	if (denom <= 0.f) return 0.f;
+	return Util::Clamp(0.5f * ((float)before - (float)after) / denom, -0.5f, 0.5f);
+}
+
+void OFS_MotionTracker::subPixelOffset(const GrayImage& prev, const GrayImage& cur,
+	int x, int y, int w, int h, int bestX, int bestY, float* outX, float* outY) noexcept
+{
+	const uint8_t* prevBlock = prev.pixels.data() + (size_t)y * prev.width + x;
+	auto cost = [&](int ox, int oy) noexcept {
+		return sad(prevBlock, cur.pixels.data() + (size_t)(y + oy) * cur.width + x + ox, cur.width, w, h);
+	};
+	const uint32_t center = cost(bestX, bestY);
+	*outX = (float)bestX;
+	*outY = (float)bestY;
+	// without both neighbours inside the frame the integer offset is kept
+	if (x + bestX - 1 >= 0 && x + bestX + 1 + w <= cur.width) {
+		*outX += parabolaVertex(cost(bestX - 1, bestY), center, cost(bestX + 1, bestY));
+	}
+	if (y + bestY - 1 >= 0 && y + bestY + 1 + h <= cur.height) {
+		*outY += parabolaVertex(cost(bestX, bestY - 1), center, cost(bestX, bestY + 1));
+	}
+}
+
+OFS_FrameResultPtr OFS_MotionTracker::Process(const OFS_ConsumerFrame& frame) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	if (frame.format != OFS_FrameFormat::Gray) return nullptr;
+
+	auto& cur = pyramids[currentPyramid];
+	auto& prev = pyramids[currentPyramid ^ 1];
+	buildPyramid(frame, cur);
+
+	bool reset = SDL_AtomicSet(&resetRequested, 0) != 0
+		|| !hasPrevious
+		|| frame.timeSeconds < previousTime
+		|| frame.timeSeconds - previousTime > MaxFrameGapSeconds
+		|| prev[0].width != cur[0].width || prev[0].height != cur[0].height;
+
+	auto result = std::make_unique<OFS_MotionResult>();
+	result->reset = reset;
+
+	if (!reset) {
+		SDL_AtomicLock(&roiLock);
+		auto region = roi;
+		SDL_AtomicUnlock(&roiLock);
+
+		// keep a margin so the coarse search stays inside the frame
+		const int coarseScale = 1 << (PyramidLevels - 1);
+		const int margin = (CoarseSearch + RefineSearch) * coarseScale;
+		int rx = Util::Clamp((int)(region.x * frame.width), margin, frame.width - margin);
+		int ry = Util::Clamp((int)(region.y * frame.height), margin, frame.height - margin);
+		int rw = Util::Clamp((int)(region.w * frame.width), 0, frame.width - margin - rx);
+		int rh = Util::Clamp((int)(region.h * frame.height), 0, frame.height - margin - ry);
+		// align to the coarsest level
+		rw -= rw % coarseScale;
+		rh -= rh % coarseScale;
+
+		if (rw >= BlockSize && rh >= BlockSize) {
+			// coarse to fine global motion of the whole region
+			int gx = 0, gy = 0;
+			float subX, subY;
+			for (int level = PyramidLevels - 1; level >= 0; level -= 1) {
+				const int scale = 1 << level;
+				if (level != PyramidLevels - 1) {
+					gx *= 2;
+					gy *= 2;
+				}
+				matchRegion(prev[level], cur[level], rx / scale, ry / scale, rw / scale, rh / scale,
+					level == PyramidLevels - 1 ? CoarseSearch : RefineSearch, gx, gy, &gx, &gy);
+			}
+			subPixelOffset(prev[0], cur[0], rx, ry, rw, rh, gx, gy, &subX, &subY);
+
+			// per block refinement around the global motion, one block row per task
+			const int blocksX = rw / BlockSize;
+			const int blocksY = rh / BlockSize;
+			blockDy.resize((size_t)blocksX * blocksY);
+			OFS_ThreadPool::Get()->ParallelFor(blocksY, [&](int by) noexcept {
+				for (int bx = 0; bx < blocksX; bx += 1) {
+					const int x = rx + bx * BlockSize;
+					const int y = ry + by * BlockSize;
+					int ox, oy;
+					float fx, fy;
+					matchRegion(prev[0], cur[0], x, y, BlockSize, BlockSize, RefineSearch, gx, gy, &ox, &oy);
+					// slow motion moves less than half a pixel per frame and would round to zero
+					subPixelOffset(prev[0], cur[0], x, y, BlockSize, BlockSize, ox, oy, &fx, &fy);
+					blockDy[(size_t)by * blocksX + bx] = fy;
+				}
+			});
+
+			// median is robust against blocks on the background
+			auto mid = blockDy.begin() + blockDy.size() / 2;
+			std::nth_element(blockDy.begin(), mid, blockDy.end());
+			result->dy = *mid;
+			result->dx = subX;
+		}
+	}
+
+	previousTime = frame.timeSeconds;
+	hasPrevious = true;
+	currentPyramid ^= 1;
+	return result;
+}
+
+void OFS_MotionTracker::OnResult(OFS_FrameResult& baseResult) noexcept
+{
+	auto& result = static_cast<OFS_MotionResult&>(baseResult);
+	float time = (float)result.timeSeconds;
+	if (result.reset) {
+		// tracking the same range again replaces the old samples
+		auto it = std::lower_bound(samples.begin(), samples.end(), time,
+			[](const Sample& s, float t) noexcept { return s.timeSeconds < t; });
+		samples.erase(it, samples.end());
+		accumulated = samples.empty() ? 0.f : samples.back().position;
+	}
+	else {
+		// image rows grow downwards, positions grow upwards
+		accumulated -= result.dy;
+	}
+	if (samples.empty() || samples.back().timeSeconds < time) {
+		samples.push_back(Sample{ time, accumulated });
+	}
+}
+
+FunscriptArray OFS_MotionTracker::GenerateActions(const OFS_MotionTrackerSettings& settings) const noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	FunscriptArray actions;
+	const size_t n = samples.size();
+	if (n < 3) return actions;
+
+	// remove slow drift with a centered moving average
+	std::vector<double> prefix(n + 1, 0.0);
+	for (size_t i = 0; i < n; i += 1) prefix[i + 1] = prefix[i] + samples[i].position;
+
+	std::vector<float> values(n);
+	const float halfWindow = settings.detrendSeconds * 0.5f;
+	size_t lo = 0, hi = 0;
+	for (size_t i = 0; i < n; i += 1) {
+		const float t = samples[i].timeSeconds;
+		while (samples[lo].timeSeconds < t - halfWindow) lo += 1;
+		while (hi < n && samples[hi].timeSeconds <= t + halfWindow) hi += 1;
+		float mean = (float)((prefix[hi] - prefix[lo]) / (double)(hi - lo));
+		values[i] = halfWindow > 0.f ? samples[i].position - mean : samples[i].position;
+		if (settings.invert) values[i] = -values[i];
+	}
+
+	auto [minIt, maxIt] = std::minmax_element(values.begin(), values.end());
+	const float minVal = *minIt;
+	const float range = *maxIt - minVal;
+	if (range <= 0.f) return actions;
+	for (auto& v : values) v = (v - minVal) / range * 100.f;
+
+	// zigzag with hysteresis, alternating peaks and troughs
+	std::vector<size_t> extrema;
+	const float h = settings.minStrokeHeight;
+	int dir = 0;
+	size_t cand = 0, lowIdx = 0, highIdx = 0;
+	for (size_t i = 1; i < n; i += 1) {
+		const float v = values[i];
+		if (dir == 0) {
+			if (v - values[lowIdx] >= h) { extrema.push_back(lowIdx); dir = 1; cand = i; }
+			else if (values[highIdx] - v >= h) { extrema.push_back(highIdx); dir = -1; cand = i; }
+			else {
+				if (v < values[lowIdx]) lowIdx = i;
+				if (v > values[highIdx]) highIdx = i;
+			}
+		}
+		else if (dir > 0) {
+			if (v > values[cand]) cand = i;
+			else if (values[cand] - v >= h) { extrema.push_back(cand); dir = -1; cand = i; }
+		}
+		else {
+			if (v < values[cand]) cand = i;
+			else if (v - values[cand] >= h) { extrema.push_back(cand); dir = 1; cand = i; }
+		}
+	}
+	if (dir != 0) extrema.push_back(cand);
+
+	actions.reserve(extrema.size());
+	for (auto idx : extrema) {
+		int pos = Util::Clamp((int)std::lround(values[idx]), 0, 100);
+		actions.emplace_back_unsorted(FunscriptAction(samples[idx].timeSeconds, pos));
+	}
+	return actions;
+}
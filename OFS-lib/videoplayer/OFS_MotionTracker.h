@@ -0,0 +1,103 @@
+#pragma once
+
+#include "OFS_FrameConsumers.h"
+#include "FunscriptAction.h"
+#include "OFS_Event.h"
+
+#include <vector>
+#include <array>
+
+#include "SDL_atomic.h"
+
+// Normalized region of interest (0..1) in processing frame coordinates
+struct OFS_TrackerROI
+{
+    float x = 0.25f;
+    float y = 0.25f;
+    float w = 0.5f;
+    float h = 0.5f;
+};
+
+struct OFS_MotionTrackerSettings
+{
+    OFS_TrackerROI roi;
+    float detrendSeconds = 2.f;  // slow drift removal window
+    float minStrokeHeight = 10.f; // peaks/troughs closer than this (0-100) are merged
+    bool invert = false;
+};
+
+struct OFS_MotionResult : public OFS_FrameResult
+{
+    float dx = 0.f;
+    float dy = 0.f;
+    bool reset = false; // discontinuity (seek / first frame), displacement is meaningless
+};
+
+// Block matching motion tracker. Consumes gray processing frames, estimates the vertical motion
+// of the region of interest with SAD block matching on a gray pyramid and turns it into strokes.
+class OFS_MotionTracker : public OFS_FrameConsumer
+{
+public:
+    static constexpr int PyramidLevels = 3;
+    static constexpr int BlockSize = 16;
+    static constexpr int CoarseSearch = 4; // pixels at the coarsest level
+    static constexpr int RefineSearch = 2;
+
+    struct Sample
+    {
+        float timeSeconds;
+        float position; // accumulated displacement in pixels
+    };
+
+private:
+    struct GrayImage
+    {
+        std::vector<uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+    };
+    using Pyramid = std::array<GrayImage, PyramidLevels>;
+
+    // worker side
+    Pyramid pyramids[2];
+    int currentPyramid = 0;
+    bool hasPrevious = false;
+    double previousTime = 0.0;
+    std::vector<float> blockDy;
+
+    // shared, written on the main thread
+    SDL_SpinLock roiLock = 0;
+    OFS_TrackerROI roi;
+    SDL_atomic_t resetRequested = {0};
+
+    // main thread side
+    std::vector<Sample> samples;
+    float accumulated = 0.f;
+
+    static void buildPyramid(const OFS_ConsumerFrame& frame, Pyramid& pyramid) noexcept;
+    static void matchRegion(const GrayImage& prev, const GrayImage& cur,
+        int x, int y, int w, int h, int searchRange, int guessX, int guessY, int* outX, int* outY) noexcept;
+    static void subPixelOffset(const GrayImage& prev, const GrayImage& cur,
+        int x, int y, int w, int h, int bestX, int bestY, float* outX, float* outY) noexcept;
+
+public:
+    OFS_FrameConsumerDesc Describe() const noexcept override;
+    OFS_FrameResultPtr Process(const OFS_ConsumerFrame& frame) noexcept override;
+    void OnResult(OFS_FrameResult& result) noexcept override;
+
+    void SetROI(const OFS_TrackerROI& newRoi) noexcept;
+    void Reset() noexcept;
+
+    inline const std::vector<Sample>& Samples() const noexcept { return samples; }
+    // Normalizes the recorded motion to 0-100 and extracts peaks and troughs.
+    FunscriptArray GenerateActions(const OFS_MotionTrackerSettings& settings) const noexcept;
+};
+
+// Emitted when the user wants the generated actions inserted into the active script.
+class MotionTrackerActionsEvent : public OFS_Event<MotionTrackerActionsEvent>
+{
+    public:
+    FunscriptArray actions;
+    MotionTrackerActionsEvent(FunscriptArray&& actions) noexcept
+        : actions(std::move(actions)) {}
+};
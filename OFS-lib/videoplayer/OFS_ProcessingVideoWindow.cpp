@@ -5,9 +5,13 @@
 #include "OFS_EventSystem.h"
 #include "OFS_ImGui.h"
 #include "OFS_Profiling.h"
+#include "OFS_FrameConsumers.h"
+#include "OFS_MotionTracker.h"
 
 #include "state/states/ProcessingVideoWindowState.h"
 
+#include <cmath>
+
 bool OFS_ProcessingVideoWindow::Init() noexcept
 {
 	stateHandle = OFS_ProjectState<ProcessingVideoWindowState>::Register(ProcessingVideoWindowState::StateName);
@@ -35,6 +39,9 @@ bool OFS_ProcessingVideoWindow::Init() noexcept
 
 OFS_ProcessingVideoWindow::~OFS_ProcessingVideoWindow() noexcept
 {
+	if (motionTrackerId && OFS_FrameConsumers::Get()) {
+		OFS_FrameConsumers::Get()->Unregister(motionTrackerId);
+	}
 	if (processingTexture) {
 		glDeleteTextures(1, &processingTexture);
 		processingTexture = 0;
@@ -57,6 +64,8 @@ void OFS_ProcessingVideoWindow::updateProcessingFrame(const ProcessingFrameReady
 	// Upload frame data to GPU
 	glBindTexture(GL_TEXTURE_2D, processingTexture);
 	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frameWidth, frameHeight, GL_RGBA, GL_UNSIGNED_BYTE, ev->frameData);
+
+	cpuRemapMs = ev->remapMs;
 }
 
 void OFS_ProcessingVideoWindow::mouseScroll(const OFS_SDL_Event* ev) noexcept
@@ -127,7 +136,7 @@ void OFS_ProcessingVideoWindow::DrawProcessingVideo(bool* open) noexcept
 
 	// Handle drag
 	windowPos = ImGui::GetWindowPos() - viewportPos;
-	if (!state.lockedPosition && videoHovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !dragStarted) {
+	if (!state.lockedPosition && !selectingRoi && videoHovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !dragStarted) {
 		dragStarted = true;
 	}
 	else if (dragStarted && videoHovered) {
@@ -151,6 +160,7 @@ void OFS_ProcessingVideoWindow::DrawProcessingVideo(bool* open) noexcept
 
 	videoHovered = ImGui::IsItemHovered() && ImGui::IsWindowHovered();
 	videoDrawSize = ImGui::GetItemRectSize();
+	updateTrackerRoi(ImGui::GetItemRectMin(), videoDrawSize);
 
 	// Cancel drag
 	if ((dragStarted && !videoHovered) || ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
@@ -211,6 +221,20 @@ void OFS_ProcessingVideoWindow::DrawProcessingVideo(bool* open) noexcept
 
 		ImGui::Separator();
 
+		// CPU remap
+		ImGui::Checkbox("CPU Crop/Unwarp", &state.cpuRemap);
+		OFS::Tooltip("Crop (and optionally unwarp) on the CPU after readback instead of the crop shader");
+		if (state.cpuRemap) {
+			ImGui::Checkbox("Unwarp", &state.vrUnwarp);
+			OFS::Tooltip("Unwarp the VR projection using pitch, yaw and zoom");
+			ImGui::SliderFloat("Yaw", &state.vrYaw, -90.0f, 90.0f, "%.1f°");
+			if (cpuRemapMs > 0.f) {
+				ImGui::Text("CPU remap: %.2f ms (%.0f FPS)", cpuRemapMs, 1000.f / cpuRemapMs);
+			}
+		}
+
+		ImGui::Separator();
+
 		// Reset button
 		if (ImGui::Button("Reset VR Settings")) {
 			state.vrPitch = -21.0f;
@@ -218,14 +242,128 @@ void OFS_ProcessingVideoWindow::DrawProcessingVideo(bool* open) noexcept
 			state.useRightEye = false;
 			state.videoType = ProcessingVideoType::Auto;
 			state.vrLayout = ProcessingVRLayout::Auto;
+			state.vrYaw = 0.0f;
+			state.vrUnwarp = false;
 		}
 
 		ImGui::PopItemWidth();
 	}
 
+	if (ImGui::CollapsingHeader("Motion Tracker")) {
+		showMotionTracker();
+	}
+
+	if (ImGui::CollapsingHeader("Frame Consumers", ImGuiTreeNodeFlags_DefaultOpen)) {
+		if (auto consumers = OFS_FrameConsumers::Get()) {
+			consumers->ShowStats();
+		}
+	}
+
 	ImGui::End();
 }
 
+void OFS_ProcessingVideoWindow::updateTrackerRoi(const ImVec2& imageMin, const ImVec2& imageSize) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	if (!motionTracker && !selectingRoi) return;
+	auto& state = ProcessingVideoWindowState::State(stateHandle);
+
+	if (selectingRoi && videoHovered) {
+		auto toNormalized = [&](ImVec2 p) noexcept {
+			return ImVec2(Util::Clamp((p.x - imageMin.x) / imageSize.x, 0.f, 1.f),
+				Util::Clamp((p.y - imageMin.y) / imageSize.y, 0.f, 1.f));
+		};
+		if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+			roiDragStart = toNormalized(ImGui::GetMousePos());
+		}
+		else if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+			auto current = toNormalized(ImGui::GetMousePos());
+			state.trackerRoiPos = ImVec2(Util::Min(roiDragStart.x, current.x), Util::Min(roiDragStart.y, current.y));
+			state.trackerRoiSize = ImVec2(std::abs(current.x - roiDragStart.x), std::abs(current.y - roiDragStart.y));
+		}
+		else if (ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
+			selectingRoi = false;
+		}
+	}
+
+	if (motionTracker) {
+		OFS_TrackerROI roi;
+		roi.x = state.trackerRoiPos.x;
+		roi.y = state.trackerRoiPos.y;
+		roi.w = state.trackerRoiSize.x;
+		roi.h = state.trackerRoiSize.y;
+		motionTracker->SetROI(roi);
+	}
+
+	auto drawList = ImGui::GetWindowDrawList();
+	ImVec2 p1 = imageMin + state.trackerRoiPos * imageSize;
+	ImVec2 p2 = p1 + state.trackerRoiSize * imageSize;
+	drawList->AddRect(p1, p2, selectingRoi ? IM_COL32(255, 255, 0, 255) : IM_COL32(0, 255, 0, 255), 0.f, ImDrawFlags_None, 2.f);
+}
+
+void OFS_ProcessingVideoWindow::showMotionTracker() noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	auto& state = ProcessingVideoWindowState::State(stateHandle);
+	auto consumers = OFS_FrameConsumers::Get();
+	if (!consumers) return;
+
+	ImGui::PushItemWidth(200);
+	if (!motionTracker) {
+		if (ImGui::Button("Start tracking")) {
+			motionTracker = std::make_shared<OFS_MotionTracker>();
+			motionTrackerId = consumers->Register(motionTracker);
+		}
+	}
+	else {
+		if (motionTrackerId != 0) {
+			if (ImGui::Button("Stop tracking")) {
+				// waits for a frame still being processed, so resuming can't run Process twice at once
+				consumers->Unregister(motionTrackerId);
+				motionTrackerId = 0;
+			}
+		}
+		else if (ImGui::Button("Resume")) {
+			motionTrackerId = consumers->Register(motionTracker);
+		}
+	}
+	ImGui::SameLine();
+	if (ImGui::Button(selectingRoi ? "Drag on the frame..." : "Select ROI")) {
+		selectingRoi = !selectingRoi;
+	}
+	OFS::Tooltip("Drag a rectangle around the moving part on the processing frame.");
+	ImGui::TextDisabled("Frames are only produced while \"Enable Tracking\" is active.");
+
+	ImGui::SliderFloat("Detrend window", &state.trackerDetrendSeconds, 0.f, 10.f, "%.1f s");
+	OFS::Tooltip("Removes slow drift like camera movement. 0 disables it.");
+	ImGui::SliderFloat("Min stroke height", &state.trackerMinStrokeHeight, 1.f, 50.f, "%.0f");
+	OFS::Tooltip("Peaks and troughs closer than this are merged.");
+	ImGui::Checkbox("Invert", &state.trackerInvert);
+	ImGui::PopItemWidth();
+
+	if (motionTracker) {
+		auto& samples = motionTracker->Samples();
+		if (!samples.empty()) {
+			ImGui::Text("Tracked %zu frames (%.2f s - %.2f s)", samples.size(), samples.front().timeSeconds, samples.back().timeSeconds);
+		}
+		if (ImGui::Button("Insert actions") && !samples.empty()) {
+			OFS_MotionTrackerSettings settings;
+			settings.detrendSeconds = state.trackerDetrendSeconds;
+			settings.minStrokeHeight = state.trackerMinStrokeHeight;
+			settings.invert = state.trackerInvert;
+			EV::Enqueue<MotionTrackerActionsEvent>(motionTracker->GenerateActions(settings));
+		}
+		OFS::Tooltip("Inserts the detected peaks and troughs into the active script as one undo step.");
+		ImGui::SameLine();
+		if (ImGui::Button("Clear")) {
+			motionTracker->Reset();
+		}
+		if (motionTrackerId == 0 && ImGui::Button("Discard tracker")) {
+			motionTracker.reset();
+		}
+	}
+}
+
 void OFS_ProcessingVideoWindow::ResetTranslationAndZoom() noexcept
 {
 	auto& state = ProcessingVideoWindowState::State(stateHandle);
@@ -9,6 +9,9 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+
+class OFS_MotionTracker;
 
 // Window to display downscaled processing frames from dual-pipeline
 // Used for visualizing tracking overlays (grid, motion vectors, bounding boxes)
@@ -28,15 +31,23 @@ private:
 
 	int frameWidth = 640;
 	int frameHeight = 640;
+	float cpuRemapMs = 0.f;
 
 	bool videoHovered = false;
 	bool dragStarted = false;
 
+	std::shared_ptr<OFS_MotionTracker> motionTracker;
+	uint32_t motionTrackerId = 0;
+	bool selectingRoi = false;
+	ImVec2 roiDragStart;
+
 	float baseScaleFactor = 1.f;
 	static constexpr float ZoomMulti = 0.05f;
 
 	void mouseScroll(const OFS_SDL_Event* ev) noexcept;
 	void updateProcessingFrame(const ProcessingFrameReadyEvent* ev) noexcept;
+	void updateTrackerRoi(const ImVec2& imageMin, const ImVec2& imageSize) noexcept;
+	void showMotionTracker() noexcept;
 
 public:
 	static constexpr const char* WindowId = "###PROCESSINGVIDEO";
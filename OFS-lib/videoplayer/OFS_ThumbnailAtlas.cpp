@@ -0,0 +1,317 @@
+#include "OFS_ThumbnailAtlas.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+#include "OFS_GL.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "SDL_timer.h"
+
+#include "subprocess.h"
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+static constexpr uint32_t CacheMagic = 0x4153464F; // "OFSA"
+
+struct ThumbnailCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t thumbWidth;
+    int32_t thumbHeight;
+    int32_t columns;
+    int32_t count;
+    float interval;
+    uint32_t jpegSize;
+};
+
+OFS_ThumbnailAtlas::~OFS_ThumbnailAtlas() noexcept
+{
+    Clear();
+}
+
+std::string OFS_ThumbnailAtlas::CachePath(const std::string& mediaPath) noexcept
+{
+    auto name = Util::MediaFingerprint(mediaPath) + ".jpgatlas";
+    return Util::Prefpath((Util::PathFromString("cache") / "thumbnails" / name).u8string());
+}
+
+void OFS_ThumbnailAtlas::Build(const std::string& newMediaPath, float duration, int videoWidth, int videoHeight) noexcept
+{
+    Clear();
+    if (duration <= 0.f || videoWidth <= 0 || videoHeight <= 0) {
+        status = Status::Failed;
+        return;
+    }
+    mediaPath = newMediaPath;
+    status = Status::Building;
+
+    job = std::make_shared<BuildJob>();
+    job->mediaPath = newMediaPath;
+    job->duration = duration;
+    job->videoWidth = videoWidth;
+    job->videoHeight = videoHeight;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &job->maxTextureSize);
+    OFS_JobDesc desc;
+    desc.Name = "Thumbnails: " + Util::Filename(newMediaPath);
+    desc.Priority = OFS_ThreadPool::Priority::Low;
+    desc.Lane = OFS_JobLane::Process;
+    // the task keeps the job alive, even if the atlas moves on to another file
+    desc.Work = [buildJob = job](OFS_Job& task) noexcept { return build(*buildJob, task); };
+    task = OFS_JobSystem::Submit(std::move(desc));
+}
+
+void OFS_ThumbnailAtlas::releaseTexture() noexcept
+{
+    if (texture) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+}
+
+void OFS_ThumbnailAtlas::Clear() noexcept
+{
+    if (task) {
+        task->Cancel();
+        task.reset();
+    }
+    job.reset();
+    releaseTexture();
+    layout = Layout();
+    mediaPath.clear();
+    status = Status::Empty;
+}
+
+void OFS_ThumbnailAtlas::Update() noexcept
+{
+    if (!task || !task->IsFinished()) return;
+
+    if (job->success) {
+        OFS_PROFILE(__FUNCTION__);
+        releaseTexture();
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, OFS_InternalTexFormat, job->atlasWidth, job->atlasHeight, 0, OFS_TexFormat, GL_UNSIGNED_BYTE, job->rgba.data());
+
+        layout = job->layout;
+        atlasWidth = job->atlasWidth;
+        atlasHeight = job->atlasHeight;
+        status = Status::Ready;
+        LOGF_INFO("Thumbnail atlas ready: %d thumbnails every %.1f seconds%s", layout.count,
+            layout.interval, job->fromCache ? " (cached)" : "");
+    }
+    else {
+        status = Status::Failed;
+    }
+    job.reset();
+    task.reset();
+}
+
+bool OFS_ThumbnailAtlas::Lookup(float timeSeconds, Sprite* outSprite) const noexcept
+{
+    if (!IsReady() || layout.count <= 0) return false;
+    int idx = Util::Clamp((int)std::lround(timeSeconds / layout.interval), 0, layout.count - 1);
+    int col = idx % layout.columns;
+    int row = idx / layout.columns;
+
+    outSprite->texture = texture;
+    outSprite->uv0[0] = (float)(col * layout.thumbWidth) / atlasWidth;
+    outSprite->uv0[1] = (float)(row * layout.thumbHeight) / atlasHeight;
+    outSprite->uv1[0] = (float)((col + 1) * layout.thumbWidth) / atlasWidth;
+    outSprite->uv1[1] = (float)((row + 1) * layout.thumbHeight) / atlasHeight;
+    outSprite->timeSeconds = idx * layout.interval;
+    return true;
+}
+
+bool OFS_ThumbnailAtlas::build(BuildJob& job, OFS_Job& task) noexcept
+{
+    auto cachePath = CachePath(job.mediaPath);
+    if (loadCache(cachePath, job)) {
+        job.success = true;
+        job.fromCache = true;
+    }
+    else {
+        auto startTicks = SDL_GetTicks64();
+        job.success = extract(job, task);
+        if (job.success) {
+            LOGF_INFO("Thumbnails extracted in %.2f seconds", (SDL_GetTicks64() - startTicks) / 1000.f);
+            saveCache(cachePath, job);
+        }
+    }
+
+    return job.success;
+}
+
+bool OFS_ThumbnailAtlas::extract(BuildJob& job, OFS_Job& task) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    auto& layout = job.layout;
+    layout.interval = Util::Max(MinIntervalSeconds, std::ceil(job.duration / MaxThumbnails));
+    layout.thumbWidth = ThumbnailWidth;
+    layout.thumbHeight = Util::Max(2, (int)std::lround(ThumbnailWidth * job.videoHeight / (float)job.videoWidth / 2.f) * 2);
+
+    char filter[64];
+    stbsp_snprintf(filter, sizeof(filter), "fps=1/%d,scale=%d:%d", (int)layout.interval, layout.thumbWidth, layout.thumbHeight);
+    auto ffmpegPath = Util::FfmpegPath().u8string();
+
+    // decoding keyframes only is what makes this fast, the fps filter repeats the last keyframe
+    std::array<const char*, 18> args =
+    {
+        ffmpegPath.c_str(),
+        "-loglevel", "quiet",
+        "-skip_frame", "nokey",
+        "-i", job.mediaPath.c_str(),
+        "-an", "-sn",
+        "-vf", filter,
+        "-f", "rawvideo",
+        "-pix_fmt", "rgba",
+        "-",
+        nullptr
+    };
+
+    struct subprocess_s proc;
+    if (subprocess_create(args.data(), subprocess_option_no_window | subprocess_option_inherit_environment, &proc) != 0) {
+        LOGF_ERROR("Failed to start \"%s\"", ffmpegPath.c_str());
+        return false;
+    }
+
+    const size_t thumbBytes = (size_t)layout.thumbWidth * layout.thumbHeight * 4;
+    std::vector<uint8_t> thumbnails;
+    const int expectedCount = Util::Min(MaxThumbnails, (int)(job.duration / layout.interval) + 1);
+    thumbnails.reserve(thumbBytes * expectedCount);
+
+    FILE* out = subprocess_stdout(&proc);
+    while (out && layout.count < MaxThumbnails) {
+        if (task.IsCancelled()) {
+            subprocess_terminate(&proc);
+            break;
+        }
+        size_t offset = thumbnails.size();
+        thumbnails.resize(offset + thumbBytes);
+        if (fread(thumbnails.data() + offset, 1, thumbBytes, out) != thumbBytes) {
+            thumbnails.resize(offset);
+            break;
+        }
+        layout.count += 1;
+        task.SetProgress(layout.count, expectedCount);
+    }
+    if (layout.count == MaxThumbnails && subprocess_alive(&proc)) {
+        subprocess_terminate(&proc);
+    }
+
+    int returnCode = -1;
+    subprocess_join(&proc, &returnCode);
+    subprocess_destroy(&proc);
+
+    if (task.IsCancelled() || layout.count == 0) {
+        return false;
+    }
+
+    // roughly square atlas, within the texture size limit of the driver
+    const int maxColumns = Util::Max(1, job.maxTextureSize / layout.thumbWidth);
+    const int maxRows = Util::Max(1, job.maxTextureSize / layout.thumbHeight);
+    // keep every stride-th thumbnail if they don't fit, so the whole video stays covered
+    const int stride = (layout.count + maxColumns * maxRows - 1) / (maxColumns * maxRows);
+    const int extractedCount = layout.count;
+    if (stride > 1) {
+        layout.count = (extractedCount + stride - 1) / stride;
+        layout.interval *= stride;
+        LOGF_WARN("Thumbnail atlas exceeds the maximum texture size of %d, keeping one in %d thumbnails", job.maxTextureSize, stride);
+    }
+    layout.columns = Util::Clamp((int)std::ceil(std::sqrt(layout.count * layout.thumbHeight / (float)layout.thumbWidth)), 1, maxColumns);
+    int rows = (layout.count + layout.columns - 1) / layout.columns;
+    if (rows > maxRows) {
+        layout.columns = Util::Min(maxColumns, (layout.count + maxRows - 1) / maxRows);
+        rows = (layout.count + layout.columns - 1) / layout.columns;
+    }
+    job.atlasWidth = layout.columns * layout.thumbWidth;
+    job.atlasHeight = rows * layout.thumbHeight;
+    job.rgba.assign((size_t)job.atlasWidth * job.atlasHeight * 4, 0);
+
+    const size_t thumbPitch = (size_t)layout.thumbWidth * 4;
+    const size_t atlasPitch = (size_t)job.atlasWidth * 4;
+    for (int i = 0; i < layout.count; i += 1) {
+        const uint8_t* src = thumbnails.data() + thumbBytes * Util::Min(i * stride, extractedCount - 1);
+        uint8_t* dst = job.rgba.data() + (size_t)(i / layout.columns) * layout.thumbHeight * atlasPitch
+            + (size_t)(i % layout.columns) * thumbPitch;
+        for (int y = 0; y < layout.thumbHeight; y += 1) {
+            memcpy(dst + y * atlasPitch, src + y * thumbPitch, thumbPitch);
+        }
+    }
+    return true;
+}
+
+bool OFS_ThumbnailAtlas::loadCache(const std::string& cachePath, BuildJob& job) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    std::vector<uint8_t> fileData;
+    if (Util::ReadFile(cachePath.c_str(), fileData) < sizeof(ThumbnailCacheHeader)) {
+        return false;
+    }
+
+    ThumbnailCacheHeader header;
+    memcpy(&header, fileData.data(), sizeof(header));
+    if (header.magic != CacheMagic || header.version != CacheVersion
+        || header.jpegSize > fileData.size() - sizeof(header)
+        || header.count <= 0 || header.columns <= 0) {
+        return false;
+    }
+
+    int width, height, channels;
+    auto pixels = stbi_load_from_memory(fileData.data() + sizeof(header), header.jpegSize, &width, &height, &channels, 4);
+    if (!pixels) return false;
+    // a cache written on another GPU may exceed the texture size limit of this one
+    if (width != header.columns * header.thumbWidth || height < header.thumbHeight
+        || width > job.maxTextureSize || height > job.maxTextureSize) {
+        stbi_image_free(pixels);
+        return false;
+    }
+
+    job.layout.thumbWidth = header.thumbWidth;
+    job.layout.thumbHeight = header.thumbHeight;
+    job.layout.columns = header.columns;
+    job.layout.count = header.count;
+    job.layout.interval = header.interval;
+    job.atlasWidth = width;
+    job.atlasHeight = height;
+    job.rgba.assign(pixels, pixels + (size_t)width * height * 4);
+    stbi_image_free(pixels);
+    return true;
+}
+
+bool OFS_ThumbnailAtlas::saveCache(const std::string& cachePath, const BuildJob& job) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    if (!Util::CreateDirectories(Util::PathFromString(cachePath).parent_path())) {
+        return false;
+    }
+
+    std::vector<uint8_t> fileData;
+    fileData.resize(sizeof(ThumbnailCacheHeader));
+    auto writeFunc = [](void* context, void* data, int size) noexcept {
+        auto& buffer = *(std::vector<uint8_t>*)context;
+        buffer.insert(buffer.end(), (uint8_t*)data, (uint8_t*)data + size);
+    };
+    stbi_flip_vertically_on_write(false);
+    if (!stbi_write_jpg_to_func(writeFunc, &fileData, job.atlasWidth, job.atlasHeight, 4, job.rgba.data(), JpegQuality)) {
+        return false;
+    }
+
+    ThumbnailCacheHeader header;
+    header.magic = CacheMagic;
+    header.version = CacheVersion;
+    header.thumbWidth = job.layout.thumbWidth;
+    header.thumbHeight = job.layout.thumbHeight;
+    header.columns = job.layout.columns;
+    header.count = job.layout.count;
+    header.interval = job.layout.interval;
+    header.jpegSize = (uint32_t)(fileData.size() - sizeof(header));
+    memcpy(fileData.data(), &header, sizeof(header));
+    return Util::WriteFile(cachePath.c_str(), fileData.data(), fileData.size()) == fileData.size();
+}
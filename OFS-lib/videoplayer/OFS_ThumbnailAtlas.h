@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "OFS_JobSystem.h"
+
+// Low resolution thumbnails at a fixed interval, packed into one sprite atlas texture.
+// Extracted in the background with ffmpeg (keyframes only) and cached on disk as a jpeg
+// keyed by the media fingerprint. Previews are a texture lookup afterwards.
+class OFS_ThumbnailAtlas
+{
+public:
+    static constexpr uint32_t CacheVersion = 1;
+    static constexpr int ThumbnailWidth = 160;
+    static constexpr int MaxThumbnails = 400;
+    static constexpr float MinIntervalSeconds = 2.f;
+    static constexpr int JpegQuality = 85;
+
+    enum class Status : int32_t
+    {
+        Empty,
+        Building,
+        Ready,
+        Failed
+    };
+
+    struct Sprite
+    {
+        uint32_t texture = 0;
+        float uv0[2] = {0.f, 0.f};
+        float uv1[2] = {0.f, 0.f};
+        float timeSeconds = 0.f;
+    };
+
+private:
+    struct Layout
+    {
+        int thumbWidth = 0;
+        int thumbHeight = 0;
+        int columns = 0;
+        int count = 0;
+        float interval = 0.f;
+    };
+
+    struct BuildJob
+    {
+        std::string mediaPath;
+        float duration = 0.f;
+        int videoWidth = 0;
+        int videoHeight = 0;
+        int maxTextureSize = 0; // GL_MAX_TEXTURE_SIZE, queried on the main thread
+
+        Layout layout;
+        std::vector<uint8_t> rgba; // atlas pixels
+        int atlasWidth = 0;
+        int atlasHeight = 0;
+
+        bool success = false;
+        bool fromCache = false;
+    };
+
+    std::shared_ptr<BuildJob> job;
+    OFS_JobHandle task;
+    std::string mediaPath;
+    Layout layout;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    uint32_t texture = 0;
+    Status status = Status::Empty;
+
+    static bool build(BuildJob& job, OFS_Job& task) noexcept;
+    static bool extract(BuildJob& job, OFS_Job& task) noexcept;
+    static bool loadCache(const std::string& cachePath, BuildJob& job) noexcept;
+    static bool saveCache(const std::string& cachePath, const BuildJob& job) noexcept;
+
+    void releaseTexture() noexcept;
+
+public:
+    OFS_ThumbnailAtlas() noexcept {}
+    ~OFS_ThumbnailAtlas() noexcept;
+
+    static std::string CachePath(const std::string& mediaPath) noexcept;
+
+    // Starts extracting thumbnails in the background, cancels a running build.
+    void Build(const std::string& mediaPath, float duration, int videoWidth, int videoHeight) noexcept;
+    void Clear() noexcept;
+    // Main thread, uploads a finished atlas.
+    void Update() noexcept;
+
+    inline Status GetStatus() const noexcept { return status; }
+    inline bool IsReady() const noexcept { return status == Status::Ready; }
+    inline const std::string& MediaPath() const noexcept { return mediaPath; }
+    inline float Interval() const noexcept { return layout.interval; }
+    inline float AspectRatio() const noexcept { return layout.thumbHeight > 0 ? (float)layout.thumbWidth / layout.thumbHeight : 16.f / 9.f; }
+
+    // Thumbnail closest to time, false if the atlas isn't ready.
+    bool Lookup(float timeSeconds, Sprite* outSprite) const noexcept;
+};
@@ -0,0 +1,315 @@
+#include "OFS_VRRemap.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "SDL_timer.h"
+#include "SDL_cpuinfo.h"
+
+#if OFS_VRREMAP_SSE2
+#include "emmintrin.h"
+#endif
+
+static constexpr float PI = 3.1415926535f;
+static constexpr float DEG2RAD = 0.01745329251994329576923690768489f;
+// VrShader hfovDegrees
+static constexpr float HFovRad = 75.f * DEG2RAD;
+// Max amount of row bands a frame gets split into
+static constexpr int MaxBands = 8;
+
+bool OFS_VRRemapConfig::operator==(const OFS_VRRemapConfig& o) const noexcept
+{
+	return format.isVR == o.format.isVR
+		&& format.projection == o.format.projection
+		&& format.layout == o.format.layout
+		&& pitch == o.pitch
+		&& yaw == o.yaw
+		&& zoom == o.zoom
+		&& rightEye == o.rightEye
+		&& unwarp == o.unwarp
+		&& srcWidth == o.srcWidth
+		&& srcHeight == o.srcHeight
+		&& dstWidth == o.dstWidth
+		&& dstHeight == o.dstHeight;
+}
+
+OFS_VRRemap::OFS_VRRemap() noexcept
+{
+	bandsDone = SDL_CreateSemaphore(0);
+	int bands = Util::Clamp(SDL_GetCPUCount(), 1, MaxBands);
+	// the calling thread handles the last band
+	workers.resize(bands - 1);
+	for (int i = 0; i < (int)workers.size(); i += 1) {
+		auto& worker = workers[i];
+		worker.remap = this;
+		worker.band = i;
+		worker.start = SDL_CreateSemaphore(0);
+		worker.thread = SDL_CreateThread(workerThread, "VRRemapWorker", &worker);
+	}
+}
+
+OFS_VRRemap::~OFS_VRRemap() noexcept
+{
+	SDL_AtomicSet(&shutdown, 1);
+	for (auto& worker : workers) {
+		SDL_SemPost(worker.start);
+		SDL_WaitThread(worker.thread, nullptr);
+		SDL_DestroySemaphore(worker.start);
+	}
+	SDL_DestroySemaphore(bandsDone);
+}
+
+int OFS_VRRemap::workerThread(void* data) noexcept
+{
+	auto& worker = *(Worker*)data;
+	auto remap = worker.remap;
+	for (;;) {
+		SDL_SemWait(worker.start);
+		if (SDL_AtomicGet(&remap->shutdown)) break;
+		remap->remapBand(worker.band);
+		SDL_SemPost(remap->bandsDone);
+	}
+	return 0;
+}
+
+inline static void rotateXY(float p[3], float angleX, float angleY) noexcept
+{
+	// VrShader rotateXY
+	float cx = std::cos(angleX), sx = std::sin(angleX);
+	float cy = std::cos(angleY), sy = std::sin(angleY);
+	float x = p[0];
+	float y = cx * p[1] + sx * p[2];
+	float z = -sx * p[1] + cx * p[2];
+	p[0] = cy * x + sy * z;
+	p[1] = y;
+	p[2] = -sy * x + cy * z;
+}
+
+inline static void normalize(float p[3]) noexcept
+{
+	float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+	if (len > 0.f) {
+		p[0] /= len; p[1] /= len; p[2] /= len;
+	}
+}
+
+void OFS_VRRemap::MapUV(const OFS_VRRemapConfig& config, float u, float v, float* outU, float* outV) noexcept
+{
+	const auto& format = config.format;
+	const float eyeOffset = config.rightEye ? 0.5f : 0.f;
+
+	if (!format.isVR || format.layout == VRLayout::None && format.projection == VRProjection::None) {
+		*outU = u;
+		*outV = v;
+		return;
+	}
+
+	if (!config.unwarp || format.projection == VRProjection::None) {
+		// VRCropShader
+		if (format.layout == VRLayout::SideBySide) {
+			u = eyeOffset + u * 0.5f;
+		}
+		else if (format.layout == VRLayout::TopBottom) {
+			v = eyeOffset + v * 0.5f;
+		}
+		*outU = u;
+		*outV = v;
+		return;
+	}
+
+	const float aspect = (float)config.dstWidth / (float)config.dstHeight;
+	const float tanHalfH = std::tan(0.5f * HFovRad);
+	const float pitchRad = config.pitch * DEG2RAD;
+	const float yawRad = config.yaw * DEG2RAD;
+
+	if (format.projection == VRProjection::Fisheye190 || format.projection == VRProjection::Fisheye200) {
+		// fisheye_unwarp.frag, output fov derived from zoom so it matches the VrShader framing
+		const float fovRad = (format.projection == VRProjection::Fisheye190 ? 190.f : 200.f) * DEG2RAD;
+		const float focal = config.zoom / (0.5f * tanHalfH);
+		float ray[3] = { (u * 2.f - 1.f) * aspect, v * 2.f - 1.f, focal };
+		normalize(ray);
+		// rotationY(yaw) * rotationX(pitch), the shader matrices are column major
+		float cp = std::cos(pitchRad), sp = std::sin(pitchRad);
+		float y = cp * ray[1] + sp * ray[2];
+		float z = -sp * ray[1] + cp * ray[2];
+		float cyaw = std::cos(yawRad), syaw = std::sin(yawRad);
+		float x = cyaw * ray[0] - syaw * z;
+		z = syaw * ray[0] + cyaw * z;
+
+		float pxz = std::sqrt(x * x + y * y);
+		float r = 2.f * std::atan2(pxz, z) / fovRad;
+		float theta = std::atan2(y, x);
+		u = (r * std::cos(theta) + 1.f) * 0.5f;
+		v = (r * std::sin(theta) + 1.f) * 0.5f;
+		if (format.layout == VRLayout::TopBottom) {
+			v = v * 0.5f + eyeOffset;
+		}
+		else {
+			u = u * 0.5f + eyeOffset;
+		}
+		*outU = Util::Clamp(u, 0.f, 1.f);
+		*outV = Util::Clamp(v, 0.f, 1.f);
+		return;
+	}
+
+	// VrShader (equirectangular)
+	const float vfovRad = -2.f * std::atan(tanHalfH / aspect);
+	float camDir[3] = {
+		(u - 0.5f) * tanHalfH,
+		(v - 0.5f) * std::tan(0.5f * vfovRad),
+		config.zoom
+	};
+	normalize(camDir);
+	rotateXY(camDir, pitchRad, yawRad);
+	normalize(camDir);
+
+	u = (std::atan2(camDir[2], camDir[0]) + PI) / (2.f * PI);
+	v = std::acos(Util::Clamp(-camDir[1], -1.f, 1.f)) / PI;
+
+	if (format.layout == VRLayout::TopBottom) {
+		// VrShader maps to the top half for video_aspect_ratio <= 1
+		v = v * 0.5f + eyeOffset;
+	}
+	else if (format.layout == VRLayout::SideBySide) {
+		// each eye covers one half, fold the longitude into the selected eye
+		float eyeU = u * 2.f;
+		eyeU -= std::floor(eyeU);
+		u = eyeU * 0.5f + eyeOffset;
+	}
+	*outU = u;
+	*outV = v;
+}
+
+void OFS_VRRemap::Configure(const OFS_VRRemapConfig& newConfig) noexcept
+{
+	if (lutValid && newConfig == config) return;
+	config = newConfig;
+	buildLut();
+}
+
+void OFS_VRRemap::buildLut() noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	lutValid = false;
+	if (config.srcWidth < 2 || config.srcHeight < 2 || config.dstWidth <= 0 || config.dstHeight <= 0) {
+		lut.clear();
+		return;
+	}
+	FUN_ASSERT(config.srcWidth <= UINT16_MAX && config.srcHeight <= UINT16_MAX, "source too large");
+
+	lut.resize((size_t)config.dstWidth * config.dstHeight);
+	const float maxX = (float)(config.srcWidth - 1);
+	const float maxY = (float)(config.srcHeight - 1);
+
+	for (int y = 0; y < config.dstHeight; y += 1) {
+		float v = (y + 0.5f) / (float)config.dstHeight;
+		auto row = lut.data() + (size_t)y * config.dstWidth;
+		for (int x = 0; x < config.dstWidth; x += 1) {
+			float u = (x + 0.5f) / (float)config.dstWidth;
+			float su, sv;
+			MapUV(config, u, v, &su, &sv);
+
+			// texel centers like GL_LINEAR with GL_CLAMP_TO_EDGE
+			float fx = Util::Clamp(su * config.srcWidth - 0.5f, 0.f, maxX);
+			float fy = Util::Clamp(sv * config.srcHeight - 0.5f, 0.f, maxY);
+			int x0 = Util::Min((int)fx, config.srcWidth - 2);
+			int y0 = Util::Min((int)fy, config.srcHeight - 2);
+
+			auto& entry = row[x];
+			entry.x0 = (uint16_t)x0;
+			entry.y0 = (uint16_t)y0;
+			entry.wx = (uint16_t)std::lround((fx - x0) * WeightOne);
+			entry.wy = (uint16_t)std::lround((fy - y0) * WeightOne);
+		}
+	}
+	lutValid = true;
+}
+
+#if OFS_VRREMAP_SSE2
+inline static uint32_t bilinearSSE2(const uint8_t* top, const uint8_t* bottom, uint16_t wx, uint16_t wy) noexcept
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(OFS_VRRemap::WeightOne / 2);
+	// [p00 p01] and [p10 p11] as 16 bit channels
+	__m128i t = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)top), zero);
+	__m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)bottom), zero);
+
+	const int16_t ix = (int16_t)(OFS_VRRemap::WeightOne - wx);
+	const __m128i wxv = _mm_set_epi16(wx, wx, wx, wx, ix, ix, ix, ix);
+	t = _mm_mullo_epi16(t, wxv);
+	b = _mm_mullo_epi16(b, wxv);
+	// horizontal: low half + high half
+	t = _mm_add_epi16(t, _mm_srli_si128(t, 8));
+	b = _mm_add_epi16(b, _mm_srli_si128(b, 8));
+	t = _mm_srli_epi16(_mm_add_epi16(t, round), OFS_VRRemap::WeightBits);
+	b = _mm_srli_epi16(_mm_add_epi16(b, round), OFS_VRRemap::WeightBits);
+
+	// vertical: [top bottom] * [1-wy wy]
+	const int16_t iy = (int16_t)(OFS_VRRemap::WeightOne - wy);
+	const __m128i wyv = _mm_set_epi16(wy, wy, wy, wy, iy, iy, iy, iy);
+	__m128i tb = _mm_mullo_epi16(_mm_unpacklo_epi64(t, b), wyv);
+	tb = _mm_add_epi16(tb, _mm_srli_si128(tb, 8));
+	tb = _mm_srli_epi16(_mm_add_epi16(tb, round), OFS_VRRemap::WeightBits);
+	return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(tb, zero));
+}
+#endif
+
+inline static uint32_t bilinearScalar(const uint8_t* top, const uint8_t* bottom, uint16_t wx, uint16_t wy) noexcept
+{
+	constexpr uint32_t one = OFS_VRRemap::WeightOne;
+	constexpr uint32_t round = one / 2;
+	uint32_t result = 0;
+	for (int c = 0; c < 4; c += 1) {
+		uint32_t t = (top[c] * (one - wx) + top[c + 4] * wx + round) >> OFS_VRRemap::WeightBits;
+		uint32_t b = (bottom[c] * (one - wx) + bottom[c + 4] * wx + round) >> OFS_VRRemap::WeightBits;
+		uint32_t value = (t * (one - wy) + b * wy + round) >> OFS_VRRemap::WeightBits;
+		result |= value << (c * 8);
+	}
+	return result;
+}
+
+void OFS_VRRemap::remapBand(int band) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	const int bands = ThreadCount();
+	const int rowsPerBand = (config.dstHeight + bands - 1) / bands;
+	const int rowStart = band * rowsPerBand;
+	const int rowEnd = Util::Min(rowStart + rowsPerBand, config.dstHeight);
+
+	for (int y = rowStart; y < rowEnd; y += 1) {
+		auto lutRow = lut.data() + (size_t)y * config.dstWidth;
+		auto dstRow = (uint32_t*)(jobDst + (size_t)y * jobDstPitch);
+		for (int x = 0; x < config.dstWidth; x += 1) {
+			const auto& e = lutRow[x];
+			const uint8_t* top = jobSrc + (size_t)e.y0 * jobSrcPitch + (size_t)e.x0 * 4;
+			const uint8_t* bottom = top + jobSrcPitch;
+#if OFS_VRREMAP_SSE2
+			dstRow[x] = bilinearSSE2(top, bottom, e.wx, e.wy);
+#else
+			dstRow[x] = bilinearScalar(top, bottom, e.wx, e.wy);
+#endif
+		}
+	}
+}
+
+void OFS_VRRemap::Remap(const uint8_t* src, int srcPitch, uint8_t* dst, int dstPitch) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	if (!lutValid || !src || !dst) return;
+	uint64_t startTime = SDL_GetPerformanceCounter();
+
+	jobSrc = src;
+	jobDst = dst;
+	jobSrcPitch = srcPitch;
+	jobDstPitch = dstPitch;
+
+	// semaphores act as the memory barrier for the job parameters
+	for (auto& worker : workers) SDL_SemPost(worker.start);
+	remapBand((int)workers.size());
+	for (size_t i = 0; i < workers.size(); i += 1) SDL_SemWait(bandsDone);
+
+	float ms = (float)((SDL_GetPerformanceCounter() - startTime) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+	averageMs = averageMs == 0.f ? ms : averageMs + (ms - averageMs) * 0.05f;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "OFS_VRFormatDetector.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "SDL_thread.h"
+#include "SDL_mutex.h"
+#include "SDL_atomic.h"
+
+// Which kernels the build was compiled with
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OFS_VRREMAP_SSE2 1
+#else
+    #define OFS_VRREMAP_SSE2 0
+#endif
+
+struct OFS_VRRemapConfig
+{
+    VRFormatInfo format;
+    float pitch = 0.f; // degrees
+    float yaw = 0.f;   // degrees
+    float zoom = 0.2f; // same meaning as VrShader zoom (lower = more zoom)
+    bool rightEye = false;
+    // false only crops the selected eye (like VRCropShader)
+    // true additionally unwarps the projection (like VrShader / fisheye_unwarp.frag)
+    bool unwarp = true;
+
+    int srcWidth = 0;
+    int srcHeight = 0;
+    int dstWidth = 0;
+    int dstHeight = 0;
+
+    bool operator==(const OFS_VRRemapConfig& o) const noexcept;
+    bool operator!=(const OFS_VRRemapConfig& o) const noexcept { return !(*this == o); }
+};
+
+// CPU implementation of the VR crop/unwarp done by the processing pipeline shaders.
+// A lookup table with source coordinates + bilinear weights is built once per configuration,
+// Remap then only does the bilinear gather, split into row bands across worker threads.
+class OFS_VRRemap
+{
+public:
+    // Fixed point precision of the bilinear weights
+    static constexpr int WeightBits = 8;
+    static constexpr int WeightOne = 1 << WeightBits;
+
+    OFS_VRRemap() noexcept;
+    ~OFS_VRRemap() noexcept;
+    OFS_VRRemap(const OFS_VRRemap&) = delete;
+    OFS_VRRemap(OFS_VRRemap&&) = delete;
+
+    // Only rebuilds the lookup table if the configuration changed.
+    void Configure(const OFS_VRRemapConfig& config) noexcept;
+    inline const OFS_VRRemapConfig& Config() const noexcept { return config; }
+
+    // src & dst are RGBA8, pitches are in bytes.
+    void Remap(const uint8_t* src, int srcPitch, uint8_t* dst, int dstPitch) noexcept;
+
+    // Maps a destination uv (0..1) to a source uv (0..1) like the shaders do.
+    static void MapUV(const OFS_VRRemapConfig& config, float u, float v, float* outU, float* outV) noexcept;
+
+    inline float AverageMs() const noexcept { return averageMs; }
+    inline float Fps() const noexcept { return averageMs > 0.f ? 1000.f / averageMs : 0.f; }
+    inline int ThreadCount() const noexcept { return (int)workers.size() + 1; }
+    static constexpr bool SimdEnabled() noexcept { return OFS_VRREMAP_SSE2 == 1; }
+
+private:
+    struct LutEntry
+    {
+        uint16_t x0;
+        uint16_t y0;
+        uint16_t wx; // weight of x0+1 in [0, WeightOne]
+        uint16_t wy; // weight of y0+1 in [0, WeightOne]
+    };
+    static_assert(sizeof(LutEntry) == 8);
+
+    struct Worker
+    {
+        OFS_VRRemap* remap = nullptr;
+        SDL_Thread* thread = nullptr;
+        SDL_sem* start = nullptr;
+        int band = 0;
+    };
+
+    OFS_VRRemapConfig config;
+    std::vector<LutEntry> lut;
+    bool lutValid = false;
+
+    // Per call parameters read by the workers
+    const uint8_t* jobSrc = nullptr;
+    uint8_t* jobDst = nullptr;
+    int jobSrcPitch = 0;
+    int jobDstPitch = 0;
+
+    std::vector<Worker> workers;
+    SDL_sem* bandsDone = nullptr;
+    SDL_atomic_t shutdown = {0};
+
+    float averageMs = 0.f;
+
+    void buildLut() noexcept;
+    void remapBand(int band) noexcept;
+    static int workerThread(void* data) noexcept;
+};
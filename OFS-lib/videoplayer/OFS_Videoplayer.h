@@ -5,6 +5,8 @@
 
 #include "OFS_VideoplayerEvents.h"
 
+class OFS_FrameIndex;
+
 class OFS_Videoplayer
 {
     private:
@@ -76,6 +78,8 @@ class OFS_Videoplayer
     double CurrentPlayerTime() const noexcept { return CurrentPlayerPosition() * Duration(); }
 
     const char* VideoPath() const noexcept;
+    // Exact frame times, only built for the main player
+    const OFS_FrameIndex& FrameIndex() const noexcept;
     inline uint32_t FrameTexture() const noexcept { return frameTexture; }
 
     // Enable/disable AI tracking processing (YOLO, optical flow, etc.)
@@ -38,6 +38,9 @@ class TimeChangeEvent : public OFS_Event<TimeChangeEvent>
 	VideoplayerType playerType;
 	TimeChangeEvent(float time, VideoplayerType type) noexcept
 		: playerType(type), time(time) {} 
+
+	static constexpr bool Coalescing = true;
+	inline uint64_t CoalescingKey() const noexcept { return (uint64_t)playerType; }
 };
 
 class DurationChangeEvent : public OFS_Event<DurationChangeEvent>
@@ -57,6 +60,9 @@ class PlaybackSpeedChangeEvent : public OFS_Event<PlaybackSpeedChangeEvent>
 	PlaybackSpeedChangeEvent(float speed, VideoplayerType type) noexcept
 		: playerType(type), playbackSpeed(speed) {}
 
+	static constexpr bool Coalescing = true;
+	inline uint64_t CoalescingKey() const noexcept { return (uint64_t)playerType; }
+
 };
 
 // Event emitted with downscaled frames for AI tracking (YOLO, optical flow, etc.)
@@ -71,9 +77,10 @@ class ProcessingFrameReadyEvent : public OFS_Event<ProcessingFrameReadyEvent>
 	VideoplayerType playerType;
 	int originalWidth;          // Original video width (for coordinate transformation)
 	int originalHeight;         // Original video height
+	float remapMs;              // Average CPU crop/unwarp time, 0 when done on the GPU
 
 	ProcessingFrameReadyEvent(const uint8_t* data, int w, int h, double time,
-	                          VideoplayerType type, int origW, int origH) noexcept
+	                          VideoplayerType type, int origW, int origH, float remapMs = 0.f) noexcept
 		: frameData(data), width(w), height(h), timeSeconds(time),
-		  playerType(type), originalWidth(origW), originalHeight(origH) {}
+		  playerType(type), originalWidth(origW), originalHeight(origH), remapMs(remapMs) {}
 };
\ No newline at end of file
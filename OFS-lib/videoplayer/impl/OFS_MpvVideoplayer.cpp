@@ -1,7 +1,9 @@
 #include "OFS_Videoplayer.h"
 #include "OFS_Util.h"
+#include "OFS_Profiling.h"
 
 #include "OFS_EventSystem.h"
+#include "OFS_Redraw.h"
 #include "OFS_VideoplayerEvents.h"
 
 #define OFS_MPV_LOADER_MACROS
@@ -11,14 +13,19 @@
 #include "OFS_GL.h"
 #include "OFS_Shader.h"
 #include "videoplayer/OFS_VRFormatDetector.h"
+#include "videoplayer/OFS_VRRemap.h"
+#include "videoplayer/OFS_FrameIndex.h"
 #include "state/states/ProcessingVideoWindowState.h"
 #include "state/OFS_StateManager.h"
 
 #include <sstream>
+#include <array>
 
 #include "SDL_timer.h"
 #include "SDL_atomic.h"
 
+#include "subprocess.h"
+
 enum MpvPropertyGet : uint64_t {
     MpvDuration,
     MpvPosition,
@@ -53,6 +60,46 @@ struct MpvDataCache {
     std::string filePath = "";
 };
 
+// LRU of downscaled frames around the paused playhead. Holds the frames reached by stepping and
+// the PrefillFrames before the paused frame, decoded by ffmpeg from the previous keyframe in the
+// background. Stepping back onto one of these shows it immediately while mpv is still decoding
+// from the previous keyframe. Not a seek cache, frames shown during playback aren't kept.
+struct SteppedFrameCache
+{
+    static constexpr int Size = 8;
+    static constexpr int MaxWidth = 1920;
+    // leaves room for the paused frame and the one stepped to
+    static constexpr int PrefillFrames = Size - 2;
+
+    struct Entry
+    {
+        int64_t frameIdx = -1;
+        uint64_t lastUse = 0;
+        uint32_t framebuffer = 0;
+        uint32_t texture = 0;
+    };
+    std::array<Entry, Size> entries;
+    int width = 0;
+    int height = 0;
+    uint64_t useCounter = 0;
+
+    struct Prefill
+    {
+        std::string mediaPath;
+        double seekTime = 0.0;
+        int64_t firstFrame = 0;
+        int count = 0;
+        int width = 0;
+        int height = 0;
+        int decoded = 0;
+        std::vector<uint8_t> rgba;
+    };
+    std::shared_ptr<Prefill> prefill;
+    OFS_JobHandle prefillTask;
+    // paused frame the last prefill was started for, not retried if decoding failed
+    int64_t prefilledFrame = -1;
+};
+
 struct MpvPlayerContext
 {
     mpv_handle* mpv = nullptr;
@@ -97,8 +144,19 @@ struct MpvPlayerContext
     VRCropShader* cropShader = nullptr;
     VrShader* vrShader = nullptr;  // Use the proven VR shader from main window
 
+    // CPU crop/unwarp path, alternative to the shaders
+    OFS_VRRemap* cpuRemap = nullptr;
+
+    // ProcessingFrameReadyEvent is dispatched after the PBO got unmapped, so frames are copied out.
+    // Double-buffered so listeners can still read the previous frame.
+    std::vector<uint8_t> processingFrames[2];
+    int processingFrameIndex = 0;
+
     // State handle for VR settings
     uint32_t vrStateHandle = 0;
+
+    OFS_FrameIndex frameIndex;
+    SteppedFrameCache frameCache;
 };
 
 #define CTX static_cast<MpvPlayerContext*>(ctx)
@@ -106,11 +164,13 @@ struct MpvPlayerContext
 static void OnMpvEvents(void* ctx) noexcept
 {
     SDL_AtomicIncRef(&CTX->hasEvents);
+    OFS_Redraw::Request(1);
 }
 
 static void OnMpvRenderUpdate(void* ctx) noexcept
 {
     SDL_AtomicIncRef(&CTX->renderUpdate);
+    OFS_Redraw::Request(1);
 }
 
 inline static void notifyVideoLoaded(MpvPlayerContext* ctx) noexcept
@@ -138,8 +198,211 @@ inline static void notifyPlaybackSpeed(MpvPlayerContext* ctx) noexcept
     EV::Enqueue<PlaybackSpeedChangeEvent>((float)CTX->data.currentSpeed, CTX->playerType);
 }
 
+inline static void releaseFrameCache(MpvPlayerContext* ctx) noexcept
+{
+	if (ctx->frameCache.prefillTask) {
+		ctx->frameCache.prefillTask->Cancel();
+		ctx->frameCache.prefillTask.reset();
+	}
+	ctx->frameCache.prefill.reset();
+	ctx->frameCache.prefilledFrame = -1;
+	for (auto& entry : ctx->frameCache.entries) {
+		if (entry.framebuffer) glDeleteFramebuffers(1, &entry.framebuffer);
+		if (entry.texture) glDeleteTextures(1, &entry.texture);
+		entry = SteppedFrameCache::Entry();
+	}
+	ctx->frameCache.width = 0;
+	ctx->frameCache.height = 0;
+}
+
+inline static void allocateFrameCache(MpvPlayerContext* ctx) noexcept
+{
+	auto& cache = ctx->frameCache;
+	if (cache.width == 0) {
+		// lazily allocated the first time frames are stepped
+		float scale = Util::Min(1.f, (float)SteppedFrameCache::MaxWidth / ctx->data.videoWidth);
+		cache.width = Util::Max(1, (int)(ctx->data.videoWidth * scale));
+		cache.height = Util::Max(1, (int)(ctx->data.videoHeight * scale));
+		for (auto& entry : cache.entries) {
+			glGenFramebuffers(1, &entry.framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, entry.framebuffer);
+			glGenTextures(1, &entry.texture);
+			glBindTexture(GL_TEXTURE_2D, entry.texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, OFS_InternalTexFormat, cache.width, cache.height, 0, OFS_TexFormat, GL_UNSIGNED_BYTE, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, entry.texture, 0);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+}
+
+inline static SteppedFrameCache::Entry* cacheEntryFor(SteppedFrameCache& cache, int64_t frameIdx) noexcept
+{
+	// reuse an entry of the same frame or the least recently used one
+	auto* target = &cache.entries[0];
+	for (auto& entry : cache.entries) {
+		if (entry.frameIdx == frameIdx) {
+			target = &entry;
+			break;
+		}
+		if (entry.lastUse < target->lastUse) target = &entry;
+	}
+	target->frameIdx = frameIdx;
+	target->lastUse = ++cache.useCounter;
+	return target;
+}
+
+inline static bool isFrameCached(const SteppedFrameCache& cache, int64_t frameIdx) noexcept
+{
+	for (auto& entry : cache.entries) {
+		if (entry.frameIdx == frameIdx) return true;
+	}
+	return false;
+}
+
+inline static void storeCachedFrame(MpvPlayerContext* ctx, int64_t frameIdx) noexcept
+{
+	auto& cache = ctx->frameCache;
+	allocateFrameCache(ctx);
+	auto target = cacheEntryFor(cache, frameIdx);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx->framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target->framebuffer);
+	glBlitFramebuffer(0, 0, ctx->data.videoWidth, ctx->data.videoHeight,
+		0, 0, cache.width, cache.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static bool decodePrefill(SteppedFrameCache::Prefill& prefill, OFS_Job& task) noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	char seekTime[32];
+	stbsp_snprintf(seekTime, sizeof(seekTime), "%.6f", prefill.seekTime);
+	char filter[48];
+	stbsp_snprintf(filter, sizeof(filter), "scale=%d:%d", prefill.width, prefill.height);
+	char frameCount[16];
+	stbsp_snprintf(frameCount, sizeof(frameCount), "%d", prefill.count);
+	auto ffmpegPath = Util::FfmpegPath().u8string();
+
+	// -ss before -i seeks to the keyframe before seekTime and drops the decoded frames up to it
+	std::array<const char*, 21> args =
+	{
+		ffmpegPath.c_str(),
+		"-loglevel", "quiet",
+		"-ss", seekTime,
+		"-i", prefill.mediaPath.c_str(),
+		"-an", "-sn",
+		"-vf", filter,
+		"-vsync", "passthrough",
+		"-frames:v", frameCount,
+		"-f", "rawvideo",
+		"-pix_fmt", "rgba",
+		"-",
+		nullptr
+	};
+
+	struct subprocess_s proc;
+	if (subprocess_create(args.data(), subprocess_option_no_window | subprocess_option_inherit_environment, &proc) != 0) {
+		LOGF_ERROR("Failed to start \"%s\"", ffmpegPath.c_str());
+		return false;
+	}
+
+	const size_t frameBytes = (size_t)prefill.width * prefill.height * 4;
+	prefill.rgba.resize(frameBytes * prefill.count);
+	FILE* out = subprocess_stdout(&proc);
+	while (out && prefill.decoded < prefill.count) {
+		if (task.IsCancelled()) {
+			subprocess_terminate(&proc);
+			break;
+		}
+		if (fread(prefill.rgba.data() + frameBytes * prefill.decoded, 1, frameBytes, out) != frameBytes) {
+			break;
+		}
+		prefill.decoded += 1;
+	}
+
+	int returnCode = -1;
+	subprocess_join(&proc, &returnCode);
+	subprocess_destroy(&proc);
+	return !task.IsCancelled() && prefill.decoded > 0;
+}
+
+// Decodes the frames before the paused frame, unless the one right before it is cached already.
+inline static void requestPrefill(MpvPlayerContext* ctx, int64_t pausedFrame) noexcept
+{
+	auto& cache = ctx->frameCache;
+	if (cache.prefillTask || pausedFrame <= 0 || pausedFrame == cache.prefilledFrame
+		|| isFrameCached(cache, pausedFrame - 1)) {
+		return;
+	}
+	cache.prefilledFrame = pausedFrame;
+
+	auto& index = ctx->frameIndex;
+	auto prefill = std::make_shared<SteppedFrameCache::Prefill>();
+	prefill->mediaPath = ctx->data.filePath;
+	prefill->firstFrame = Util::Max<int64_t>(0, pausedFrame - SteppedFrameCache::PrefillFrames);
+	prefill->count = (int)(pausedFrame - prefill->firstFrame);
+	prefill->width = cache.width;
+	prefill->height = cache.height;
+	// between two frames, the accurate seek keeps the first frame and drops the one before it
+	prefill->seekTime = prefill->firstFrame > 0
+		? (index.FrameTime(prefill->firstFrame - 1) + index.FrameTime(prefill->firstFrame)) / 2.0
+		: 0.0;
+
+	cache.prefill = prefill;
+	OFS_JobDesc desc;
+	desc.Name = "Frame prefill";
+	desc.Priority = OFS_ThreadPool::Priority::High;
+	desc.Lane = OFS_JobLane::Process;
+	desc.Work = [prefill](OFS_Job& task) noexcept { return decodePrefill(*prefill, task); };
+	cache.prefillTask = OFS_JobSystem::Submit(std::move(desc));
+}
+
+// Main thread, uploads the frames of a finished prefill.
+inline static void updatePrefill(MpvPlayerContext* ctx) noexcept
+{
+	auto& cache = ctx->frameCache;
+	if (!cache.prefillTask || !cache.prefillTask->IsFinished()) return;
+
+	auto& prefill = *cache.prefill;
+	// the cache is released and allocated again if the video changed in between
+	if (prefill.mediaPath == ctx->data.filePath && prefill.width == cache.width && prefill.height == cache.height) {
+		OFS_PROFILE(__FUNCTION__);
+		const size_t frameBytes = (size_t)prefill.width * prefill.height * 4;
+		// farthest first, so the frames closest to the playhead are evicted last
+		for (int i = 0; i < prefill.decoded; i += 1) {
+			auto entry = cacheEntryFor(cache, prefill.firstFrame + i);
+			glBindTexture(GL_TEXTURE_2D, entry->texture);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, prefill.width, prefill.height, OFS_TexFormat, GL_UNSIGNED_BYTE,
+				prefill.rgba.data() + frameBytes * i);
+		}
+	}
+	cache.prefill.reset();
+	cache.prefillTask.reset();
+}
+
+inline static bool showCachedFrame(MpvPlayerContext* ctx, int64_t frameIdx) noexcept
+{
+	auto& cache = ctx->frameCache;
+	for (auto& entry : cache.entries) {
+		if (entry.frameIdx != frameIdx || !entry.framebuffer) continue;
+		entry.lastUse = ++cache.useCounter;
+		// the real frame replaces this once mpv finished seeking
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, entry.framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, ctx->framebuffer);
+		glBlitFramebuffer(0, 0, cache.width, cache.height,
+			0, 0, ctx->data.videoWidth, ctx->data.videoHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return true;
+	}
+	return false;
+}
+
 inline static void cleanupOpenGLResources(MpvPlayerContext* ctx) noexcept
 {
+	releaseFrameCache(ctx);
+
 	// Clean up processing pipeline resources
 	if (ctx->processingFramebuffer) {
 		glDeleteFramebuffers(1, &ctx->processingFramebuffer);
@@ -200,6 +463,10 @@ inline static void cleanupOpenGLResources(MpvPlayerContext* ctx) noexcept
 		delete ctx->vrShader;
 		ctx->vrShader = nullptr;
 	}
+	if (ctx->cpuRemap) {
+		delete ctx->cpuRemap;
+		ctx->cpuRemap = nullptr;
+	}
 
 	// Clean up main framebuffer
 	if (ctx->framebuffer) {
@@ -388,6 +655,7 @@ inline static void updateRenderTexture(MpvPlayerContext* ctx) noexcept
 		}
 	}
 	else if(ctx->data.videoHeight > 0 && ctx->data.videoWidth > 0) {
+		releaseFrameCache(ctx);
 		// update size of render texture based on video resolution
 		glBindTexture(GL_TEXTURE_2D, *ctx->frameTexture);
 		glTexImage2D(GL_TEXTURE_2D, 0, OFS_InternalTexFormat, ctx->data.videoWidth, ctx->data.videoHeight, 0, OFS_TexFormat, GL_UNSIGNED_BYTE, 0);
@@ -445,6 +713,18 @@ bool OFS_Videoplayer::Init(bool hwAccel) noexcept
         return false;
     }
 
+    if (CTX->playerType == VideoplayerType::Main) {
+        // keep demuxed packets behind the playhead so backward seeks don't read the file again
+        error = mpv_set_property_string(CTX->mpv, "demuxer-seekable-cache", "yes");
+        if(error != 0) {
+            LOG_WARN("Failed to set mpv: demuxer-seekable-cache=yes");
+        }
+        error = mpv_set_property_string(CTX->mpv, "demuxer-max-back-bytes", "150MiB");
+        if(error != 0) {
+            LOG_WARN("Failed to set mpv: demuxer-max-back-bytes=150MiB");
+        }
+    }
+
     error = mpv_set_property_string(CTX->mpv, "loop-file", "inf");
     if(error != 0) {
         LOG_WARN("Failed to set mpv: loop-file=inf");
@@ -679,6 +959,10 @@ inline static void ProcessEvents(MpvPlayerContext* ctx) noexcept
                     }
                     case MpvFilePath:
                         ctx->data.filePath = *((const char**)(prop->data));
+                        releaseFrameCache(ctx);
+                        if (ctx->playerType == VideoplayerType::Main) {
+                            ctx->frameIndex.Build(ctx->data.filePath);
+                        }
                         notifyVideoLoaded(ctx);
                         break;
                 }
@@ -705,10 +989,20 @@ inline static void RenderFrameToTexture(MpvPlayerContext* ctx) noexcept
 	};
 	mpv_render_context_render(ctx->mpvGL, mainParams);
 
+	// Keep stepped frames for reverse stepping, only once mpv arrived at the requested frame
+	if (ctx->data.paused && ctx->frameIndex.IsReady() && ctx->data.videoWidth > 0) {
+		auto& index = ctx->frameIndex;
+		int64_t frameIdx = index.FrameAt(*ctx->logicalPosition * ctx->data.duration);
+		if (frameIdx >= 0 && frameIdx == index.FrameAt(ctx->data.percentPos * ctx->data.duration)) {
+			storeCachedFrame(ctx, frameIdx);
+			requestPrefill(ctx, frameIdx);
+		}
+	}
+
 	// Path 2: PROCESSING PIPELINE (downsample from main texture for AI tracking)
 	// Only when tracking is active to avoid overhead
 	if (ctx->trackingActive && ctx->processingFramebuffer && *ctx->frameTexture) {
-		LOGF_INFO("Processing pipeline active: framebuffer=%u, texture=%u, videoSize=%dx%d",
+		LOGF_DEBUG("Processing pipeline active: framebuffer=%u, texture=%u, videoSize=%dx%d",
 		          ctx->processingFramebuffer, *ctx->frameTexture, ctx->data.videoWidth, ctx->data.videoHeight);
 
 		// Run VR detection if not done yet and dimensions are available
@@ -778,7 +1072,27 @@ inline static void RenderFrameToTexture(MpvPlayerContext* ctx) noexcept
 
 		uint32_t finalTexture = ctx->processingTexture;  // Default: use raw mpv output
 
-		if (needsProcessing && ctx->cropShader && ctx->quadVAO) {
+		bool cpuRemap = needsProcessing && vrState.cpuRemap;
+		if (cpuRemap) {
+			// Crop/unwarp happens on the CPU after readback, read back the raw processing texture
+			if (!ctx->cpuRemap) {
+				ctx->cpuRemap = new OFS_VRRemap();
+				LOGF_INFO("CPU VR remap initialized with %d threads", ctx->cpuRemap->ThreadCount());
+			}
+			OFS_VRRemapConfig remapConfig;
+			remapConfig.format = activeFormat;
+			remapConfig.pitch = vrState.vrPitch;
+			remapConfig.yaw = vrState.vrYaw;
+			remapConfig.zoom = vrState.vrZoom;
+			remapConfig.rightEye = vrState.useRightEye;
+			remapConfig.unwarp = vrState.vrUnwarp;
+			remapConfig.srcWidth = MpvPlayerContext::PROCESSING_SIZE;
+			remapConfig.srcHeight = MpvPlayerContext::PROCESSING_SIZE;
+			remapConfig.dstWidth = MpvPlayerContext::PROCESSING_SIZE;
+			remapConfig.dstHeight = MpvPlayerContext::PROCESSING_SIZE;
+			ctx->cpuRemap->Configure(remapConfig);
+		}
+		else if (needsProcessing && ctx->cropShader && ctx->quadVAO) {
 			// For AI tracking: Only crop VR video to single eye
 			// NO unwarp shader - AI needs raw pixel data, not view-dependent projections
 			// VR unwarp is only for human viewing, not for AI processing
@@ -819,6 +1133,20 @@ inline static void RenderFrameToTexture(MpvPlayerContext* ctx) noexcept
 		const uint8_t* frameData = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
 
 		if (frameData) {
+			constexpr int pitch = MpvPlayerContext::PROCESSING_SIZE * 4;
+			auto& output = ctx->processingFrames[ctx->processingFrameIndex];
+			ctx->processingFrameIndex = (ctx->processingFrameIndex + 1) % 2;
+			output.resize(pitch * MpvPlayerContext::PROCESSING_SIZE);
+
+			float remapMs = 0.f;
+			if (cpuRemap) {
+				ctx->cpuRemap->Remap(frameData, pitch, output.data(), pitch);
+				remapMs = ctx->cpuRemap->AverageMs();
+			}
+			else {
+				memcpy(output.data(), frameData, output.size());
+			}
+			frameData = output.data();
 
 			// Emit event with processing frame data
 			double timeSeconds = ctx->data.duration * ctx->data.percentPos;
@@ -829,10 +1157,11 @@ inline static void RenderFrameToTexture(MpvPlayerContext* ctx) noexcept
 				timeSeconds,
 				ctx->playerType,
 				ctx->data.videoWidth,
-				ctx->data.videoHeight
+				ctx->data.videoHeight,
+				remapMs
 			);
 
-			LOG_INFO("ProcessingFrameReadyEvent enqueued");
+			LOG_DEBUG("ProcessingFrameReadyEvent enqueued");
 
 			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
 		} else {
@@ -858,6 +1187,8 @@ void OFS_Videoplayer::Update(float delta) noexcept
         ProcessEvents(CTX);
         SDL_AtomicDecRef(&CTX->hasEvents);
     }
+    CTX->frameIndex.Update();
+    updatePrefill(CTX);
 
     while(SDL_AtomicGet(&CTX->renderUpdate) > 0)
     {
@@ -880,6 +1211,10 @@ void OFS_Videoplayer::SetVolume(float volume) noexcept
 void OFS_Videoplayer::NextFrame() noexcept
 {
     if (IsPaused()) {
+        if (CTX->frameIndex.IsReady()) {
+            SeekFrames(1);
+            return;
+        }
         // use same method as previousFrame for consistency
         double relSeek = FrameTime() * 1.000001;
         CTX->data.percentPos += (relSeek / CTX->data.duration);
@@ -891,6 +1226,10 @@ void OFS_Videoplayer::NextFrame() noexcept
 void OFS_Videoplayer::PreviousFrame() noexcept
 {
     if (IsPaused()) {
+        if (CTX->frameIndex.IsReady()) {
+            SeekFrames(-1);
+            return;
+        }
         // this seeks much faster
         // https://github.com/mpv-player/mpv/issues/4019#issuecomment-358641908
         double relSeek = FrameTime() * 1.000001;
@@ -968,6 +1307,14 @@ void OFS_Videoplayer::SeekFrames(int32_t offset) noexcept
 {
     // this updates logicalPosition in SetPositionPercent
     if (IsPaused()) {
+        auto& index = CTX->frameIndex;
+        if (index.IsReady()) {
+            // exact frame times, also correct for variable frame rate
+            double target = index.StepFrames(CurrentTime(), offset);
+            showCachedFrame(CTX, index.FrameAt(target));
+            SetPositionExact(target, false);
+            return;
+        }
         float relSeek = (FrameTime() * 1.000001f) * offset;
         CTX->data.percentPos += (relSeek / CTX->data.duration);
         CTX->data.percentPos = Util::Clamp(CTX->data.percentPos, 0.0, 1.0);
@@ -991,6 +1338,7 @@ void OFS_Videoplayer::CycleSubtitles() noexcept
 void OFS_Videoplayer::CloseVideo() noexcept
 {
     CTX->data.videoLoaded = false;
+    CTX->frameIndex.Clear();
     const char* cmd[] = { "stop", NULL };
     mpv_command_async(CTX->mpv, 0, cmd);
     SetPaused(true);
@@ -1097,6 +1445,11 @@ const char* OFS_Videoplayer::VideoPath() const noexcept
     return CTX->data.filePath.c_str();
 }
 
+const OFS_FrameIndex& OFS_Videoplayer::FrameIndex() const noexcept
+{
+    return CTX->frameIndex;
+}
+
 void OFS_Videoplayer::SetTrackingActive(bool active) noexcept
 {
 	CTX->trackingActive = active;
@@ -0,0 +1,642 @@
+#include "Funscript.h"
+#include "FunscriptUndoSystem.h"
+#include "FunscriptHeatmap.h"
+#include "FunscriptOps.h"
+#include "OFS_Waveform.h"
+#include "OFS_BinarySerialization.h"
+#include "state/OFS_StateManager.h"
+#include "state/OFS_LibState.h"
+#include "state/states/ChapterState.h"
+#include "state/states/WaveformState.h"
+#include "videoplayer/OFS_VRRemap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+/*
+    Microbenchmarks for the Funscript core operations on synthetic scripts.
+
+    ofs_bench [--filter <substring>] [--max-actions <n>] [--min-time <seconds>]
+              [--out <results.csv>] [--compare <baseline.csv>]
+
+    Every benchmark reports the time and the heap allocations per operation and the peak heap usage per call,
+    results get written to a csv which can be passed to --compare on another commit.
+*/
+
+#ifndef OFS_LATEST_GIT_HASH
+#define OFS_LATEST_GIT_HASH "unknown"
+#endif
+
+// Counting allocator, only the global operator new is tracked.
+static std::atomic<uint64_t> AllocatedBytes = {0};
+static std::atomic<uint64_t> AllocationCount = {0};
+static std::atomic<uint64_t> LiveBytes = {0};
+static std::atomic<uint64_t> PeakBytes = {0};
+
+// the size is kept in front of each block so that delete knows how much is released
+static constexpr size_t BlockHeader = alignof(std::max_align_t);
+
+static void* CountedAlloc(size_t size) noexcept
+{
+    auto block = static_cast<uint8_t*>(std::malloc(size + BlockHeader));
+    if (!block) return nullptr;
+    *reinterpret_cast<size_t*>(block) = size;
+    AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    uint64_t live = LiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = PeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return block + BlockHeader;
+}
+
+static void CountedFree(void* ptr) noexcept
+{
+    if (!ptr) return;
+    auto block = static_cast<uint8_t*>(ptr) - BlockHeader;
+    LiveBytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void* operator new(size_t size)
+{
+    if (void* ptr = CountedAlloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+
+struct BenchResult
+{
+    std::string name;
+    uint32_t actions;
+    uint32_t opsPerCall;
+    double nsPerOp;
+    double bytesPerOp;
+    double allocsPerOp;
+    // highest heap usage above what was live before a call
+    double peakBytes;
+};
+
+struct BenchOptions
+{
+    const char* filter = nullptr;
+    uint32_t maxActions = 1'000'000;
+    double minTime = 0.25;
+    std::string outPath = std::string("ofs_bench_") + OFS_LATEST_GIT_HASH + ".csv";
+    const char* comparePath = nullptr;
+};
+
+static BenchOptions Options;
+static std::vector<BenchResult> Results;
+
+// Calls fn until minTime passed, each call performs opsPerCall operations.
+template<typename Fn>
+static void Run(const char* name, uint32_t actions, uint32_t opsPerCall, Fn&& fn) noexcept
+{
+    if (Options.filter && !strstr(name, Options.filter)) return;
+    using Clock = std::chrono::steady_clock;
+
+    fn();
+
+    uint64_t calls = 0;
+    uint64_t peak = 0;
+    uint64_t bytesBefore = AllocatedBytes.load(std::memory_order_relaxed);
+    uint64_t allocsBefore = AllocationCount.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        uint64_t live = LiveBytes.load(std::memory_order_relaxed);
+        PeakBytes.store(live, std::memory_order_relaxed);
+        fn();
+        peak = std::max(peak, PeakBytes.load(std::memory_order_relaxed) - live);
+        calls += 1;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < Options.minTime);
+    uint64_t bytes = AllocatedBytes.load(std::memory_order_relaxed) - bytesBefore;
+    uint64_t allocs = AllocationCount.load(std::memory_order_relaxed) - allocsBefore;
+
+    double ops = (double)calls * opsPerCall;
+    BenchResult result{ name, actions, opsPerCall, elapsed * 1e9 / ops, bytes / ops, allocs / ops, (double)peak };
+    printf("%-32s %9u %14.2f %14.2f %10.3f %14.0f\n", name, actions, result.nsPerOp, result.bytesPerOp, result.allocsPerOp, result.peakBytes);
+    fflush(stdout);
+    Results.emplace_back(std::move(result));
+}
+
+// Deterministic so results stay comparable between runs.
+struct BenchRandom
+{
+    uint64_t state = 0x853c49e6748fea9bULL;
+    inline uint32_t Next() noexcept
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (uint32_t)(state >> 33);
+    }
+    inline float Range(float min, float max) noexcept { return min + (Next() / (float)(1u << 31)) * (max - min); }
+};
+
+// Strokes between 80ms and 500ms alternating between low and high positions.
+static FunscriptArray GenerateActions(uint32_t count, uint64_t seed = 1) noexcept
+{
+    BenchRandom rng;
+    rng.state ^= seed;
+    FunscriptArray actions;
+    actions.reserve(count);
+    float time = 0.f;
+    for (uint32_t i = 0; i < count; i += 1) {
+        time += rng.Range(0.08f, 0.5f);
+        int32_t pos = (i & 1) ? 50 + rng.Next() % 51 : rng.Next() % 50;
+        actions.emplace_back_unsorted(FunscriptAction(time, pos));
+    }
+    return actions;
+}
+
+static void BenchInsertion(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    Run("insert/append", n, n, [&]() noexcept {
+        Funscript script;
+        for (auto action : actions) script.AddAction(action);
+    });
+
+    Funscript script;
+    script.SetActions(actions);
+    float duration = actions.back().atS;
+    BenchRandom rng;
+    constexpr uint32_t Batch = 16;
+    // the script size stays the same
+    Run("insert/random_insert_remove", n, Batch, [&]() noexcept {
+        for (uint32_t i = 0; i < Batch; i += 1) {
+            FunscriptAction action(rng.Range(0.f, duration), 50);
+            script.AddAction(action);
+            script.RemoveAction(action, false);
+        }
+    });
+
+    auto extra = GenerateActions(n / 10, 2);
+    Run("insert/add_multiple_10pct", n, extra.size(), [&]() noexcept {
+        script.SetActions(actions);
+        script.AddMultipleActions(extra);
+    });
+}
+
+static void BenchEdits(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    Funscript script;
+    script.SetActions(actions);
+    float duration = actions.back().atS;
+
+    script.SelectAll();
+    Run("edit/move_all_time", n, 2, [&]() noexcept {
+        script.MoveSelectionTime(0.001f, 0.f);
+        script.MoveSelectionTime(-0.001f, 0.f);
+    });
+    Run("edit/move_all_position", n, 2, [&]() noexcept {
+        script.MoveSelectionPosition(1);
+        script.MoveSelectionPosition(-1);
+    });
+
+    // roughly a hundred actions in the middle
+    uint32_t mid = n / 2;
+    uint32_t windowSize = std::min(n / 2, 100u);
+    float windowFrom = actions[mid].atS;
+    float windowTo = actions[mid + windowSize - 1].atS;
+    script.SelectTime(windowFrom, windowTo);
+    Run("edit/move_window_time", n, 2, [&]() noexcept {
+        script.MoveSelectionTime(0.001f, 0.f);
+        script.MoveSelectionTime(-0.001f, 0.f);
+    });
+    script.ClearSelection();
+    script.SetActions(actions);
+
+    float replaceFrom = duration * 0.45f;
+    float replaceTo = duration * 0.55f;
+    auto replacement = script.GetSelection(replaceFrom, replaceTo);
+    FunscriptArray emptySelection;
+    Run("edit/replace_interval_10pct", n, 1, [&]() noexcept {
+        script.ReplaceActionsInInterval(replaceFrom, replaceTo, replacement, emptySelection);
+    });
+}
+
+static void BenchSelection(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    Funscript script;
+    script.SetActions(actions);
+    float duration = actions.back().atS;
+
+    Run("select/time_half", n, 1, [&]() noexcept {
+        script.SelectTime(0.f, duration * 0.5f);
+    });
+    Run("select/all_clear", n, 1, [&]() noexcept {
+        script.SelectAll();
+        script.ClearSelection();
+    });
+    Run("select/top_actions", n, 1, [&]() noexcept {
+        script.SelectAll();
+        script.SelectTopActions();
+    });
+    script.ClearSelection();
+
+    BenchRandom rng;
+    constexpr uint32_t Batch = 16;
+    Run("select/toggle_random", n, Batch, [&]() noexcept {
+        for (uint32_t i = 0; i < Batch; i += 1) {
+            script.ToggleSelection(actions[rng.Next() % n]);
+        }
+    });
+}
+
+static void BenchSampling(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    Funscript script;
+    script.SetActions(actions);
+    float duration = actions.back().atS;
+    constexpr uint32_t Batch = 1024;
+    volatile float sink = 0.f;
+
+    // what the simulator and the device output do every frame
+    float time = 0.f;
+    Run("sample/spline_sequential", n, Batch, [&]() noexcept {
+        for (uint32_t i = 0; i < Batch; i += 1) {
+            time += 1.f / 60.f;
+            if (time > duration) time = 0.f;
+            sink = sink + script.Spline(time);
+        }
+    });
+
+    BenchRandom rng;
+    Run("sample/spline_random", n, Batch, [&]() noexcept {
+        for (uint32_t i = 0; i < Batch; i += 1) {
+            sink = sink + script.Spline(rng.Range(0.f, duration));
+        }
+    });
+    Run("sample/position_random", n, Batch, [&]() noexcept {
+        for (uint32_t i = 0; i < Batch; i += 1) {
+            sink = sink + script.GetPositionAtTime(rng.Range(0.f, duration));
+        }
+    });
+    Run("sample/action_at_time", n, Batch, [&]() noexcept {
+        for (uint32_t i = 0; i < Batch; i += 1) {
+            auto action = script.GetActionAtTime(rng.Range(0.f, duration), 0.1f);
+            sink = sink + (action ? action->pos : 0);
+        }
+    });
+}
+
+// What ofs.ops does with the whole script selected, load the columns, run the op and store them again.
+// The Core extension's spline smooth and jitter used to do the same through the Lua Funscript API.
+static void BenchOps(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    FunscriptArray selection = actions;
+    FunscriptColumns cols;
+    FunscriptArray outActions;
+    FunscriptArray outSelection;
+    auto apply = [&](auto&& op) noexcept {
+        cols.Load(actions.data(), actions.data() + actions.size(), selection, true);
+        op();
+        cols.Store(outActions, outSelection);
+    };
+
+    // Core extension default of a point every 100ms
+    Run("ops/spline_resample", n, 1, [&]() noexcept {
+        apply([&]() noexcept { FunscriptOps::Resample(cols, 0.1f, true); });
+    });
+    Run("ops/jitter", n, 1, [&]() noexcept {
+        apply([&]() noexcept { FunscriptOps::Jitter(cols, 0.01f, 15.f); });
+    });
+    Run("ops/smooth", n, 1, [&]() noexcept {
+        apply([&]() noexcept { FunscriptOps::Smooth(cols, 2); });
+    });
+}
+
+static void BenchSerialization(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    Funscript script;
+    script.SetActions(actions);
+    Funscript::Metadata metadata;
+
+    // per action
+    std::string text;
+    Run("json/serialize", n, n, [&]() noexcept {
+        text = script.Serialize(metadata, nullptr).dump();
+    });
+    Run("json/deserialize", n, n, [&]() noexcept {
+        Funscript loaded;
+        Funscript::Metadata loadedMetadata;
+        loaded.Deserialize(nlohmann::json::parse(text, nullptr, false), &loadedMetadata, nullptr);
+    });
+
+    ByteBuffer buffer;
+    Run("bitsery/serialize", n, n, [&]() noexcept {
+        buffer.clear();
+        OFS_Binary::Serialize(buffer, script);
+    });
+    Run("bitsery/deserialize", n, n, [&]() noexcept {
+        Funscript loaded;
+        OFS_Binary::Deserialize(buffer, loaded);
+    });
+}
+
+struct BenchProjectState
+{
+    Funscript::Metadata metadata;
+    std::string relativeMediaPath;
+    float activeTimer = 0.f;
+    std::vector<uint8_t> binaryFunscriptData;
+};
+
+REFL_TYPE(BenchProjectState)
+    REFL_FIELD(metadata)
+    REFL_FIELD(relativeMediaPath)
+    REFL_FIELD(activeTimer)
+    REFL_FIELD(binaryFunscriptData)
+REFL_END
+
+// A project like OFS_Project::Save writes it, per call
+static void BenchStateSerialization(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    auto mgr = OFS_StateManager::Get();
+    mgr->ClearProjectAll();
+    auto& project = mgr->GetProject<BenchProjectState>(mgr->RegisterProject<BenchProjectState>("ProjectState"));
+    auto& chapters = mgr->GetProject<ChapterState>(mgr->RegisterProject<ChapterState>(ChapterState::StateName));
+    auto& waveform = mgr->GetProject<WaveformState>(mgr->RegisterProject<WaveformState>(WaveformState::StateName));
+
+    Funscript script;
+    script.SetActions(actions);
+    project.relativeMediaPath = "bench.mp4";
+    project.binaryFunscriptData.resize(OFS_Binary::Serialize(project.binaryFunscriptData, script));
+    for (uint32_t i = 0; i < n / 100; i += 1) {
+        Chapter chapter;
+        chapter.startTime = i * 10.f;
+        chapter.endTime = chapter.startTime + 5.f;
+        chapter.name = "Chapter";
+        chapters.chapters.emplace_back(std::move(chapter));
+    }
+    // stands in for the compressed waveform, about as big as the one of a video this long
+    BenchRandom rng;
+    waveform.BinSamples.resize(n * 16);
+    for (auto& byte : waveform.BinSamples) byte = (uint8_t)rng.Next();
+    waveform.UncompressedSize = n * 32;
+
+    // the format before OFS_StateBinary
+    ByteBuffer cbor;
+    Run("state/save_cbor", n, 1, [&]() noexcept {
+        cbor = Util::SerializeCBOR(mgr->SerializeProjectAll(true));
+    });
+    Run("state/load_cbor", n, 1, [&]() noexcept {
+        bool succ = false;
+        auto json = Util::ParseCBOR(cbor, &succ);
+        mgr->DeserializeProjectAll(json, true);
+    });
+
+    // a fresh buffer per call like the cbor path and OFS_Project::Save
+    Run("state/save_binary", n, 1, [&]() noexcept {
+        ByteBuffer binary;
+        mgr->SerializeProjectAll(binary);
+    });
+    ByteBuffer binary;
+    mgr->SerializeProjectAll(binary);
+    Run("state/load_binary", n, 1, [&]() noexcept {
+        mgr->DeserializeProjectAll(binary);
+    });
+}
+
+// Not timed. A state file that can't be read has to leave every registered state at its default,
+// the handles of the project states are used right after a failed load.
+static bool CheckUnreadableStateFiles() noexcept
+{
+    auto mgr = OFS_StateManager::Get();
+    mgr->RegisterProject<BenchProjectState>("ProjectState");
+    mgr->RegisterProject<ChapterState>(ChapterState::StateName);
+    mgr->RegisterProject<WaveformState>(WaveformState::StateName);
+    mgr->ClearProjectAll();
+    ByteBuffer defaults;
+    mgr->SerializeProjectAll(defaults);
+
+    // the magic but less than the 10 byte header
+    ByteBuffer truncated(defaults.begin(), defaults.begin() + 6);
+    // little endian format version right after the magic
+    ByteBuffer future = defaults;
+    uint16_t futureVersion = OFS_StateBinary::FormatVersion + 1;
+    future[4] = (uint8_t)(futureVersion & 0xFF);
+    future[5] = (uint8_t)(futureVersion >> 8);
+
+    struct Case { const char* name; const ByteBuffer* buffer; };
+    bool ok = true;
+    for (auto& test : { Case{ "truncated header", &truncated }, Case{ "newer format version", &future } }) {
+        bool loaded = mgr->DeserializeProjectAll(*test.buffer);
+        ByteBuffer written;
+        mgr->SerializeProjectAll(written);
+        if (loaded || written != defaults) {
+            printf("state file with a %s: %s\n", test.name, loaded ? "loaded without an error" : "states weren't reset to defaults");
+            ok = false;
+        }
+    }
+    mgr->ClearProjectAll();
+    return ok;
+}
+
+// Not timed. OFS_VRRemap::MapUV against the shaders at a non-square output. The expected values were
+// computed with a line by line transcription of VrShader (top/bottom, rotation = (yaw/360+0.5, pitch/180+0.5))
+// and FisheyeUnwarpShader (u_output_fov = 2*atan(0.5*tan(hfov/2)/zoom)), mat3 column major like GLSL.
+static bool CheckVRRemapParity() noexcept
+{
+    struct Case
+    {
+        VRProjection projection;
+        VRLayout layout;
+        bool rightEye;
+        float pitch, yaw, zoom;
+        float u, v;
+        float expectedU, expectedV;
+    };
+    static constexpr Case Cases[] = {
+        { VRProjection::Equirectangular180, VRLayout::TopBottom, false, 15.f, -30.f, 0.20f, 0.50f, 0.50f, 0.833333f, 0.291667f },
+        { VRProjection::Equirectangular180, VRLayout::TopBottom, false, 15.f, -30.f, 0.20f, 0.10f, 0.20f, 0.006988f, 0.325202f },
+        { VRProjection::Equirectangular180, VRLayout::TopBottom, false, 15.f, -30.f, 0.20f, 0.85f, 0.70f, 0.690966f, 0.235427f },
+        { VRProjection::Equirectangular180, VRLayout::TopBottom, false, 15.f, -30.f, 0.20f, 0.30f, 0.95f, 0.922850f, 0.179808f },
+        { VRProjection::Equirectangular360, VRLayout::TopBottom, false, -40.f, 60.f, 0.35f, 0.50f, 0.50f, 0.583333f, 0.138889f },
+        { VRProjection::Equirectangular360, VRLayout::TopBottom, false, -40.f, 60.f, 0.35f, 0.10f, 0.20f, 0.697611f, 0.208086f },
+        { VRProjection::Equirectangular360, VRLayout::TopBottom, false, -40.f, 60.f, 0.35f, 0.85f, 0.70f, 0.439915f, 0.137892f },
+        { VRProjection::Equirectangular360, VRLayout::TopBottom, false, -40.f, 60.f, 0.35f, 0.30f, 0.95f, 0.713801f, 0.081453f },
+        { VRProjection::Fisheye190, VRLayout::SideBySide, false, 20.f, -25.f, 0.20f, 0.50f, 0.50f, 0.313027f, 0.608562f },
+        { VRProjection::Fisheye190, VRLayout::SideBySide, false, 20.f, -25.f, 0.20f, 0.10f, 0.20f, 0.149573f, 0.422194f },
+        { VRProjection::Fisheye190, VRLayout::SideBySide, false, 20.f, -25.f, 0.20f, 0.85f, 0.70f, 0.487584f, 0.706196f },
+        { VRProjection::Fisheye190, VRLayout::SideBySide, false, 20.f, -25.f, 0.20f, 0.30f, 0.95f, 0.162848f, 0.814490f },
+        { VRProjection::Fisheye200, VRLayout::SideBySide, true, -35.f, 50.f, 0.30f, 0.50f, 0.50f, 0.642553f, 0.303575f },
+        { VRProjection::Fisheye200, VRLayout::SideBySide, true, -35.f, 50.f, 0.30f, 0.10f, 0.20f, 0.515926f, 0.114402f },
+        { VRProjection::Fisheye200, VRLayout::SideBySide, true, -35.f, 50.f, 0.30f, 0.85f, 0.70f, 0.762583f, 0.477219f },
+        { VRProjection::Fisheye200, VRLayout::SideBySide, true, -35.f, 50.f, 0.30f, 0.30f, 0.95f, 0.550149f, 0.585920f },
+    };
+    // 0.06 pixels of the 640 pixel processing frame
+    constexpr float Tolerance = 1e-4f;
+
+    bool ok = true;
+    for (auto& test : Cases) {
+        OFS_VRRemapConfig config;
+        config.format.isVR = true;
+        config.format.projection = test.projection;
+        config.format.layout = test.layout;
+        config.rightEye = test.rightEye;
+        config.pitch = test.pitch;
+        config.yaw = test.yaw;
+        config.zoom = test.zoom;
+        config.srcWidth = 640;
+        config.srcHeight = 640;
+        config.dstWidth = 640;
+        config.dstHeight = 360;
+        float u, v;
+        OFS_VRRemap::MapUV(config, test.u, test.v, &u, &v);
+        if (std::abs(u - test.expectedU) > Tolerance || std::abs(v - test.expectedV) > Tolerance) {
+            printf("VR remap differs from the shader (projection %d, pitch %.0f, yaw %.0f) at %.2f %.2f: %f %f, expected %f %f\n",
+                (int)test.projection, test.pitch, test.yaw, test.u, test.v, u, v, test.expectedU, test.expectedV);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void BenchHeatmapAndWaveform(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    float duration = actions.back().atS;
+    std::vector<float> speeds;
+    Run("heatmap/compute_speeds", n, 1, [&]() noexcept {
+        FunscriptHeatmap::ComputeSpeeds(duration, actions, speeds);
+    });
+
+    // the waveform size doesn't depend on the script, it only scales with the same parameter
+    uint32_t sampleCount = std::min(n * 16u, 16'000'000u);
+    std::vector<float> samples;
+    samples.reserve(sampleCount);
+    BenchRandom rng;
+    for (uint32_t i = 0; i < sampleCount; i += 1) samples.push_back(rng.Range(0.f, 1.f));
+    OFS_Waveform waveform;
+    waveform.SetSamples(std::move(samples));
+    Run("waveform/build_lod_pyramid", n, 1, [&]() noexcept {
+        waveform.BuildLODPyramid();
+    });
+}
+
+static void BenchUndo(uint32_t n, const FunscriptArray& actions) noexcept
+{
+    Funscript script;
+    script.SetActions(actions);
+    script.SelectTime(0.f, actions.back().atS * 0.1f);
+
+    // FunscriptUndoSystem::Snapshot copies the whole FunscriptData into a ScriptState
+    std::vector<ScriptState> undoStack;
+    undoStack.reserve(8);
+    Run("undo/snapshot", n, 1, [&]() noexcept {
+        if (undoStack.size() == 8) undoStack.clear();
+        undoStack.emplace_back(0, script.Data());
+    });
+    Run("undo/rollback", n, 1, [&]() noexcept {
+        script.Rollback(undoStack.back().Data());
+    });
+}
+
+static bool WriteResults(const std::string& path) noexcept
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    // peak_bytes comes last, older files without it can still be compared against
+    fprintf(file, "name,actions,ops_per_call,ns_per_op,bytes_per_op,allocs_per_op,git_hash,peak_bytes\n");
+    for (auto& result : Results) {
+        fprintf(file, "%s,%u,%u,%.3f,%.3f,%.5f,%s,%.0f\n", result.name.c_str(), result.actions, result.opsPerCall,
+            result.nsPerOp, result.bytesPerOp, result.allocsPerOp, OFS_LATEST_GIT_HASH, result.peakBytes);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool CompareResults(const char* path) noexcept
+{
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    std::map<std::pair<std::string, uint32_t>, BenchResult> baseline;
+    char line[512];
+    char baselineHash[64] = "?";
+    // skip the header
+    if (!fgets(line, sizeof(line), file)) { fclose(file); return false; }
+    while (fgets(line, sizeof(line), file)) {
+        char name[128];
+        BenchResult result;
+        if (sscanf(line, "%127[^,],%u,%u,%lf,%lf,%lf,%63[^,\n]", name, &result.actions, &result.opsPerCall,
+            &result.nsPerOp, &result.bytesPerOp, &result.allocsPerOp, baselineHash) < 6) continue;
+        result.name = name;
+        baseline[{ result.name, result.actions }] = result;
+    }
+    fclose(file);
+
+    printf("\nCompared to %s (%s)\n", path, baselineHash);
+    printf("%-32s %9s %14s %14s %10s\n", "benchmark", "actions", "ns/op", "baseline", "change");
+    for (auto& result : Results) {
+        auto it = baseline.find({ result.name, result.actions });
+        if (it == baseline.end()) continue;
+        double change = (result.nsPerOp / it->second.nsPerOp - 1.0) * 100.0;
+        printf("%-32s %9u %14.2f %14.2f %+9.1f%%%s\n", result.name.c_str(), result.actions,
+            result.nsPerOp, it->second.nsPerOp, change, change > 10.0 ? "  <- slower" : "");
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i += 1) {
+        auto arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--filter") && hasValue) Options.filter = argv[++i];
+        else if (!strcmp(arg, "--max-actions") && hasValue) Options.maxActions = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--min-time") && hasValue) Options.minTime = strtod(argv[++i], nullptr);
+        else if (!strcmp(arg, "--out") && hasValue) Options.outPath = argv[++i];
+        else if (!strcmp(arg, "--compare") && hasValue) Options.comparePath = argv[++i];
+        else {
+            printf("Usage: %s [--filter <substring>] [--max-actions <n>] [--min-time <seconds>] [--out <results.csv>] [--compare <baseline.csv>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("ofs_bench %s\n", OFS_LATEST_GIT_HASH);
+    printf("%-32s %9s %14s %14s %10s %14s\n", "benchmark", "actions", "ns/op", "bytes/op", "allocs/op", "peak bytes");
+
+    OFS_StateManager::Init();
+    OFS_LibState::RegisterAll();
+    OFS_REGISTER_STATE(BenchProjectState);
+    if (!CheckUnreadableStateFiles()) return 1;
+    if (!CheckVRRemapParity()) return 1;
+    for (uint32_t n = 1'000; n <= Options.maxActions; n *= 10) {
+        auto actions = GenerateActions(n);
+        BenchInsertion(n, actions);
+        BenchEdits(n, actions);
+        BenchSelection(n, actions);
+        BenchSampling(n, actions);
+        BenchOps(n, actions);
+        BenchSerialization(n, actions);
+        BenchStateSerialization(n, actions);
+        BenchHeatmapAndWaveform(n, actions);
+        BenchUndo(n, actions);
+    }
+
+    if (!WriteResults(Options.outPath)) {
+        printf("Failed to write %s\n", Options.outPath.c_str());
+        return 1;
+    }
+    printf("\nResults written to %s\n", Options.outPath.c_str());
+    if (Options.comparePath && !CompareResults(Options.comparePath)) {
+        printf("Failed to read %s\n", Options.comparePath);
+        return 1;
+    }
+    return 0;
+}
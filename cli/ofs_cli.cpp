@@ -0,0 +1,457 @@
+#include "Funscript.h"
+#include "FunscriptOps.h"
+#include "FunscriptHeatmap.h"
+#include "OFS_ThreadPool.h"
+#include "OFS_FileLogging.h"
+#include "OFS_Util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+/*
+    Headless batch processing of funscripts, no window, GL context or mpv gets created.
+
+    ofs-cli <job.json> [--threads <n>]
+
+    {
+        "input": "scripts/",        directory (or a single file) with .funscript files
+        "recursive": true,
+        "output": "processed/",     required by every step which writes files
+        "threads": 0,               0 uses all cores
+        "report": "report.json",    optional, per file results
+        "steps": [
+            { "op": "validate", "strict": false },
+            { "op": "normalize" },
+            { "op": "simplify", "tolerance": 2.0 },
+            { "op": "split_axes" },
+            { "op": "heatmap", "width": 1024, "height": 64 }
+        ]
+    }
+
+    validate    reports questionable actions, with strict every warning is an error.
+                Actions which can't be loaded are always an error.
+    normalize   rewrites sorted actions with unique millisecond timestamps and clamped positions
+    simplify    removes actions which deviate less than tolerance from the line between their neighbours
+    split_axes  writes 2.0 `channels` and 1.1 `axes` into <name>.<axis>.funscript files
+    heatmap     renders <name>.heatmap.png
+*/
+
+struct CliJob
+{
+    std::filesystem::path input;
+    std::filesystem::path output;
+    std::string reportPath;
+    bool recursive = true;
+    int threads = 0;
+
+    bool validate = false;
+    bool strict = false;
+    bool normalize = false;
+    bool simplify = false;
+    float simplifyTolerance = 2.f;
+    bool splitAxes = false;
+    bool heatmap = false;
+    int16_t heatmapWidth = 1024;
+    int16_t heatmapHeight = 64;
+
+    inline bool WritesScripts() const noexcept { return normalize || simplify || splitAxes; }
+};
+
+struct CliFileResult
+{
+    std::filesystem::path path;
+    std::vector<std::string> errors;
+    std::vector<std::string> warnings;
+    std::vector<std::string> written;
+    uint64_t bytes = 0;
+    uint64_t actions = 0;
+    uint32_t removedActions = 0;
+    uint32_t channels = 0;
+};
+
+static bool loadJob(const char* path, CliJob& job)
+{
+    bool succ = false;
+    auto json = Util::ParseJson(Util::ReadFileString(path), &succ);
+    if (!succ || !json.is_object()) {
+        fprintf(stderr, "Failed to parse job file \"%s\"\n", path);
+        return false;
+    }
+    if (!json.contains("input") || !json["input"].is_string()) {
+        fprintf(stderr, "The job needs an \"input\" path.\n");
+        return false;
+    }
+    // relative paths in the job are relative to the job file
+    auto jobDir = Util::PathFromString(path).parent_path();
+    auto resolve = [&jobDir](const std::string& p) noexcept {
+        auto result = Util::PathFromString(p);
+        return result.is_absolute() ? result : jobDir / result;
+    };
+    job.input = resolve(json["input"].get<std::string>());
+    if (json.contains("output") && json["output"].is_string()) job.output = resolve(json["output"].get<std::string>());
+    if (json.contains("report") && json["report"].is_string()) job.reportPath = resolve(json["report"].get<std::string>()).u8string();
+    job.recursive = json.value("recursive", true);
+    job.threads = json.value("threads", 0);
+
+    if (!json.contains("steps") || !json["steps"].is_array()) {
+        fprintf(stderr, "The job needs a \"steps\" array.\n");
+        return false;
+    }
+    for (auto& step : json["steps"]) {
+        std::string op;
+        if (step.is_string()) op = step.get<std::string>();
+        else if (step.is_object() && step.contains("op") && step["op"].is_string()) op = step["op"].get<std::string>();
+        if (op == "validate") {
+            job.validate = true;
+            if (step.is_object()) job.strict = step.value("strict", false);
+        }
+        else if (op == "normalize") {
+            job.normalize = true;
+        }
+        else if (op == "simplify") {
+            job.simplify = true;
+            if (step.is_object()) job.simplifyTolerance = step.value("tolerance", job.simplifyTolerance);
+        }
+        else if (op == "split_axes") {
+            job.splitAxes = true;
+        }
+        else if (op == "heatmap") {
+            job.heatmap = true;
+            if (step.is_object()) {
+                job.heatmapWidth = step.value("width", job.heatmapWidth);
+                job.heatmapHeight = step.value("height", job.heatmapHeight);
+            }
+        }
+        else {
+            fprintf(stderr, "Unknown step \"%s\"\n", op.c_str());
+            return false;
+        }
+    }
+    if ((job.WritesScripts() || job.heatmap) && job.output.empty()) {
+        fprintf(stderr, "The steps write files but the job has no \"output\" directory.\n");
+        return false;
+    }
+    return true;
+}
+
+static bool LoadJob(const char* path, CliJob& job) noexcept
+{
+    // nlohmann throws if a value has the wrong type
+    try {
+        return loadJob(path, job);
+    }
+    catch (const nlohmann::json::exception& ex) {
+        fprintf(stderr, "Invalid job file \"%s\": %s\n", path, ex.what());
+        return false;
+    }
+}
+
+static std::vector<std::filesystem::path> CollectScripts(const CliJob& job) noexcept
+{
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(job.input, ec)) {
+        files.emplace_back(job.input);
+        return files;
+    }
+    auto isScript = [](const std::filesystem::directory_entry& entry) noexcept {
+        std::error_code ec;
+        return entry.is_regular_file(ec) && entry.path().extension() == Funscript::Extension;
+    };
+    if (job.recursive) {
+        for (auto& entry : std::filesystem::recursive_directory_iterator(job.input, ec)) {
+            if (isScript(entry)) files.emplace_back(entry.path());
+        }
+    }
+    else {
+        for (auto& entry : std::filesystem::directory_iterator(job.input, ec)) {
+            if (isScript(entry)) files.emplace_back(entry.path());
+        }
+    }
+    // stable output order independent of the file system
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Checks the actions as they are in the file, before Funscript::Deserialize fixes them up.
+static void ValidateActions(const nlohmann::json& actions, const std::string& channel, CliFileResult& result) noexcept
+{
+    uint32_t invalid = 0, negative = 0, outOfRange = 0, unsorted = 0, duplicates = 0;
+    double lastAt = -std::numeric_limits<double>::infinity();
+    for (auto& action : actions) {
+        if (!action.is_object() || !action.contains("at") || !action.contains("pos")
+            || !action["at"].is_number() || !action["pos"].is_number()) {
+            invalid += 1;
+            continue;
+        }
+        double at = action["at"].get<double>();
+        double pos = action["pos"].get<double>();
+        if (at < 0.0) negative += 1;
+        if (pos < 0.0 || pos > 100.0) outOfRange += 1;
+        if (at == lastAt) duplicates += 1;
+        else if (at < lastAt) unsorted += 1;
+        lastAt = std::max(lastAt, at);
+    }
+
+    auto prefix = channel.empty() ? std::string{} : channel + ": ";
+    if (invalid > 0) result.errors.emplace_back(prefix + std::to_string(invalid) + " actions without a numeric at and pos");
+    if (negative > 0) result.warnings.emplace_back(prefix + std::to_string(negative) + " actions with negative timestamps");
+    if (outOfRange > 0) result.warnings.emplace_back(prefix + std::to_string(outOfRange) + " positions outside of 0 - 100");
+    if (unsorted > 0) result.warnings.emplace_back(prefix + std::to_string(unsorted) + " actions out of order");
+    if (duplicates > 0) result.warnings.emplace_back(prefix + std::to_string(duplicates) + " duplicate timestamps");
+}
+
+// Loads actions through the same path as the editor and applies the editing steps.
+static bool ProcessActions(const CliJob& job, const nlohmann::json& scriptJson, Funscript& script, Funscript::Metadata* metadata, CliFileResult& result) noexcept
+{
+    if (!script.Deserialize(scriptJson, metadata, nullptr)) {
+        return false;
+    }
+    result.actions += script.Actions().size();
+    if (job.simplify && script.Actions().size() > 2) {
+        FunscriptColumns cols;
+        FunscriptArray actions, selection;
+        auto& current = script.Actions();
+        cols.Load(current.data(), current.data() + current.size(), selection, false);
+        FunscriptOps::Decimate(cols, job.simplifyTolerance);
+        cols.Store(actions, selection);
+        result.removedActions += current.size() - actions.size();
+        script.SetActions(actions);
+    }
+    return true;
+}
+
+static nlohmann::json SerializeScript(const Funscript& script, const Funscript::Metadata& metadata, const nlohmann::json& original) noexcept
+{
+    nlohmann::json json;
+    Funscript::Serialize(json, script.Data(), metadata, nullptr);
+    // keep metadata OFS doesn't know about, like chapters written by other tools
+    if (original.contains("metadata") && original["metadata"].is_object()) {
+        auto& jsonMetadata = json["metadata"];
+        for (auto it = original["metadata"].begin(); it != original["metadata"].end(); ++it) {
+            if (!jsonMetadata.contains(it.key())) jsonMetadata[it.key()] = it.value();
+        }
+    }
+    return json;
+}
+
+static bool WriteJson(const std::filesystem::path& path, const nlohmann::json& json, CliFileResult& result) noexcept
+{
+    if (!Util::CreateDirectories(path.parent_path())) {
+        result.errors.emplace_back("Failed to create " + path.parent_path().u8string());
+        return false;
+    }
+    auto text = Util::SerializeJson(json, false);
+    if (Util::WriteFile(path.u8string().c_str(), text.data(), text.size()) != text.size()) {
+        result.errors.emplace_back("Failed to write " + path.u8string());
+        return false;
+    }
+    result.written.emplace_back(path.u8string());
+    return true;
+}
+
+static void ProcessFile(const CliJob& job, const std::filesystem::path& path, CliFileResult& result) noexcept
+{
+    result.path = path;
+    auto text = Util::ReadFileString(path.u8string().c_str());
+    result.bytes = text.size();
+    bool succ = false;
+    auto json = Util::ParseJson(text, &succ);
+    if (!succ || !json.is_object()) {
+        result.errors.emplace_back("Invalid json");
+        return;
+    }
+
+    // always validated, Funscript::Deserialize expects numeric actions
+    bool hasRootActions = json.contains("actions") && json["actions"].is_array();
+    if (hasRootActions) ValidateActions(json["actions"], std::string{}, result);
+    bool hasChannels = Funscript::ForEachChannel(json, [&](const std::string& name, const nlohmann::json& channel) noexcept {
+        result.channels += 1;
+        ValidateActions(channel["actions"], name, result);
+    });
+    if (!hasRootActions && !hasChannels) {
+        result.errors.emplace_back("No actions array found");
+        return;
+    }
+    if (!job.validate) {
+        result.warnings.clear();
+    }
+    else if (job.strict) {
+        for (auto& warning : result.warnings) result.errors.emplace_back(warning);
+        result.warnings.clear();
+    }
+    if (!result.errors.empty()) return;
+
+    Funscript root;
+    Funscript::Metadata metadata;
+    if (hasRootActions && !ProcessActions(job, json, root, &metadata, result)) {
+        result.errors.emplace_back("Failed to load the actions");
+        return;
+    }
+
+    // the output mirrors the directory structure of the input
+    std::error_code ec;
+    auto relative = std::filesystem::is_directory(job.input, ec)
+        ? std::filesystem::relative(path, job.input, ec)
+        : path.filename();
+    auto outBase = (job.output / relative).replace_extension("");
+
+    if (job.WritesScripts()) {
+        if (job.splitAxes && hasChannels) {
+            if (hasRootActions) {
+                auto rootJson = SerializeScript(root, metadata, json);
+                WriteJson(outBase.u8string() + Funscript::Extension, rootJson, result);
+            }
+            Funscript::ForEachChannel(json, [&](const std::string& name, const nlohmann::json& channel) noexcept {
+                Funscript script;
+                if (!ProcessActions(job, channel, script, nullptr, result)) {
+                    result.errors.emplace_back(name + ": failed to load the actions");
+                    return;
+                }
+                // same naming as OFS_Project::AddFunscript
+                WriteJson(outBase.u8string() + "." + name + Funscript::Extension, SerializeScript(script, metadata, json), result);
+            });
+        }
+        else {
+            // the file keeps its layout, only the actions and the metadata get rewritten
+            auto outJson = json;
+            if (hasRootActions) {
+                auto rootJson = SerializeScript(root, metadata, json);
+                outJson["actions"] = std::move(rootJson["actions"]);
+                outJson["metadata"] = std::move(rootJson["metadata"]);
+            }
+            Funscript::ForEachChannel(outJson, [&](const std::string& name, nlohmann::json& channel) noexcept {
+                Funscript script;
+                if (!ProcessActions(job, channel, script, nullptr, result)) {
+                    result.errors.emplace_back(name + ": failed to load the actions");
+                    return;
+                }
+                nlohmann::json channelJson;
+                Funscript::Serialize(channelJson, script.Data(), Funscript::Metadata(), nullptr);
+                channel["actions"] = std::move(channelJson["actions"]);
+            });
+            WriteJson(outBase.u8string() + Funscript::Extension, outJson, result);
+        }
+    }
+
+    if (job.heatmap && hasRootActions && !root.Actions().empty()) {
+        float duration = metadata.duration > 0.0 ? (float)metadata.duration : root.Actions().back().atS;
+        std::vector<float> speeds;
+        FunscriptHeatmap::ComputeSpeeds(duration, root.Actions(), speeds);
+        auto bitmap = FunscriptHeatmap::RenderSpeedsToBitmap(speeds, job.heatmapWidth, job.heatmapHeight);
+        auto pngPath = outBase.u8string() + ".heatmap.png";
+        if (!Util::CreateDirectories(outBase.parent_path())
+            || !Util::SavePNG(pngPath, bitmap.data(), job.heatmapWidth, job.heatmapHeight, 3, false)) {
+            result.errors.emplace_back("Failed to write " + pngPath);
+        }
+        else {
+            result.written.emplace_back(pngPath);
+        }
+    }
+}
+
+static bool WriteReport(const std::string& path, const std::vector<CliFileResult>& results, double seconds) noexcept
+{
+    auto report = nlohmann::json::object();
+    report["seconds"] = seconds;
+    auto& files = report["files"] = nlohmann::json::array();
+    for (auto& result : results) {
+        files.emplace_back(nlohmann::json{
+            { "path", result.path.u8string() },
+            { "actions", result.actions },
+            { "channels", result.channels },
+            { "removedActions", result.removedActions },
+            { "errors", result.errors },
+            { "warnings", result.warnings },
+            { "written", result.written },
+        });
+    }
+    auto text = Util::SerializeJson(report, true);
+    return Util::WriteFile(path.c_str(), text.data(), text.size()) == text.size();
+}
+
+int main(int argc, char** argv)
+{
+    const char* jobPath = nullptr;
+    int threadOverride = -1;
+    for (int i = 1; i < argc; i += 1) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) threadOverride = atoi(argv[++i]);
+        else if (!jobPath && argv[i][0] != '-') jobPath = argv[i];
+        else {
+            jobPath = nullptr;
+            break;
+        }
+    }
+    if (!jobPath) {
+        printf("Usage: %s <job.json> [--threads <n>]\n", argv[0]);
+        return 2;
+    }
+
+    // the console output is the report, library logging would only get in the way
+    SDL_AtomicSet(&OFS_FileLogger::MinSeverity, OFS_LogSeverity(OFS_LogLevel::OFS_LOG_ERROR));
+    // without the logger thread nothing drains the log rings, use a separate file so the editor's log survives
+    OFS_FileLogger::Init("ofs-cli.log");
+
+    CliJob job;
+    if (!LoadJob(jobPath, job)) {
+        OFS_FileLogger::Shutdown();
+        return 2;
+    }
+    if (threadOverride >= 0) job.threads = threadOverride;
+
+    auto files = CollectScripts(job);
+    if (files.empty()) {
+        fprintf(stderr, "No %s files found in \"%s\"\n", Funscript::Extension, job.input.u8string().c_str());
+        OFS_FileLogger::Shutdown();
+        return 2;
+    }
+
+    OFS_ThreadPool::Init(job.threads);
+    auto pool = OFS_ThreadPool::Get();
+    printf("Processing %zu files on %d threads\n", files.size(), pool->ThreadCount() + 1);
+
+    std::vector<CliFileResult> results(files.size());
+    auto start = std::chrono::steady_clock::now();
+    pool->ParallelFor((int)files.size(), [&](int idx) noexcept {
+        ProcessFile(job, files[idx], results[idx]);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    OFS_ThreadPool::Shutdown();
+    OFS_FileLogger::Shutdown();
+
+    uint64_t totalActions = 0, totalBytes = 0, removed = 0, written = 0;
+    uint32_t failed = 0, warned = 0;
+    for (auto& result : results) {
+        totalActions += result.actions;
+        totalBytes += result.bytes;
+        removed += result.removedActions;
+        written += result.written.size();
+        if (!result.errors.empty()) {
+            failed += 1;
+            for (auto& error : result.errors) fprintf(stderr, "error: %s: %s\n", result.path.u8string().c_str(), error.c_str());
+        }
+        if (!result.warnings.empty()) {
+            warned += 1;
+            for (auto& warning : result.warnings) printf("warning: %s: %s\n", result.path.u8string().c_str(), warning.c_str());
+        }
+    }
+
+    printf("\n%zu files, %u failed, %u with warnings, %" PRIu64 " files written\n", files.size(), failed, warned, written);
+    printf("%" PRIu64 " actions", totalActions);
+    if (job.simplify) printf(", %" PRIu64 " removed by simplify", removed);
+    printf("\n%.3f s, %.1f files/s, %.0f actions/s, %s/s\n", seconds,
+        files.size() / seconds, totalActions / seconds, Util::FormatBytes((size_t)(totalBytes / seconds)));
+
+    if (!job.reportPath.empty() && !WriteReport(job.reportPath, results, seconds)) {
+        fprintf(stderr, "Failed to write the report to \"%s\"\n", job.reportPath.c_str());
+        return 1;
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+-- Compares the Core extension's old Lua spline smooth and jitter with ofs.ops.
+-- Copy this directory into the extensions directory of OFS and enable it.
+-- Replaces the actions of the active script with generated ones and selects them,
+-- every measurement gets undone again. Use it on a scratch project.
+
+Bench = {}
+Bench.ActionCount = 50000
+Bench.PointEveryMs = 100
+Bench.JitterTimeMs = 10
+Bench.JitterPosition = 15
+Bench.Results = {}
+
+function init()
+end
+
+function update(delta)
+end
+
+local function clamp(val, min, max)
+    return math.min(math.max(val, min), max)
+end
+
+local function build_script()
+    local script = ofs.Script(ofs.ActiveIdx())
+    if script == nil then return false end
+    script.actions:clear()
+    for i=1, Bench.ActionCount do
+        script.actions:add(Action.new(i * 0.3, (i % 2) * 100, true))
+    end
+    script:commit()
+    return true
+end
+
+-- binding.spline_smooth before it called ofs.ops.SplineResample
+local function lua_spline_smooth()
+    local catmullRom = function(v1, v2, v3, v4, s)
+        local s2 = s*s
+        local s3 = s*s*s
+        local f1 = -s3 + 2.0 * s2 - s
+        local f2 = 3.0 * s3 - 5.0 * s2 + 2.0
+        local f3 = -3.0 * s3 + 4.0 * s2 + s
+        local f4 = s3 - s2
+        return (f1 * v1 + f2 * v2 + f3 * v3 + f4 * v4) / 2.0
+    end
+    local script = ofs.Script(ofs.ActiveIdx())
+    local actionCount = #script.actions
+    local smoothedActions = {}
+    for idx, action in ipairs(script.actions) do
+        local action1 = script.actions[clamp(idx - 1, 1, actionCount)]
+        local action2 = script.actions[clamp(idx, 1, actionCount)]
+        local action3 = script.actions[clamp(idx + 1, 1, actionCount)]
+        local action4 = script.actions[clamp(idx + 2, 1, actionCount)]
+        if action2.selected and action3.selected then
+            local duration = action3.at - action2.at
+            local pointEverySecond = Bench.PointEveryMs / 1000.0
+            local pointCount = duration / pointEverySecond
+            for i=1, pointCount-1, 1 do
+                local s = (i*pointEverySecond) / duration
+                local spline_pos = catmullRom(action1.pos, action2.pos, action3.pos, action4.pos, s)
+                table.insert(smoothedActions, {at=action2.at + (i*pointEverySecond), pos=clamp(spline_pos, 0, 100)})
+            end
+        end
+    end
+    for idx, action in ipairs(smoothedActions) do
+        script.actions:add(Action.new(action.at, action.pos))
+    end
+    script:commit()
+end
+
+-- binding.jitter before it called ofs.ops.Jitter
+local function lua_jitter()
+    local script = ofs.Script(ofs.ActiveIdx())
+    for idx, action in ipairs(script.actions) do
+        if action.selected then
+            action.at = action.at + math.random(-Bench.JitterTimeMs, Bench.JitterTimeMs) / 1000.0
+            action.pos = action.pos + math.random(-Bench.JitterPosition, Bench.JitterPosition)
+        end
+    end
+    script:commit()
+end
+
+local function measure(name, fn)
+    local start = os.clock()
+    fn()
+    local ms = (os.clock() - start) * 1000.0
+    ofs.Undo()
+    table.insert(Bench.Results, string.format("%-28s %10.2f ms", name, ms))
+    print(Bench.Results[#Bench.Results])
+end
+
+function run_benchmark()
+    Bench.Results = {}
+    if not build_script() then
+        print("No script loaded.")
+        return
+    end
+    local idx = ofs.ActiveIdx()
+
+    measure("spline smooth (Lua)", lua_spline_smooth)
+    measure("spline smooth (ofs.ops)", function()
+        ofs.ops.SplineResample(idx, Bench.PointEveryMs / 1000.0)
+    end)
+    measure("jitter (Lua)", lua_jitter)
+    measure("jitter (ofs.ops)", function()
+        ofs.ops.Jitter(idx, Bench.JitterTimeMs / 1000.0, Bench.JitterPosition)
+    end)
+end
+
+function gui()
+    Bench.ActionCount = ofs.Input("Actions", Bench.ActionCount)
+    Bench.ActionCount = math.max(Bench.ActionCount, 2)
+    if ofs.Button("Run") then
+        run_benchmark()
+    end
+    for i=1, #Bench.Results do
+        ofs.Text(Bench.Results[i])
+    end
+end
@@ -0,0 +1,114 @@
+-- Benchmarks the closest action queries of the Funscript API.
+-- Copy this directory into the extensions directory of OFS and enable it.
+-- Works on a local snapshot of the active script filled with generated actions,
+-- nothing gets committed.
+
+Bench = {}
+Bench.ActionCount = 50000
+Bench.QueryCount = 2000
+Bench.Results = {}
+
+function init()
+end
+
+function update(delta)
+end
+
+local function build_script()
+    local script = ofs.Script(ofs.ActiveIdx())
+    if script == nil then return nil end
+    script.actions:clear()
+    for i=1, Bench.ActionCount do
+        script.actions:add(Action.new(i * 0.1, (i % 2) * 100))
+    end
+    return script
+end
+
+local function query_times()
+    local times = {}
+    local duration = Bench.ActionCount * 0.1
+    for i=1, Bench.QueryCount do
+        times[i] = math.random() * duration
+    end
+    return times
+end
+
+-- what every closestAction call used to cost
+local function linear_closest(script, time)
+    local closestIdx = nil
+    local closestDelta = math.huge
+    for idx, action in ipairs(script.actions) do
+        local delta = math.abs(action.at - time)
+        if delta < closestDelta then
+            closestDelta = delta
+            closestIdx = idx
+        end
+    end
+    return closestIdx
+end
+
+local function measure(name, fn)
+    local start = os.clock()
+    local checksum = fn()
+    local ms = (os.clock() - start) * 1000.0
+    table.insert(Bench.Results, string.format("%-28s %10.2f ms  (%d)", name, ms, checksum))
+    print(Bench.Results[#Bench.Results])
+end
+
+function run_benchmark()
+    Bench.Results = {}
+    local script = build_script()
+    if script == nil then
+        print("No script loaded.")
+        return
+    end
+    local times = query_times()
+
+    measure("linear scan in Lua", function()
+        local sum = 0
+        for i=1, #times do
+            sum = sum + linear_closest(script, times[i])
+        end
+        return sum
+    end)
+
+    measure("closestAction", function()
+        local sum = 0
+        for i=1, #times do
+            local action, idx = script:closestAction(times[i])
+            sum = sum + idx
+        end
+        return sum
+    end)
+
+    measure("closestIndices (bulk)", function()
+        local sum = 0
+        local indices = script:closestIndices(times)
+        for i=1, #indices do
+            sum = sum + indices[i]
+        end
+        return sum
+    end)
+
+    measure("positionsAt (bulk)", function()
+        local sum = 0
+        local positions = script:positionsAt(times)
+        for i=1, #positions do
+            sum = sum + positions[i]
+        end
+        return math.floor(sum)
+    end)
+end
+
+function gui()
+    Bench.ActionCount = ofs.Input("Actions", Bench.ActionCount)
+    Bench.QueryCount = ofs.Input("Queries", Bench.QueryCount)
+    Bench.ActionCount = math.max(Bench.ActionCount, 1)
+    Bench.QueryCount = math.max(Bench.QueryCount, 1)
+    if ofs.Button("Run") then
+        run_benchmark()
+    end
+    for i=1, #Bench.Results do
+        ofs.Text(Bench.Results[i])
+    end
+end
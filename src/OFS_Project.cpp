@@ -4,6 +4,7 @@
 #include "OFS_DynamicFontAtlas.h"
 #include "OFS_BlockingTask.h"
 #include "OFS_EventSystem.h"
+#include "OFS_JobSystem.h"
 
 #include "subprocess.h"
 
@@ -25,6 +26,35 @@ static std::array<const char*, 4> AudioExtensions{
     ".wav",
 };
 
+// Saves and exports are encoded and written in the background.
+// They run one after another so that writes to the same file can't overtake each other.
+static OFS_JobHandle LastWriteJob;
+
+template<typename SerializeFn>
+static void WriteFileInBackground(std::string path, SerializeFn&& serialize) noexcept
+{
+    OFS_JobDesc desc;
+    desc.Name = FMT("%s: %s", TR(SAVE), Util::PathFromString(path).filename().u8string().c_str());
+    desc.Priority = OFS_ThreadPool::Priority::High;
+    desc.Cancellable = false;
+    desc.OrderOnly = true;
+    desc.DependsOn.emplace_back(LastWriteJob);
+    desc.Work = [path = std::move(path), serialize = std::forward<SerializeFn>(serialize)](OFS_Job&) mutable noexcept {
+        auto buffer = serialize();
+        if (Util::WriteFile(path.c_str(), buffer.data(), buffer.size()) != buffer.size()) {
+            LOGF_ERROR("Failed to write \"%s\"", path.c_str());
+            return false;
+        }
+        return true;
+    };
+    LastWriteJob = OFS_JobSystem::Submit(std::move(desc));
+}
+
+void OFS_Project::AfterPendingWrites(std::function<void()>&& fn) noexcept
+{
+    OFS_JobSystem::After(LastWriteJob, std::move(fn));
+}
+
 inline bool static HasMediaExtension(const std::string& pathStr) noexcept
 {
     auto path = Util::PathFromString(pathStr);
@@ -72,6 +102,7 @@ inline bool FindMedia(const std::string& pathStr, std::string* outMedia) noexcep
 OFS_Project::OFS_Project() noexcept
 {
     stateHandle = OFS_ProjectState<ProjectState>::Register(ProjectState::StateName);
+    chapterStateHandle = OFS_ProjectState<ChapterState>::Register(ChapterState::StateName);
     auto script = std::make_shared<Funscript>();
     RegisterScript(script);
     Funscripts.emplace_back(std::move(script));
@@ -103,14 +134,11 @@ void OFS_Project::loadNecessaryGlyphs() noexcept
 bool OFS_Project::Load(const std::string& path) noexcept
 {
     FUN_ASSERT(!valid, "Can't import if project is already loaded.");
+    FUN_ASSERT(!LastWriteJob || LastWriteJob->IsFinished(), "the file may still be getting written, use AfterPendingWrites");
 #if 1
     std::vector<uint8_t> projectBin;
     if (Util::ReadFile(path.c_str(), projectBin) > 0) {
-        bool succ;
-        auto projectState = Util::ParseCBOR(projectBin, &succ);
-        if (succ) {
-            valid = OFS_StateManager::Get()->DeserializeProjectAll(projectState, true);
-        }
+        valid = OFS_StateManager::Get()->DeserializeProjectAll(projectBin);
     }
 #else
     std::string projectJson = Util::ReadFileString(path.c_str());
@@ -130,6 +158,8 @@ bool OFS_Project::Load(const std::string& path) noexcept
     if (valid) {
         auto& projectState = State();
         OFS_Binary::Deserialize(projectState.binaryFunscriptData, *this);
+        // only needed while saving and loading, the scripts hold the actual data
+        projectState.binaryFunscriptData = ByteBuffer();
 
         // Register all deserialized scripts
         for (auto& script : Funscripts) {
@@ -225,7 +255,7 @@ bool OFS_Project::AddFunscript(const std::string& path) noexcept
 			{
 				auto script = std::make_shared<Funscript>();
 				auto metadata = Funscript::Metadata();
-				if (script->Deserialize(json, &metadata, isFirstFunscript)) {
+				if (script->Deserialize(json, &metadata, isFirstFunscript ? &Chapters() : nullptr)) {
 					RegisterScript(script);
 					script = Funscripts.emplace_back(std::move(script));
 					script->UpdateRelativePath(MakePathRelative(path));
@@ -237,58 +267,21 @@ bool OFS_Project::AddFunscript(const std::string& path) noexcept
 					loadedScript = true;
 				}
 			}
-			// Load each named channel (2.0)
-			if (hasChannels) {
-				for (auto it = json["channels"].begin(); it != json["channels"].end(); ++it) {
-					const std::string channelName = it.key();
-					const nlohmann::json& channelObj = it.value();
-					if (!channelObj.is_object()) continue;
-					if (!channelObj.contains("actions") || !channelObj["actions"].is_array()) continue;
-					auto scriptCh = std::make_shared<Funscript>();
-					if (scriptCh->Deserialize(channelObj, nullptr, false)) {
-						RegisterScript(scriptCh);
-						scriptCh = Funscripts.emplace_back(std::move(scriptCh));
-						// Synthesize a per-channel relative path for UI/export compatibility
-						auto base = Util::PathFromString(path);
-						auto baseNoExt = base;
-						baseNoExt.replace_extension("");
-						auto channelPath = (baseNoExt.u8string() + "." + channelName + ".funscript");
-						scriptCh->UpdateRelativePath(MakePathRelative(channelPath));
-						loadedScript = true;
-					}
-				}
-			}
-			// Load 1.1 axes
-			if (hasAxes) {
-				auto mapAxisIdToName = [](const std::string& id) -> std::string {
-					if (id == "L0") return "stroke";
-					if (id == "L1") return "surge";
-					if (id == "L2") return "sway";
-					if (id == "R0") return "twist";
-					if (id == "R1") return "roll";
-					if (id == "R2") return "pitch";
-					if (id == "A1") return "suck";
-					return id; // fallback
-				};
-				for (auto& axisObj : json["axes"]) {
-					if (!axisObj.is_object()) continue;
-					if (!axisObj.contains("actions") || !axisObj["actions"].is_array()) continue;
-					std::string axisId = axisObj.contains("id") && axisObj["id"].is_string() ? axisObj["id"].get<std::string>() : std::string{};
-					std::string channelName = !axisId.empty() ? mapAxisIdToName(axisId) : std::string{"axis"};
-					auto scriptAxis = std::make_shared<Funscript>();
-					if (scriptAxis->Deserialize(axisObj, nullptr, false)) {
-						RegisterScript(scriptAxis);
-						scriptAxis = Funscripts.emplace_back(std::move(scriptAxis));
-						// Synthesize a per-axis relative path
-						auto base = Util::PathFromString(path);
-						auto baseNoExt = base;
-						baseNoExt.replace_extension("");
-						auto axisPath = (baseNoExt.u8string() + "." + channelName + ".funscript");
-						scriptAxis->UpdateRelativePath(MakePathRelative(axisPath));
-						loadedScript = true;
-					}
+			// Load each named channel (2.0) and axis (1.1)
+			Funscript::ForEachChannel(json, [&](const std::string& channelName, const nlohmann::json& channelObj) {
+				auto scriptCh = std::make_shared<Funscript>();
+				if (scriptCh->Deserialize(channelObj, nullptr, nullptr)) {
+					RegisterScript(scriptCh);
+					scriptCh = Funscripts.emplace_back(std::move(scriptCh));
+					// Synthesize a per-channel relative path for UI/export compatibility
+					auto base = Util::PathFromString(path);
+					auto baseNoExt = base;
+					baseNoExt.replace_extension("");
+					auto channelPath = (baseNoExt.u8string() + "." + channelName + ".funscript");
+					scriptCh->UpdateRelativePath(MakePathRelative(channelPath));
+					loadedScript = true;
 				}
-			}
+			});
 			return loadedScript;
 		}
 	}
@@ -296,7 +289,7 @@ bool OFS_Project::AddFunscript(const std::string& path) noexcept
 	// Default 1.0 single-file path
 	auto script = std::make_shared<Funscript>();
 	auto metadata = Funscript::Metadata();
-	if (succ && script->Deserialize(json, &metadata, isFirstFunscript)) {
+	if (succ && script->Deserialize(json, &metadata, isFirstFunscript ? &Chapters() : nullptr)) {
 		// Add existing script to project
 		RegisterScript(script);
 		script = Funscripts.emplace_back(std::move(script));
@@ -338,9 +331,12 @@ void OFS_Project::Save(const std::string& path, bool clearUnsavedChanges) noexce
     }
 
 #if 1
-    auto projectState = OFS_StateManager::Get()->SerializeProjectAll(true);
-    auto projectBin = Util::SerializeCBOR(projectState);
-    Util::WriteFile(path.c_str(), projectBin.data(), projectBin.size());
+    ByteBuffer projectBin;
+    OFS_StateManager::Get()->SerializeProjectAll(projectBin);
+    State().binaryFunscriptData = ByteBuffer();
+    WriteFileInBackground(path, [projectBin = std::move(projectBin)]() mutable noexcept {
+        return std::move(projectBin);
+    });
 #else
     auto projectState = OFS_StateManager::Get()->SerializeProjectAll(false);
     auto projectJson = Util::SerializeJson(projectState, false);
@@ -387,8 +383,9 @@ void OFS_Project::ShowProjectWindow(bool* open) noexcept
 
         ImGui::Text("%s: %s", TR(MEDIA), projectState.relativeMediaPath.c_str());
 
-        Util::FormatTime(Util::FormatBuffer, sizeof(Util::FormatBuffer), projectState.activeTimer, true);
-        ImGui::Text("%s: %s", TR(TIME_SPENT), Util::FormatBuffer);
+        char timeBuf[16];
+        Util::FormatTime(timeBuf, sizeof(timeBuf), projectState.activeTimer, true);
+        ImGui::Text("%s: %s", TR(TIME_SPENT), timeBuf);
         ImGui::Separator();
 
         ImGui::Spacing();
@@ -419,7 +416,7 @@ void OFS_Project::ExportFunscripts() noexcept
     for (auto& script : Funscripts) {
         FUN_ASSERT(!script->RelativePath().empty(), "path is empty");
         if (!script->RelativePath().empty()) {
-            auto json = script->Serialize(state.metadata, true);
+            auto json = script->Serialize(state.metadata, &Chapters());
             script->ClearUnsavedEdits();
             // Reorder keys using ordered_json: version, metadata (ordered), actions
             nlohmann::ordered_json ordered;
@@ -466,8 +463,9 @@ void OFS_Project::ExportFunscripts() noexcept
                     }
                 }
             }
-            auto jsonText = ordered.dump(-1, ' ');
-            Util::WriteFile(MakePathAbsolute(script->RelativePath()).c_str(), jsonText.data(), jsonText.size());
+            WriteFileInBackground(MakePathAbsolute(script->RelativePath()), [ordered = std::move(ordered)]() noexcept {
+                return ordered.dump(-1, ' ');
+            });
         }
     }
 }
@@ -480,7 +478,7 @@ void OFS_Project::ExportFunscripts(const std::string& outputDir) noexcept
         if (!script->RelativePath().empty()) {
             auto filename = Util::PathFromString(script->RelativePath()).filename();
             auto outputPath = (Util::PathFromString(outputDir) / filename).u8string();
-            auto json = script->Serialize(state.metadata, true);
+            auto json = script->Serialize(state.metadata, &Chapters());
             script->ClearUnsavedEdits();
             // Reorder keys using ordered_json: version, metadata (ordered), actions
             nlohmann::ordered_json ordered;
@@ -523,8 +521,9 @@ void OFS_Project::ExportFunscripts(const std::string& outputDir) noexcept
                     }
                 }
             }
-            auto jsonText = ordered.dump(-1, ' ');
-            Util::WriteFile(outputPath.c_str(), jsonText.data(), jsonText.size());
+            WriteFileInBackground(outputPath, [ordered = std::move(ordered)]() noexcept {
+                return ordered.dump(-1, ' ');
+            });
         }
     }
 }
@@ -533,7 +532,7 @@ void OFS_Project::ExportFunscript(const std::string& outputPath, int32_t idx) no
 {
     FUN_ASSERT(idx >= 0 && idx < Funscripts.size(), "out of bounds");
     auto& state = State();
-    auto json = Funscripts[idx]->Serialize(state.metadata, true);
+    auto json = Funscripts[idx]->Serialize(state.metadata, &Chapters());
     Funscripts[idx]->ClearUnsavedEdits();
     // Using this function changes the default path
     Funscripts[idx]->UpdateRelativePath(MakePathRelative(outputPath));
@@ -578,8 +577,9 @@ void OFS_Project::ExportFunscript(const std::string& outputPath, int32_t idx) no
             }
         }
     }
-    auto jsonText = ordered.dump(-1, ' ');
-    Util::WriteFile(outputPath.c_str(), jsonText.data(), jsonText.size());
+    WriteFileInBackground(outputPath, [ordered = std::move(ordered)]() noexcept {
+        return ordered.dump(-1, ' ');
+    });
 }
 
 void OFS_Project::ExportFunscript2Quick() noexcept
@@ -598,7 +598,7 @@ void OFS_Project::ExportFunscript2Quick() noexcept
 	auto outPath = MakePathAbsolute(baseRel.u8string());
 
 	// Start from the primary axis as fully serialized 1.0 (keeps chapters/bookmarks)
-	nlohmann::json root = Funscripts[0]->Serialize(state.metadata, true);
+	nlohmann::json root = Funscripts[0]->Serialize(state.metadata, &Chapters());
 	root["version"] = "2.0";
 	// Channels for subsequent scripts using filename suffix as channel name if present
 	{
@@ -607,7 +607,7 @@ void OFS_Project::ExportFunscript2Quick() noexcept
 			auto& fs = Funscripts[i];
 			nlohmann::json chObj;
 			// Only include actions
-			Funscript::Serialize(chObj, fs->Data(), state.metadata, false);
+			Funscript::Serialize(chObj, fs->Data(), state.metadata, nullptr);
 			nlohmann::json actions = std::move(chObj["actions"]);
 			// Channel name derived from relative filename like name.roll.funscript -> "roll"
 			auto rel = Util::PathFromString(fs->RelativePath());
@@ -657,8 +657,9 @@ void OFS_Project::ExportFunscript2Quick() noexcept
             }
         }
     }
-    auto jsonText = ordered.dump(-1, ' ');
-	Util::WriteFile(outPath.c_str(), jsonText.data(), jsonText.size());
+    WriteFileInBackground(outPath, [ordered = std::move(ordered)]() noexcept {
+        return ordered.dump(-1, ' ');
+    });
 }
 
 void OFS_Project::ExportFunscript11Quick() noexcept
@@ -674,7 +675,7 @@ void OFS_Project::ExportFunscript11Quick() noexcept
 	auto outPath = MakePathAbsolute(baseRel.u8string());
 
 	// Start from the primary axis as fully serialized 1.0 (keeps chapters/bookmarks)
-	nlohmann::json root = Funscripts[0]->Serialize(state.metadata, true);
+	nlohmann::json root = Funscripts[0]->Serialize(state.metadata, &Chapters());
 	root["version"] = "1.1";
 	// axes array from subsequent scripts using id mapping inverse
 	{
@@ -692,7 +693,7 @@ void OFS_Project::ExportFunscript11Quick() noexcept
 		for (size_t i = 1; i < Funscripts.size(); ++i) {
 			auto& fs = Funscripts[i];
 			nlohmann::json chObj;
-			Funscript::Serialize(chObj, fs->Data(), state.metadata, false);
+			Funscript::Serialize(chObj, fs->Data(), state.metadata, nullptr);
 			nlohmann::json actions = std::move(chObj["actions"]);
 			// Derive channel name from filename suffix
 			auto rel = Util::PathFromString(fs->RelativePath());
@@ -741,8 +742,9 @@ void OFS_Project::ExportFunscript11Quick() noexcept
             }
         }
     }
-    auto jsonText = ordered.dump(-1, ' ');
-	Util::WriteFile(outPath.c_str(), jsonText.data(), jsonText.size());
+    WriteFileInBackground(outPath, [ordered = std::move(ordered)]() noexcept {
+        return ordered.dump(-1, ' ');
+    });
 }
 
 void OFS_Project::loadMultiAxis(const std::string& rootScript) noexcept
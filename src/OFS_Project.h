@@ -1,5 +1,6 @@
 #pragma once
 #include "state/ProjectState.h"
+#include "state/states/ChapterState.h"
 #include "Funscript.h"
 #include "OFS_Event.h"
 
@@ -8,6 +9,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <functional>
 
 class ProjectLoadedEvent: public OFS_Event<ProjectLoadedEvent> {
 public:
@@ -19,7 +21,7 @@ public:
 class OFS_Project {
 private:
     uint32_t stateHandle = 0xFFFF'FFFF;
-    uint32_t bookmarkStateHandle = 0xFFFF'FFFF;
+    uint32_t chapterStateHandle = 0xFFFF'FFFF;
 
     std::string lastPath;
 
@@ -49,6 +51,8 @@ public:
 
     std::vector<std::shared_ptr<Funscript>> Funscripts;
 
+    // Main thread, runs fn once saves still being written are on disk. Load has to go through this.
+    static void AfterPendingWrites(std::function<void()>&& fn) noexcept;
     bool Load(const std::string& path) noexcept;
     void Save(bool clearUnsavedChanges) noexcept { Save(lastPath, clearUnsavedChanges); }
     void Save(const std::string& path, bool clearUnsavedChanges) noexcept;
@@ -72,6 +76,7 @@ public:
     inline bool IsValid() const noexcept { return valid; }
     inline const std::string& NotValidError() const noexcept { return notValidError; }
     inline ProjectState& State() const noexcept { return ProjectState::State(stateHandle); }
+    inline ChapterState& Chapters() const noexcept { return ChapterState::State(chapterStateHandle); }
 
     // Script registry methods for safe ID-based event handling
     uint32_t RegisterScript(std::shared_ptr<Funscript> script) noexcept;
@@ -169,6 +169,9 @@ void ScriptingMode::AddEditAction(FunscriptAction action) noexcept
         auto& state = ScriptingModeState::State(stateHandle);
         action.atS += state.actionInsertDelayMs / 1000.f;
     }
+    else {
+        action.atS = overlayImpl->snapTime(action.atS);
+    }
     Mode()->AddEditAction(action);
 }
 
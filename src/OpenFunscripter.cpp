@@ -7,6 +7,11 @@
 #include "OFS_DownloadFfmpeg.h"
 #include "OFS_Shader.h"
 #include "OFS_MpvLoader.h"
+#include "OFS_ThreadPool.h"
+#include "OFS_JobSystem.h"
+#include "OFS_FrameArena.h"
+#include "OFS_Redraw.h"
+#include "OFS_FrameConsumers.h"
 #include "OFS_Localization.h"
 
 #include "state/OpenFunscripterState.h"
@@ -97,8 +102,8 @@ bool OpenFunscripter::imguiSetup() noexcept
 
 static void SaveState() noexcept
 {
-    auto stateJson = OFS_StateManager::Get()->SerializeAppAll(true);
-    auto stateBin = Util::SerializeCBOR(stateJson);
+    ByteBuffer stateBin;
+    OFS_StateManager::Get()->SerializeAppAll(stateBin);
     auto statePath = Util::Prefpath("state.ofs");
     Util::WriteFile(statePath.c_str(), stateBin.data(), stateBin.size());
 }
@@ -117,6 +122,7 @@ bool OpenFunscripter::Init(int argc, char* argv[])
 {
     OFS_FileLogger::Init();
     Util::InMainThread();
+    OFS_FrameArena::Init();
     Util::InitRandom();
 
     FUN_ASSERT(!ptr, "there can only be one instance");
@@ -131,11 +137,7 @@ bool OpenFunscripter::Init(int argc, char* argv[])
         std::vector<uint8_t> fileData;
         auto statePath = Util::Prefpath("state.ofs");
         if (Util::ReadFile(statePath.c_str(), fileData) > 0) {
-            bool succ;
-            auto cbor = Util::ParseCBOR(fileData, &succ);
-            if (succ) {
-                stateMgr->DeserializeAppAll(cbor, true);
-            }
+            stateMgr->DeserializeAppAll(fileData);
         }
     }
 
@@ -205,6 +207,9 @@ bool OpenFunscripter::Init(int argc, char* argv[])
     preferences->SetTheme(static_cast<OFS_Theme>(prefState.currentTheme));
 
     EV::Init();
+    OFS_Redraw::Init();
+    OFS_ThreadPool::Init();
+    OFS_FrameConsumers::Init();
     LoadedProject = std::make_unique<OFS_Project>();
 
     player = std::make_unique<OFS_Videoplayer>(VideoplayerType::Main);
@@ -255,6 +260,8 @@ bool OpenFunscripter::Init(int argc, char* argv[])
         FunscriptActionClickedEvent::HandleEvent(EVENT_SYSTEM_BIND(this, &OpenFunscripter::ScriptTimelineActionClicked)));
     EV::Queue().appendListener(FunscriptActionShouldCreateEvent::EventType,
         FunscriptActionShouldCreateEvent::HandleEvent(EVENT_SYSTEM_BIND(this, &OpenFunscripter::ScriptTimelineActionCreated)));
+    EV::Queue().appendListener(MotionTrackerActionsEvent::EventType,
+        MotionTrackerActionsEvent::HandleEvent(EVENT_SYSTEM_BIND(this, &OpenFunscripter::MotionTrackerActions)));
     EV::Queue().appendListener(ShouldSetTimeEvent::EventType,
         ShouldSetTimeEvent::HandleEvent(EVENT_SYSTEM_BIND(this, &OpenFunscripter::ScriptTimelineDoubleClick)));
     EV::Queue().appendListener(FunscriptShouldSelectTimeEvent::EventType,
@@ -263,6 +270,8 @@ bool OpenFunscripter::Init(int argc, char* argv[])
         ShouldChangeActiveScriptEvent::HandleEvent(EVENT_SYSTEM_BIND(this, &OpenFunscripter::ScriptTimelineActiveScriptChanged)));
     EV::Queue().appendListener(ExportClipForChapter::EventType,
         ExportClipForChapter::HandleEvent(EVENT_SYSTEM_BIND(this, &OpenFunscripter::ExportClip)));
+    EV::Queue().appendListener(ExportClipsForAllChapters::EventType,
+        ExportClipsForAllChapters::HandleEvent(EVENT_SYSTEM_BIND(this, &OpenFunscripter::ExportAllClips)));
 
     specialFunctions = std::make_unique<SpecialFunctionsWindow>();
     controllerInput = std::make_unique<ControllerInput>();
@@ -1305,7 +1314,6 @@ void OpenFunscripter::render() noexcept
         SDL_GL_MakeCurrent(backup_current_window, backup_current_context);
     }
     glFlush();
-    glFinish();
 }
 
 void OpenFunscripter::processEvents() noexcept
@@ -1315,6 +1323,9 @@ void OpenFunscripter::processEvents() noexcept
     auto& event = wrappedEvent->sdl;
     bool IsExiting = false;
     while (SDL_PollEvent(&event)) {
+        // only there to end OFS_Redraw::Wait
+        if (OFS_Redraw::IsWakeEvent(event)) continue;
+        OFS_Redraw::Request();
         ImGui_ImplSDL2_ProcessEvent(&event);
         switch (event.type) {
             case SDL_QUIT: {
@@ -1367,25 +1378,31 @@ void OpenFunscripter::ExportClip(const ExportClipForChapter* ev) noexcept
 {
     const auto& ofsState = OpenFunscripterState::State(stateHandle);
     Util::OpenDirectoryDialog(TR(CHOOSE_OUTPUT_DIR), ofsState.lastPath,
-        [chapter = ev->chapter](auto& result) {
+        [this, chapter = ev->chapter](auto& result) {
             if (!result.files.empty()) {
-                OFS_ChapterManager::ExportClip(chapter, result.files[0]);
+                const auto& prefState = PreferenceState::State(preferences->StateHandle());
+                chapterMgr->ExportClips({ chapter }, result.files[0], prefState.clipExportConcurrency);
             }
         });
 }
 
-void OpenFunscripter::FunscriptChanged(const FunscriptActionsChangedEvent* ev) noexcept
+void OpenFunscripter::ExportAllClips(const ExportClipsForAllChapters* ev) noexcept
 {
-    // Use ID-based lookup to find the script index
-    auto script = LoadedProject->GetScriptById(ev->scriptId);
-    if (script) {
-        for (int i = 0, size = LoadedFunscripts().size(); i < size; i += 1) {
-            if (LoadedFunscripts()[i] == script) {
-                extensions->ScriptChanged(i);
-                break;
+    const auto& ofsState = OpenFunscripterState::State(stateHandle);
+    Util::OpenDirectoryDialog(TR(CHOOSE_OUTPUT_DIR), ofsState.lastPath,
+        [this](auto& result) {
+            if (!result.files.empty()) {
+                // copied again, the chapters could have changed while the dialog was open
+                const auto& prefState = PreferenceState::State(preferences->StateHandle());
+                chapterMgr->ExportClips(chapterMgr->State().chapters, result.files[0], prefState.clipExportConcurrency);
             }
-        }
-    }
+        });
+}
+
+void OpenFunscripter::FunscriptChanged(const FunscriptActionsChangedEvent* ev) noexcept
+{
+    // coalesced and resolved to a script index once the debounce interval passed
+    extensions->QueueScriptChange(ev->scriptId, ev->dirtyFrom, ev->dirtyTo, ev->version);
 
     Status = Status | OFS_Status::OFS_GradientNeedsUpdate;
 }
@@ -1410,6 +1427,14 @@ void OpenFunscripter::ScriptTimelineActionCreated(const FunscriptActionShouldCre
     }
 }
 
+void OpenFunscripter::MotionTrackerActions(const MotionTrackerActionsEvent* ev) noexcept
+{
+    if (ev->actions.empty()) return;
+    auto& script = ActiveFunscript();
+    undoSystem->Snapshot(StateType::GENERATE_ACTIONS, script);
+    script->AddMultipleActions(ev->actions);
+}
+
 void OpenFunscripter::ScriptTimelineActionMoved(const FunscriptActionShouldMoveEvent* ev) noexcept
 {
     if (auto script = ev->script.lock()) {
@@ -1479,7 +1504,11 @@ void OpenFunscripter::update() noexcept
         logged = true;
     }
     player->Update(delta);
-    playerControls.videoPreview->Update(delta);
+    if (!player->IsPaused()) {
+        OFS_Redraw::Request(1);
+    }
+    playerControls.Update(delta);
+    OFS_FrameConsumers::Get()->Update();
     ControllerInput::UpdateControllers();
     scripting->Update();
     scriptTimeline.Update();
@@ -1630,6 +1659,7 @@ void OpenFunscripter::Step() noexcept
             OFS_FileLogger::DrawLogWindow(&ofsState.showDebugLog);
             keys->RenderKeybindingWindow();
             chapterMgr->ShowWindow(&ofsState.showChapterManager);
+            OFS_JobSystem::ShowWindow(&ofsState.showJobs);
 
             if (preferences->ShowPreferenceWindow()) {}
 
@@ -1696,6 +1726,8 @@ void OpenFunscripter::Step() noexcept
             if (DebugMetrics) {
                 ImGui::ShowMetricsWindow(&DebugMetrics);
             }
+            EV::ShowDebugWindow(&DebugEvents);
+            OFS_FrameProfiler::ShowWindow(&DebugFrameProfiler);
 
             playerWindow->DrawVideoPlayer(NULL, &ofsState.showVideo);
             processingWindow->DrawProcessingVideo(&ofsState.showProcessingVideo);
@@ -1705,9 +1737,14 @@ void OpenFunscripter::Step() noexcept
     }
 
     OFS_FileLogger::Flush();
+    {
+        OFS_PROFILE("Swap");
+        SDL_GL_SwapWindow(window);
+        player->NotifySwap();
+    }
     OFS_ENDPROFILING();
-    SDL_GL_SwapWindow(window);
-    player->NotifySwap();
+    // nothing allocated during the frame is referenced past this
+    OFS_FrameArena::EndFrame();
 }
 
 int OpenFunscripter::Run() noexcept
@@ -1716,32 +1753,26 @@ int OpenFunscripter::Run() noexcept
     setupDefaultLayout(false);
     render();
 
+    // without any requests a frame still gets rendered this often, timers like autosave rely on it
+    constexpr uint32_t WaitTimeoutMs = 250;
+    constexpr uint32_t IdleWaitTimeoutMs = 1000;
+
     const uint64_t PerfFreq = SDL_GetPerformanceFrequency();
     while (!(Status & OFS_Status::OFS_ShouldExit)) {
-
+        OFS_Redraw::BeginFrame();
         uint64_t FrameStart = SDL_GetPerformanceCounter();
         Step();
-        uint64_t FrameEnd = SDL_GetPerformanceCounter();
 
         const auto& prefState = PreferenceState::State(preferences->StateHandle());
-        float frameLimit = IdleMode ? 10.f : (float)prefState.framerateLimit;
-        const float minFrameTime = (float)PerfFreq / frameLimit;
-
-        int32_t sleepMs = ((minFrameTime - (float)(FrameEnd - FrameStart)) / minFrameTime) * (1000.f / frameLimit);
-        if (!IdleMode) sleepMs -= 1;
-        if (sleepMs > 0) SDL_Delay(sleepMs);
-
         if (!prefState.vsync) {
-            FrameEnd = SDL_GetPerformanceCounter();
-            while ((FrameEnd - FrameStart) < minFrameTime) {
-                OFS_PAUSE_INTRIN();
-                FrameEnd = SDL_GetPerformanceCounter();
-            }
+            // the swap doesn't limit the framerate
+            OFS_Redraw::SleepUntil(FrameStart + PerfFreq / prefState.framerateLimit);
         }
 
         if (SDL_GetTicks() - IdleTimer > 3000) {
             setIdle(true);
         }
+        OFS_Redraw::Wait(IdleMode ? IdleWaitTimeoutMs : WaitTimeoutMs);
     }
     return 0;
 }
@@ -1750,6 +1781,12 @@ void OpenFunscripter::Shutdown() noexcept
 {
     SaveState();
 
+    // running saves have to finish
+    OFS_JobSystem::Shutdown();
+    // pool first, queued tasks reference the frame consumers
+    OFS_ThreadPool::Shutdown();
+    OFS_FrameConsumers::Shutdown();
+
     OFS_DynFontAtlas::Shutdown();
     OFS_Translator::Shutdown();
 
@@ -1759,12 +1796,14 @@ void OpenFunscripter::Shutdown() noexcept
 
     // These players need to be freed before unloading mpv
     // NOTE: Do not free the GL context before these players
+    playerControls.CloseVideo(); // releases the thumbnail atlas texture
     player.reset();
     playerControls.videoPreview.reset();
     OFS_MpvLoader::Unload();
     OFS_FileLogger::Shutdown();
     webApi->Shutdown();
     controllerInput->Shutdown();
+    OFS_FrameArena::Shutdown();
 
     SDL_GL_DeleteContext(glContext);
     SDL_DestroyWindow(window);
@@ -1803,31 +1842,37 @@ void OpenFunscripter::openFile(const std::string& file) noexcept
 
     closeWithoutSavingDialog(
         [this, file]() noexcept {
-            auto filePath = Util::PathFromString(file);
-            auto fileExtension = filePath.extension().u8string();
-            LoadedProject = std::make_unique<OFS_Project>();
-            OFS_StateManager::Get()->ClearProjectAll();
+            // the project may have just been saved, its file is written in the background
+            OFS_Project::AfterPendingWrites([this, file]() noexcept { loadFile(file); });
+        });
+}
 
-            if (fileExtension == OFS_Project::Extension) {
-                // It's a project
-                LoadedProject->Load(file);
-            }
-            else if (fileExtension == Funscript::Extension) {
-                // It's a funscript it should be imported into a new project
-                LoadedProject->ImportFromFunscript(file);
-            }
-            else {
-                // Assume it's some kind of media file
-                LoadedProject->ImportFromMedia(file);
-            }
+void OpenFunscripter::loadFile(const std::string& file) noexcept
+{
+    auto filePath = Util::PathFromString(file);
+    auto fileExtension = filePath.extension().u8string();
+    LoadedProject = std::make_unique<OFS_Project>();
+    OFS_StateManager::Get()->ClearProjectAll();
 
-            if (LoadedProject->IsValid()) {
-                initProject();
-            }
-            else {
-                Util::MessageBoxAlert("Failed to open file.", LoadedProject->NotValidError());
-            }
-        });
+    if (fileExtension == OFS_Project::Extension) {
+        // It's a project
+        LoadedProject->Load(file);
+    }
+    else if (fileExtension == Funscript::Extension) {
+        // It's a funscript it should be imported into a new project
+        LoadedProject->ImportFromFunscript(file);
+    }
+    else {
+        // Assume it's some kind of media file
+        LoadedProject->ImportFromMedia(file);
+    }
+
+    if (LoadedProject->IsValid()) {
+        initProject();
+    }
+    else {
+        Util::MessageBoxAlert("Failed to open file.", LoadedProject->NotValidError());
+    }
 }
 
 void OpenFunscripter::initProject() noexcept
@@ -1919,7 +1964,7 @@ bool OpenFunscripter::closeProject(bool closeWithUnsavedChanges) noexcept
         UpdateNewActiveScript(0);
         LoadedProject = std::make_unique<OFS_Project>();
         player->CloseVideo();
-        playerControls.videoPreview->CloseVideo();
+        playerControls.CloseVideo();
         updateTitle();
     }
     return true;
@@ -2519,6 +2564,7 @@ void OpenFunscripter::ShowMainMenuBar() noexcept
             if (ImGui::MenuItem(TR(SPECIAL_FUNCTIONS), NULL, &ofsState.showSpecialFunctions)) {}
             if (ImGui::MenuItem(TR(WEBSOCKET_API), NULL, &ofsState.showWsApi)) {}
             if (ImGui::MenuItem(TR(CHAPTERS), NULL, &ofsState.showChapterManager)) {}
+            if (ImGui::MenuItem(TR(JOBS), NULL, &ofsState.showJobs)) {}
 
 
             ImGui::Separator();
@@ -2572,6 +2618,24 @@ void OpenFunscripter::ShowMainMenuBar() noexcept
             if (ImGui::BeginMenu(TR(DEBUG))) {
                 if (ImGui::MenuItem(TR(METRICS), NULL, &DebugMetrics)) {}
                 if (ImGui::MenuItem(TR(LOG_OUTPUT), NULL, &ofsState.showDebugLog)) {}
+                {
+                    // ordered by OFS_LogSeverity
+                    constexpr const char* LogLevels[] = { "Debug", "Info", "Warn", "Error" };
+                    int severity = SDL_AtomicGet(&OFS_FileLogger::MinSeverity);
+                    if (ImGui::Combo("Log level", &severity, LogLevels, IM_ARRAYSIZE(LogLevels))) {
+                        SDL_AtomicSet(&OFS_FileLogger::MinSeverity, severity);
+                    }
+                }
+                if (ImGui::MenuItem("Events", NULL, &DebugEvents)) {}
+                if (ImGui::MenuItem("Frame profiler", NULL, &DebugFrameProfiler)) {}
+                auto& eventStats = EV::LastFrameStats();
+                ImGui::TextDisabled("Events last frame: %u allocated, %u from the heap", eventStats.allocations, eventStats.heapAllocations);
+                auto& arenaStats = OFS_FrameArena::LastFrameStats();
+#ifndef NDEBUG
+                ImGui::TextDisabled("Heap allocations last frame: %u", arenaStats.heapAllocations);
+#endif
+                ImGui::TextDisabled("Frame arena last frame: %u allocations, %s, %u overflowed",
+                    arenaStats.allocations, Util::FormatBytes(arenaStats.bytes), arenaStats.overflows);
 #ifndef NDEBUG
                 if (ImGui::MenuItem("ImGui Demo", NULL, &DebugDemo)) {}
 #endif
@@ -2605,6 +2669,9 @@ void OpenFunscripter::ShowMainMenuBar() noexcept
             if (ImGui::MenuItem(TR(DEV_MODE), NULL, &OFS_LuaExtensions::DevMode)) {}
             OFS::Tooltip(TR(DEV_MODE_TOOLTIP));
             if (ImGui::MenuItem(TR(SHOW_LOGS), NULL, &OFS_LuaExtensions::ShowLogs)) {}
+            if (ImGui::MenuItem(TR(SHOW_STATS), NULL, &OFS_LuaExtensions::ShowStats)) {}
+            if (ImGui::SliderInt(TR(SCRIPT_CHANGE_DEBOUNCE), &OFS_LuaExtensions::ScriptChangeDebounceMs, 0, 1000, "%d ms")) {}
+            OFS::Tooltip(TR(SCRIPT_CHANGE_DEBOUNCE_TOOLTIP));
             if (ImGui::MenuItem(TR(EXTENSION_DIR))) {
                 Util::OpenFileExplorer(Util::Prefpath(OFS_LuaExtensions::ExtensionDir));
             }
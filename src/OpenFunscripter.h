@@ -21,6 +21,7 @@
 #include "OFS_Videoplayer.h"
 #include "OFS_VideoplayerWindow.h"
 #include "OFS_ProcessingVideoWindow.h"
+#include "OFS_MotionTracker.h"
 #include "OFS_WebsocketApi.h"
 #include "OFS_ChapterManager.h"
 
@@ -48,6 +49,8 @@ private:
     bool DebugDemo = false;
 #endif
     bool DebugMetrics = false;
+    bool DebugEvents = false;
+    bool DebugFrameProfiler = false;
     bool ShowAbout = false;
     bool IdleMode = false;
     uint32_t IdleTimer = 0;
@@ -76,6 +79,7 @@ private:
     void processEvents() noexcept;
 
     void ExportClip(const class ExportClipForChapter* ev) noexcept;
+    void ExportAllClips(const class ExportClipsForAllChapters* ev) noexcept;
 
     void FunscriptChanged(const FunscriptActionsChangedEvent* ev) noexcept;
     void DragNDrop(const OFS_SDL_Event* ev) noexcept;
@@ -93,6 +97,8 @@ private:
     void ScriptTimelineSelectTime(const FunscriptShouldSelectTimeEvent* ev) noexcept;
     void ScriptTimelineActiveScriptChanged(const ShouldChangeActiveScriptEvent* ev) noexcept;
 
+    void MotionTrackerActions(const MotionTrackerActionsEvent* ev) noexcept;
+
     void selectTopPoints() noexcept;
     void selectMiddlePoints() noexcept;
     void selectBottomPoints() noexcept;
@@ -121,6 +127,8 @@ private:
     void saveActiveScriptAs();
 
     void openFile(const std::string& file) noexcept;
+    // openFile once pending saves are written
+    void loadFile(const std::string& file) noexcept;
     void initProject() noexcept;
     bool closeProject(bool closeWithUnsavedChanges) noexcept;
 
@@ -9,6 +9,8 @@
 #include "imgui.h"
 #include "imgui_stdlib.h"
 
+#include <algorithm>
+
 OFS_ChapterManager::OFS_ChapterManager() noexcept
 {
     stateHandle = OFS_ProjectState<ChapterState>::Register(ChapterState::StateName);
@@ -82,83 +84,259 @@ void OFS_ChapterManager::ShowWindow(bool* open) noexcept
         ImGui::EndTable();
     }
 
+    ImGui::Separator();
+    if (!exportBatches.empty()) {
+        int finished = 0;
+        int total = 0;
+        float progress = 0.f;
+        for (auto& batch : exportBatches) {
+            for (auto& clip : batch->clips) {
+                if (clip.scripts->IsFinished() && clip.media->IsFinished()) {
+                    finished += 1;
+                    progress += 1.f;
+                }
+                else if (clip.media->GetState() == OFS_Job::State::Running) {
+                    progress += Util::Max(clip.media->Progress(), 0.f);
+                }
+            }
+            total += (int)batch->clips.size();
+        }
+        ImGui::ProgressBar(progress / total, ImVec2(-1.f, 0.f), FMT("%s %d/%d", TR(EXPORTING_CLIPS), finished, total));
+        if (ImGui::Button(TR(CANCEL), ImVec2(-1.f, 0.f))) {
+            cancelExport();
+        }
+    }
+    else if (!chapterState.chapters.empty()) {
+        if (ImGui::Button(TR(EXPORT_ALL_CLIPS), ImVec2(-1.f, 0.f))) {
+            EV::Enqueue<ExportClipsForAllChapters>();
+        }
+    }
+
     ImGui::End();
 }
 
-bool OFS_ChapterManager::ExportClip(const Chapter& chapter, const std::string& outputDirStr) noexcept
+static const char* JobStateName(const OFS_JobHandle& job) noexcept
 {
-    auto app = OpenFunscripter::ptr;
-    char startTimeChar[16];
-    char endTimeChar[16];
-    stbsp_snprintf(startTimeChar, sizeof(startTimeChar), "%f", chapter.startTime);
-    stbsp_snprintf(endTimeChar, sizeof(endTimeChar), "%f", chapter.endTime);
+    switch (job->GetState()) {
+        case OFS_Job::State::Done: return "done";
+        case OFS_Job::State::Failed: return "failed";
+        case OFS_Job::State::Cancelled: return "cancelled";
+        default: return "unfinished";
+    }
+}
 
-    
+void OFS_ChapterManager::ExportClips(const std::vector<Chapter>& chapters, const std::string& outputDirStr, int ffmpegConcurrency) noexcept
+{
+    if (chapters.empty()) return;
+    auto app = OpenFunscripter::ptr;
     auto outputDir = Util::PathFromString(outputDirStr);
     auto mediaPath = Util::PathFromString(app->player->VideoPath());
+    auto mediaPathStr = mediaPath.u8string();
 
-    auto& projectState = app->LoadedProject->State();
-
-    for(auto& script : app->LoadedFunscripts())
+    // The jobs only see copies, the scripts can be edited while exporting.
+    struct ScriptSnapshot
     {
-        auto scriptOutputPath = (outputDir / (chapter.name + "_" + script->Title()));
-        scriptOutputPath.replace_extension(".funscript");
-        auto scriptOutputPathStr = scriptOutputPath.u8string();
-
-        auto clippedScript = Funscript();
-        auto slice = script->GetSelection(chapter.startTime, chapter.endTime);
-        clippedScript.SetActions(slice);
-        clippedScript.AddEditAction(FunscriptAction(chapter.startTime, script->GetPositionAtTime(chapter.startTime)), 0.001f);
-        clippedScript.AddEditAction(FunscriptAction(chapter.endTime, script->GetPositionAtTime(chapter.endTime)), 0.001f);
-        clippedScript.SelectAll();
-        clippedScript.MoveSelectionTime(-chapter.startTime, 0.f);
-
-        // FIXME: chapters and bookmarks are not included
-        auto funscriptJson = clippedScript.Serialize(projectState.metadata, false);
-        auto funscriptText = Util::SerializeJson(funscriptJson);
-        Util::WriteFile(scriptOutputPathStr.c_str(), funscriptText.data(), funscriptText.size());
+        std::string title;
+        Funscript script;
+    };
+    auto scripts = std::make_shared<std::vector<ScriptSnapshot>>(app->LoadedFunscripts().size());
+    for (size_t i = 0; i < scripts->size(); i += 1) {
+        auto& script = app->LoadedFunscripts()[i];
+        (*scripts)[i].title = script->Title();
+        (*scripts)[i].script.SetActions(script->Data().Actions);
     }
+    auto metadata = std::make_shared<const Funscript::Metadata>(app->LoadedProject->State().metadata);
 
-    auto clippedMedia = Util::PathFromString("");
-    clippedMedia.replace_filename(chapter.name + "_" + mediaPath.filename().u8string());
-    clippedMedia.replace_extension(mediaPath.extension());
-    
-    auto videoOutputPath = outputDir / clippedMedia;
-    auto videoOutputString = videoOutputPath.u8string();
-    
-    auto ffmpegPath = Util::FfmpegPath().u8string();
-    auto mediaPathStr = mediaPath.u8string();
-
-    std::array<const char*, 17> args = {
-        ffmpegPath.c_str(),
-        "-y",
-        "-ss", startTimeChar,
-        "-to", endTimeChar,
-        "-i", mediaPathStr.c_str(),
-        "-vcodec", "copy",
-        "-acodec", "copy",
-        videoOutputString.c_str(),
-        nullptr
-    };
+    // ffmpeg jobs form this many chains, each one waits for the previous one in its chain.
+    // They run on the process lane, one of its threads is kept for frame indexing, thumbnails and the waveform.
+    ffmpegConcurrency = Util::Clamp(ffmpegConcurrency, 1, OFS_JobSystem::ProcessLaneThreads - 1);
 
-    struct subprocess_s proc;
-    if (subprocess_create(args.data(), subprocess_option_no_window, &proc) != 0) {
-        return false;
+    // the chains continue after the ones of the previous batch, the total stays bounded
+    std::vector<OFS_JobHandle> previousMedia;
+    if (!exportBatches.empty()) {
+        auto& previous = *exportBatches.back();
+        int tail = Util::Min(previous.ffmpegConcurrency, (int)previous.clips.size());
+        for (int i = (int)previous.clips.size() - tail; i < (int)previous.clips.size(); i += 1) {
+            previousMedia.emplace_back(previous.clips[i].media);
+        }
     }
 
-    if (proc.stdout_file) {
-        fclose(proc.stdout_file);
-        proc.stdout_file = nullptr;
+    auto batch = std::make_shared<ClipExportBatch>();
+    batch->ffmpegConcurrency = ffmpegConcurrency;
+    batch->clips.reserve(chapters.size());
+    const int clipCount = (int)chapters.size();
+    for (int i = 0; i < clipCount; i += 1) {
+        auto& chapter = chapters[i];
+        ClipExport clip;
+        auto jobName = std::string(FMT("%s %d/%d: %s", TR(EXPORT_CLIP), i + 1, clipCount, chapter.name.c_str()));
+
+        OFS_JobDesc scriptsDesc;
+        scriptsDesc.Name = jobName + " (.funscript)";
+        scriptsDesc.Work = [scripts, metadata, outputDir, chapter](OFS_Job& job) noexcept {
+            bool success = true;
+            for (int s = 0, count = (int)scripts->size(); s < count && !job.IsCancelled(); s += 1) {
+                auto& source = (*scripts)[s];
+                auto scriptOutputPath = (outputDir / (chapter.name + "_" + source.title));
+                scriptOutputPath.replace_extension(".funscript");
+
+                auto clippedScript = Funscript();
+                clippedScript.SetActions(source.script.GetSelection(chapter.startTime, chapter.endTime));
+                clippedScript.AddEditAction(FunscriptAction(chapter.startTime, source.script.GetPositionAtTime(chapter.startTime)), 0.001f);
+                clippedScript.AddEditAction(FunscriptAction(chapter.endTime, source.script.GetPositionAtTime(chapter.endTime)), 0.001f);
+                clippedScript.SelectAll();
+                clippedScript.MoveSelectionTime(-chapter.startTime, 0.f);
+
+                // FIXME: chapters and bookmarks are not included
+                auto funscriptText = Util::SerializeJson(clippedScript.Serialize(*metadata, nullptr));
+                auto scriptOutputPathStr = scriptOutputPath.u8string();
+                if (Util::WriteFile(scriptOutputPathStr.c_str(), funscriptText.data(), funscriptText.size()) != funscriptText.size()) {
+                    LOGF_ERROR("Failed to write \"%s\"", scriptOutputPathStr.c_str());
+                    success = false;
+                }
+                job.SetProgress(s + 1, count);
+            }
+            return success;
+        };
+        clip.scripts = OFS_JobSystem::Submit(std::move(scriptsDesc));
+
+        auto clippedMedia = Util::PathFromString("");
+        clippedMedia.replace_filename(chapter.name + "_" + mediaPath.filename().u8string());
+        clippedMedia.replace_extension(mediaPath.extension());
+
+        OFS_JobDesc mediaDesc;
+        mediaDesc.Name = std::move(jobName);
+        mediaDesc.Lane = OFS_JobLane::Process;
+        // a failed or cancelled clip doesn't stop the rest of its chain
+        mediaDesc.OrderOnly = true;
+        if (i >= ffmpegConcurrency) {
+            mediaDesc.DependsOn.emplace_back(batch->clips[i - ffmpegConcurrency].media);
+        }
+        else if (!previousMedia.empty()) {
+            mediaDesc.DependsOn.emplace_back(previousMedia[i % previousMedia.size()]);
+        }
+        mediaDesc.Work = [mediaPathStr, startTime = chapter.startTime, endTime = chapter.endTime,
+            videoOutputString = (outputDir / clippedMedia).u8string()](OFS_Job& job) noexcept
+        {
+            char startTimeChar[16];
+            char endTimeChar[16];
+            stbsp_snprintf(startTimeChar, sizeof(startTimeChar), "%f", startTime);
+            stbsp_snprintf(endTimeChar, sizeof(endTimeChar), "%f", endTime);
+            auto ffmpegPath = Util::FfmpegPath().u8string();
+
+            std::array<const char*, 19> args = {
+                ffmpegPath.c_str(),
+                "-y",
+                "-loglevel", "error",
+                "-nostats",
+                "-progress", "pipe:1",
+                "-ss", startTimeChar,
+                "-to", endTimeChar,
+                "-i", mediaPathStr.c_str(),
+                "-vcodec", "copy",
+                "-acodec", "copy",
+                videoOutputString.c_str(),
+                nullptr
+            };
+
+            struct subprocess_s proc;
+            if (subprocess_create(args.data(), subprocess_option_no_window | subprocess_option_combined_stdout_stderr, &proc) != 0) {
+                LOGF_ERROR("Failed to start \"%s\"", ffmpegPath.c_str());
+                return false;
+            }
+
+            // -progress prints key=value blocks about twice a second
+            const int64_t durationUs = (int64_t)((endTime - startTime) * 1000000.0);
+            char line[256];
+            FILE* out = subprocess_stdout(&proc);
+            while (out && !job.IsCancelled() && fgets(line, sizeof(line), out)) {
+                if (strncmp(line, "out_time_us=", 12) == 0 && durationUs > 0) {
+                    int64_t timeUs = strtoll(line + 12, nullptr, 10);
+                    job.SetProgress((int)(Util::Clamp<int64_t>(timeUs, 0, durationUs) * 1000 / durationUs), 1000);
+                }
+                else if (strchr(line, '=') == nullptr) {
+                    line[strcspn(line, "\r\n")] = '\0';
+                    LOGF_WARN("ffmpeg: %s", line);
+                }
+            }
+
+            int returnCode = -1;
+            bool success = job.JoinProcess(&proc, &returnCode);
+            if (!success && !job.IsCancelled()) {
+                LOGF_ERROR("ffmpeg failed with code %d for \"%s\"", returnCode, videoOutputString.c_str());
+            }
+            return success;
+        };
+        clip.media = OFS_JobSystem::Submit(std::move(mediaDesc));
+        batch->clips.emplace_back(std::move(clip));
     }
 
-    if (proc.stderr_file) {
-        fclose(proc.stderr_file);
-        proc.stderr_file = nullptr;
+    struct ClipInfo
+    {
+        Chapter chapter;
+        OFS_JobHandle scripts;
+        OFS_JobHandle media;
+    };
+    std::vector<ClipInfo> clipInfos;
+    OFS_JobDesc summaryDesc;
+    summaryDesc.Name = FMT("%s (%d)", TR(EXPORT_CLIP), clipCount);
+    summaryDesc.Cancellable = false;
+    summaryDesc.OrderOnly = true;
+    for (int i = 0; i < clipCount; i += 1) {
+        auto& clip = batch->clips[i];
+        summaryDesc.DependsOn.emplace_back(clip.scripts);
+        summaryDesc.DependsOn.emplace_back(clip.media);
+        clipInfos.emplace_back(ClipInfo{ chapters[i], clip.scripts, clip.media });
     }
+    summaryDesc.Work = [clipInfos = std::move(clipInfos), mediaPathStr, outputDir, startTicks = SDL_GetTicks64()](OFS_Job&) noexcept {
+        int exported = 0;
+        int failed = 0;
+        int cancelled = 0;
+        auto jsonClips = nlohmann::json::array();
+        for (auto& clip : clipInfos) {
+            if (clip.scripts->Succeeded() && clip.media->Succeeded()) exported += 1;
+            else if (clip.scripts->GetState() == OFS_Job::State::Failed || clip.media->GetState() == OFS_Job::State::Failed) failed += 1;
+            else cancelled += 1;
 
-    int returnCode;
-    subprocess_join(&proc, &returnCode);
-    subprocess_destroy(&proc);
+            jsonClips.emplace_back(nlohmann::json {
+                { "chapter", clip.chapter.name },
+                { "startTime", clip.chapter.StartTimeToString() },
+                { "endTime", clip.chapter.EndTimeToString() },
+                { "scripts", JobStateName(clip.scripts) },
+                { "media", JobStateName(clip.media) }
+            });
+        }
+        float seconds = (SDL_GetTicks64() - startTicks) / 1000.f;
+        LOGF_INFO("Clip export finished in %.1f seconds: %d exported, %d failed, %d cancelled", seconds, exported, failed, cancelled);
 
-    return returnCode == 0;
+        if (clipInfos.size() > 1) {
+            nlohmann::json summary = {
+                { "media", mediaPathStr },
+                { "seconds", seconds },
+                { "exported", exported },
+                { "failed", failed },
+                { "cancelled", cancelled },
+                { "clips", std::move(jsonClips) }
+            };
+            auto summaryText = Util::SerializeJson(summary, true);
+            auto summaryPath = (outputDir / "clip_export_summary.json").u8string();
+            Util::WriteFile(summaryPath.c_str(), summaryText.data(), summaryText.size());
+        }
+        return failed == 0;
+    };
+    summaryDesc.Then = [this, batch](OFS_Job&) noexcept {
+        auto it = std::find(exportBatches.begin(), exportBatches.end(), batch);
+        if (it != exportBatches.end()) exportBatches.erase(it);
+    };
+    batch->summary = OFS_JobSystem::Submit(std::move(summaryDesc));
+    exportBatches.emplace_back(std::move(batch));
+}
+
+void OFS_ChapterManager::cancelExport() noexcept
+{
+    for (auto& batch : exportBatches) {
+        for (auto& clip : batch->clips) {
+            clip.scripts->Cancel();
+            clip.media->Cancel();
+        }
+    }
 }
\ No newline at end of file
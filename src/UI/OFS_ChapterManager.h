@@ -2,19 +2,49 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
+#include <memory>
+
+#include "OFS_JobSystem.h"
+#include "state/states/ChapterState.h"
 
 class OFS_ChapterManager
 {
     private:
     uint32_t stateHandle = 0xFFFF'FFFF;
 
+    struct ClipExport
+    {
+        OFS_JobHandle scripts;
+        OFS_JobHandle media;
+    };
+
+    struct ClipExportBatch
+    {
+        std::vector<ClipExport> clips;
+        OFS_JobHandle summary;
+        int ffmpegConcurrency = 1;
+    };
+    // exports started while others are still running queue up behind them
+    std::vector<std::shared_ptr<ClipExportBatch>> exportBatches;
+
+    void cancelExport() noexcept;
+
     public:
     OFS_ChapterManager() noexcept;
     OFS_ChapterManager(const OFS_ChapterManager&) = delete;
     OFS_ChapterManager(OFS_ChapterManager&&) = delete;
     ~OFS_ChapterManager() noexcept;
 
-    static bool ExportClip(const class Chapter& chapter, const std::string& outputDirStr) noexcept;
+    // Main thread, snapshots the scripts and builds the job graph:
+    // one job per clip which slices and writes the scripts, all of them in parallel,
+    // plus one ffmpeg job per clip of which at most ffmpegConcurrency run at the same time.
+    // ffmpeg runs on the process lane and leaves one of its threads to the other process jobs.
+    // The ffmpeg jobs of a batch wait for the ones of the batch started before it.
+    // A summary gets logged, and written to the output directory for more than one clip.
+    void ExportClips(const std::vector<Chapter>& chapters, const std::string& outputDirStr, int ffmpegConcurrency) noexcept;
+    inline bool IsExporting() const noexcept { return !exportBatches.empty(); }
+
     void ShowWindow(bool* open) noexcept;
 
     class ChapterState& State() noexcept;
@@ -21,8 +21,9 @@ bool OFS_FunscriptMetadataEditor::ShowMetadataEditor(bool* open, Funscript::Meta
 
     if (ImGui::BeginPopupModal(TR_ID("METADATA_EDITOR", Tr::METADATA_EDITOR), open, ImGuiWindowFlags_NoDocking)) {
         metaDataChanged |= ImGui::InputText(TR(TITLE), &metadata.title);
-        Util::FormatTime(Util::FormatBuffer, sizeof(Util::FormatBuffer), (float)metadata.duration, false);
-        ImGui::LabelText(TR(DURATION), "%s", Util::FormatBuffer);
+        char timeBuf[16];
+        Util::FormatTime(timeBuf, sizeof(timeBuf), (float)metadata.duration, false);
+        ImGui::LabelText(TR(DURATION), "%s", timeBuf);
 
         metaDataChanged |= ImGui::InputText(TR(CREATOR), &metadata.creator);
         metaDataChanged |= ImGui::InputText(TR(URL), &metadata.script_url);
@@ -3,6 +3,7 @@
 #include "OpenFunscripter.h"
 #include "OFS_Localization.h"
 #include "OFS_ImGui.h"
+#include "OFS_JobSystem.h"
 
 #include "imgui.h"
 #include "imgui_stdlib.h"
@@ -166,6 +167,11 @@ bool OFS_Preferences::ShowPreferenceWindow() noexcept
 						save = true;
 					}
 					OFS::Tooltip(TR(FORCE_HW_DECODING_TOOLTIP));
+					if (ImGui::InputInt(TR(CLIP_EXPORT_CONCURRENCY), &state.clipExportConcurrency, 1, 1)) {
+						save = true;
+						state.clipExportConcurrency = Util::Clamp<int32_t>(state.clipExportConcurrency, 1, OFS_JobSystem::ProcessLaneThreads - 1);
+					}
+					OFS::Tooltip(TR(CLIP_EXPORT_CONCURRENCY_TOOLTIP));
 					ImGui::EndTabItem();
 				}
 				if (ImGui::BeginTabItem(TR(SCRIPTING)))
@@ -2,6 +2,7 @@
 #include "OpenFunscripter.h"
 
 #include "state/ProjectState.h"
+#include "OFS_FrameIndex.h"
 
 void FrameOverlay::DrawScriptPositionContent(const OverlayDrawingCtx& ctx) noexcept
 {
@@ -10,8 +11,27 @@ void FrameOverlay::DrawScriptPositionContent(const OverlayDrawingCtx& ctx) noexc
     float frameTime = enableFpsOverride ? (1.f / fpsOverride) : app->scripting->LogicalFrameTime();
     float visibleFrames = ctx.visibleTime / frameTime;
     constexpr float maxVisibleFrames = 400.f;
+    auto& frameIndex = app->player->FrameIndex();
    
-    if (visibleFrames <= (maxVisibleFrames * 0.75f)) {
+    if (!enableFpsOverride && frameIndex.IsReady()) {
+        // render the actual frame times, variable frame rate videos don't have a constant frame time
+        int64_t firstFrame = Util::Max<int64_t>(frameIndex.FrameAt(ctx.offsetTime), 0);
+        int64_t lastFrame = frameIndex.FrameAt(ctx.offsetTime + ctx.visibleTime) + 1;
+        visibleFrames = lastFrame - firstFrame;
+        if (visibleFrames <= (maxVisibleFrames * 0.75f)) {
+            int alpha = 255 * (1.f - (visibleFrames / maxVisibleFrames));
+            for (int64_t i = firstFrame; i <= lastFrame; i += 1) {
+                float x = ((frameIndex.FrameTime(i) - ctx.offsetTime) / ctx.visibleTime) * ctx.canvasSize.x;
+                ctx.drawList->AddLine(
+                    ctx.canvasPos + ImVec2(x, 0.f),
+                    ctx.canvasPos + ImVec2(x, ctx.canvasSize.y),
+                    IM_COL32(80, 80, 80, alpha),
+                    1.f
+                );
+            }
+        }
+    }
+    else if (visibleFrames <= (maxVisibleFrames * 0.75f)) {
         //render frame dividers
         float offset = -std::fmod(ctx.offsetTime, frameTime);
         const int lineCount = visibleFrames + 2;
@@ -87,14 +107,31 @@ void FrameOverlay::previousFrame(float realFrameTime) noexcept
 
 float FrameOverlay::steppingIntervalBackward(float realFrameTime, float fromTime) noexcept
 {
+    auto& frameIndex = OpenFunscripter::ptr->player->FrameIndex();
+    if (!enableFpsOverride && frameIndex.IsReady()) {
+        return frameIndex.PreviousFrameTime(fromTime) - fromTime;
+    }
     return -logicalFrameTime(realFrameTime);
 }
 
 float FrameOverlay::steppingIntervalForward(float realFrameTime, float fromTime) noexcept
 {
+    auto& frameIndex = OpenFunscripter::ptr->player->FrameIndex();
+    if (!enableFpsOverride && frameIndex.IsReady()) {
+        return frameIndex.NextFrameTime(fromTime) - fromTime;
+    }
     return logicalFrameTime(realFrameTime);
 }
 
+float FrameOverlay::snapTime(float time) noexcept
+{
+    auto& frameIndex = OpenFunscripter::ptr->player->FrameIndex();
+    if (!enableFpsOverride && frameIndex.IsReady()) {
+        return frameIndex.SnapToFrame(time);
+    }
+    return time;
+}
+
 float FrameOverlay::logicalFrameTime(float realFrameTime) noexcept
 {
     return enableFpsOverride ? (1.f / fpsOverride) : realFrameTime;
@@ -79,6 +79,7 @@ public:
 	virtual void previousFrame(float realFrameTime) noexcept override;
 
 	virtual float logicalFrameTime(float realFrameTime) noexcept override;
+	virtual float snapTime(float time) noexcept override;
 	virtual float steppingIntervalForward(float realFrameTime, float fromTime) noexcept override;
 	virtual float steppingIntervalBackward(float realFrameTime, float fromTime) noexcept override;
 };
\ No newline at end of file
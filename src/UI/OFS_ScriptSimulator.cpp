@@ -32,6 +32,7 @@ inline static uint32_t GetColor(const ImColor& col, float opacity) noexcept
 void ScriptSimulator::Init() noexcept
 {
     stateHandle = OFS_ProjectState<SimulatorState>::Register(SimulatorState::StateName);
+    defaultStateHandle = OFS_AppState<SimulatorDefaultConfigState>::Register(SimulatorDefaultConfigState::StateName);
     EV::Queue().appendListener(SDL_MOUSEMOTION,
         OFS_SDL_Event::HandleEvent(EVENT_SYSTEM_BIND(this, &ScriptSimulator::MouseMovement)));
 }
@@ -151,7 +152,7 @@ void ScriptSimulator::ShowSimulator(bool* open, std::shared_ptr<Funscript>& acti
 
     ImGui::Columns(2, 0, false);
     if (ImGui::Button(TR(LOAD_CONFIG), ImVec2(-1.f, 0.f))) {
-        auto& dState = SimulatorDefaultConfigState::StaticStateSlow();
+        auto& dState = SimulatorDefaultConfigState::State(defaultStateHandle);
         state = dState.defaultState;
     }
     ImGui::NextColumn();
@@ -160,7 +161,7 @@ void ScriptSimulator::ShowSimulator(bool* open, std::shared_ptr<Funscript>& acti
             TR(SAVE_SIMULATOR_CONFIG_MSG), 
             [this](Util::YesNoCancel result) {
                 if(result == Util::YesNoCancel::Yes) {
-                    auto& dState = SimulatorDefaultConfigState::StaticStateSlow();
+                    auto& dState = SimulatorDefaultConfigState::State(defaultStateHandle);
                     auto& state = SimulatorState::State(stateHandle);
                     dState.defaultState = state;
                 }
@@ -14,6 +14,7 @@ private:
 	ImVec2* dragging = nullptr;
 	float mouseValue;
 	uint32_t stateHandle = 0xFFFF'FFFF;
+	uint32_t defaultStateHandle = 0xFFFF'FFFF;
 	bool IsMovingSimulator = false;
 	bool EnableVanilla = false;
 	bool MouseOnSimulator = false;
@@ -237,7 +237,7 @@ OFS_WebsocketApi::OFS_WebsocketApi() noexcept
 				if (script) {
 					auto& projectState = app->LoadedProject->State();
 					eventSerializationCtx->Push<WsFunscriptRemove>(ev->oldName);
-					eventSerializationCtx->Push<WsFunscriptChange>(ev->newName, script->Data(), projectState.metadata);
+					eventSerializationCtx->Push<WsFunscriptChange>(ev->newName, script->Data(), projectState.metadata, app->LoadedProject->Chapters());
 				}
 			}
 		}
@@ -385,13 +385,24 @@ void OFS_WebsocketApi::Update() noexcept
 			{
 				auto& projectState = app->LoadedProject->State();
 				auto& script = app->LoadedFunscripts()[i];
-				eventSerializationCtx->Push<WsFunscriptChange>(script->Title(), script->Data(), projectState.metadata);
+				eventSerializationCtx->Push<WsFunscriptChange>(script->Title(), script->Data(), projectState.metadata, app->LoadedProject->Chapters());
 				LOGF_DEBUG("[WsFunscriptChange]: ScriptIdx: %d", i);
 			}
 			cd = 0;
 		}
 	}
 
+	if(SDL_GetTicks() - lastStatsTicks >= StatsIntervalMs)
+	{
+		lastStatsTicks = SDL_GetTicks();
+		std::vector<OFS_LuaExtensionStatsEntry> stats;
+		OpenFunscripter::ptr->extensions->CollectStats(stats);
+		if(!stats.empty())
+		{
+			eventSerializationCtx->Push<WsExtensionStats>(std::move(stats), OFS_LuaExtensions::InstructionBudget);
+		}
+	}
+
 	if(!eventSerializationCtx->EventsEmpty())
 	{
 		eventSerializationCtx->StartProcessing();
@@ -65,9 +65,12 @@ class OFS_WebsocketApi
     void* ctx = nullptr;
     uint32_t stateHandle = 0xFFFF'FFFF;
     std::vector<uint32_t> scriptUpdateCooldown;
+    uint32_t lastStatsTicks = 0;
     std::unique_ptr<EventSerializationContext> eventSerializationCtx;
 
     public:
+    static constexpr uint32_t StatsIntervalMs = 1000;
+
     OFS_WebsocketApi() noexcept;
     OFS_WebsocketApi(const OFS_WebsocketApi&) = delete;
     OFS_WebsocketApi(OFS_WebsocketApi&&) = delete;
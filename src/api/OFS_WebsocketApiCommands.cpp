@@ -1,4 +1,5 @@
 #include "OFS_WebsocketApiCommands.h"
+#include "OFS_Redraw.h"
 #include <optional>
 
 WsCommandBuffer::WsCommandBuffer() noexcept
@@ -43,6 +44,8 @@ bool WsCommandBuffer::AddCmd(const nlohmann::json& jsonCmd) noexcept
         SDL_AtomicLock(&commandLock);
         commands.emplace_back(std::move(cmd));
         SDL_AtomicUnlock(&commandLock);
+        // commands run on the main thread
+        OFS_Redraw::Request(1);
         return true;
     }
     return false;
@@ -45,7 +45,7 @@ void to_json(nlohmann::json& j, const WsFunscriptChange& p)
 {
     initializeEvent(j, "funscript_change");
     nlohmann::json funscript;
-    Funscript::Serialize(funscript, p.funscriptData, p.funscriptMetadata, true);
+    Funscript::Serialize(funscript, p.funscriptData, p.funscriptMetadata, &p.chapters);
     j["data"] = { { "name", p.name }, { "funscript",  std::move(funscript) } };
 }
 
@@ -53,4 +53,31 @@ void to_json(nlohmann::json& j, const WsFunscriptRemove& p)
 {
     initializeEvent(j, "funscript_remove");
     j["data"] = { {"name", p.name } };
-}
\ No newline at end of file
+}
+
+void to_json(nlohmann::json& j, const WsExtensionStats& p)
+{
+    initializeEvent(j, "extension_stats");
+    auto extensions = nlohmann::json::array();
+    for(auto& ext : p.extensions)
+    {
+        auto callbacks = nlohmann::json::object();
+        for(size_t i = 0; i < ext.callbacks.size(); i += 1)
+        {
+            auto& cb = ext.callbacks[i];
+            callbacks[OFS_LuaCallbackName((OFS_LuaCallback)i)] = {
+                { "avg_ms", cb.averageMs },
+                { "max_ms", cb.maxMs },
+                { "calls", cb.calls },
+                { "over_budget", cb.overBudget }
+            };
+        }
+        extensions.push_back({
+            { "name", ext.name },
+            { "memory_bytes", ext.memoryBytes },
+            { "skipped_updates", ext.skippedUpdates },
+            { "callbacks", std::move(callbacks) }
+        });
+    }
+    j["data"] = { { "instruction_budget", p.instructionBudget }, { "extensions", std::move(extensions) } };
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "OFS_Event.h"
 #include "Funscript.h"
+#include "OFS_LuaExtensionStats.h"
+#include "state/states/ChapterState.h"
 
 #include "nlohmann/json.hpp"
 
@@ -20,6 +22,7 @@ void to_json(nlohmann::json& j, const class WsMediaChange& p);
 void to_json(nlohmann::json& j, const class WsPlaybackSpeedChange& p);
 void to_json(nlohmann::json& j, const class WsFunscriptChange& p);
 void to_json(nlohmann::json& j, const class WsFunscriptRemove& p);
+void to_json(nlohmann::json& j, const class WsExtensionStats& p);
 
 class WsMediaChange : public OFS_Event<WsMediaChange>, public ToJsonInterface
 {
@@ -79,9 +82,11 @@ class WsFunscriptChange : public OFS_Event<WsFunscriptChange>, public ToJsonInte
     std::string name;
     Funscript::FunscriptData funscriptData;
     Funscript::Metadata funscriptMetadata;
+    // a copy, the event gets serialized on another thread
+    ChapterState chapters;
 
-    WsFunscriptChange(const std::string& name, Funscript::FunscriptData funscriptData, Funscript::Metadata metadata) noexcept
-        : name(name), funscriptData(std::move(funscriptData)), funscriptMetadata(std::move(metadata)) {}
+    WsFunscriptChange(const std::string& name, Funscript::FunscriptData funscriptData, Funscript::Metadata metadata, ChapterState chapters) noexcept
+        : name(name), funscriptData(std::move(funscriptData)), funscriptMetadata(std::move(metadata)), chapters(std::move(chapters)) {}
 
     void Serialize(nlohmann::json& json) noexcept override { to_json(json, *this); }
 };
@@ -104,3 +109,14 @@ class WsFunscriptRemove : public OFS_Event<WsFunscriptRemove>, public ToJsonInte
     void Serialize(nlohmann::json& json) noexcept override { to_json(json, *this); }
 };
 
+
+class WsExtensionStats : public OFS_Event<WsExtensionStats>, public ToJsonInterface
+{
+    public:
+    std::vector<OFS_LuaExtensionStatsEntry> extensions;
+    int32_t instructionBudget;
+    WsExtensionStats(std::vector<OFS_LuaExtensionStatsEntry> extensions, int32_t instructionBudget) noexcept
+        : extensions(std::move(extensions)), instructionBudget(instructionBudget) {}
+
+    void Serialize(nlohmann::json& json) noexcept override { to_json(json, *this); }
+};
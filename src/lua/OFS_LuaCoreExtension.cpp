@@ -71,65 +71,8 @@ function gui()
 end
 
 function binding.spline_smooth()
-    local catmullRom = function(v1, v2, v3, v4, s)
-        s2 = s*s
-        s3 = s*s*s
-    
-        f1 = -s3 + 2.0 * s2 - s;
-        f2 = 3.0 * s3 - 5.0 * s2 + 2.0;
-        f3 = -3.0 * s3 + 4.0 * s2 + s;
-        f4 = s3 - s2;
-    
-        return (f1 * v1 + f2 * v2 + f3 * v3 + f4 * v4) / 2.0;
-    end
-    local script = ofs.Script(ofs.ActiveIdx())
-    local actionCount = #script.actions
-
-    if not script:hasSelection() then
-        return
-    end
-
-    local smoothedActions = {}
-
-    for idx, action in ipairs(script.actions) do
-        local i0 = clamp(idx - 1, 1, actionCount);
-        local i1 = clamp(idx, 1, actionCount);
-        local i2 = clamp(idx + 1, 1, actionCount);
-        local i3 = clamp(idx + 2, 1, actionCount);
-    
-        local action1 = script.actions[i0]
-        local action2 = script.actions[i1]
-        local action3 = script.actions[i2]
-        local action4 = script.actions[i3]
-    
-        -- skip all actions which aren't selected
-        -- since lua doesn't have a continue,
-        -- we use a goto + a label at the bottom of the loop
-        if not action2.selected or not action3.selected then goto continue end
-
-
-        local startTime = action2.at
-        local endTime = action3.at
-        local duration = endTime - startTime;
-    
-        local pointEverySecond = Spline.PointEveryMs / 1000.0
-
-        pointCount = duration/pointEverySecond
-   
-        for i=1, pointCount-1, 1 do
-            s = (i*pointEverySecond) / duration
-            time_ms = action2.at + (i*pointEverySecond)
-            spline_pos = catmullRom(action1.pos, action2.pos, action3.pos, action4.pos, s)
-            spline_pos = clamp(spline_pos, 0, 100)
-            table.insert( smoothedActions, {at=time_ms, pos=spline_pos} )
-        end
-        ::continue::
-    end
-
-    for idx, action in ipairs(smoothedActions) do
-        script.actions:add(Action.new(action.at, action.pos))
-    end
-    script:commit()
+    -- resamples every pair of selected actions along a catmull-rom spline
+    ofs.ops.SplineResample(ofs.ActiveIdx(), Spline.PointEveryMs / 1000.0)
 end
 
 function binding.random_noise()
@@ -157,47 +100,17 @@ function binding.random_noise()
     script:commit()
 end
 
-function select_all() 
-    local script = ofs.Script(ofs.ActiveIdx())
-    for idx, action in ipairs(script.actions) do
-        action.selected = true
-    end
-    script:commit()
+function select_all()
+    ofs.ops.SelectAll(ofs.ActiveIdx())
 end
 
 function select_none()
-    local script = ofs.Script(ofs.ActiveIdx())
-    for idx, action in ipairs(script.actions) do
-        action.selected = false
-    end
-    script:commit()
+    ofs.ops.SelectNone(ofs.ActiveIdx())
 end
 
 function binding.jitter()
-    local script = ofs.Script(ofs.ActiveIdx())
-
-    if not script:hasSelection() then
-        return
-    end
-    
-    for idx, action in ipairs(script.actions) do
-        -- check if action is selected
-        if action.selected then
-            local time_jitter_value = math.random(-Jitter.TimeMs, Jitter.TimeMs) 
-            local pos_jitter_value = math.random(-Jitter.Position, Jitter.Position)
-
-            -- ATTENTION
-            -- there's a bug here
-            -- the timestamp change can reorder actions when that happens
-            -- the position jitter will be applied to the wrong action
-
-            -- A more sophisticated function would check the next and the previous action
-            -- to ensure that the new time is still in between them.
-            action.at = action.at + time_jitter_value/1000.0
-            action.pos = action.pos + pos_jitter_value
-        end
-    end
-    script:commit()
+    -- jittered times stay in between the neighbouring actions
+    ofs.ops.Jitter(ofs.ActiveIdx(), Jitter.TimeMs / 1000.0, Jitter.Position)
 end
 )";
 
@@ -1,10 +1,13 @@
 #include "OFS_LuaExtension.h"
 #include "OFS_LuaExtensions.h"
 #include "OFS_Util.h"
+#include "OFS_Redraw.h"
 #include "OpenFunscripter.h"
 
 #include <string>
 
+#include "SDL_timer.h"
+
 void OFS_LuaExtension::Toggle() noexcept
 {
     if (!this->Active) {
@@ -15,6 +18,56 @@ void OFS_LuaExtension::Toggle() noexcept
     }
 }
 
+void OFS_LuaExtension::budgetHook(lua_State* L, lua_Debug* ar) noexcept
+{
+	auto ext = *(OFS_LuaExtension**)lua_getextraspace(L);
+	ext->budgetUsed += BudgetCheckInstructions;
+	auto budget = OFS_LuaExtensions::InstructionBudget;
+	if(budget <= 0 || ext->budgetUsed <= (uint32_t)budget) return;
+
+	if(!ext->budgetExceeded) {
+		ext->budgetExceeded = true;
+		ext->Stats[ext->currentCallback].overBudget += 1;
+	}
+	if(!OFS_LuaExtensions::ThrottleOverBudget) {
+		luaL_error(L, "%s exceeded the instruction budget of %d", OFS_LuaCallbackName(ext->currentCallback), budget);
+	}
+}
+
+uint64_t OFS_LuaExtension::callBegin(OFS_LuaCallback callback) noexcept
+{
+	auto luaState = L.lua_state();
+	// extensions are stored by value and move when the list changes
+	*(OFS_LuaExtension**)lua_getextraspace(luaState) = this;
+	budgetUsed = 0;
+	budgetExceeded = false;
+	currentCallback = callback;
+	// init only runs once, it isn't held to the budget
+	if(OFS_LuaExtensions::InstructionBudget > 0 && callback != OFS_LuaCallback::Init) {
+		lua_sethook(luaState, budgetHook, LUA_MASKCOUNT, BudgetCheckInstructions);
+	}
+	return SDL_GetPerformanceCounter();
+}
+
+void OFS_LuaExtension::callEnd(OFS_LuaCallback callback, uint64_t startCounter) noexcept
+{
+	float ms = (SDL_GetPerformanceCounter() - startCounter) * 1000.0 / SDL_GetPerformanceFrequency();
+	Stats[callback].AddSample(ms);
+
+	auto luaState = L.lua_state();
+	// task and process callbacks run outside of call() and must not hit the hook
+	if(lua_gethook(luaState)) {
+		lua_sethook(luaState, nullptr, 0, 0);
+	}
+	Stats.memoryBytes = (int64_t)lua_gc(luaState, LUA_GCCOUNT) * 1024 + lua_gc(luaState, LUA_GCCOUNTB);
+
+	if(budgetExceeded && OFS_LuaExtensions::ThrottleOverBudget) {
+		// skip update for as many frames as the budget was exceeded
+		int32_t frames = budgetUsed / Util::Max(OFS_LuaExtensions::InstructionBudget, 1);
+		throttleFrames = Util::Clamp(frames, 1, MaxThrottleFrames);
+	}
+}
+
 void OFS_LuaExtension::ShowWindow() noexcept
 {
 	if(!WindowOpen || !Active) return;
@@ -39,7 +92,7 @@ void OFS_LuaExtension::ShowWindow() noexcept
 	}
 
 	auto gui = L.get<sol::protected_function>(OFS_LuaExtensions::RenderGui);
-	auto res = gui();
+	auto res = call(OFS_LuaCallback::Gui, gui);
 	if(res.status() != sol::call_status::ok) {
 		auto err = sol::stack::get_traceback_or_errors(L.lua_state());
 		AddError(err.what());
@@ -47,18 +100,42 @@ void OFS_LuaExtension::ShowWindow() noexcept
 	if(!api->guiAPI->Validate()) {
 		AddError(api->guiAPI->Error().c_str());
 	}
+	api->taskAPI->ShowProgress();
 	ImGui::End();
 }
 
 void OFS_LuaExtension::Update() noexcept
 {
 	if(!Active) return;
-	auto update = L.get<sol::protected_function>(OFS_LuaExtensions::UpdateFunction);
-	auto res = update(ImGui::GetIO().DeltaTime);
-	if(res.status() != sol::call_status::ok)
-	{
-		auto err = sol::stack::get_traceback_or_errors(L.lua_state());
-		AddError(err.what());
+	if(throttleFrames > 0) {
+		throttleFrames -= 1;
+		Stats.skippedUpdates += 1;
+	}
+	else {
+		auto update = L.get<sol::protected_function>(OFS_LuaExtensions::UpdateFunction);
+		auto res = call(OFS_LuaCallback::Update, update, ImGui::GetIO().DeltaTime);
+		if(res.status() != sol::call_status::ok)
+		{
+			auto err = sol::stack::get_traceback_or_errors(L.lua_state());
+			AddError(err.what());
+		}
+	}
+
+	// finished tasks and process output request a frame themselves
+	if(api->taskAPI->HasTasks()) {
+		std::vector<std::string> taskErrors;
+		api->taskAPI->Update(taskErrors);
+		for(auto& error : taskErrors) {
+			AddError(error.c_str());
+		}
+	}
+
+	if(api->procAPI->HasExitCallbacks()) {
+		std::vector<std::string> exitErrors;
+		api->procAPI->Update(exitErrors);
+		for(auto& error : exitErrors) {
+			AddError(error.c_str());
+		}
 	}
 }
 
@@ -81,12 +158,13 @@ bool OFS_LuaExtension::Load() noexcept
 		extensionText = std::string((char*)dataBuf.data(), dataBuf.size());
 	}
 
-	//UpdateTime = 0.f;
-	//MaxUpdateTime = 0.f;
-	//MaxGuiTime = 0.f;
-	//Bindables.clear();
+	Stats.Reset();
+	throttleFrames = 0;
 
+	// exit callbacks reference the old state
+	if(api) api->procAPI->Clear();
 	L = sol::state();
+	*(OFS_LuaExtension**)lua_getextraspace(L.lua_state()) = this;
 	L.open_libraries(
 		sol::lib::base,
 		sol::lib::package,
@@ -128,6 +206,18 @@ bool OFS_LuaExtension::Load() noexcept
 		}
 		return nullptr;
 	};
+	ofs["ScriptVersion"] = [](lua_Integer idx) noexcept -> lua_Integer {
+		auto app = OpenFunscripter::ptr;
+		idx -= 1;
+		if(idx >= 0 && idx < app->LoadedFunscripts().size()) {
+			return app->LoadedFunscripts()[idx]->Version();
+		}
+		return 0;
+	};
+
+	ofs["Redraw"] = [](sol::optional<lua_Integer> frames) noexcept {
+		OFS_Redraw::Request(Util::Clamp<int32_t>(frames.value_or(1), 1, 60));
+	};
 
 	api = std::make_unique<OFS_ExtensionAPI>(ofs);
 
@@ -155,7 +245,7 @@ bool OFS_LuaExtension::Load() noexcept
 		FUN_ASSERT(res.valid(), "what");
 
 		auto init = L.get<sol::protected_function>(OFS_LuaExtensions::InitFunction);
-		res = init();
+		res = call(OFS_LuaCallback::Init, init);
 		if(res.status() != sol::call_status::ok) {
 			auto err = sol::stack::get_traceback_or_errors(L.lua_state());
 			AddError(err.what());
@@ -187,7 +277,7 @@ void OFS_LuaExtension::Execute(const std::string& func) noexcept
 {
 	sol::protected_function bind = L[OFS_LuaExtension::BindingTable][func];
 	if(bind.valid()) {
-		auto res = bind();
+		auto res = call(OFS_LuaCallback::Binding, bind);
 		if(res.status() != sol::call_status::ok) {
 			auto err = sol::stack::get_traceback_or_errors(L.lua_state());
 			AddError(err.what());
@@ -195,11 +285,11 @@ void OFS_LuaExtension::Execute(const std::string& func) noexcept
 	}
 }
 
-void OFS_LuaExtension::ScriptChanged(uint32_t scriptIdx) noexcept
+void OFS_LuaExtension::ScriptChanged(uint32_t scriptIdx, float fromTime, float toTime, uint32_t version) noexcept
 {
 	sol::protected_function change = L[OFS_LuaExtension::ScriptChangeFunction];
 	if(change.valid()) {
-		auto res = change(scriptIdx + 1);
+		auto res = call(OFS_LuaCallback::ScriptChange, change, scriptIdx + 1, fromTime, toTime, version);
 		if(res.status() != sol::call_status::ok) {
 			auto err = sol::stack::get_traceback_or_errors(L.lua_state());
 			AddError(err.what());
@@ -209,10 +299,10 @@ void OFS_LuaExtension::ScriptChanged(uint32_t scriptIdx) noexcept
 
 void OFS_LuaExtension::Shutdown() noexcept
 {
-	// UpdateTime = 0.f;
-	// MaxUpdateTime = 0.f;
-	// MaxGuiTime = 0.f;
-	// Bindables.clear();
+	if(api) {
+		api->taskAPI->CancelAll();
+		api->procAPI->Clear();
+	}
 	L = sol::state();
 	Active = false;
 }
\ No newline at end of file
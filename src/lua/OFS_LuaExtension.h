@@ -2,6 +2,7 @@
 #include <string>
 #include "OFS_Lua.h"
 #include "OFS_LuaExtensionAPI.h"
+#include "OFS_LuaExtensionStats.h"
 #include "OFS_Util.h"
 
 #include <memory>
@@ -11,10 +12,32 @@ class OFS_LuaExtension
 	private:
 		sol::state L;
 		std::unique_ptr<OFS_ExtensionAPI> api = nullptr;
+
+		// instructions executed by the running callback, counted by the budget hook
+		uint32_t budgetUsed = 0;
+		bool budgetExceeded = false;
+		OFS_LuaCallback currentCallback = OFS_LuaCallback::Init;
+		int32_t throttleFrames = 0;
+
+		static void budgetHook(lua_State* L, lua_Debug* ar) noexcept;
+		uint64_t callBegin(OFS_LuaCallback callback) noexcept;
+		void callEnd(OFS_LuaCallback callback, uint64_t startCounter) noexcept;
+
+		template<typename... Args>
+		inline sol::protected_function_result call(OFS_LuaCallback callback, const sol::protected_function& function, Args&&... args) noexcept
+		{
+			auto startCounter = callBegin(callback);
+			auto res = function(std::forward<Args>(args)...);
+			callEnd(callback, startCounter);
+			return res;
+		}
     public:
 		static constexpr const char* MainFile = "main.lua";
 		static constexpr const char* BindingTable = "binding";
 		static constexpr const char* ScriptChangeFunction = "scriptChange";
+		// granularity of the instruction budget
+		static constexpr int32_t BudgetCheckInstructions = 1000;
+		static constexpr int32_t MaxThrottleFrames = 60;
 
 		std::string Name;
 		std::string NameId;
@@ -22,6 +45,7 @@ class OFS_LuaExtension
 		std::string Error;
 		bool Active = false;
 		bool WindowOpen = false;
+		OFS_LuaExtensionStats Stats;
 
 		inline bool HasError() const noexcept { return !Error.empty(); }
 		bool Load() noexcept;
@@ -37,7 +61,7 @@ class OFS_LuaExtension
 		void Update() noexcept;
 		void Shutdown() noexcept;
 		void Toggle() noexcept;
-		void ScriptChanged(uint32_t scriptIdx) noexcept;
+		void ScriptChanged(uint32_t scriptIdx, float fromTime, float toTime, uint32_t version) noexcept;
 
 		void Execute(const std::string& function) noexcept;
 };
@@ -40,6 +40,8 @@ OFS_ExtensionAPI::OFS_ExtensionAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) n
     guiAPI = std::make_unique<OFS_ImGuiAPI>(ofs);
 	procAPI = std::make_unique<OFS_ProcessAPI>(ofs);
     scriptAPI = std::make_unique<OFS_ScriptAPI>(ofs);
+    opsAPI = std::make_unique<OFS_OpsAPI>(ofs);
+    taskAPI = std::make_unique<OFS_TaskAPI>(ofs);
     playerAPI = std::make_unique<OFS_PlayerAPI>(L);
 
 	L.set_function("print", LuaPrint);
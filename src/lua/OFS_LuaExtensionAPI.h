@@ -5,6 +5,8 @@
 #include "api/OFS_LuaScriptAPI.h"
 #include "api/OFS_LuaPlayerAPI.h"
 #include "api/OFS_LuaProcessAPI.h"
+#include "api/OFS_LuaOpsAPI.h"
+#include "api/OFS_LuaTaskAPI.h"
 
 #include <memory>
 
@@ -19,6 +21,8 @@ class OFS_ExtensionAPI
     std::unique_ptr<OFS_ProcessAPI> procAPI;
     std::unique_ptr<OFS_PlayerAPI> playerAPI;
     std::unique_ptr<OFS_ScriptAPI> scriptAPI;
+    std::unique_ptr<OFS_OpsAPI> opsAPI;
+    std::unique_ptr<OFS_TaskAPI> taskAPI;
 
     OFS_ExtensionAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) noexcept;
     ~OFS_ExtensionAPI() noexcept;
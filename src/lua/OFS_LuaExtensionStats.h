@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class OFS_LuaCallback : int32_t
+{
+	Init,
+	Update,
+	Gui,
+	Binding,
+	ScriptChange,
+	Count
+};
+
+inline const char* OFS_LuaCallbackName(OFS_LuaCallback callback) noexcept
+{
+	switch(callback) {
+		case OFS_LuaCallback::Init: return "init";
+		case OFS_LuaCallback::Update: return "update";
+		case OFS_LuaCallback::Gui: return "gui";
+		case OFS_LuaCallback::Binding: return "binding";
+		case OFS_LuaCallback::ScriptChange: return "scriptChange";
+		default: return "";
+	}
+}
+
+struct OFS_LuaCallbackStats
+{
+	static constexpr uint32_t WindowSize = 64;
+
+	std::array<float, WindowSize> samples = {};
+	float windowSum = 0.f;
+	float maxMs = 0.f;
+	float lastMs = 0.f;
+	uint64_t calls = 0;
+	uint64_t overBudget = 0;
+
+	inline void AddSample(float ms) noexcept
+	{
+		auto& slot = samples[calls % WindowSize];
+		windowSum += ms - slot;
+		slot = ms;
+		lastMs = ms;
+		if(ms > maxMs) maxMs = ms;
+		calls += 1;
+	}
+
+	// average over the last WindowSize calls
+	inline float AverageMs() const noexcept
+	{
+		uint64_t count = calls < WindowSize ? calls : WindowSize;
+		return count > 0 ? windowSum / count : 0.f;
+	}
+};
+
+struct OFS_LuaExtensionStats
+{
+	std::array<OFS_LuaCallbackStats, (size_t)OFS_LuaCallback::Count> callbacks;
+	int64_t memoryBytes = 0;
+	uint64_t skippedUpdates = 0;
+
+	inline OFS_LuaCallbackStats& operator[](OFS_LuaCallback callback) noexcept { return callbacks[(size_t)callback]; }
+	inline const OFS_LuaCallbackStats& operator[](OFS_LuaCallback callback) const noexcept { return callbacks[(size_t)callback]; }
+	inline void Reset() noexcept { *this = OFS_LuaExtensionStats(); }
+};
+
+// Condensed copy for the websocket api.
+struct OFS_LuaExtensionStatsEntry
+{
+	struct Callback
+	{
+		float averageMs;
+		float maxMs;
+		uint64_t calls;
+		uint64_t overBudget;
+	};
+
+	std::string name;
+	int64_t memoryBytes;
+	uint64_t skippedUpdates;
+	std::array<Callback, (size_t)OFS_LuaCallback::Count> callbacks;
+};
@@ -1,11 +1,18 @@
 #include "OpenFunscripter.h"
 #include "OFS_LuaExtensions.h"
 #include "OFS_Util.h"
+#include "OFS_Redraw.h"
 #include "OFS_Profiling.h"
 #include "OFS_LuaCoreExtension.h"
 
+#include "SDL_timer.h"
+
 bool OFS_LuaExtensions::DevMode = false;
 bool OFS_LuaExtensions::ShowLogs = false;
+bool OFS_LuaExtensions::ShowStats = false;
+int32_t OFS_LuaExtensions::InstructionBudget = 0;
+bool OFS_LuaExtensions::ThrottleOverBudget = false;
+int32_t OFS_LuaExtensions::ScriptChangeDebounceMs = 100;
 
 OFS::AppLog OFS_LuaExtensions::ExtensionLogBuffer;
 
@@ -15,6 +22,60 @@ inline static void ShowExtensionLogWindow(bool* open) noexcept
 	OFS_LuaExtensions::ExtensionLogBuffer.Draw("Extension Log Output", open);
 }
 
+static void ShowExtensionStatsWindow(bool* open, std::vector<OFS_LuaExtension>& extensions) noexcept
+{
+	if(!*open) return;
+	OFS_PROFILE(__FUNCTION__);
+	ImGui::Begin("Extension Stats", open, ImGuiWindowFlags_None);
+
+	if(ImGui::InputInt("Instruction budget", &OFS_LuaExtensions::InstructionBudget, 100000, 1000000)) {
+		OFS_LuaExtensions::InstructionBudget = Util::Max(OFS_LuaExtensions::InstructionBudget, 0);
+	}
+	OFS::Tooltip("Instructions a single callback may execute. 0 disables the budget.\nInit is never limited.");
+	ImGui::Checkbox("Throttle instead of abort", &OFS_LuaExtensions::ThrottleOverBudget);
+	OFS::Tooltip("Callbacks over budget finish, update is skipped for the following frames.");
+	ImGui::Separator();
+
+	for(auto& ext : extensions) {
+		if(!ext.Active) continue;
+		auto& stats = ext.Stats;
+		ImGui::PushID(ext.NameId.c_str());
+		ImGui::Text("%s - %.1f KB Lua memory, %llu updates skipped", ext.Name.c_str(),
+			stats.memoryBytes / 1024.f, (unsigned long long)stats.skippedUpdates);
+		ImGui::SameLine();
+		if(ImGui::SmallButton("Reset")) {
+			auto memoryBytes = stats.memoryBytes;
+			stats.Reset();
+			stats.memoryBytes = memoryBytes;
+		}
+		if(ImGui::BeginTable("##ExtensionStats", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+			ImGui::TableSetupColumn("Callback");
+			ImGui::TableSetupColumn("Avg ms");
+			ImGui::TableSetupColumn("Max ms");
+			ImGui::TableSetupColumn("Calls");
+			ImGui::TableSetupColumn("Over budget");
+			ImGui::TableHeadersRow();
+			for(int32_t i = 0; i < (int32_t)OFS_LuaCallback::Count; i += 1) {
+				auto& cb = stats.callbacks[i];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(OFS_LuaCallbackName((OFS_LuaCallback)i));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", cb.AverageMs());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", cb.maxMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)cb.calls);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)cb.overBudget);
+			}
+			ImGui::EndTable();
+		}
+		ImGui::PopID();
+	}
+	ImGui::End();
+}
+
 OFS_LuaExtensions::OFS_LuaExtensions() noexcept
 {
 	load(Util::Prefpath("extension.json"));
@@ -52,11 +113,63 @@ void OFS_LuaExtensions::load(const std::string& path) noexcept
 	}
 }
 
-void OFS_LuaExtensions::ScriptChanged(uint32_t scriptIdx) noexcept
+void OFS_LuaExtensions::QueueScriptChange(uint32_t scriptId, float fromTime, float toTime, uint32_t version) noexcept
 {
-	for(auto& ext : Extensions)	{
+	auto it = std::find_if(pendingScriptChanges.begin(), pendingScriptChanges.end(),
+		[scriptId](auto& change) { return change.scriptId == scriptId; });
+	if(it == pendingScriptChanges.end()) {
+		auto ticks = SDL_GetTicks();
+		pendingScriptChanges.emplace_back(OFS_PendingScriptChange{ scriptId, version, fromTime, toTime, ticks, ticks });
+		return;
+	}
+	it->version = version;
+	it->fromTime = Util::Min(it->fromTime, fromTime);
+	it->toTime = Util::Max(it->toTime, toTime);
+	it->lastChangeTicks = SDL_GetTicks();
+}
+
+void OFS_LuaExtensions::flushScriptChanges() noexcept
+{
+	OFS_PROFILE(__FUNCTION__);
+	auto app = OpenFunscripter::ptr;
+	auto ticks = SDL_GetTicks();
+	auto it = std::remove_if(pendingScriptChanges.begin(), pendingScriptChanges.end(),
+		[this, app, ticks](auto& change) {
+			uint32_t debounce = Util::Max(ScriptChangeDebounceMs, 0);
+			// continuous edits like recording would otherwise hold back the notification indefinitely
+			bool quiet = ticks - change.lastChangeTicks >= debounce;
+			bool overdue = ticks - change.firstChangeTicks >= Util::Max(debounce, MaxScriptChangeDelayMs);
+			if(!quiet && !overdue) return false;
+			// the script may have been closed or moved since the change
+			auto script = app->LoadedProject->GetScriptById(change.scriptId);
+			if(!script) return true;
+			auto& scripts = app->LoadedFunscripts();
+			auto scriptIt = std::find(scripts.begin(), scripts.end(), script);
+			if(scriptIt == scripts.end()) return true;
+
+			uint32_t scriptIdx = scriptIt - scripts.begin();
+			for(auto& ext : Extensions) {
+				if(!ext.Active) continue;
+				ext.ScriptChanged(scriptIdx, change.fromTime, change.toTime, change.version);
+			}
+			return true;
+		});
+	pendingScriptChanges.erase(it, pendingScriptChanges.end());
+}
+
+void OFS_LuaExtensions::CollectStats(std::vector<OFS_LuaExtensionStatsEntry>& outStats) const noexcept
+{
+	outStats.clear();
+	for(auto& ext : Extensions) {
 		if(!ext.Active) continue;
-		ext.ScriptChanged(scriptIdx);
+		auto& entry = outStats.emplace_back();
+		entry.name = ext.Name;
+		entry.memoryBytes = ext.Stats.memoryBytes;
+		entry.skippedUpdates = ext.Stats.skippedUpdates;
+		for(size_t i = 0; i < entry.callbacks.size(); i += 1) {
+			auto& cb = ext.Stats.callbacks[i];
+			entry.callbacks[i] = { cb.AverageMs(), cb.maxMs, cb.calls, cb.overBudget };
+		}
 	}
 }
 
@@ -105,6 +218,11 @@ void OFS_LuaExtensions::UpdateExtensionList() noexcept
 
 void OFS_LuaExtensions::Update(float delta) noexcept
 {
+	if(!pendingScriptChanges.empty()) {
+		flushScriptChanges();
+		// the debounce only elapses while frames are rendered
+		OFS_Redraw::Request(1);
+	}
 	for(auto& ext : Extensions) {
 		ext.Update();
 	}
@@ -114,6 +232,7 @@ void OFS_LuaExtensions::ShowExtensions() noexcept
 {
     OFS_PROFILE(__FUNCTION__);
 	ShowExtensionLogWindow(&OFS_LuaExtensions::ShowLogs);
+	ShowExtensionStatsWindow(&OFS_LuaExtensions::ShowStats, Extensions);
 	for(auto& ext : Extensions) {
 		ext.ShowWindow();
 	}
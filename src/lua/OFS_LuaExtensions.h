@@ -16,9 +16,22 @@ struct OFS_LuaBinding
 	std::string Name;
 };
 
+// Changes of one script collected until the debounce interval passed.
+struct OFS_PendingScriptChange
+{
+    uint32_t scriptId;
+    uint32_t version;
+    float fromTime;
+    float toTime;
+    uint32_t firstChangeTicks;
+    uint32_t lastChangeTicks;
+};
+
 class OFS_LuaExtensions
 {
     private:
+        std::vector<OFS_PendingScriptChange> pendingScriptChanges;
+        void flushScriptChanges() noexcept;
         std::string LastConfigPath;
         void load(const std::string& path) noexcept;
         void save() noexcept;
@@ -27,8 +40,16 @@ class OFS_LuaExtensions
     public:
         static constexpr const char* ExtensionDir = "extensions";
         static constexpr const char* DynamicBindingHandler = "OFS_LuaExtensions";
+        static constexpr uint32_t MaxScriptChangeDelayMs = 1000;
         static bool DevMode;
         static bool ShowLogs;
+        static bool ShowStats;
+        // instructions a callback may execute, 0 disables the budget
+        static int32_t InstructionBudget;
+        // let callbacks over budget finish and skip update frames instead of aborting them
+        static bool ThrottleOverBudget;
+        // scriptChange is only called once a script didn't change for this long
+        static int32_t ScriptChangeDebounceMs;
         static OFS::AppLog ExtensionLogBuffer;
         std::vector<OFS_LuaExtension> Extensions;
 
@@ -53,8 +74,9 @@ class OFS_LuaExtensions
         void Update(float delta) noexcept;
         void ShowExtensions() noexcept;
         void ReloadEnabledExtensions() noexcept;
-        void ScriptChanged(uint32_t scriptIdx) noexcept;
-        
+        void QueueScriptChange(uint32_t scriptId, float fromTime, float toTime, uint32_t version) noexcept;
+        void CollectStats(std::vector<OFS_LuaExtensionStatsEntry>& outStats) const noexcept;
+
         void AddBinding(const std::string& extId, const std::string& uniqueId, const std::string& name) noexcept;
 };
 
@@ -62,4 +84,8 @@ REFL_TYPE(OFS_LuaExtensions)
     REFL_FIELD(Extensions)
     REFL_FIELD(DevMode)
     REFL_FIELD(ShowLogs)
+    REFL_FIELD(ShowStats)
+    REFL_FIELD(InstructionBudget)
+    REFL_FIELD(ThrottleOverBudget)
+    REFL_FIELD(ScriptChangeDebounceMs)
 REFL_END
\ No newline at end of file
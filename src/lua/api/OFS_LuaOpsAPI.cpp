@@ -0,0 +1,219 @@
+#include "OFS_LuaOpsAPI.h"
+#include "OFS_LuaExtensionAPI.h"
+#include "OpenFunscripter.h"
+
+OFS_OpsAPI::~OFS_OpsAPI() noexcept
+{
+}
+
+OFS_OpsAPI::OFS_OpsAPI(sol::usertype<OFS_ExtensionAPI>& ofs) noexcept
+{
+    sol::state_view L(ofs.lua_state());
+    auto ops = L.create_table();
+    ops["SplineResample"] = OFS_OpsAPI::SplineResample;
+    ops["LinearResample"] = OFS_OpsAPI::LinearResample;
+    ops["Smooth"] = OFS_OpsAPI::Smooth;
+    ops["ScalePositions"] = OFS_OpsAPI::ScalePositions;
+    ops["OffsetPositions"] = OFS_OpsAPI::OffsetPositions;
+    ops["ScaleTimes"] = OFS_OpsAPI::ScaleTimes;
+    ops["OffsetTimes"] = OFS_OpsAPI::OffsetTimes;
+    ops["Jitter"] = OFS_OpsAPI::Jitter;
+    ops["Clamp"] = OFS_OpsAPI::Clamp;
+    ops["Invert"] = OFS_OpsAPI::Invert;
+    ops["Decimate"] = OFS_OpsAPI::Decimate;
+    ops["SelectAll"] = OFS_OpsAPI::SelectAll;
+    ops["SelectNone"] = OFS_OpsAPI::SelectNone;
+    ofs[OpsNamespace] = ops;
+}
+
+static std::shared_ptr<Funscript> getScript(lua_Integer scriptIdx) noexcept
+{
+    auto app = OpenFunscripter::ptr;
+    scriptIdx -= 1;
+    if(scriptIdx < 0 || scriptIdx >= app->LoadedFunscripts().size()) {
+        return nullptr;
+    }
+    return app->LoadedFunscripts()[scriptIdx];
+}
+
+template<typename Op>
+lua_Integer OFS_OpsAPI::apply(lua_Integer scriptIdx, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime, Op&& op) noexcept
+{
+    FUN_ASSERT(Util::InMainThread(), "Not in main thread.");
+    OFS_PROFILE(__FUNCTION__);
+    auto app = OpenFunscripter::ptr;
+    auto script = getScript(scriptIdx);
+    if(!script) return 0;
+
+    auto& actions = script->Actions();
+    auto& selection = script->Selection();
+    bool useRange = fromTime && toTime;
+    float from, to;
+    if(useRange) {
+        from = *fromTime;
+        to = *toTime;
+    }
+    else if(!selection.empty()) {
+        from = selection.front().atS;
+        to = selection.back().atS;
+    }
+    else {
+        return 0;
+    }
+
+    auto first = std::lower_bound(actions.begin(), actions.end(), from,
+        [](auto action, float time) noexcept { return action.atS < time; });
+    auto last = std::upper_bound(first, actions.end(), to,
+        [](float time, auto action) noexcept { return time < action.atS; });
+    if(first == last) return 0;
+
+    // one unmasked neighbour on each side, the spline and the jitter need them
+    bool leadingAnchor = first != actions.begin();
+    bool trailingAnchor = last != actions.end();
+    auto loadFirst = leadingAnchor ? first - 1 : first;
+    auto loadLast = trailingAnchor ? last + 1 : last;
+
+    FunscriptColumns cols;
+    cols.Load(&*loadFirst, &*loadFirst + (loadLast - loadFirst), selection, !useRange);
+    if(leadingAnchor) cols.mask.front() = 0;
+    if(trailingAnchor) cols.mask.back() = 0;
+    op(cols, from);
+
+    FunscriptArray newActions;
+    FunscriptArray newSelection;
+    cols.Store(newActions, newSelection);
+
+    // moved actions can leave the loaded interval, the replaced interval grows with them
+    // and the untouched actions in there get merged back in, unless they're overwritten
+    float loadFrom = loadFirst->atS;
+    float loadTo = (loadLast - 1)->atS;
+    float lo = loadFrom;
+    float hi = loadTo;
+    if(!newActions.empty()) {
+        lo = std::min(lo, newActions.front().atS);
+        hi = std::max(hi, newActions.back().atS);
+    }
+    auto mergeFirst = std::lower_bound(actions.begin(), actions.end(), lo,
+        [](auto action, float time) noexcept { return action.atS < time; });
+    auto mergeLast = std::upper_bound(mergeFirst, actions.end(), hi,
+        [](float time, auto action) noexcept { return time < action.atS; });
+
+    if(mergeFirst != loadFirst || mergeLast != loadLast) {
+        FunscriptArray merged;
+        FunscriptArray mergedSelection;
+        merged.reserve(newActions.size() + (mergeLast - mergeFirst));
+        auto newIt = newActions.begin();
+        for(auto it = mergeFirst; it != mergeLast; ++it) {
+            if(it->atS >= loadFrom && it->atS <= loadTo) continue;
+            for(; newIt != newActions.end() && newIt->atS <= it->atS; ++newIt) {
+                merged.emplace_back_unsorted(*newIt);
+            }
+            if(!merged.empty() && merged.back().atS == it->atS) continue;
+            merged.emplace_back_unsorted(*it);
+            if(script->IsSelected(*it)) mergedSelection.emplace(*it);
+        }
+        merged.insert(merged.end(), newIt, newActions.end());
+        for(auto action : newSelection) mergedSelection.emplace(action);
+        newActions = std::move(merged);
+        newSelection = std::move(mergedSelection);
+    }
+
+    app->undoSystem->Snapshot(StateType::CUSTOM_LUA, script);
+    script->ReplaceActionsInInterval(lo, hi, newActions, newSelection);
+    return newActions.size();
+}
+
+lua_Integer OFS_OpsAPI::SplineResample(lua_Integer scriptIdx, lua_Number interval, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [interval](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::Resample(cols, interval, true);
+    });
+}
+
+lua_Integer OFS_OpsAPI::LinearResample(lua_Integer scriptIdx, lua_Number interval, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [interval](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::Resample(cols, interval, false);
+    });
+}
+
+lua_Integer OFS_OpsAPI::Smooth(lua_Integer scriptIdx, lua_Integer radius, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [radius](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::Smooth(cols, radius);
+    });
+}
+
+lua_Integer OFS_OpsAPI::ScalePositions(lua_Integer scriptIdx, lua_Number factor, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [factor](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::ScalePositions(cols, factor, 50.f);
+    });
+}
+
+lua_Integer OFS_OpsAPI::OffsetPositions(lua_Integer scriptIdx, lua_Number offset, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [offset](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::OffsetPositions(cols, offset);
+    });
+}
+
+lua_Integer OFS_OpsAPI::ScaleTimes(lua_Integer scriptIdx, lua_Number factor, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [factor](FunscriptColumns& cols, float origin) noexcept {
+        FunscriptOps::ScaleTimes(cols, factor, origin);
+    });
+}
+
+lua_Integer OFS_OpsAPI::OffsetTimes(lua_Integer scriptIdx, lua_Number offset, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [offset](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::OffsetTimes(cols, offset);
+    });
+}
+
+lua_Integer OFS_OpsAPI::Jitter(lua_Integer scriptIdx, lua_Number timeJitter, lua_Number positionJitter, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [timeJitter, positionJitter](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::Jitter(cols, timeJitter, positionJitter);
+    });
+}
+
+lua_Integer OFS_OpsAPI::Clamp(lua_Integer scriptIdx, lua_Number min, lua_Number max, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [min, max](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::ClampPositions(cols, min, max);
+    });
+}
+
+lua_Integer OFS_OpsAPI::Invert(lua_Integer scriptIdx, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::InvertPositions(cols);
+    });
+}
+
+lua_Integer OFS_OpsAPI::Decimate(lua_Integer scriptIdx, lua_Number tolerance, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept
+{
+    return apply(scriptIdx, fromTime, toTime, [tolerance](FunscriptColumns& cols, float) noexcept {
+        FunscriptOps::Decimate(cols, tolerance);
+    });
+}
+
+void OFS_OpsAPI::SelectAll(lua_Integer scriptIdx) noexcept
+{
+    auto app = OpenFunscripter::ptr;
+    auto script = getScript(scriptIdx);
+    if(!script) return;
+    app->undoSystem->Snapshot(StateType::CUSTOM_LUA, script);
+    script->SelectAll();
+}
+
+void OFS_OpsAPI::SelectNone(lua_Integer scriptIdx) noexcept
+{
+    auto app = OpenFunscripter::ptr;
+    auto script = getScript(scriptIdx);
+    if(!script) return;
+    app->undoSystem->Snapshot(StateType::CUSTOM_LUA, script);
+    script->SetSelection(FunscriptArray());
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "OFS_Lua.h"
+#include "FunscriptOps.h"
+
+// ofs.ops, native bulk transforms for extensions.
+// Every op works on the selection or, if given, on all actions between fromTime and toTime
+// and is committed as a single undo step.
+class OFS_OpsAPI
+{
+    private:
+    template<typename Op>
+    static lua_Integer apply(lua_Integer scriptIdx, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime, Op&& op) noexcept;
+
+    static lua_Integer SplineResample(lua_Integer scriptIdx, lua_Number interval, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer LinearResample(lua_Integer scriptIdx, lua_Number interval, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer Smooth(lua_Integer scriptIdx, lua_Integer radius, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer ScalePositions(lua_Integer scriptIdx, lua_Number factor, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer OffsetPositions(lua_Integer scriptIdx, lua_Number offset, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer ScaleTimes(lua_Integer scriptIdx, lua_Number factor, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer OffsetTimes(lua_Integer scriptIdx, lua_Number offset, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer Jitter(lua_Integer scriptIdx, lua_Number timeJitter, lua_Number positionJitter, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer Clamp(lua_Integer scriptIdx, lua_Number min, lua_Number max, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer Invert(lua_Integer scriptIdx, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+    static lua_Integer Decimate(lua_Integer scriptIdx, lua_Number tolerance, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime) noexcept;
+
+    static void SelectAll(lua_Integer scriptIdx) noexcept;
+    static void SelectNone(lua_Integer scriptIdx) noexcept;
+
+    public:
+    static constexpr const char* OpsNamespace = "ops";
+    OFS_OpsAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) noexcept;
+    ~OFS_OpsAPI() noexcept;
+};
@@ -1,5 +1,68 @@
 #include "OFS_LuaProcessAPI.h"
 #include "OFS_LuaExtensionAPI.h"
+#include "OFS_Util.h"
+#include "OFS_Profiling.h"
+#include "OFS_Redraw.h"
+
+#include <algorithm>
+#include <csignal>
+
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+
+static constexpr unsigned ReadChunkSize = 4096;
+
+struct ProcessReaderArgs
+{
+    std::shared_ptr<OFS_ProcessState> state;
+    bool isStderr;
+};
+
+bool OFS_ProcessStream::ReadLine(std::string& outLine) noexcept
+{
+    // everything was appended before eof gets set
+    bool isEof = SDL_AtomicGet(&eof) != 0;
+    SDL_AtomicLock(&lock);
+    auto newLine = buffer.find('\n', readPos);
+    bool hasLine = newLine != std::string::npos || (isEof && readPos < buffer.size());
+    if(hasLine) {
+        size_t lineEnd = newLine != std::string::npos ? newLine : buffer.size();
+        size_t length = lineEnd > readPos && buffer[lineEnd - 1] == '\r' ? lineEnd - 1 - readPos : lineEnd - readPos;
+        outLine.assign(buffer, readPos, length);
+        readPos = Util::Min(lineEnd + 1, buffer.size());
+        // consumed data is only dropped once in a while, not for every line
+        if(readPos == buffer.size()) {
+            buffer.clear();
+            readPos = 0;
+        }
+        else if(readPos > buffer.size() / 2) {
+            buffer.erase(0, readPos);
+            readPos = 0;
+        }
+    }
+    SDL_AtomicUnlock(&lock);
+    return hasLine;
+}
+
+bool OFS_ProcessStream::ReadAll(std::string& outData) noexcept
+{
+    SDL_AtomicLock(&lock);
+    bool hasData = readPos < buffer.size();
+    outData.assign(buffer, readPos, std::string::npos);
+    buffer.clear();
+    readPos = 0;
+    SDL_AtomicUnlock(&lock);
+    return hasData;
+}
+
+OFS_ProcessState::~OFS_ProcessState() noexcept
+{
+    // only still open if the writer thread couldn't be started
+    if(in.file) fclose(in.file);
+    if(in.wake) SDL_DestroyCond(in.wake);
+    if(in.mutex) SDL_DestroyMutex(in.mutex);
+    subprocess_destroy(&proc);
+}
 
 OFS_ProcessAPI::~OFS_ProcessAPI() noexcept
 {
@@ -9,15 +72,87 @@ OFS_ProcessAPI::~OFS_ProcessAPI() noexcept
 OFS_ProcessAPI::OFS_ProcessAPI(sol::usertype<OFS_ExtensionAPI>& ofs) noexcept
 {
     sol::state_view Lua(ofs.lua_state());
-    auto process = Lua.new_usertype<OFS_LuaProcess>("Process", 
+    auto process = Lua.new_usertype<OFS_LuaProcess>("Process",
         sol::factories<>(OFS_LuaProcess::CreateProcess));
+    process["pipe"] = OFS_LuaProcess::CreatePipedProcess;
     process["alive"] = &OFS_LuaProcess::IsAlive;
     process["join"] = &OFS_LuaProcess::Join;
     process["detach"] = &OFS_LuaProcess::Detach;
     process["kill"] = &OFS_LuaProcess::Shutdown;
+    process["readLine"] = &OFS_LuaProcess::ReadLine;
+    process["read"] = &OFS_LuaProcess::Read;
+    process["readErrorLine"] = &OFS_LuaProcess::ReadErrorLine;
+    process["readError"] = &OFS_LuaProcess::ReadError;
+    process["write"] = &OFS_LuaProcess::Write;
+    process["closeInput"] = &OFS_LuaProcess::CloseInput;
+    process["onExit"] = [this](OFS_LuaProcess& p, sol::protected_function callback) noexcept { onExit(p, std::move(callback)); };
+}
+
+void OFS_ProcessAPI::onExit(OFS_LuaProcess& process, sol::protected_function callback) noexcept
+{
+    auto& state = process.State();
+    auto it = std::find_if(exitCallbacks.begin(), exitCallbacks.end(),
+        [&state](auto& exit) { return exit.state == state; });
+    if(it != exitCallbacks.end()) {
+        it->callback = std::move(callback);
+    }
+    else {
+        exitCallbacks.emplace_back(ExitCallback{ state, std::move(callback) });
+    }
+}
+
+void OFS_ProcessAPI::Update(std::vector<std::string>& outErrors) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    std::vector<ExitCallback> exited;
+    auto it = std::remove_if(exitCallbacks.begin(), exitCallbacks.end(),
+        [&exited](auto& exit) {
+            auto& state = *exit.state;
+            // the callback should be able to read the complete output
+            if(!SDL_AtomicGet(&state.out.eof) || !SDL_AtomicGet(&state.err.eof)) return false;
+            if(subprocess_alive(&state.proc) > 0) {
+                // the pipes were closed just before the process exited, the readers don't wake us up again
+                OFS_Redraw::Request(1);
+                return false;
+            }
+            exited.emplace_back(std::move(exit));
+            return true;
+        });
+    exitCallbacks.erase(it, exitCallbacks.end());
+
+    // callbacks can register new callbacks, so they are called after erasing
+    for(auto& exit : exited) {
+        int code = -1;
+        subprocess_join(&exit.state->proc, &code);
+        auto res = exit.callback((lua_Integer)code);
+        if(!res.valid()) {
+            sol::error err = res;
+            outErrors.emplace_back(err.what());
+        }
+    }
+}
+
+OFS_LuaProcess::~OFS_LuaProcess() noexcept
+{
+    if(!state->detached) {
+        Shutdown();
+    }
+    // nothing can be written anymore, lets the writer thread finish
+    CloseInput();
+    SDL_AtomicSet(&state->discard, 1);
 }
 
 std::unique_ptr<OFS_LuaProcess> OFS_LuaProcess::CreateProcess(const char* prog, sol::variadic_args va) noexcept
+{
+    return create(prog, va, false);
+}
+
+std::unique_ptr<OFS_LuaProcess> OFS_LuaProcess::CreatePipedProcess(const char* prog, sol::variadic_args va) noexcept
+{
+    return create(prog, va, true);
+}
+
+std::unique_ptr<OFS_LuaProcess> OFS_LuaProcess::create(const char* prog, sol::variadic_args va, bool piped) noexcept
 {
     const char** args = (const char**)alloca(sizeof(const char*) * (va.size() + 2));
     args[0] = prog;
@@ -31,11 +166,203 @@ std::unique_ptr<OFS_LuaProcess> OFS_LuaProcess::CreateProcess(const char* prog,
         index += 1;
     }
     args[va.size() + 1] = nullptr;
-    struct subprocess_s p{0};
-    bool succ = subprocess_create(args, subprocess_option_inherit_environment | subprocess_option_no_window, &p) == 0;
+
+#if !defined(_WIN32)
+    // writing to a child which already exited must fail instead of terminating OFS
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    auto state = std::make_shared<OFS_ProcessState>();
+    // partial reads instead of blocking until a buffer is full
+    int options = subprocess_option_inherit_environment | subprocess_option_no_window | subprocess_option_enable_async;
+    if(subprocess_create(args, options, &state->proc) != 0) {
+        return nullptr;
+    }
+
+    if(!piped) {
+        // nobody reads the output, the readers drain it and notice when the process exits
+        SDL_AtomicSet(&state->discard, 1);
+    }
+
+    // subprocess_join would close stdin under the writer's feet
+    state->in.file = state->proc.stdin_file;
+    state->proc.stdin_file = nullptr;
+    state->in.mutex = SDL_CreateMutex();
+    state->in.wake = SDL_CreateCond();
+    if(state->in.file && state->in.mutex && state->in.wake) {
+        auto writerState = new std::shared_ptr<OFS_ProcessState>(state);
+        auto handle = SDL_CreateThread(writerThread, "OFS_ProcessStdin", writerState);
+        if(handle) {
+            SDL_DetachThread(handle);
+        }
+        else {
+            delete writerState;
+            state->in.failed = true;
+        }
+    }
+    else {
+        state->in.failed = true;
+    }
+
+    for(bool isStderr : { false, true }) {
+        auto readerArgs = new ProcessReaderArgs{ state, isStderr };
+        auto handle = SDL_CreateThread(readerThread, isStderr ? "OFS_ProcessStderr" : "OFS_ProcessStdout", readerArgs);
+        if(!handle) {
+            delete readerArgs;
+            SDL_AtomicSet(isStderr ? &state->err.eof : &state->out.eof, 1);
+            continue;
+        }
+        SDL_DetachThread(handle);
+    }
+    return std::make_unique<OFS_LuaProcess>(std::move(state));
+}
+
+int OFS_LuaProcess::readerThread(void* userData) noexcept
+{
+    auto args = (ProcessReaderArgs*)userData;
+    auto& state = *args->state;
+    auto& stream = args->isStderr ? state.err : state.out;
+
+    char chunk[ReadChunkSize];
+    for(;;) {
+        unsigned bytesRead = args->isStderr
+            ? subprocess_read_stderr(&state.proc, chunk, sizeof(chunk))
+            : subprocess_read_stdout(&state.proc, chunk, sizeof(chunk));
+        if(bytesRead == 0) break;
+
+        for(;;) {
+            if(SDL_AtomicGet(&state.discard)) break;
+            SDL_AtomicLock(&stream.lock);
+            bool hasSpace = stream.buffer.size() - stream.readPos + bytesRead <= OFS_ProcessStream::BufferLimit;
+            if(hasSpace) stream.buffer.append(chunk, bytesRead);
+            SDL_AtomicUnlock(&stream.lock);
+            if(hasSpace) {
+                // extensions poll the output in update(), which only runs when a frame gets rendered
+                OFS_Redraw::Request(1);
+                break;
+            }
+            SDL_Delay(1);
+        }
+    }
+
+    SDL_AtomicSet(&stream.eof, 1);
+    // exit callbacks get called once both streams are closed
+    OFS_Redraw::Request(1);
+    delete args;
+    return 0;
+}
+
+int OFS_LuaProcess::writerThread(void* userData) noexcept
+{
+    auto statePtr = (std::shared_ptr<OFS_ProcessState>*)userData;
+    auto& in = (*statePtr)->in;
+
+    std::string pending;
+    SDL_LockMutex(in.mutex);
+    for(;;) {
+        while(in.buffer.empty() && !in.closed) {
+            SDL_CondWait(in.wake, in.mutex);
+        }
+        if(in.buffer.empty()) break;
+        pending.swap(in.buffer);
+        SDL_UnlockMutex(in.mutex);
+
+        // may block for as long as the child doesn't read
+        bool succ = fwrite(pending.data(), 1, pending.size(), in.file) == pending.size();
+        succ = fflush(in.file) == 0 && succ;
+        pending.clear();
+
+        SDL_LockMutex(in.mutex);
+        if(!succ) {
+            in.failed = true;
+            in.buffer.clear();
+            break;
+        }
+    }
+    in.closed = true;
+    FILE* file = in.file;
+    in.file = nullptr;
+    SDL_UnlockMutex(in.mutex);
+
+    fclose(file);
+    delete statePtr;
+    return 0;
+}
+
+void OFS_LuaProcess::Shutdown() noexcept
+{
+    if(subprocess_alive(&state->proc) > 0) {
+        subprocess_terminate(&state->proc);
+    }
+}
+
+bool OFS_LuaProcess::IsAlive() noexcept
+{
+    return subprocess_alive(&state->proc) > 0;
+}
+
+lua_Integer OFS_LuaProcess::Join() noexcept
+{
+    // subprocess_join used to close stdin, a child waiting for the end of its input would never exit
+    CloseInput();
+    int code = -1;
+    subprocess_join(&state->proc, &code);
+    return code;
+}
+
+void OFS_LuaProcess::Detach() noexcept
+{
+    state->detached = true;
+}
+
+sol::object OFS_LuaProcess::ReadLine(sol::this_state L) noexcept
+{
+    std::string line;
+    if(state->out.ReadLine(line)) return sol::make_object(L, line);
+    return sol::lua_nil;
+}
+
+sol::object OFS_LuaProcess::Read(sol::this_state L) noexcept
+{
+    std::string data;
+    if(state->out.ReadAll(data)) return sol::make_object(L, data);
+    return sol::lua_nil;
+}
+
+sol::object OFS_LuaProcess::ReadErrorLine(sol::this_state L) noexcept
+{
+    std::string line;
+    if(state->err.ReadLine(line)) return sol::make_object(L, line);
+    return sol::lua_nil;
+}
+
+sol::object OFS_LuaProcess::ReadError(sol::this_state L) noexcept
+{
+    std::string data;
+    if(state->err.ReadAll(data)) return sol::make_object(L, data);
+    return sol::lua_nil;
+}
+
+bool OFS_LuaProcess::Write(std::string_view data) noexcept
+{
+    auto& in = state->in;
+    if(!in.mutex) return false;
+    SDL_LockMutex(in.mutex);
+    bool succ = !in.closed && !in.failed && in.buffer.size() + data.size() <= OFS_ProcessInput::BufferLimit;
     if(succ) {
-        auto process = std::make_unique<OFS_LuaProcess>(p);
-        return std::move(process);
+        in.buffer.append(data.data(), data.size());
+        SDL_CondSignal(in.wake);
     }
-    return nullptr;
-}
\ No newline at end of file
+    SDL_UnlockMutex(in.mutex);
+    return succ;
+}
+
+void OFS_LuaProcess::CloseInput() noexcept
+{
+    auto& in = state->in;
+    if(!in.mutex) return;
+    SDL_LockMutex(in.mutex);
+    in.closed = true;
+    SDL_CondSignal(in.wake);
+    SDL_UnlockMutex(in.mutex);
+}
@@ -2,78 +2,115 @@
 #include "OFS_Lua.h"
 #include "subprocess.h"
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+
+// Output of one pipe, filled by a reader thread.
+struct OFS_ProcessStream
+{
+	// the reader waits while the buffer is full, which in turn blocks the child
+	static constexpr size_t BufferLimit = 1024 * 1024;
+
+	SDL_SpinLock lock = {0};
+	std::string buffer;
+	size_t readPos = 0;
+	SDL_atomic_t eof = {0};
+
+	bool ReadLine(std::string& outLine) noexcept;
+	bool ReadAll(std::string& outData) noexcept;
+};
+
+// Input for the child, written by a writer thread so a child which stops reading can't block the UI.
+struct OFS_ProcessInput
+{
+	// write() fails while this much is waiting to be written
+	static constexpr size_t BufferLimit = 1024 * 1024;
+
+	// taken from the subprocess, only the writer thread touches and closes it
+	FILE* file = nullptr;
+	SDL_mutex* mutex = nullptr;
+	SDL_cond* wake = nullptr;
+	std::string buffer;
+	// no more input, the writer closes the file once the buffer is written
+	bool closed = false;
+	// a write failed, most likely the child closed its end
+	bool failed = false;
+};
+
+// Shared between the Lua handle, the exit callback and the reader and writer threads.
+// The process gets destroyed once the last of them lets go of it.
+struct OFS_ProcessState
+{
+	struct subprocess_s proc = {0};
+	bool detached = false;
+	OFS_ProcessInput in;
+	OFS_ProcessStream out;
+	OFS_ProcessStream err;
+	// nobody reads anymore, the readers drain the pipes without buffering
+	SDL_atomic_t discard = {0};
+
+	~OFS_ProcessState() noexcept;
+};
 
 class OFS_LuaProcess
 {
     private:
-	struct subprocess_s proc = {0};
-	bool active = false;
+	std::shared_ptr<OFS_ProcessState> state;
+
+	static int readerThread(void* userData) noexcept;
+	static int writerThread(void* userData) noexcept;
+	static std::unique_ptr<OFS_LuaProcess> create(const char* program, sol::variadic_args va, bool piped) noexcept;
 
 	public:
-	
-	OFS_LuaProcess(subprocess_s p) noexcept
-		: proc(p), active(true) 
-	{
-        if(proc.stdout_file) 
-        {
-            fclose(proc.stdout_file);
-            proc.stdout_file = nullptr;
-        }
-        if(proc.stderr_file)
-        {
-            fclose(proc.stderr_file);
-            proc.stderr_file = nullptr;
-        }
-	}
-
-    ~OFS_LuaProcess() noexcept
-    {
-        Shutdown();
-    }
+	OFS_LuaProcess(std::shared_ptr<OFS_ProcessState> state) noexcept
+		: state(std::move(state)) {}
+    ~OFS_LuaProcess() noexcept;
 
+	// stdout and stderr are drained and discarded
 	static std::unique_ptr<OFS_LuaProcess> CreateProcess(const char* program, sol::variadic_args va) noexcept;
+	// stdin, stdout and stderr stay open and are accessible from Lua
+	static std::unique_ptr<OFS_LuaProcess> CreatePipedProcess(const char* program, sol::variadic_args va) noexcept;
 
-	inline void Shutdown() noexcept
-	{
-		if(active) {
-			if(subprocess_alive(&proc)) {
-				subprocess_terminate(&proc);
-			}
-			subprocess_destroy(&proc);
-		}
-	}
-
-	inline bool IsAlive() noexcept
-	{
-		if(active) {
-			return subprocess_alive(&proc) > 0;
-		}
-		return false;
-	}
+	inline const std::shared_ptr<OFS_ProcessState>& State() const noexcept { return state; }
 
-	inline lua_Integer Join() noexcept
-	{
-		int code = -1;
-		if(active) {
-			if(subprocess_join(&proc, &code) != 0) {
-            	return code;
-        	}
-		}
-		return code;
-	}
-
-	inline void Detach() noexcept
-	{
-		if(active) {
-			subprocess_destroy(&proc);
-			active = false;
-		}
-	}
+	void Shutdown() noexcept;
+	bool IsAlive() noexcept;
+	lua_Integer Join() noexcept;
+	void Detach() noexcept;
+
+	sol::object ReadLine(sol::this_state L) noexcept;
+	sol::object Read(sol::this_state L) noexcept;
+	sol::object ReadErrorLine(sol::this_state L) noexcept;
+	sol::object ReadError(sol::this_state L) noexcept;
+	// Queues the data for the writer thread. False if the input was closed, a write failed
+	// or more than OFS_ProcessInput::BufferLimit would be waiting.
+	bool Write(std::string_view data) noexcept;
+	void CloseInput() noexcept;
 };
 
 class OFS_ProcessAPI
 {
+	private:
+	struct ExitCallback
+	{
+		std::shared_ptr<OFS_ProcessState> state;
+		sol::protected_function callback;
+	};
+	std::vector<ExitCallback> exitCallbacks;
+
+	void onExit(OFS_LuaProcess& process, sol::protected_function callback) noexcept;
+
     public:
     OFS_ProcessAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) noexcept;
     ~OFS_ProcessAPI() noexcept;
-};
\ No newline at end of file
+
+	// Main thread, calls the exit callbacks of processes which exited and whose output was read completely.
+	void Update(std::vector<std::string>& outErrors) noexcept;
+	inline bool HasExitCallbacks() const noexcept { return !exitCallbacks.empty(); }
+	// has to be called before the Lua state goes away
+	inline void Clear() noexcept { exitCallbacks.clear(); }
+};
@@ -1,6 +1,9 @@
 #include "OFS_LuaScriptAPI.h"
 #include "OpenFunscripter.h"
 
+#include <cmath>
+#include <numeric>
+
 OFS_ScriptAPI::OFS_ScriptAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) noexcept
 {
     auto L = sol::state_view(ofs.lua_state());
@@ -12,6 +15,8 @@ OFS_ScriptAPI::OFS_ScriptAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) noexcep
     script["closestAction"] = &LuaFunscript::ClosestAction;
     script["closestActionAfter"] = &LuaFunscript::ClosestActionAfter;
     script["closestActionBefore"] = &LuaFunscript::ClosestActionBefore;
+    script["closestIndices"] = &LuaFunscript::ClosestIndices;
+    script["positionsAt"] = &LuaFunscript::PositionsAt;
     script["selectedIndices"] = &LuaFunscript::SelectedIndices;
     script["markForRemoval"] = &LuaFunscript::MarkForRemoval;
     script["removeMarked"] = &LuaFunscript::RemoveMarked;
@@ -25,8 +30,22 @@ OFS_ScriptAPI::OFS_ScriptAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) noexcep
     action["pos"] = sol::property(&LuaFunscriptAction::pos, &LuaFunscriptAction::set_pos);
     action["selected"] = sol::property(&LuaFunscriptAction::get_selected, &LuaFunscriptAction::set_selected);
 
+    auto range = L.new_usertype<LuaScriptRange>("ScriptRange");
+    range["from"] = sol::readonly_property(&LuaScriptRange::From);
+    range["to"] = sol::readonly_property(&LuaScriptRange::To);
+    range["count"] = &LuaScriptRange::Count;
+    range["times"] = &LuaScriptRange::Times;
+    range["positions"] = &LuaScriptRange::Positions;
+    range["selected"] = &LuaScriptRange::Selected;
+    range["setTimes"] = &LuaScriptRange::SetTimes;
+    range["setPositions"] = &LuaScriptRange::SetPositions;
+    range["setSelected"] = &LuaScriptRange::SetSelected;
+    range["replace"] = &LuaScriptRange::Replace;
+    range["commit"] = &LuaScriptRange::Commit;
+
     ofs["ActiveIdx"] = OFS_ScriptAPI::ActiveIdx;
     ofs["Script"] = OFS_ScriptAPI::Script;
+    ofs["ScriptRange"] = OFS_ScriptAPI::ScriptRange;
     ofs["Clipboard"] = OFS_ScriptAPI::Clipboard;
     ofs["Undo"] = OFS_ScriptAPI::Undo;
 }
@@ -47,6 +66,16 @@ std::unique_ptr<LuaFunscript> OFS_ScriptAPI::Script(lua_Integer idx) noexcept
     return std::make_unique<LuaFunscript>(static_cast<int32_t>(idx), app->LoadedFunscripts()[idx]);
 }
 
+std::unique_ptr<LuaScriptRange> OFS_ScriptAPI::ScriptRange(lua_Integer idx, lua_Number fromTime, lua_Number toTime) noexcept
+{
+    auto app = OpenFunscripter::ptr;
+    idx -= 1;
+    if(idx < 0 || idx >= app->LoadedFunscripts().size() || fromTime > toTime) {
+        return nullptr;
+    }
+    return std::make_unique<LuaScriptRange>(static_cast<int32_t>(idx), app->LoadedFunscripts()[idx], fromTime, toTime);
+}
+
 std::unique_ptr<LuaFunscript> OFS_ScriptAPI::Clipboard() noexcept
 {
     auto app = OpenFunscripter::ptr;
@@ -134,69 +163,146 @@ bool LuaFunscript::HasSelection() const noexcept
     return std::any_of(actions.begin(), actions.end(), [](auto a) { return a.selected; });
 }
 
-sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>> LuaFunscript::ClosestAction(lua_Number time) noexcept
+void LuaFunscript::updateQueryIndex() noexcept
 {
-    float closestDelta = std::numeric_limits<float>::max();
-    int closestIdx = -1;
-    LuaFunscriptAction closestAction(FunscriptAction(0, 0), false);
+    if(queryIndex.valid
+        && queryIndex.data == actions.data()
+        && queryIndex.size == actions.size()
+        && queryIndex.generation == timeGeneration) {
+        return;
+    }
+    OFS_PROFILE(__FUNCTION__);
+    queryIndex.order.clear();
+    bool sorted = std::is_sorted(actions.begin(), actions.end(),
+        [](auto& a1, auto& a2) noexcept { return a1.o.atS < a2.o.atS; });
+    if(!sorted) {
+        // stable, so equal timestamps keep preferring the lower index like a linear scan would
+        queryIndex.order.resize(actions.size());
+        std::iota(queryIndex.order.begin(), queryIndex.order.end(), 0);
+        std::stable_sort(queryIndex.order.begin(), queryIndex.order.end(),
+            [this](uint32_t a, uint32_t b) noexcept { return actions[a].o.atS < actions[b].o.atS; });
+    }
+    // new actions arrive detached
+    for(auto& action : actions) {
+        action.owner.timeGeneration = &timeGeneration;
+    }
+    queryIndex.data = actions.data();
+    queryIndex.size = actions.size();
+    queryIndex.generation = timeGeneration;
+    queryIndex.valid = true;
+}
 
-    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
-        auto a = actions[i];
-        float delta = std::abs(a.at() - time);
-        if(delta < closestDelta) {
-            closestDelta = delta;
-            closestIdx = i;
-            closestAction = a;
-        }
+size_t LuaFunscript::lowerBound(lua_Number time) const noexcept
+{
+    size_t lo = 0, hi = actions.size();
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(timeAt(mid) < time) lo = mid + 1;
+        else hi = mid;
     }
-    if(closestDelta != std::numeric_limits<float>::max()) {
-        return sol::make_optional(std::make_tuple(closestAction, closestIdx + 1));
+    return lo;
+}
+
+size_t LuaFunscript::upperBound(lua_Number time) const noexcept
+{
+    size_t lo = 0, hi = actions.size();
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(timeAt(mid) <= time) lo = mid + 1;
+        else hi = mid;
     }
-    return sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>>();
+    return lo;
 }
 
-sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>> LuaFunscript::ClosestActionAfter(lua_Number time) noexcept
+int64_t LuaFunscript::closestIdx(lua_Number time) const noexcept
 {
-    float closestDelta = std::numeric_limits<float>::max();
-    int closestIdx = -1;
-    LuaFunscriptAction closestAction(FunscriptAction(0, 0), false);
+    if(actions.empty()) return -1;
+    size_t after = lowerBound(time);
+    if(after == 0) return actionIdx(0);
+    // start of the run of equal timestamps, which holds the lowest index
+    size_t before = lowerBound(timeAt(after - 1));
+    if(after == actions.size()) return actionIdx(before);
 
-    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
-        auto a = actions[i];
-        if(a.at() < time) continue;
-        float delta = std::abs(a.at() - time);
-        if(delta < closestDelta && delta != 0.f) {
-            closestDelta = delta;
-            closestIdx = i;
-            closestAction = a;
-        }
+    lua_Number deltaBefore = time - timeAt(before);
+    lua_Number deltaAfter = timeAt(after) - time;
+    if(deltaBefore == deltaAfter) {
+        return std::min(actionIdx(before), actionIdx(after));
     }
-    if(closestDelta != std::numeric_limits<float>::max()) {
-        return sol::make_optional(std::make_tuple(closestAction, closestIdx + 1));
+    return deltaBefore < deltaAfter ? actionIdx(before) : actionIdx(after);
+}
+
+sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>> LuaFunscript::ClosestAction(lua_Number time) noexcept
+{
+    updateQueryIndex();
+    auto idx = closestIdx(time);
+    if(idx >= 0) {
+        return sol::make_optional(std::make_tuple(actions[idx], (lua_Integer)idx + 1));
+    }
+    return sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>>();
+}
+
+sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>> LuaFunscript::ClosestActionAfter(lua_Number time) noexcept
+{
+    updateQueryIndex();
+    size_t after = upperBound(time);
+    if(after < actions.size()) {
+        auto idx = actionIdx(after);
+        return sol::make_optional(std::make_tuple(actions[idx], (lua_Integer)idx + 1));
     }
     return sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>>();
 }
 
 sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>> LuaFunscript::ClosestActionBefore(lua_Number time) noexcept
 {
-    float closestDelta = std::numeric_limits<float>::max();
-    int closestIdx = -1;
-    LuaFunscriptAction closestAction(FunscriptAction(0, 0), false);
+    updateQueryIndex();
+    size_t before = lowerBound(time);
+    if(before > 0) {
+        auto idx = actionIdx(lowerBound(timeAt(before - 1)));
+        return sol::make_optional(std::make_tuple(actions[idx], (lua_Integer)idx + 1));
+    }
+    return sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>>();
+}
 
-    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
-        auto a = actions[i];
-        if(a.at() > time) continue;
-        float delta = std::abs(a.at() - time);
-        if(delta < closestDelta && delta != 0.f) {
-            closestDelta = delta;
-            closestIdx = i;
-            closestAction = a;
-        }
+sol::table LuaFunscript::ClosestIndices(sol::table times, sol::this_state L) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    updateQueryIndex();
+    auto size = times.size();
+    auto indices = sol::state_view(L).create_table(size, 0);
+    for(uint32_t i=1; i <= size; i += 1) {
+        // 0 if there are no actions, keeps the array free of holes
+        indices.raw_set(i, closestIdx(times.raw_get<lua_Number>(i)) + 1);
     }
-    if(closestDelta != std::numeric_limits<float>::max()) {
-        return sol::make_optional(std::make_tuple(closestAction, closestIdx + 1));
+    return indices;
+}
+
+sol::table LuaFunscript::PositionsAt(sol::table times, sol::this_state L) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    updateQueryIndex();
+    auto size = times.size();
+    auto positions = sol::state_view(L).create_table(size, 0);
+    for(uint32_t i=1; i <= size; i += 1) {
+        lua_Number time = times.raw_get<lua_Number>(i);
+        lua_Number pos = 0.0;
+        if(!actions.empty()) {
+            size_t next = upperBound(time);
+            if(next == 0) {
+                pos = actions[actionIdx(0)].o.pos;
+            }
+            else if(next == actions.size()) {
+                pos = actions[actionIdx(next - 1)].o.pos;
+            }
+            else {
+                auto a1 = actions[actionIdx(next - 1)].o;
+                auto a2 = actions[actionIdx(next)].o;
+                lua_Number progress = (time - a1.atS) / (a2.atS - a1.atS);
+                pos = a1.pos + (a2.pos - a1.pos) * progress;
+            }
+        }
+        positions.raw_set(i, pos);
     }
-    return sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>>();
+    return positions;
 }
 
 std::vector<lua_Integer> LuaFunscript::SelectedIndices() const noexcept
@@ -232,5 +338,212 @@ lua_Integer LuaFunscript::RemoveMarked() noexcept
     auto removedCount = actions.size() - filteredActions.size();
     actions = std::move(filteredActions);
     markedIndices.clear();
+    queryIndex.valid = false;
     return removedCount;
-}
\ No newline at end of file
+}
+
+LuaScriptRange::LuaScriptRange(int32_t scriptIdx, std::weak_ptr<Funscript> script, float fromTime, float toTime) noexcept
+    : scriptIdx(scriptIdx), script(script), fromTime(fromTime), toTime(toTime)
+{
+    FUN_ASSERT(Util::InMainThread(), "Not in main thread.");
+}
+
+void LuaScriptRange::materialize() noexcept
+{
+    if(materialized) return;
+    OFS_PROFILE(__FUNCTION__);
+    materialized = true;
+    actions.clear();
+    auto ref = script.lock();
+    if(!ref) return;
+
+    auto& all = ref->Actions();
+    auto& selection = ref->Selection();
+    auto first = std::lower_bound(all.begin(), all.end(), fromTime,
+        [](auto action, float time) noexcept { return action.atS < time; });
+    auto last = std::upper_bound(first, all.end(), toTime,
+        [](float time, auto action) noexcept { return time < action.atS; });
+    // both are sorted, so the selection is walked alongside instead of searched per action
+    auto selIt = std::lower_bound(selection.begin(), selection.end(), fromTime,
+        [](auto action, float time) noexcept { return action.atS < time; });
+
+    actions.reserve(last - first);
+    for(auto it = first; it != last; ++it) {
+        while(selIt != selection.end() && selIt->atS < it->atS) ++selIt;
+        actions.emplace_back(*it, selIt != selection.end() && *selIt == *it);
+    }
+}
+
+bool LuaScriptRange::checkLength(const sol::table& values, sol::this_state L) noexcept
+{
+    if(values.size() != actions.size()) {
+        luaL_error(L.lua_state(), "Array length doesn't match the action count of the range.");
+        return false;
+    }
+    return true;
+}
+
+lua_Integer LuaScriptRange::Count() noexcept
+{
+    materialize();
+    return actions.size();
+}
+
+sol::table LuaScriptRange::Times(sol::this_state L) noexcept
+{
+    materialize();
+    auto times = sol::state_view(L).create_table(actions.size(), 0);
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        times.raw_set(i + 1, actions[i].at());
+    }
+    return times;
+}
+
+sol::table LuaScriptRange::Positions(sol::this_state L) noexcept
+{
+    materialize();
+    auto positions = sol::state_view(L).create_table(actions.size(), 0);
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        positions.raw_set(i + 1, actions[i].pos());
+    }
+    return positions;
+}
+
+sol::table LuaScriptRange::Selected(sol::this_state L) noexcept
+{
+    materialize();
+    auto selected = sol::state_view(L).create_table(actions.size(), 0);
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        selected.raw_set(i + 1, actions[i].selected);
+    }
+    return selected;
+}
+
+void LuaScriptRange::SetTimes(sol::table times, sol::this_state L) noexcept
+{
+    materialize();
+    if(!checkLength(times, L)) return;
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        actions[i].set_at(times.raw_get<lua_Number>(i + 1));
+    }
+    modified = true;
+}
+
+void LuaScriptRange::SetPositions(sol::table positions, sol::this_state L) noexcept
+{
+    materialize();
+    if(!checkLength(positions, L)) return;
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        actions[i].set_pos(std::lround(positions.raw_get<lua_Number>(i + 1)));
+    }
+    modified = true;
+}
+
+void LuaScriptRange::SetSelected(sol::table selected, sol::this_state L) noexcept
+{
+    materialize();
+    if(!checkLength(selected, L)) return;
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        actions[i].selected = selected.raw_get<bool>(i + 1);
+    }
+    modified = true;
+}
+
+void LuaScriptRange::Replace(sol::table times, sol::table positions, sol::optional<sol::table> selected, sol::this_state L) noexcept
+{
+    auto size = times.size();
+    if(positions.size() != size || (selected && selected->size() != size)) {
+        luaL_error(L.lua_state(), "Arrays need to have the same length.");
+        return;
+    }
+    materialized = true;
+    actions.clear();
+    actions.reserve(size);
+    for(uint32_t i=1; i <= size; i += 1) {
+        actions.emplace_back(times.raw_get<lua_Number>(i), std::lround(positions.raw_get<lua_Number>(i)),
+            selected ? selected->raw_get<bool>(i) : false);
+    }
+    modified = true;
+}
+
+void LuaScriptRange::Replace(LuaFunscriptArray&& newActions) noexcept
+{
+    materialized = true;
+    actions = std::move(newActions);
+    modified = true;
+}
+
+void LuaScriptRange::Commit(sol::this_state L) noexcept
+{
+    if(!TryCommit()) {
+        luaL_error(L.lua_state(), "Tried adding multiple actions with the same timestamp.");
+    }
+}
+
+bool LuaScriptRange::TryCommit() noexcept
+{
+    FUN_ASSERT(Util::InMainThread(), "Not in main thread.");
+    if(!modified) return true;
+    OFS_PROFILE(__FUNCTION__);
+    auto app = OpenFunscripter::ptr;
+    auto ref = script.lock();
+    if(!ref) return true;
+
+    std::stable_sort(actions.begin(), actions.end(),
+        [](auto& a1, auto& a2) noexcept {
+            return a1.o.atS < a2.o.atS;
+        });
+
+    // actions which moved out of the range widen the replaced interval,
+    // the untouched script actions in the widened part are merged back in
+    float lo = fromTime;
+    float hi = toTime;
+    if(!actions.empty()) {
+        lo = std::min(lo, actions.front().o.atS);
+        hi = std::max(hi, actions.back().o.atS);
+    }
+    auto& all = ref->Actions();
+    auto first = std::lower_bound(all.begin(), all.end(), lo,
+        [](auto action, float time) noexcept { return action.atS < time; });
+    auto last = std::upper_bound(first, all.end(), hi,
+        [](float time, auto action) noexcept { return time < action.atS; });
+
+    FunscriptArray commit;
+    FunscriptArray selection;
+    commit.reserve(actions.size() + (last - first));
+    auto append = [&](FunscriptAction action, bool selected) noexcept {
+        if(!commit.empty() && commit.back().atS == action.atS) {
+            return false;
+        }
+        commit.emplace_back_unsorted(action);
+        if(selected) selection.emplace_back_unsorted(action);
+        return true;
+    };
+
+    auto merge = [&]() noexcept {
+        auto viewIt = actions.begin();
+        for(auto it = first; it != last; ++it) {
+            if(it->atS >= fromTime && it->atS <= toTime) continue;
+            for(; viewIt != actions.end() && viewIt->o.atS <= it->atS; ++viewIt) {
+                if(!append(viewIt->o, viewIt->selected)) return false;
+            }
+            if(!append(*it, ref->IsSelected(*it))) return false;
+        }
+        for(; viewIt != actions.end(); ++viewIt) {
+            if(!append(viewIt->o, viewIt->selected)) return false;
+        }
+        return true;
+    };
+    if(!merge()) {
+        return false;
+    }
+
+    app->undoSystem->Snapshot(StateType::CUSTOM_LUA, script);
+    ref->ReplaceActionsInInterval(lo, hi, commit, selection);
+    fromTime = lo;
+    toTime = hi;
+    modified = false;
+    // the widened interval may contain actions which aren't part of the view yet
+    materialized = false;
+    return true;
+}
@@ -10,8 +10,28 @@
 
 struct LuaFunscriptAction
 {
+    // Lua can write through references into the actions array, so a LuaFunscript can't be told
+    // about changed timestamps directly. It attaches its generation counter to the actions it holds,
+    // which get bumped when such an action is written, overwritten or destroyed.
+    // Copies always start out detached.
+    struct Owner
+    {
+        uint32_t* timeGeneration = nullptr;
+
+        Owner() noexcept = default;
+        Owner(const Owner&) noexcept {}
+        Owner& operator=(const Owner&) noexcept { Changed(); return *this; }
+        ~Owner() noexcept { Changed(); }
+
+        inline void Changed() noexcept
+        {
+            if(timeGeneration) *timeGeneration += 1;
+        }
+    };
+
     FunscriptAction o;
     bool selected = false;
+    Owner owner;
 
     LuaFunscriptAction(FunscriptAction action, bool selected) noexcept
         : o(action), selected(selected) 
@@ -35,6 +55,7 @@ struct LuaFunscriptAction
     inline void set_at(lua_Number at) noexcept
     {
         o.atS = std::max(0.0, at);
+        owner.Changed();
     }
 
     inline lua_Integer pos() noexcept
@@ -65,11 +86,40 @@ class LuaFunscript
     private:
         int32_t scriptIdx = -1;
         std::weak_ptr<Funscript> script;
+        // declared before actions, the actions still bump it while they're destroyed
+        uint32_t timeGeneration = 0;
         LuaFunscriptArray actions;
         std::set<uint32_t> markedIndices;
+
+        // Time order of the snapshot for the closest action queries.
+        // Rebuilt lazily once the array was resized or any of its actions changed.
+        struct QueryIndex
+        {
+            std::vector<uint32_t> order; // empty while the snapshot itself is sorted
+            const LuaFunscriptAction* data = nullptr;
+            size_t size = 0;
+            uint32_t generation = 0;
+            bool valid = false;
+        } queryIndex;
+
+        void updateQueryIndex() noexcept;
+        inline uint32_t actionIdx(size_t sortedIdx) const noexcept
+        {
+            return queryIndex.order.empty() ? sortedIdx : queryIndex.order[sortedIdx];
+        }
+        inline float timeAt(size_t sortedIdx) const noexcept
+        {
+            return actions[actionIdx(sortedIdx)].o.atS;
+        }
+        size_t lowerBound(lua_Number time) const noexcept;
+        size_t upperBound(lua_Number time) const noexcept;
+        int64_t closestIdx(lua_Number time) const noexcept;
     public:
         LuaFunscript(int32_t scriptIdx, std::weak_ptr<Funscript> script) noexcept;
         LuaFunscript(const FunscriptArray& actions) noexcept;
+        // the actions point at timeGeneration
+        LuaFunscript(const LuaFunscript&) = delete;
+        LuaFunscript(LuaFunscript&&) = delete;
 
         inline void TakeSnapshot() noexcept
         {
@@ -92,9 +142,10 @@ class LuaFunscript
         inline void Sort() noexcept
         {
             std::stable_sort(actions.begin(), actions.end(),
-                [](auto a1, auto a2) {
+                [](auto& a1, auto& a2) {
                     return a1.o.atS < a2.o.atS;
                 });
+            queryIndex.valid = false;
         }
 
         void Commit(sol::this_state L) noexcept;
@@ -108,14 +159,57 @@ class LuaFunscript
         sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>> ClosestActionAfter(lua_Number time) noexcept;
         sol::optional<std::tuple<LuaFunscriptAction, lua_Integer>> ClosestActionBefore(lua_Number time) noexcept;
 
+        // Bulk queries, one result per timestamp.
+        sol::table ClosestIndices(sol::table times, sol::this_state L) noexcept;
+        sol::table PositionsAt(sol::table times, sol::this_state L) noexcept;
+
         void MarkForRemoval(lua_Integer actionIdx, sol::this_state L) noexcept;
         lua_Integer RemoveMarked() noexcept;
 };
 
+// Time limited view of a script which copies nothing until it's accessed.
+// Whole columns are exchanged as plain Lua arrays, so a slider tick costs
+// a handful of calls instead of one per action and field.
+class LuaScriptRange
+{
+    private:
+        int32_t scriptIdx = -1;
+        std::weak_ptr<Funscript> script;
+        float fromTime = 0.f;
+        float toTime = 0.f;
+        LuaFunscriptArray actions;
+        bool materialized = false;
+        bool modified = false;
+
+        void materialize() noexcept;
+        bool checkLength(const sol::table& values, sol::this_state L) noexcept;
+    public:
+        LuaScriptRange(int32_t scriptIdx, std::weak_ptr<Funscript> script, float fromTime, float toTime) noexcept;
+
+        inline lua_Number From() const noexcept { return fromTime; }
+        inline lua_Number To() const noexcept { return toTime; }
+        lua_Integer Count() noexcept;
+
+        sol::table Times(sol::this_state L) noexcept;
+        sol::table Positions(sol::this_state L) noexcept;
+        sol::table Selected(sol::this_state L) noexcept;
+
+        void SetTimes(sol::table times, sol::this_state L) noexcept;
+        void SetPositions(sol::table positions, sol::this_state L) noexcept;
+        void SetSelected(sol::table selected, sol::this_state L) noexcept;
+        void Replace(sol::table times, sol::table positions, sol::optional<sol::table> selected, sol::this_state L) noexcept;
+        void Replace(LuaFunscriptArray&& newActions) noexcept;
+
+        void Commit(sol::this_state L) noexcept;
+        // False if multiple actions ended up with the same timestamp, nothing is committed then.
+        bool TryCommit() noexcept;
+};
+
 class OFS_ScriptAPI
 {
     private:
         static std::unique_ptr<LuaFunscript> Script(lua_Integer idx) noexcept;
+        static std::unique_ptr<LuaScriptRange> ScriptRange(lua_Integer idx, lua_Number fromTime, lua_Number toTime) noexcept;
         static lua_Integer ActiveIdx() noexcept;
         static bool Undo() noexcept;
 
@@ -0,0 +1,380 @@
+#include "OFS_LuaTaskAPI.h"
+#include "OFS_LuaExtensionAPI.h"
+#include "OpenFunscripter.h"
+#include "OFS_ImGui.h"
+#include "OFS_Redraw.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+static constexpr int32_t MaxParamDepth = 16;
+
+sol::table LuaScriptSnapshot::Times(sol::this_state L) const noexcept
+{
+    auto times = sol::state_view(L).create_table(actions.size(), 0);
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        times.raw_set(i + 1, actions[i].atS);
+    }
+    return times;
+}
+
+sol::table LuaScriptSnapshot::Positions(sol::this_state L) const noexcept
+{
+    auto positions = sol::state_view(L).create_table(actions.size(), 0);
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        positions.raw_set(i + 1, actions[i].pos);
+    }
+    return positions;
+}
+
+sol::table LuaScriptSnapshot::Selected(sol::this_state L) const noexcept
+{
+    auto selected = sol::state_view(L).create_table(actions.size(), 0);
+    for(uint32_t i=0, size=actions.size(); i < size; i += 1) {
+        selected.raw_set(i + 1, selection.find(actions[i]) != selection.end());
+    }
+    return selected;
+}
+
+void LuaTaskContext::SetProgress(lua_Number progress) noexcept
+{
+    progress = Util::Clamp(progress, 0.0, 1.0);
+    int newProgress = (int)(progress * OFS_LuaTaskJob::ProgressScale);
+    if(SDL_AtomicSet(&job->progress, newProgress) != newProgress) {
+        // the progress bar of the extension window
+        OFS_Redraw::Request(1);
+    }
+}
+
+bool LuaTaskContext::Cancelled() const noexcept
+{
+    return SDL_AtomicGet(&job->cancel) != 0;
+}
+
+lua_Number LuaTask::Progress() const noexcept
+{
+    return SDL_AtomicGet(&job->progress) / (lua_Number)OFS_LuaTaskJob::ProgressScale;
+}
+
+bool LuaTask::IsDone() const noexcept
+{
+    return job->IsDone();
+}
+
+void LuaTask::Cancel() noexcept
+{
+    SDL_AtomicSet(&job->cancel, 1);
+    if(job->poolJob) job->poolJob->Cancel();
+}
+
+const char* LuaTask::Error() const noexcept
+{
+    if(!IsDone() || job->error.empty()) return nullptr;
+    return job->error.c_str();
+}
+
+OFS_TaskAPI::OFS_TaskAPI(sol::usertype<OFS_ExtensionAPI>& ofs) noexcept
+{
+    sol::state_view L(ofs.lua_state());
+    auto task = L.new_usertype<LuaTask>("Task");
+    task["progress"] = &LuaTask::Progress;
+    task["done"] = &LuaTask::IsDone;
+    task["cancel"] = &LuaTask::Cancel;
+    task["error"] = &LuaTask::Error;
+
+    ofs["Task"] = [this](const char* name, sol::function function, lua_Integer scriptIdx, sol::optional<sol::table> params,
+        sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime, sol::this_state L) noexcept {
+        return createTask(name, function, scriptIdx, params, fromTime, toTime, L);
+    };
+}
+
+OFS_TaskAPI::~OFS_TaskAPI() noexcept
+{
+    CancelAll();
+}
+
+// Deep copy of plain data, anything else ends up as nil.
+static void copyValue(lua_State* from, int idx, lua_State* to, int32_t depth) noexcept
+{
+    idx = lua_absindex(from, idx);
+    switch(lua_type(from, idx)) {
+        case LUA_TBOOLEAN:
+            lua_pushboolean(to, lua_toboolean(from, idx));
+            break;
+        case LUA_TNUMBER:
+            if(lua_isinteger(from, idx)) lua_pushinteger(to, lua_tointeger(from, idx));
+            else lua_pushnumber(to, lua_tonumber(from, idx));
+            break;
+        case LUA_TSTRING:
+        {
+            size_t len;
+            const char* str = lua_tolstring(from, idx, &len);
+            lua_pushlstring(to, str, len);
+            break;
+        }
+        case LUA_TTABLE:
+            if(depth >= MaxParamDepth) {
+                lua_pushnil(to);
+                break;
+            }
+            lua_newtable(to);
+            lua_pushnil(from);
+            while(lua_next(from, idx) != 0) {
+                copyValue(from, -2, to, depth + 1);
+                copyValue(from, -1, to, depth + 1);
+                if(lua_isnil(to, -2)) lua_pop(to, 2);
+                else lua_rawset(to, -3);
+                lua_pop(from, 1);
+            }
+            break;
+        default:
+            lua_pushnil(to);
+            break;
+    }
+}
+
+static void cancelHook(lua_State* L, lua_Debug* ar) noexcept
+{
+    auto job = *(OFS_LuaTaskJob**)lua_getextraspace(L);
+    if(SDL_AtomicGet(&job->cancel) || job->runningJob->IsCancelled()) {
+        luaL_error(L, "Task cancelled.");
+    }
+}
+
+std::unique_ptr<LuaTask> OFS_TaskAPI::createTask(const char* name, sol::function function, lua_Integer scriptIdx,
+    sol::optional<sol::table> params, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime, sol::this_state L) noexcept
+{
+    FUN_ASSERT(Util::InMainThread(), "Not in main thread.");
+    OFS_PROFILE(__FUNCTION__);
+    auto app = OpenFunscripter::ptr;
+    scriptIdx -= 1;
+    if(scriptIdx < 0 || scriptIdx >= app->LoadedFunscripts().size()) {
+        return nullptr;
+    }
+    auto script = app->LoadedFunscripts()[scriptIdx];
+
+    auto job = std::make_shared<OFS_LuaTaskJob>();
+    job->name = name ? name : "Task";
+    job->scriptIdx = scriptIdx;
+    job->script = script;
+    job->scriptVersion = script->Version();
+    bool useRange = fromTime && toTime;
+    job->fromTime = useRange ? *fromTime : std::numeric_limits<float>::lowest();
+    job->toTime = useRange ? *toTime : std::numeric_limits<float>::max();
+
+    // the function moves over as bytecode, closures can't be shared between states
+    std::string bytecode;
+    {
+        lua_State* from = L.lua_state();
+        function.push();
+        auto writer = [](lua_State*, const void* data, size_t size, void* user) noexcept -> int {
+            ((std::string*)user)->append((const char*)data, size);
+            return 0;
+        };
+        int status = lua_dump(from, writer, &bytecode, 0);
+        lua_pop(from, 1);
+        if(status != 0 || bytecode.empty()) {
+            luaL_error(from, "Task function can't be transferred, it has to be a Lua function.");
+            return nullptr;
+        }
+    }
+
+    job->L = std::make_unique<sol::state>();
+    auto& workerL = *job->L;
+    workerL.open_libraries(
+        sol::lib::base,
+        sol::lib::string,
+        sol::lib::table,
+        sol::lib::math,
+        sol::lib::utf8,
+        sol::lib::os
+    );
+    auto snapshotType = workerL.new_usertype<LuaScriptSnapshot>("Snapshot");
+    snapshotType["from"] = sol::readonly_property(&LuaScriptSnapshot::From);
+    snapshotType["to"] = sol::readonly_property(&LuaScriptSnapshot::To);
+    snapshotType["count"] = &LuaScriptSnapshot::Count;
+    snapshotType["times"] = &LuaScriptSnapshot::Times;
+    snapshotType["positions"] = &LuaScriptSnapshot::Positions;
+    snapshotType["selected"] = &LuaScriptSnapshot::Selected;
+    auto contextType = workerL.new_usertype<LuaTaskContext>("TaskContext");
+    contextType["progress"] = &LuaTaskContext::SetProgress;
+    contextType["cancelled"] = &LuaTaskContext::Cancelled;
+
+    lua_State* to = workerL.lua_state();
+    if(luaL_loadbufferx(to, bytecode.data(), bytecode.size(), job->name.c_str(), "b") != LUA_OK) {
+        luaL_error(L.lua_state(), "Failed to load task function: %s", lua_tostring(to, -1));
+        return nullptr;
+    }
+    // load binds the first upvalue to the globals, whatever it was, only _ENV should be
+    for(int i=1; const char* upvalue = lua_getupvalue(to, -1, i); i += 1) {
+        lua_pop(to, 1);
+        if(strcmp(upvalue, "_ENV") == 0) lua_pushglobaltable(to);
+        else lua_pushnil(to);
+        lua_setupvalue(to, -2, i);
+    }
+    job->function = sol::protected_function(to, -1);
+    lua_pop(to, 1);
+
+    if(params) {
+        params->push();
+        copyValue(L.lua_state(), -1, to, 0);
+        lua_pop(L.lua_state(), 1);
+        job->params = sol::object(to, -1);
+        lua_pop(to, 1);
+    }
+
+    job->snapshot = std::make_shared<LuaScriptSnapshot>();
+    job->snapshot->fromTime = job->fromTime;
+    job->snapshot->toTime = job->toTime;
+    auto copyInterval = [&job](const FunscriptArray& source, FunscriptArray& target) noexcept {
+        auto first = std::lower_bound(source.begin(), source.end(), job->fromTime,
+            [](auto action, float time) noexcept { return action.atS < time; });
+        auto last = std::upper_bound(first, source.end(), job->toTime,
+            [](float time, auto action) noexcept { return time < action.atS; });
+        target.assign(first, last);
+    };
+    copyInterval(script->Actions(), job->snapshot->actions);
+    copyInterval(script->Selection(), job->snapshot->selection);
+
+    // the work function keeps the job alive, even if the extension drops it
+    OFS_JobDesc desc;
+    desc.Name = Util::Format("Lua: %s", job->name.c_str());
+    desc.Work = [job](OFS_Job& poolJob) noexcept { return runTask(*job, poolJob); };
+    desc.Priority = OFS_ThreadPool::Priority::Low;
+    // tasks can run for minutes
+    desc.Lane = OFS_JobLane::Process;
+    job->poolJob = OFS_JobSystem::Submit(std::move(desc));
+    tasks.emplace_back(job);
+    return std::make_unique<LuaTask>(std::move(job));
+}
+
+bool OFS_TaskAPI::runTask(OFS_LuaTaskJob& job, OFS_Job& poolJob) noexcept
+{
+    job.runningJob = &poolJob;
+    lua_State* L = job.L->lua_state();
+    *(OFS_LuaTaskJob**)lua_getextraspace(L) = &job;
+    lua_sethook(L, cancelHook, LUA_MASKCOUNT, OFS_LuaTaskJob::CancelCheckInstructions);
+
+    {
+        auto res = job.function(job.snapshot, LuaTaskContext(&job), job.params);
+        if(!res.valid()) {
+            sol::error err = res;
+            job.error = err.what();
+        }
+        else if(!SDL_AtomicGet(&job.cancel) && res.return_count() >= 2) {
+            sol::object times = res[0];
+            sol::object positions = res[1];
+            sol::object selected;
+            if(res.return_count() >= 3) selected = res[2];
+            if(!times.is<sol::table>() || !positions.is<sol::table>()) {
+                job.error = "A task has to return arrays of times and positions.";
+            }
+            else {
+                auto timesTable = times.as<sol::table>();
+                auto positionsTable = positions.as<sol::table>();
+                auto selectedTable = selected.is<sol::table>() ? selected.as<sol::table>() : sol::table();
+                auto size = timesTable.size();
+                if(positionsTable.size() != size || (selectedTable.valid() && selectedTable.size() != size)) {
+                    job.error = "Returned arrays need to have the same length.";
+                }
+                else {
+                    job.result.reserve(size);
+                    for(uint32_t i=1; i <= size; i += 1) {
+                        job.result.emplace_back(timesTable.raw_get<lua_Number>(i), std::lround(positionsTable.raw_get<lua_Number>(i)),
+                            selectedTable.valid() ? selectedTable.raw_get<bool>(i) : false);
+                    }
+                    job.hasResult = true;
+                }
+            }
+        }
+    }
+
+    // the state is only ever touched by the worker, close it here
+    job.function = sol::protected_function();
+    job.params = sol::object();
+    job.L.reset();
+    if(poolJob.IsCancelled()) {
+        SDL_AtomicSet(&job.cancel, 1);
+    }
+    job.runningJob = nullptr;
+    SDL_AtomicSet(&job.progress, OFS_LuaTaskJob::ProgressScale);
+    SDL_AtomicSet(&job.done, 1);
+    return job.error.empty();
+}
+
+void OFS_TaskAPI::finishTask(OFS_LuaTaskJob& job) noexcept
+{
+    OFS_PROFILE(__FUNCTION__);
+    auto script = job.script.lock();
+    if(!script) return;
+    if(script->Version() != job.scriptVersion) {
+        // edits outside of the range survive the commit, edits inside it would be lost
+        auto& all = script->Actions();
+        auto first = std::lower_bound(all.begin(), all.end(), job.fromTime,
+            [](auto action, float time) noexcept { return action.atS < time; });
+        auto last = std::upper_bound(first, all.end(), job.toTime,
+            [](float time, auto action) noexcept { return time < action.atS; });
+        auto& snapshot = job.snapshot->actions;
+        bool unchanged = (size_t)(last - first) == snapshot.size()
+            && std::equal(first, last, snapshot.begin(),
+                [](auto a, auto b) noexcept { return a.atS == b.atS && a.pos == b.pos; });
+        if(!unchanged) {
+            job.error = "The actions were edited while the task was running, the result was discarded.";
+            return;
+        }
+    }
+
+    LuaScriptRange range(job.scriptIdx, job.script, job.fromTime, job.toTime);
+    range.Replace(std::move(job.result));
+    if(!range.TryCommit()) {
+        job.error = "Tried adding multiple actions with the same timestamp.";
+    }
+}
+
+void OFS_TaskAPI::Update(std::vector<std::string>& outErrors) noexcept
+{
+    for(auto it = tasks.begin(); it != tasks.end();) {
+        auto& job = **it;
+        if(!job.IsDone()) {
+            ++it;
+            continue;
+        }
+        if(!SDL_AtomicGet(&job.cancel)) {
+            if(job.hasResult) finishTask(job);
+            if(!job.error.empty()) {
+                outErrors.emplace_back(Util::Format("%s: %s", job.name.c_str(), job.error.c_str()));
+            }
+        }
+        it = tasks.erase(it);
+    }
+}
+
+void OFS_TaskAPI::ShowProgress() noexcept
+{
+    if(tasks.empty()) return;
+    ImGui::Separator();
+    for(auto& job : tasks) {
+        ImGui::PushID(job.get());
+        float progress = SDL_AtomicGet(&job->progress) / (float)OFS_LuaTaskJob::ProgressScale;
+        bool cancelled = SDL_AtomicGet(&job->cancel) != 0;
+        ImGui::ProgressBar(progress, ImVec2(-ImGui::GetFrameHeight() * 3.f, 0.f), job->name.c_str());
+        ImGui::SameLine();
+        if(cancelled) ImGui::BeginDisabled();
+        if(ImGui::Button("Cancel", ImVec2(-1.f, 0.f))) {
+            SDL_AtomicSet(&job->cancel, 1);
+        }
+        if(cancelled) ImGui::EndDisabled();
+        ImGui::PopID();
+    }
+}
+
+void OFS_TaskAPI::CancelAll() noexcept
+{
+    for(auto& job : tasks) {
+        SDL_AtomicSet(&job->cancel, 1);
+        if(job->poolJob) job->poolJob->Cancel();
+    }
+    tasks.clear();
+}
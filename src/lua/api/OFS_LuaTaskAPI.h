@@ -0,0 +1,115 @@
+#pragma once
+#include "OFS_Lua.h"
+#include "OFS_LuaScriptAPI.h"
+#include "FunscriptAction.h"
+#include "OFS_JobSystem.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SDL_atomic.h"
+
+// Read-only copy of the actions a task works on, lives in the task's own Lua state.
+struct LuaScriptSnapshot
+{
+    FunscriptArray actions;
+    FunscriptArray selection;
+    float fromTime = 0.f;
+    float toTime = 0.f;
+
+    inline lua_Number From() const noexcept { return fromTime; }
+    inline lua_Number To() const noexcept { return toTime; }
+    inline lua_Integer Count() const noexcept { return actions.size(); }
+    sol::table Times(sol::this_state L) const noexcept;
+    sol::table Positions(sol::this_state L) const noexcept;
+    sol::table Selected(sol::this_state L) const noexcept;
+};
+
+// Shared between the extension and the pool worker running the task.
+// After the start the Lua state only belongs to the worker, the extension only
+// touches the atomics until done is set.
+struct OFS_LuaTaskJob
+{
+    static constexpr int32_t ProgressScale = 10000;
+    // how often the worker checks for cancellation
+    static constexpr int32_t CancelCheckInstructions = 10000;
+
+    std::string name;
+    int32_t scriptIdx = -1;
+    std::weak_ptr<Funscript> script;
+    float fromTime = 0.f;
+    float toTime = 0.f;
+    // the result is only committed if the snapshotted actions weren't edited in the meantime
+    uint32_t scriptVersion = 0;
+
+    std::unique_ptr<sol::state> L;
+    sol::protected_function function;
+    sol::object params;
+    std::shared_ptr<LuaScriptSnapshot> snapshot;
+
+    SDL_atomic_t progress = {0};
+    SDL_atomic_t cancel = {0};
+    SDL_atomic_t done = {0};
+    // main thread, cancels the job when the task gets cancelled
+    OFS_JobHandle poolJob;
+    // worker, the job can also be cancelled from the job list
+    OFS_Job* runningJob = nullptr;
+
+    // main thread, a job cancelled before it started never runs the task
+    inline bool IsDone() noexcept { return SDL_AtomicGet(&done) || (poolJob && poolJob->IsFinished()); }
+
+    // valid once done is set
+    std::string error;
+    bool hasResult = false;
+    LuaFunscriptArray result;
+};
+
+// Passed to the task function, used from the worker thread.
+class LuaTaskContext
+{
+    private:
+        OFS_LuaTaskJob* job = nullptr;
+    public:
+        LuaTaskContext(OFS_LuaTaskJob* job) noexcept : job(job) {}
+        void SetProgress(lua_Number progress) noexcept;
+        bool Cancelled() const noexcept;
+};
+
+// Handle returned to the extension by ofs.Task().
+class LuaTask
+{
+    private:
+        std::shared_ptr<OFS_LuaTaskJob> job;
+    public:
+        LuaTask(std::shared_ptr<OFS_LuaTaskJob> job) noexcept : job(std::move(job)) {}
+        lua_Number Progress() const noexcept;
+        bool IsDone() const noexcept;
+        void Cancel() noexcept;
+        const char* Error() const noexcept;
+};
+
+// ofs.Task, runs a Lua function as a background job in a separate Lua state.
+// The function is transferred as bytecode, upvalues don't survive that, data is passed via params.
+// Its result replaces the actions of the snapshot on the main thread as a single undo step.
+class OFS_TaskAPI
+{
+    private:
+    std::vector<std::shared_ptr<OFS_LuaTaskJob>> tasks;
+
+    std::unique_ptr<LuaTask> createTask(const char* name, sol::function function, lua_Integer scriptIdx,
+        sol::optional<sol::table> params, sol::optional<lua_Number> fromTime, sol::optional<lua_Number> toTime, sol::this_state L) noexcept;
+    void finishTask(OFS_LuaTaskJob& job) noexcept;
+
+    static bool runTask(OFS_LuaTaskJob& job, OFS_Job& poolJob) noexcept;
+
+    public:
+    OFS_TaskAPI(sol::usertype<class OFS_ExtensionAPI>& ofs) noexcept;
+    ~OFS_TaskAPI() noexcept;
+
+    // Main thread, commits finished tasks, returns errors of failed tasks.
+    void Update(std::vector<std::string>& outErrors) noexcept;
+    void ShowProgress() noexcept;
+    void CancelAll() noexcept;
+    inline bool HasTasks() const noexcept { return !tasks.empty(); }
+};
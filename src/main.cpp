@@ -3,6 +3,37 @@
 
 #include "state/OpenFunscripterState.h"
 #include "state/OFS_LibState.h"
+#include "OFS_FrameArena.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+// Counts heap allocations for the per-frame numbers in the debug menu.
+// The array, nothrow and sized variants all end up here, the aligned ones aren't counted.
+// Debug builds only, release builds keep the allocator untouched.
+void* operator new(size_t size)
+{
+    SDL_AtomicIncRef(&OFS_FrameArena::HeapAllocations);
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* ptr = std::malloc(size)) return ptr;
+        auto handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
 
 int main(int argc, char* argv[])
 {
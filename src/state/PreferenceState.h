@@ -25,6 +25,7 @@ struct PreferenceState
 
 	bool forceHwDecoding = false;
 	bool showMetaOnNew = true;
+	int32_t clipExportConcurrency = 2;
 
 	static inline PreferenceState& State(uint32_t stateHandle) noexcept {
 		return OFS_AppState<PreferenceState>(stateHandle).Get();
@@ -41,4 +42,5 @@ REFL_TYPE(PreferenceState)
 	REFL_FIELD(framerateLimit)
 	REFL_FIELD(forceHwDecoding)
 	REFL_FIELD(showMetaOnNew)
+	REFL_FIELD(clipExportConcurrency)
 REFL_END
\ No newline at end of file
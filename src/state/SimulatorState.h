@@ -39,11 +39,9 @@ struct SimulatorDefaultConfigState
     static constexpr auto StateName = "SimulatorDefaultConfigState";
     SimulatorState defaultState;
 
-    inline static SimulatorDefaultConfigState& StaticStateSlow() noexcept
+    inline static SimulatorDefaultConfigState& State(uint32_t stateHandle) noexcept
     {
-        // This shouldn't be done in hot paths but shouldn't be a problem otherwise.
-        uint32_t handle = OFS_AppState<SimulatorDefaultConfigState>::Register(StateName);
-        return OFS_AppState<SimulatorDefaultConfigState>(handle).Get();
+        return OFS_AppState<SimulatorDefaultConfigState>(stateHandle).Get();
     }
 };
 